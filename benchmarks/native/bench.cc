@@ -0,0 +1,454 @@
+// Microbenchmarks for the trie core, with no N-API layer in the way.
+//
+// Every case is run once to warm up and then --runs times; the table shows
+// the median time per operation, the run-to-run CV%, and per operation: heap
+// allocations (global operator new, aligned or not), arena allocations
+// (nodes, child blocks and spilled labels) and nodes visited (see
+// src/PerfCounters.h). Counts are exact and repeatable, so a change that
+// moves them is visible however noisy the timings are.
+//
+// Usage: seshat_bench [--runs N] [--words N] [--max-words N] [file...]
+//
+// Each file is a newline-delimited corpus. Without files, the word lists
+// `npm run setupTextFiles` downloads into ./textfiles are used when present.
+// A generated corpus of --words words always runs first.
+#include "RadixTrie.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+std::atomic<std::uint64_t> heap_allocations{0};
+
+} // namespace
+
+// Every replacement allocates with malloc or aligned_alloc and frees with
+// free, which is a matching pair; g++ only sees operator delete calling free
+// and warns.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void *operator new(std::size_t size) {
+	heap_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void *p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+void *operator new(std::size_t size, std::align_val_t alignment) {
+	heap_allocations.fetch_add(1, std::memory_order_relaxed);
+	// aligned_alloc wants a size that is a multiple of the alignment
+	const std::size_t align = static_cast<std::size_t>(alignment);
+	const std::size_t rounded = (std::max<std::size_t>(size, 1) + align - 1) /
+								align * align;
+	if (void *p = std::aligned_alloc(align, rounded))
+		return p;
+	throw std::bad_alloc();
+}
+void *operator new[](std::size_t size) { return operator new(size); }
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+	return operator new(size, alignment);
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+	std::free(p);
+}
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+	std::free(p);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Corpus {
+	std::string name;
+	std::string text;				  // newline-delimited, as the loaders read it
+	std::vector<std::string_view> words; // views into text
+};
+
+struct Result {
+	double median_ns; // per operation
+	double cv;		  // percent
+	double heap;	  // the rest are per operation too
+	double arena;
+	double nodes;
+};
+
+struct Options {
+	size_t runs = 7;
+	size_t generated_words = 200000;
+	size_t max_words = 0; // 0 keeps every line of a file
+	std::vector<std::string> files;
+};
+
+// Runs `body` (which performs `ops` operations) once untimed and then `runs`
+// times, calling `setup` untimed before each. Allocations and node visits are
+// summed over the timed runs.
+Result measure(size_t runs, size_t ops, const std::function<void()> &setup,
+			   const std::function<void()> &body) {
+	setup();
+	body();
+
+	std::vector<double> samples;
+	std::uint64_t heap = 0, arena = 0, nodes = 0;
+	for (size_t r = 0; r < runs; ++r) {
+		setup();
+		const PerfCounters before = perf_counters.load();
+		const std::uint64_t heap_before = heap_allocations.load();
+		const auto start = Clock::now();
+		body();
+		const auto end = Clock::now();
+		heap += heap_allocations.load() - heap_before;
+		PerfCounters delta = perf_counters.load();
+		delta -= before;
+		arena += delta.arena_allocations;
+		nodes += delta.nodes_visited;
+		samples.push_back(
+			std::chrono::duration<double, std::nano>(end - start).count() /
+			static_cast<double>(ops));
+	}
+
+	double mean = 0;
+	for (double s : samples)
+		mean += s;
+	mean /= static_cast<double>(samples.size());
+	double variance = 0;
+	for (double s : samples)
+		variance += (s - mean) * (s - mean);
+	variance /= static_cast<double>(samples.size());
+	std::sort(samples.begin(), samples.end());
+
+	const double total = static_cast<double>(runs * ops);
+	return {samples[samples.size() / 2],
+			mean > 0 ? 100.0 * std::sqrt(variance) / mean : 0.0,
+			static_cast<double>(heap) / total,
+			static_cast<double>(arena) / total,
+			static_cast<double>(nodes) / total};
+}
+
+void print_header(const Corpus &corpus) {
+	std::printf("\n=== %s (%zu words) ===\n", corpus.name.c_str(),
+				corpus.words.size());
+	std::printf("%-28s %12s %7s %10s %10s %10s\n", "Test", "ns/op", "CV%",
+				"heap/op", "arena/op", "nodes/op");
+	std::printf("%s\n", std::string(82, '-').c_str());
+}
+
+void print_row(const std::string &name, const Result &r) {
+	std::printf("%-28s %12.1f %7.1f %10.2f %10.2f %10.2f\n", name.c_str(),
+				r.median_ns, r.cv, r.heap, r.arena, r.nodes);
+}
+
+void split_lines(Corpus &corpus, size_t max_words) {
+	std::string_view text = corpus.text;
+	size_t start = 0;
+	while (start < text.size() &&
+		   (max_words == 0 || corpus.words.size() < max_words)) {
+		size_t end = text.find('\n', start);
+		if (end == std::string_view::npos)
+			end = text.size();
+		std::string_view line = text.substr(start, end - start);
+		if (!line.empty() && line.back() == '\r')
+			line.remove_suffix(1);
+		if (!line.empty())
+			corpus.words.push_back(line);
+		start = end + 1;
+	}
+	if (max_words != 0 && start < text.size())
+		corpus.text.resize(start); // keep the loaders to the same words
+}
+
+// Words built from a small syllable set, so they share prefixes the way
+// natural language does and the trie has real depth and branching.
+Corpus generated_corpus(size_t count) {
+	static const char *const kSyllables[] = {
+		"an", "be", "co", "de", "er", "fi", "ga", "he", "in", "jo", "ka",
+		"le", "mo", "ne", "or", "pa", "qu", "re", "st", "th", "un", "ve",
+		"wi", "xe", "yo", "ze", "ing", "tion", "ly", "ous"};
+	constexpr size_t kSyllableCount = sizeof(kSyllables) / sizeof(*kSyllables);
+	std::mt19937_64 rng(42);
+	std::uniform_int_distribution<size_t> syllable(0, kSyllableCount - 1);
+	std::uniform_int_distribution<int> length(2, 6);
+
+	Corpus corpus;
+	corpus.name = "generated";
+	std::string word;
+	for (size_t i = 0; i < count; ++i) {
+		word.clear();
+		for (int n = length(rng); n > 0; --n)
+			word += kSyllables[syllable(rng)];
+		corpus.text += word;
+		corpus.text += '\n';
+	}
+	split_lines(corpus, 0);
+	return corpus;
+}
+
+bool load_corpus(const std::string &path, size_t max_words, Corpus &corpus) {
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+		return false;
+	std::ostringstream contents;
+	contents << in.rdbuf();
+	corpus.name = path;
+	corpus.text = contents.str();
+	split_lines(corpus, max_words);
+	return true;
+}
+
+void load(RadixTrie &trie, const Corpus &corpus) {
+	trie.bulk_insert_from_buffer(corpus.text.data(), corpus.text.size());
+}
+
+void run_corpus(const Corpus &corpus, const Options &options) {
+	if (corpus.words.empty())
+		return;
+	print_header(corpus);
+	const size_t runs = options.runs;
+	const size_t n = corpus.words.size();
+	auto noop = [] {};
+
+	// Mutations get a fresh trie per run, built outside the timed region.
+	std::optional<RadixTrie> scratch;
+	auto empty_trie = [&] { scratch.emplace(); };
+	auto full_trie = [&] { load(scratch.emplace(), corpus); };
+
+	print_row("insert", measure(runs, n, empty_trie, [&] {
+				  for (std::string_view w : corpus.words)
+					  scratch->insert(w);
+			  }));
+
+	print_row("insert (suffix index)",
+			  measure(runs, n, [&] { scratch.emplace(false, true); }, [&] {
+				  for (std::string_view w : corpus.words)
+					  scratch->insert(w);
+			  }));
+
+	print_row("put (value)", measure(runs, n, empty_trie, [&] {
+				  std::uint64_t id = 0;
+				  for (std::string_view w : corpus.words)
+					  scratch->put(w, id++);
+			  }));
+
+	std::string sorted_text;
+	{
+		std::vector<std::string_view> sorted(corpus.words);
+		std::sort(sorted.begin(), sorted.end());
+		for (std::string_view w : sorted) {
+			sorted_text.append(w.data(), w.size());
+			sorted_text += '\n';
+		}
+	}
+	print_row("bulk load", measure(runs, n, empty_trie, [&] {
+				  scratch->bulk_insert_from_buffer(corpus.text.data(),
+												   corpus.text.size());
+			  }));
+	BulkLoadOptions sorted_load;
+	sorted_load.assume_sorted = true;
+	print_row("bulk load (sorted)", measure(runs, n, empty_trie, [&] {
+				  scratch->bulk_insert_from_buffer(
+					  sorted_text.data(), sorted_text.size(), sorted_load);
+			  }));
+	print_row("clear (whole trie)",
+			  measure(runs, 1, full_trie, [&] { scratch->clear(); }));
+
+	// Set operations with a trie of every other word, per word of that trie
+	RadixTrie odds;
+	for (size_t i = 1; i < n; i += 2)
+		odds.insert(corpus.words[i]);
+	auto even_trie = [&] {
+		scratch.emplace();
+		for (size_t i = 0; i < n; i += 2)
+			scratch->insert(corpus.words[i]);
+	};
+	const size_t half = std::max<size_t>(odds.size(), 1);
+	print_row("merge (half into half)",
+			  measure(runs, half, even_trie, [&] { scratch->merge(odds); }));
+	print_row("subtract (half)",
+			  measure(runs, half, full_trie, [&] { scratch->subtract(odds); }));
+	auto thinned_trie = [&] {
+		full_trie();
+		for (size_t i = 0; i < n; ++i) {
+			if (i % 4)
+				scratch->remove(corpus.words[i]);
+		}
+	};
+	print_row("compact (3/4 removed)",
+			  measure(runs, 1, thinned_trie, [&] { scratch->compact(); }));
+	scratch.reset();
+
+	// Queries run against one trie built from the whole corpus, over a
+	// fixed random sample of its words.
+	RadixTrie trie;
+	load(trie, corpus);
+	std::mt19937_64 rng(7);
+	std::vector<std::string> hits;
+	for (size_t i = 0; i < std::min<size_t>(n, 10000); ++i)
+		hits.emplace_back(corpus.words[rng() % n]);
+	std::vector<std::string> deep_misses, shallow_misses, prefixes;
+	for (const std::string &w : hits) {
+		deep_misses.push_back(w + "qxz"); // diverges late, near the leaf
+		shallow_misses.push_back("qxz" + w); // diverges at the root
+		prefixes.push_back(w.substr(0, 3));
+	}
+
+	size_t found = 0;
+	auto search_all = [&](const std::vector<std::string> &words) {
+		return [&] {
+			for (const std::string &w : words)
+				found += trie.search(w);
+		};
+	};
+	print_row("search hit", measure(runs, hits.size(), noop, search_all(hits)));
+	print_row("search miss, deep",
+			  measure(runs, deep_misses.size(), noop, search_all(deep_misses)));
+	print_row("search miss, shallow", measure(runs, shallow_misses.size(),
+											  noop, search_all(shallow_misses)));
+
+	const size_t prefix_queries = std::min<size_t>(prefixes.size(), 1000);
+	print_row("words_with_prefix (<=100)",
+			  measure(runs, prefix_queries, noop, [&] {
+				  for (size_t i = 0; i < prefix_queries; ++i)
+					  found += trie.words_with_prefix(prefixes[i], 100).size();
+			  }));
+	print_row("range (<=100 from a miss)",
+			  measure(runs, prefix_queries, noop, [&] {
+				  for (size_t i = 0; i < prefix_queries; ++i)
+					  found += trie.range(deep_misses[i], std::nullopt, 100)
+								   .size();
+			  }));
+
+	// The rank index is built by one untimed query, as it would be by the
+	// first query after the last write.
+	found += trie.rank("");
+	print_row("rank", measure(runs, hits.size(), noop, [&] {
+				  for (const std::string &w : hits)
+					  found += trie.rank(w);
+			  }));
+	print_row("select", measure(runs, hits.size(), noop, [&] {
+				  for (size_t i = 0; i < hits.size(); ++i)
+					  found += trie.select(rng() % trie.size())->size();
+			  }));
+	// A write before every query leaves each one to rebuild the index, in
+	// time linear in the trie. Each word is put back, so the trie ends as
+	// it began.
+	const size_t churned_ranks = std::min<size_t>(hits.size(), 100);
+	print_row("rank (write between)",
+			  measure(runs, churned_ranks, noop, [&] {
+				  for (size_t i = 0; i < churned_ranks; ++i) {
+					  trie.remove(hits[i]);
+					  found += trie.rank(hits[i]);
+					  trie.insert(hits[i]);
+				  }
+			  }));
+
+	for (const char *pattern : {"th*", "*ing", "?e*s", "*qxz*"}) {
+		print_row(std::string("pattern_search('") + pattern + "')",
+				  measure(runs, 1, noop, [&] {
+					  found += trie.pattern_search(pattern).size();
+				  }));
+	}
+
+	// Leading wildcards again through a suffix index, whose parts are
+	// built by one untimed query each.
+	RadixTrie indexed(false, true);
+	load(indexed, corpus);
+	found += indexed.ends_with("ing") + indexed.pattern_search("*qxz*").size();
+	for (const char *pattern : {"*ing", "*qxz*"}) {
+		print_row(std::string("pattern '") + pattern + "' (indexed)",
+				  measure(runs, 1, noop, [&] {
+					  found += indexed.pattern_search(pattern).size();
+				  }));
+	}
+	print_row("words_with_suffix('ing')", measure(runs, 1, noop, [&] {
+				  found += trie.words_with_suffix("ing").size();
+			  }));
+	print_row("suffix 'ing' (indexed)",
+			  measure(runs, 1, noop, [&] {
+				  found += indexed.words_with_suffix("ing").size();
+			  }));
+
+	// Keeps the query results observable so none of the loops is elided.
+	if (found == 0)
+		std::printf("(no query matched)\n");
+}
+
+bool parse_count(const char *text, size_t &out) {
+	char *end = nullptr;
+	const unsigned long long value = std::strtoull(text, &end, 10);
+	if (!text[0] || *end)
+		return false;
+	out = static_cast<size_t>(value);
+	return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		size_t *count = arg == "--runs"		   ? &options.runs
+						: arg == "--words"	   ? &options.generated_words
+						: arg == "--max-words" ? &options.max_words
+											   : nullptr;
+		if (count) {
+			if (i + 1 >= argc || !parse_count(argv[++i], *count) ||
+				(count == &options.runs && *count == 0)) {
+				std::fprintf(stderr, "%s expects a count\n", arg.c_str());
+				return 2;
+			}
+		} else {
+			options.files.push_back(arg);
+		}
+	}
+	const bool defaults = options.files.empty();
+	if (defaults) {
+		options.files = {"./textfiles/enable1.txt", "./textfiles/words.txt",
+						 "./textfiles/terms.txt"};
+	}
+
+	std::printf("Seshat native core benchmarks\n");
+	std::printf("=============================\n");
+	std::printf("%zu timed runs per case after one warm-up; ns/op is the "
+				"median, CV%% the run-to-run spread\n",
+				options.runs);
+
+	run_corpus(generated_corpus(options.generated_words), options);
+	for (const std::string &path : options.files) {
+		Corpus corpus;
+		if (!load_corpus(path, options.max_words, corpus)) {
+			if (!defaults) {
+				std::fprintf(stderr, "Cannot read %s\n", path.c_str());
+				return 1;
+			}
+			continue;
+		}
+		run_corpus(corpus, options);
+	}
+	return 0;
+}
\ No newline at end of file
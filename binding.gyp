@@ -1,15 +1,21 @@
 {
+  "variables": {
+    "seshat_perf_counters%": "false"
+  },
   "targets": [
     {
       "target_name": "seshat",
       "cflags!": [ "-fno-exceptions" ],
       "cflags_cc!": [ "-fno-exceptions" ],
-      "sources": [ "src/Seshat.cc", "src/RadixTrie.cc", "src/RadixNode.cc" ],
+      "sources": [ "src/Seshat.cc", "src/RadixTrie.cc", "src/RadixNode.cc", "src/FlatTrie.cc", "src/Glob.cc", "src/Fuzzy.cc", "src/CaseFold.cc", "src/MappedFile.cc", "src/Arena.cc", "src/ConcurrentTrie.cc", "src/PerfCounters.cc", "src/SuffixIndex.cc" ],
       "include_dirs": [
         "<!@(node -p \"require('node-addon-api').include\")",
         "<(module_root_dir)"                 
       ],
       "libraries": [],
+      "conditions": [
+        [ "seshat_perf_counters=='true'", { "defines": [ "SESHAT_PERF_COUNTERS" ] } ]
+      ],
       "dependencies": [
         "<!(node -p \"require('node-addon-api').gyp\")"
       ],
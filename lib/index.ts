@@ -1,30 +1,164 @@
-import type { Readable } from "stream";
+import { Readable, Writable, pipeline } from "stream";
 
 const native = require("node-gyp-build")(__dirname + "/..");
 
+/** Nodes and children-block bytes for each child list representation, from leaves up to 256-way nodes */
+type ChildKindStats = Record<"leaf" | "single" | "node4" | "node16" | "node48" | "node256", { nodes: number; bytes: number }>;
+
+/** A word and its score, as returned by topK */
+export interface ScoredWord {
+	word: string;
+	score: number;
+}
+
+/** A word near the query, as returned by fuzzySearch */
+export interface FuzzyMatch {
+	word: string;
+	distance: number;
+	score: number;
+}
+
+/** Node depths of the trie's words, as returned by getHeightStats */
+export interface HeightStats {
+	minHeight: number;
+	maxHeight: number;
+	averageHeight: number;
+	modeHeight: number;
+	/** Every word's depth in lexicographic order; only with `{ allHeights: true }` */
+	allHeights?: number[];
+}
+
+/** Latency of one native method, as reported by getPerfCounters; quantiles are within 12.5% */
+export interface MethodLatency {
+	count: number;
+	totalNs: number;
+	minNs: number;
+	maxNs: number;
+	p50Ns: number;
+	p90Ns: number;
+	p99Ns: number;
+	p999Ns: number;
+}
+
+/** Process-wide performance counters, as returned by Seshat.getPerfCounters */
+export interface PerfCounters {
+	/** Whether method timing and bytesMarshalled are being recorded (see setPerfCounters) */
+	enabled: boolean;
+	/** Whether the addon was built with the hot-path counters (`npm run build:perf`); they read 0 otherwise */
+	countersCompiled: boolean;
+	/** Nodes probed for a child or entered by an enumeration */
+	nodesVisited: number;
+	/** Key bytes compared while picking children */
+	childProbes: number;
+	/** Edges split by inserts */
+	splits: number;
+	/** Nodes freed because a remove left them empty */
+	orphanCleanups: number;
+	/** Memory blocks the trie's arena took from the OS or heap */
+	arenaBlocks: number;
+	/** Nodes, child blocks and labels carved from the arena */
+	arenaAllocations: number;
+	/** Bytes of results (strings, Buffers, bitmaps) handed to JS while enabled */
+	bytesMarshalled: number;
+	/** Latency per native method called while enabled, keyed by method name */
+	methods: Record<string, MethodLatency>;
+}
+
+/** Opaque native cursor that holds a prefix walk's DFS stack */
+type PrefixCursorHandle = { readonly __brand: "PrefixCursor" };
+
+/** Opaque native state of a createIngest stream: its partial line and gzip decoder */
+type IngestHandle = { readonly __brand: "Ingest" };
+
+/** A packed word list from the native side: word i spans offsets[i] .. offsets[i + 1] of the bytes */
+type PackedWords = [bytes: Buffer, offsets: Uint32Array];
+
+/** PackedWords with word i's value at values[i], NaN if it has none */
+type PackedEntries = [bytes: Buffer, offsets: Uint32Array, values: Float64Array];
+
+/**
+ * Join words into the native batch format, one Buffer of `\n`-separated words.
+ * Returns null if a word contains `\n` itself and has to cross element by element.
+ */
+function packWords(words: string[]): Buffer | null {
+	return words.some(word => word.includes("\n")) ? null : Buffer.from(words.join("\n"));
+}
+
+/** Expand a native bitmap (word i at bit i % 8 of byte i / 8) into booleans */
+function unpackBits(bitmap: Uint8Array, count: number): boolean[] {
+	const results = new Array<boolean>(count);
+	for (let i = 0; i < count; i++) {
+		results[i] = (bitmap[i >> 3] & (1 << (i & 7))) !== 0;
+	}
+	return results;
+}
+
+/**
+ * Decode a packed word list. ASCII-only results are decoded once and sliced,
+ * since byte offsets are then string offsets too.
+ */
+function unpackWords([bytes, offsets]: PackedWords): string[] {
+	const count = offsets.length - 1;
+	const results = new Array<string>(count);
+	const text = bytes.toString("utf8");
+	const ascii = text.length === bytes.length;
+	for (let i = 0; i < count; i++) {
+		results[i] = ascii ? text.slice(offsets[i], offsets[i + 1]) : bytes.toString("utf8", offsets[i], offsets[i + 1]);
+	}
+	return results;
+}
+
+/** Decode packed entries into [word, value] pairs, as unpackWords does the words */
+function unpackEntries([bytes, offsets, values]: PackedEntries): Array<[string, number | undefined]> {
+	const words = unpackWords([bytes, offsets]);
+	const results = new Array<[string, number | undefined]>(words.length);
+	for (let i = 0; i < words.length; i++) {
+		results[i] = [words[i], Number.isNaN(values[i]) ? undefined : values[i]];
+	}
+	return results;
+}
+
 interface NativeSeshat {
-	insert(word: string): void;
+	insert(word: string, score?: number): void;
 	insertBatch(words: string[]): number;
-	insertFromFile(path: string, bufferSize?: number): number;
-	insertFromFileAsync(path: string, bufferSize: number | undefined, cb: (err: Error | null, count?: number) => void): void;
+	insertFromFile(path: string, bufferSize?: number, threads?: number, assumeSorted?: boolean, scored?: boolean, valued?: boolean): number;
+	insertFromFileAsync(path: string, bufferSize: number | undefined, threads: number | undefined, assumeSorted: boolean | undefined, scored: boolean | undefined, valued: boolean | undefined, cb: (err: Error | null, count?: number) => void): void;
 	search(word: string): boolean;
 	searchBatch(words: string[]): boolean[];
 	startsWith(prefix: string): boolean;
-	wordsWithPrefix(prefix: string): string[];
+	endsWith(suffix: string): boolean;
+	wordsWithSuffix(suffix: string): string[];
+	wordsWithPrefix(prefix: string, limit?: number, offset?: number): string[];
+	wordsWithPrefixAsync(prefix: string, limit?: number, offset?: number): Promise<string[]>;
+	prefixCursor(prefix: string): PrefixCursorHandle;
+	rangeCursor(from: string, to: string | undefined): PrefixCursorHandle;
+	cursorNext(cursor: PrefixCursorHandle, max: number): string[];
+	cursorChunk(cursor: PrefixCursorHandle, bytes: number, withScores: boolean, withValues: boolean): Buffer;
+	topK(prefix: string, k: number): ScoredWord[];
+	fuzzySearch(word: string, maxDistance: number, limit: number): FuzzyMatch[];
+	getScore(word: string): number | undefined;
+	put(word: string, value: number): void;
+	get(word: string): number | undefined;
 	remove(word: string): boolean;
 	removeBatch(words: string[]): boolean[];
+	insertPacked(words: Buffer, count: number): number;
+	searchPacked(words: Buffer, count: number): Uint8Array;
+	removePacked(words: Buffer, count: number): Uint8Array;
+	wordsWithPrefixPacked(prefix: string, limit?: number, offset?: number): PackedWords;
+	entriesWithPrefixPacked(prefix: string, limit?: number, offset?: number): PackedEntries;
+	lowerBound(word: string): string | undefined;
+	rangePacked(from: string, to: string | undefined, limit: number | undefined, offset: number | undefined, withValues: false): PackedWords;
+	rangePacked(from: string, to: string | undefined, limit: number | undefined, offset: number | undefined, withValues: true): PackedEntries;
+	rank(word: string): number;
+	select(index: number): string | undefined;
+	patternSearchPacked(pattern: string): PackedWords;
+	searchFromBuffer(buffer: Buffer): Uint8Array;
 	empty(): boolean;
 	size(): number;
 	clear(): void;
   
 	  // Analytics methods
-	  getHeightStats(): {
-		  minHeight: number;
-		  maxHeight: number;
-		  averageHeight: number;
-		  modeHeight: number;
-		  allHeights: number[];
-	  };
+	  getHeightStats(allHeights?: boolean): HeightStats;
 	  getMemoryStats(): {
 		  totalBytes: number;
 		  nodeCount: number;
@@ -32,8 +166,15 @@ interface NativeSeshat {
 		  structBytes: number;
 		  childBufferBytes: number;
 		  stringBufferBytes: number;
+		  casingBytes: number;
+		  arenaBytes: number;
+		  labelPoolBytes: number;
+		  reclaimedBytes: number;
+		  suffixIndexBytes: number;
+		  rankIndexBytes: number;
 		  overheadBytes: number;
 		  bytesPerWord: number;
+		  childKinds: ChildKindStats;
 	  };
 	  getWordMetrics(): {
 		  minLength: number;
@@ -43,10 +184,32 @@ interface NativeSeshat {
 		  lengthDistribution: number[];
 		  totalCharacters: number;
 	  };
+	  getHeightStatsAsync(allHeights?: boolean): Promise<HeightStats>;
+	  getWordMetricsAsync(): Promise<ReturnType<NativeSeshat["getWordMetrics"]>>;
 	  patternSearch(pattern: string): string[];
-	  insertFromBuffer(buffer: Buffer): number;
+	  patternSearchAsync(pattern: string): Promise<string[]>;
+	  insertFromBuffer(buffer: Buffer, threads?: number, assumeSorted?: boolean, scored?: boolean, valued?: boolean): number;
+	  createIngest(gzip: boolean | undefined, assumeSorted?: boolean, scored?: boolean, valued?: boolean): IngestHandle;
+	  ingestWrite(ingest: IngestHandle, chunks: Buffer[], cb: (err: Error | null, count?: number) => void): void;
+	  ingestEnd(ingest: IngestHandle, cb: (err: Error | null, count?: number) => void): void;
 	  removeFromBuffer(buffer: Buffer): number;
-	  toBuffer(): Buffer;
+	  merge(other: NativeSeshat): number;
+	  subtract(other: NativeSeshat): number;
+	  intersect(other: NativeSeshat): number;
+	  diff(other: NativeSeshat, withScores?: boolean): Buffer;
+	  toBuffer(withScores?: boolean, withValues?: boolean): Buffer;
+	  toBufferAsync(withScores?: boolean, withValues?: boolean): Promise<Buffer>;
+	  writeToFile(path: string, withScores?: boolean, withValues?: boolean): number;
+	  writeToFileAsync(path: string, withScores?: boolean, withValues?: boolean): Promise<number>;
+	  toSnapshot(): Buffer;
+	  loadSnapshot(buffer: Buffer): void;
+	  loadSnapshotFile(path: string): void;
+	  freeze(): void;
+	  thaw(): void;
+	  compact(): number;
+	  isFrozen(): boolean;
+	  share(name: string): void;
+	  ignoresCase(): boolean;
 }
 
 
@@ -61,19 +224,202 @@ export interface SeshatOptions {
 	words?: string[];
 
 	/**
-	 * Whether to ignore case when inserting/searching
+	 * Whether to ignore case when inserting/searching. Words are folded to
+	 * lower case natively (ASCII plus the common Latin, Greek, Cyrillic and
+	 * Armenian case pairs), including on the Buffer paths, and each word is
+	 * reported with the casing it was last inserted with.
 	 * @default false
 	 */
 	ignoreCase?: boolean;
 
 	/**
 	 * Maximum number of words the trie will hold.
-	 * Insertions that would exceed this limit throw an Error.
+	 * Insertions that would exceed this limit throw an Error. Only insert,
+	 * set and insertBatch check it; the bulk loads and merge do not.
 	 * @default undefined (no limit)
 	 */
 	maxSize?: number;
+
+	/**
+	 * Whether reads may overlap writes. The native side then keeps two copies
+	 * of the trie and publishes each update atomically, so async queries keep
+	 * answering during insertFromFileAsync, and a write issued while a query
+	 * is only queued goes ahead instead of throwing "Trie is busy". Reads
+	 * never wait, and a write never waits for an async query: it throws
+	 * "Trie is busy" while one is running on a worker thread. Costs twice the
+	 * memory and makes every write do its work twice.
+	 * @default false
+	 */
+	concurrent?: boolean;
+
+	/**
+	 * Whether to keep a suffix index: the words reversed, in a second trie
+	 * that inserts and removes keep in step, plus a trigram index for
+	 * literals inside a pattern. endsWith, getWordsWithSuffix and
+	 * patternSearch with a leading wildcard then descend to their matches
+	 * instead of visiting every word. Costs about the trie's memory again,
+	 * more once the trigram index is built, and that index is rebuilt on the
+	 * first infix pattern after any change, so it suits tries that are read
+	 * far more than written.
+	 * @default false
+	 */
+	suffixIndex?: boolean;
   }
   
+/**
+ * Options for getWordsWithPrefix
+ */
+export interface PrefixQueryOptions {
+	/**
+	 * Maximum number of words to return. The native walk stops as soon as it
+	 * has this many, so a small limit stays cheap even for a short prefix.
+	 * @default Infinity
+	 */
+	limit?: number;
+
+	/**
+	 * Number of matching words to skip before collecting, for paging through
+	 * results in lexicographic order
+	 * @default 0
+	 */
+	offset?: number;
+}
+
+/**
+ * Options for the bulk loaders (insertFromFile, insertFromFileAsync, insertFromBuffer)
+ */
+export interface BulkLoadOptions {
+	/**
+	 * Buffer size in bytes for file streaming (file loaders only). Regular
+	 * files are memory-mapped whole and split in place, so it only applies to
+	 * paths that cannot be mapped, such as named pipes and devices.
+	 * @default 1MB
+	 */
+	bufferSize?: number;
+
+	/**
+	 * Number of threads that build the trie, from 1 to 1024. Each thread owns
+	 * a range of leading bytes, so input that mostly starts with the same
+	 * character gains little. Inputs under 256KB always load on one thread.
+	 * @default 1
+	 */
+	threads?: number;
+
+	/**
+	 * Set when the lines are already in ascending byte order, as toBuffer()
+	 * writes them. Each word is then appended along the trie's rightmost
+	 * path instead of being looked up from the root. Lines that turn out to
+	 * be out of order are still inserted correctly, just without the shortcut.
+	 * @default false
+	 */
+	assumeSorted?: boolean;
+
+	/**
+	 * Set when each line is `word<TAB>score`, as toBuffer({ withScores: true })
+	 * writes them. The score (an integer from 0 to 4294967295) replaces the
+	 * word's current one; a line without a tab is a plain word. A score that
+	 * is not such an integer fails the load.
+	 * @default false
+	 */
+	scored?: boolean;
+
+	/**
+	 * Set when each line ends in a tab and a value, as
+	 * toBuffer({ withValues: true }) writes them: `word<TAB>value`, or
+	 * `word<TAB>score<TAB>value` together with scored. The value (an integer
+	 * from 0 to 2^64 - 1) replaces the word's current one; a line without the
+	 * field leaves it alone. A value that is not such an integer fails the load.
+	 * @default false
+	 */
+	valued?: boolean;
+  }
+
+/**
+ * Options for createIngest and insertFromStream
+ */
+export interface IngestOptions {
+	/**
+	 * Whether the input is gzip-compressed. Left unset, it is recognized by
+	 * its first two bytes, which no UTF-8 text starts with.
+	 */
+	gzip?: boolean;
+
+	/** As in BulkLoadOptions: the lines are in ascending byte order */
+	assumeSorted?: boolean;
+
+	/** As in BulkLoadOptions: each line is `word<TAB>score` */
+	scored?: boolean;
+
+	/** As in BulkLoadOptions: each line ends in `<TAB>value` */
+	valued?: boolean;
+
+	/**
+	 * Bytes the stream buffers while the trie is busy with earlier chunks
+	 * before write() returns false.
+	 * @default 1MB
+	 */
+	highWaterMark?: number;
+}
+
+/**
+ * A Writable that inserts newline-delimited text into a trie, returned by
+ * {@link Seshat.createIngest}. Chunks are split into lines on a libuv worker
+ * thread, and a line cut across chunks is held natively until it is whole.
+ * Chunks that arrive while a batch is being inserted queue up and go down
+ * together as the next batch, and write() returns false once the queue
+ * passes highWaterMark, so a piped source slows to the trie's pace.
+ */
+export class TrieIngest extends Writable {
+	private inserted = 0;
+
+	/** @internal */
+	constructor(
+		private readonly nativeTrie: NativeSeshat,
+		private readonly handle: IngestHandle,
+		highWaterMark: number,
+	) {
+		super({ highWaterMark });
+	}
+
+	/** Words inserted so far; the total once the stream has finished */
+	get count(): number {
+		return this.inserted;
+	}
+
+	_write(chunk: Buffer, _encoding: BufferEncoding, callback: (error?: Error | null) => void): void {
+		this.send([chunk], callback);
+	}
+
+	_writev(chunks: Array<{ chunk: Buffer }>, callback: (error?: Error | null) => void): void {
+		this.send(chunks.map(entry => entry.chunk), callback);
+	}
+
+	_final(callback: (error?: Error | null) => void): void {
+		this.settle(cb => this.nativeTrie.ingestEnd(this.handle, cb), callback);
+	}
+
+	private send(chunks: Buffer[], callback: (error?: Error | null) => void): void {
+		this.settle(cb => this.nativeTrie.ingestWrite(this.handle, chunks, cb), callback);
+	}
+
+	// The native calls throw when the trie is busy; that fails the stream too
+	private settle(
+		call: (cb: (err: Error | null, count?: number) => void) => void,
+		callback: (error?: Error | null) => void,
+	): void {
+		try {
+			call((err, count) => {
+				if (!err) {
+					this.inserted = count!;
+				}
+				callback(err);
+			});
+		} catch (error) {
+			callback(error instanceof Error ? error : new Error(String(error)));
+		}
+	}
+}
+
 /**
    * Statistics about the trie
    */
@@ -108,7 +454,6 @@ export class Seshat {
 	  private readonly nativeTrie: NativeSeshat;
 	  private readonly ignoreCase: boolean;
 	  private readonly maxSize: number | undefined;
-	  private readonly originalCasing: Map<string, string> = new Map();
   
 	  /**
 	 * Create a new Seshat instance
@@ -116,8 +461,8 @@ export class Seshat {
 	 * @param options - Configuration options
 	 */
 	  constructor(options: SeshatOptions = {}) {
-		  this.nativeTrie = new native.Seshat();
 		  this.ignoreCase = options.ignoreCase ?? false;
+		  this.nativeTrie = new native.Seshat(this.ignoreCase, options.concurrent ?? false, options.suffixIndex ?? false);
 		  this.maxSize = options.maxSize;
   
 		  // Insert initial words if provided
@@ -130,23 +475,31 @@ export class Seshat {
   
 	  /**
 	   * Get height statistics for the trie
-	   * @remarks This performs a full O(n) traversal of the trie. Avoid calling frequently on large tries.
-	   * @returns Object with minHeight, maxHeight, averageHeight, modeHeight, allHeights
-	   */
-	  getHeightStats(): {
-		  minHeight: number;
-		  maxHeight: number;
-		  averageHeight: number;
-		  modeHeight: number;
-		  allHeights: number[];
-		  } {
-		  return this.nativeTrie.getHeightStats();
+	   * @remarks Read off a depth histogram that mutations keep current, so the cost tracks the
+	   * trie's height rather than its size. An insert that splits an edge pushes every word below
+	   * it a level down; the next call after such a split rebuilds the histogram with one walk.
+	   * @param options - Set `allHeights` to also list every word's depth, which needs a full walk
+	   * @returns Object with minHeight, maxHeight, averageHeight, modeHeight, and allHeights if asked for
+	   */
+	  getHeightStats(options: { allHeights?: boolean } = {}): HeightStats {
+		  return this.nativeTrie.getHeightStats(options.allHeights === true);
+	  }
+
+	  /**
+	   * getHeightStats computed on a worker thread; see {@link Seshat.getWordsWithPrefixAsync} for the concurrency rules
+	   */
+	  async getHeightStatsAsync(options: { allHeights?: boolean } = {}): Promise<HeightStats> {
+		  return this.nativeTrie.getHeightStatsAsync(options.allHeights === true);
 	  }
   
 	  /**
 	   * Get memory usage statistics for the trie
-	   * @remarks This performs a full O(n) traversal of the trie. Avoid calling frequently on large tries.
-	   * @returns Object with totalBytes, nodeCount, stringBytes, structBytes, childBufferBytes, stringBufferBytes, overheadBytes, bytesPerWord
+	   * @remarks Read off counters that mutations keep current, without visiting the nodes.
+	   * @returns Object with totalBytes, nodeCount, stringBytes, structBytes, childBufferBytes, stringBufferBytes,
+	   * casingBytes (original spellings kept by an ignoreCase trie), arenaBytes, labelPoolBytes,
+	   * reclaimedBytes (arena and spelling bytes compact() has given back, summed over the trie's lifetime),
+	   * suffixIndexBytes and rankIndexBytes (neither counted in totalBytes), overheadBytes, bytesPerWord,
+	   * and childKinds: node count and children-block bytes for each child list representation
 	   */
 	  getMemoryStats(): {
 		  totalBytes: number;
@@ -155,15 +508,22 @@ export class Seshat {
 		  structBytes: number;
 		  childBufferBytes: number;
 		  stringBufferBytes: number;
+		  casingBytes: number;
+		  arenaBytes: number;
+		  labelPoolBytes: number;
+		  reclaimedBytes: number;
+		  suffixIndexBytes: number;
+		  rankIndexBytes: number;
 		  overheadBytes: number;
 		  bytesPerWord: number;
+		  childKinds: ChildKindStats;
 		  } {
 		  return this.nativeTrie.getMemoryStats();
 	  }
   
 	  /**
 	   * Get word metrics for the trie
-	   * @remarks This performs a full O(n) traversal of the trie. Avoid calling frequently on large tries.
+	   * @remarks Read off a word-length histogram that mutations keep current, without visiting the nodes.
 	   * @returns Object with minLength, maxLength, averageLength, modeLength, lengthDistribution, totalCharacters
 	   */
 	  getWordMetrics(): {
@@ -176,10 +536,22 @@ export class Seshat {
 		  } {
 		  return this.nativeTrie.getWordMetrics();
 	  }
+
+	  /**
+	   * getWordMetrics computed on a worker thread; see {@link Seshat.getWordsWithPrefixAsync} for the concurrency rules
+	   */
+	  async getWordMetricsAsync(): Promise<ReturnType<Seshat["getWordMetrics"]>> {
+		  return this.nativeTrie.getWordMetricsAsync();
+	  }
   
 	  /**
 	   * Search for words matching a pattern (supports * and ? wildcards)
-	   * @remarks This performs a full O(n) traversal of the trie. Avoid calling frequently on large tries.
+	   * @remarks The pattern is compiled into a small automaton that is run along the edges, so only
+	   * subtrees that can still match are visited: a literal prefix narrows the walk to its subtree, and
+	   * a pattern without `*` never descends past its own length. A leading wildcard visits every node,
+	   * unless the trie has a suffix index: then a pattern ending in a literal runs on the reversed words,
+	   * and one holding a literal of three or more bytes checks only the words with its trigrams.
+	   * `?` matches a single byte of the UTF-8 encoding.
 	   * @param pattern - Pattern string with wildcards
 	   * @returns Array of matching words
 	   */
@@ -187,22 +559,19 @@ export class Seshat {
 		  if (typeof pattern !== "string") {
 			  throw new TypeError("Pattern must be a string");
 		  }
-		  const normalizedPattern = this.ignoreCase ? pattern.toLowerCase() : pattern;
-		  const results = this.nativeTrie.patternSearch(normalizedPattern);
-		  if (this.ignoreCase) {
-			  return results.map(word => this.originalCasing.get(word) ?? word);
-		  }
-		  return results;
+		  return unpackWords(this.nativeTrie.patternSearchPacked(pattern));
 	  }
-  
+
 	  /**
-	 * Normalize a word based on case sensitivity settings
-	 */
-	  private normalizeWord(word: string): string {
-		  if (typeof word !== "string") {
-			  throw new TypeError("Word must be a string");
+	   * patternSearch run on a worker thread; see {@link Seshat.getWordsWithPrefixAsync} for the concurrency rules
+	   * @param pattern - Pattern string with wildcards
+	   * @returns Promise of the matching words
+	   */
+	  async patternSearchAsync(pattern: string): Promise<string[]> {
+		  if (typeof pattern !== "string") {
+			  throw new TypeError("Pattern must be a string");
 		  }
-		  return this.ignoreCase ? word.toLowerCase() : word;
+		  return this.nativeTrie.patternSearchAsync(pattern);
 	  }
   
 	  private checkCapacity(additionalWords: number = 1): void {
@@ -222,28 +591,206 @@ export class Seshat {
 			  throw new Error("Word cannot be empty or whitespace only");
 		  }
 	  }
+
+	  /**
+	 * Check an optional count option (a limit or offset) is a non-negative integer or Infinity
+	 */
+	  private validateCount(value: number | undefined, name: string): void {
+		  if (value === undefined || value === Infinity) {
+			  return;
+		  }
+		  if (!Number.isInteger(value) || value < 0) {
+			  throw new RangeError(`${name} must be a non-negative integer`);
+		  }
+	  }
+
+	  /**
+	 * Check the bounds of a range query: a string and an optional string
+	 */
+	  private validateRange(from: string, to: string | undefined): void {
+		  if (typeof from !== "string") {
+			  throw new TypeError("Range start must be a string");
+		  }
+		  if (to !== undefined && typeof to !== "string") {
+			  throw new TypeError("Range end must be a string");
+		  }
+	  }
+
+	  /**
+	 * Normalize the bulk loaders' options argument, which may also be a bare buffer size
+	 */
+	  private resolveBulkLoadOptions(options: number | BulkLoadOptions | undefined): BulkLoadOptions {
+		  if (options !== undefined && typeof options !== "number" && (typeof options !== "object" || options === null)) {
+			  throw new Error("Buffer size must be a positive number");
+		  }
+		  const resolved: BulkLoadOptions = typeof options === "number" ? { bufferSize: options } : { ...options };
+
+		  if (resolved.bufferSize !== undefined) {
+			  if (typeof resolved.bufferSize !== "number" || resolved.bufferSize <= 0) {
+				  throw new Error("Buffer size must be a positive number");
+			  }
+		  }
+
+		  if (resolved.threads !== undefined) {
+			  if (!Number.isInteger(resolved.threads) || resolved.threads < 1 || resolved.threads > 1024) {
+				  throw new RangeError("Thread count must be an integer from 1 to 1024");
+			  }
+		  }
+
+		  if (resolved.assumeSorted !== undefined && typeof resolved.assumeSorted !== "boolean") {
+			  throw new TypeError("assumeSorted must be a boolean");
+		  }
+
+		  if (resolved.scored !== undefined && typeof resolved.scored !== "boolean") {
+			  throw new TypeError("scored must be a boolean");
+		  }
+
+		  if (resolved.valued !== undefined && typeof resolved.valued !== "boolean") {
+			  throw new TypeError("valued must be a boolean");
+		  }
+
+		  return resolved;
+	  }
   
 	  /**
 	 * Insert a word into the trie
 	 *
 	 * @param word - The word to insert
+	 * @param score - Optional weight for {@link topK}, an integer from 0 to 4294967295.
+	 *   It replaces any earlier score; without one, a new word scores 0 and an
+	 *   existing word keeps its score.
 	 * @throws {TypeError} If word is not a string
 	 * @throws {Error} If word is empty or whitespace only
+	 * @throws {RangeError} If score is not an integer from 0 to 4294967295
 	 *
 	 * @example
 	 * ```typescript
 	 * trie.insert('hello');
-	 * trie.insert('world');
+	 * trie.insert('world', 42);
+	 * ```
+	 */
+	  insert(word: string, score?: number): void {
+		  this.validateWord(word);
+		  this.checkCapacity();
+		  this.nativeTrie.insert(word, score);
+	  }
+
+	  /**
+	 * Get the score of a word
+	 *
+	 * @param word - The word to look up
+	 * @returns The word's score (0 if none was given), or undefined if the word is not in the trie
+	 * @throws {TypeError} If word is not a string
+	 */
+	  getScore(word: string): number | undefined {
+		  if (typeof word !== "string") {
+			  throw new TypeError("Word must be a string");
+		  }
+		  return this.nativeTrie.getScore(word);
+	  }
+
+	  /**
+	 * Insert a word if needed and set its value, replacing any earlier one,
+	 * which makes the trie a map from words to IDs (or offsets into storage of
+	 * your own). Values are kept per word beside the trie, so words without
+	 * one cost nothing, and they survive snapshots, freeze and the set
+	 * operations. A word's score is separate and left alone.
+	 *
+	 * @param word - The word to insert
+	 * @param value - An integer from 0 to Number.MAX_SAFE_INTEGER
+	 * @throws {TypeError} If word is not a string
+	 * @throws {Error} If word is empty or whitespace only
+	 * @throws {RangeError} If value is not such an integer
+	 *
+	 * @example
+	 * ```typescript
+	 * trie.set('apple', 17);
+	 * console.log(trie.get('apple')); // 17
 	 * ```
 	 */
-	  insert(word: string): void {
+	  set(word: string, value: number): void {
 		  this.validateWord(word);
+		  if (!Number.isSafeInteger(value) || value < 0) {
+			  throw new RangeError("Value must be an integer from 0 to Number.MAX_SAFE_INTEGER");
+		  }
 		  this.checkCapacity();
-		  const normalizedWord = this.normalizeWord(word);
-		  this.nativeTrie.insert(normalizedWord);
-		  if (this.ignoreCase) {
-			  this.originalCasing.set(normalizedWord, word);
+		  this.nativeTrie.put(word, value);
+	  }
+
+	  /**
+	 * Get the value of a word
+	 *
+	 * @param word - The word to look up
+	 * @returns The word's value, or undefined if it has none or is not in the
+	 *   trie. Values above Number.MAX_SAFE_INTEGER, which only a bulk load
+	 *   can set, come back rounded.
+	 * @throws {TypeError} If word is not a string
+	 */
+	  get(word: string): number | undefined {
+		  if (typeof word !== "string") {
+			  throw new TypeError("Word must be a string");
+		  }
+		  return this.nativeTrie.get(word);
+	  }
+
+	  /**
+	 * Get the k highest-scoring words that start with the given prefix, best
+	 * first, with equal scores in lexicographic order. Every node caches the
+	 * highest score below it, so the search only descends into subtrees that
+	 * can still make the top k, and short prefixes stay cheap.
+	 *
+	 * @param prefix - The prefix to search for
+	 * @param k - Maximum number of words to return (default 10)
+	 * @returns Up to k words with their scores
+	 * @throws {TypeError} If prefix is not a string
+	 * @throws {RangeError} If k is not a non-negative integer
+	 *
+	 * @example
+	 * ```typescript
+	 * trie.insert('hello', 5);
+	 * trie.insert('help', 9);
+	 * trie.insert('helm', 1);
+	 * console.log(trie.topK('hel', 2)); // [{ word: 'help', score: 9 }, { word: 'hello', score: 5 }]
+	 * ```
+	 */
+	  topK(prefix: string, k: number = 10): ScoredWord[] {
+		  if (typeof prefix !== "string") {
+			  throw new TypeError("Prefix must be a string");
+		  }
+		  this.validateCount(k, "k");
+
+		  return this.nativeTrie.topK(prefix, k);
+	  }
+
+	  /**
+	 * Find the words closest to `word` by edit distance: the number of byte
+	 * insertions, deletions and substitutions that turn one into the other.
+	 * The native walk carries one Levenshtein row per depth along the edges
+	 * and skips every subtree that cannot come within `maxDistance`.
+	 *
+	 * @param word - The word to match, typically a misspelling
+	 * @param maxDistance - Largest edit distance to accept (default 2)
+	 * @param limit - Maximum number of suggestions to return (default 10)
+	 * @returns Up to limit words, closest first, then by score (highest
+	 *   first), then in lexicographic order
+	 * @throws {TypeError} If word is not a string
+	 * @throws {RangeError} If maxDistance or limit is not a non-negative integer
+	 *
+	 * @example
+	 * ```typescript
+	 * trie.insertBatch(['hello', 'help', 'world']);
+	 * console.log(trie.fuzzySearch('helo', 1));
+	 * // [{ word: 'hello', distance: 1, score: 0 }, { word: 'help', distance: 1, score: 0 }]
+	 * ```
+	 */
+	  fuzzySearch(word: string, maxDistance: number = 2, limit: number = 10): FuzzyMatch[] {
+		  if (typeof word !== "string") {
+			  throw new TypeError("Word must be a string");
 		  }
+		  this.validateCount(maxDistance, "maxDistance");
+		  this.validateCount(limit, "limit");
+
+		  return this.nativeTrie.fuzzySearch(word, maxDistance, limit);
 	  }
   
 	  /**
@@ -270,15 +817,10 @@ export class Seshat {
 		  }
 		  this.checkCapacity(words.length);
 
-		  const normalizedWords = words.map(word => this.normalizeWord(word));
-
-		  if (this.ignoreCase) {
-			  for (let i = 0; i < words.length; i++) {
-				  this.originalCasing.set(normalizedWords[i], words[i]);
-			  }
-		  }
-
-		  return this.nativeTrie.insertBatch(normalizedWords);
+		  const packed = packWords(words);
+		  return packed
+			  ? this.nativeTrie.insertPacked(packed, words.length)
+			  : this.nativeTrie.insertBatch(words);
 	  }
   
 	  /**
@@ -286,9 +828,10 @@ export class Seshat {
 	   * This is highly efficient for large files as it processes them in chunks
 	   *
 	   * @param filePath - Path to the text file containing words (one per line)
-	   * @param bufferSize - Buffer size in bytes for file streaming (default: 1MB)
+	   * @param options - Buffer size in bytes for file streaming (default: 1MB), or BulkLoadOptions
 	   * @returns Number of words successfully inserted
 	   * @throws {TypeError} If filePath is not a string
+	   * @throws {RangeError} If threads is not an integer from 1 to 1024
 	   * @throws {Error} If file cannot be read or buffer size is invalid
 	   *
 	   * @example
@@ -299,21 +842,20 @@ export class Seshat {
 	   * // Insert from file with custom 1KB buffer
 	   * const count2 = trie.insertFromFile('./words.txt', 1024);
 	   * console.log(`Inserted ${count2} words`);
+	   *
+	   * // Build with four threads
+	   * const count3 = trie.insertFromFile('./words.txt', { threads: 4 });
 	   * ```
 	   */
-	  insertFromFile(filePath: string, bufferSize?: number): number {
+	  insertFromFile(filePath: string, options?: number | BulkLoadOptions): number {
 		  if (typeof filePath !== "string") {
 			  throw new TypeError("File path must be a string");
 		  }
   
-		  if (bufferSize !== undefined) {
-			  if (typeof bufferSize !== "number" || bufferSize <= 0) {
-				  throw new Error("Buffer size must be a positive number");
-			  }
-		  }
+		  const { bufferSize, threads, assumeSorted, scored, valued } = this.resolveBulkLoadOptions(options);
   
 		  try {
-			  return this.nativeTrie.insertFromFile(filePath, bufferSize);
+			  return this.nativeTrie.insertFromFile(filePath, bufferSize, threads, assumeSorted, scored, valued);
 		  } catch (error) {
 			  if (error instanceof Error) {
 				  throw new Error(`Failed to insert from file: ${error.message}`, { cause: error });
@@ -325,37 +867,33 @@ export class Seshat {
 	  /**
 	   * Async insert from file. Uses a Node-style callback to avoid blocking the event loop.
 	   * @param filePath Path to file with one word per line
-	   * @param bufferSize Optional buffer size in bytes (default 1MB)
+	   * @param options Optional buffer size in bytes (default 1MB), or BulkLoadOptions
 	   * @param cb Callback (err, count)
 	   */
 	  insertFromFileAsync(filePath: string, cb: (err: Error | null, count?: number) => void): void;
-	  insertFromFileAsync(filePath: string, bufferSize: number, cb: (err: Error | null, count?: number) => void): void;
-	  insertFromFileAsync(filePath: string, bufferSizeOrCb: number | ((err: Error | null, count?: number) => void), cb?: (err: Error | null, count?: number) => void): void {
+	  insertFromFileAsync(filePath: string, options: number | BulkLoadOptions, cb: (err: Error | null, count?: number) => void): void;
+	  insertFromFileAsync(filePath: string, optionsOrCb: number | BulkLoadOptions | ((err: Error | null, count?: number) => void), cb?: (err: Error | null, count?: number) => void): void {
 		  if (typeof filePath !== "string") {
 			  throw new TypeError("File path must be a string");
 		  }
 
-		  let bufferSize: number | undefined;
+		  let options: number | BulkLoadOptions | undefined;
 		  let callback: (err: Error | null, count?: number) => void;
 
-		  if (typeof bufferSizeOrCb === "function") {
-			  callback = bufferSizeOrCb;
+		  if (typeof optionsOrCb === "function") {
+			  callback = optionsOrCb;
 		  } else {
-			  bufferSize = bufferSizeOrCb;
+			  options = optionsOrCb;
 			  if (typeof cb !== "function") {
 				  throw new TypeError("Callback function is required");
 			  }
 			  callback = cb;
 		  }
 
-		  if (bufferSize !== undefined) {
-			  if (typeof bufferSize !== "number" || bufferSize <= 0) {
-				  throw new Error("Buffer size must be a positive number");
-			  }
-		  }
+		  const { bufferSize, threads, assumeSorted, scored, valued } = this.resolveBulkLoadOptions(options);
 
 		  try {
-			  this.nativeTrie.insertFromFileAsync(filePath, bufferSize, callback);
+			  this.nativeTrie.insertFromFileAsync(filePath, bufferSize, threads, assumeSorted, scored, valued, callback);
 		  } catch (error) {
 			  if (error instanceof Error) {
 				  throw new Error(`Failed to schedule insertFromFileAsync: ${error.message}`, { cause: error });
@@ -370,8 +908,10 @@ export class Seshat {
 	   * comparable to insertFromFile but from in-memory data.
 	   *
 	   * @param buffer - Buffer containing newline-delimited words
+	   * @param options - Optional BulkLoadOptions (threads, assumeSorted, scored and valued apply)
 	   * @returns Number of words successfully inserted
 	   * @throws {TypeError} If buffer is not a Buffer
+	   * @throws {RangeError} If threads is not an integer from 1 to 1024
 	   *
 	   * @example
 	   * ```typescript
@@ -380,11 +920,12 @@ export class Seshat {
 	   * console.log(`Inserted ${count} words`);
 	   * ```
 	   */
-	  insertFromBuffer(buffer: Buffer): number {
+	  insertFromBuffer(buffer: Buffer, options: BulkLoadOptions = {}): number {
 		  if (!Buffer.isBuffer(buffer)) {
 			  throw new TypeError("Argument must be a Buffer");
 		  }
-		  return this.nativeTrie.insertFromBuffer(buffer);
+		  const { threads, assumeSorted, scored, valued } = this.resolveBulkLoadOptions(options);
+		  return this.nativeTrie.insertFromBuffer(buffer, threads, assumeSorted, scored, valued);
 	  }
 
 	  /**
@@ -393,9 +934,7 @@ export class Seshat {
 	   * to delete a large set of words in one call. It is the removal counterpart
 	   * to {@link insertFromBuffer}.
 	   *
-	   * Note: like insertFromBuffer, this operates on the raw buffer bytes and does
-	   * NOT apply case-normalization. In an `ignoreCase` trie, pass words in their
-	   * normalized (lower-case) form to match what is stored.
+	   * In an `ignoreCase` trie the words are case-folded natively, as in {@link remove}.
 	   *
 	   * @param buffer - Buffer containing newline-delimited words to remove
 	   * @returns Number of words actually removed (words not present are skipped)
@@ -412,113 +951,508 @@ export class Seshat {
 		  if (!Buffer.isBuffer(buffer)) {
 			  throw new TypeError("Argument must be a Buffer");
 		  }
-		  const removed = this.nativeTrie.removeFromBuffer(buffer);
-		  // In ignoreCase mode the originalCasing map is keyed by normalized words;
-		  // we cannot know which keys were removed without re-parsing, so callers
-		  // using ignoreCase should prefer removeBatch for casing-aware cleanup.
-		  return removed;
+		  return this.nativeTrie.removeFromBuffer(buffer);
 	  }
 
 	  /**
-	   * Insert words from a Readable stream of newline-delimited text.
-	   * Chunks are processed through the native insertFromBuffer as they arrive,
-	   * with automatic handling of words split across chunk boundaries.
+	   * Add every word of another trie to this one, with its score and
+	   * spelling. Words already here keep theirs. Both tries are walked
+	   * together natively, so the cost follows how much of the other trie is
+	   * new here rather than how many words it holds. maxSize is not enforced:
+	   * like the bulk loads, a merge may take the trie past it.
 	   *
-	   * @param stream - A Readable stream providing newline-delimited words
-	   * @returns Promise resolving to the total number of words inserted
+	   * @param other - The trie to merge in; it is left unchanged
+	   * @returns Number of words added
+	   * @throws {TypeError} If other is not a Seshat
+	   * @throws {Error} If only one of the tries ignores case
 	   *
 	   * @example
 	   * ```typescript
-	   * import { createReadStream } from 'fs';
-	   *
-	   * const count = await trie.insertFromStream(createReadStream('words.txt'));
-	   * console.log(`Inserted ${count} words`);
+	   * const a = new Seshat({ words: ['apple', 'banana'] });
+	   * const b = new Seshat({ words: ['banana', 'cherry'] });
+	   * a.merge(b); // 1
 	   * ```
 	   */
-	  insertFromStream(stream: Readable): Promise<number> {
-		  return new Promise((resolve, reject) => {
-			  let carry: Buffer<ArrayBufferLike> = Buffer.alloc(0);
-			  let totalInserted = 0;
-
-			  stream.on("data", (chunk: Buffer | string) => {
-				  const buf: Buffer<ArrayBufferLike> = Buffer.isBuffer(chunk)
-					  ? chunk
-					  : Buffer.from(chunk);
-				  const combined = carry.length > 0
-					  ? Buffer.concat([carry, buf])
-					  : buf;
-
-				  let lastNewline = -1;
-				  for (let i = combined.length - 1; i >= 0; i--) {
-					  if (combined[i] === 0x0a || combined[i] === 0x0d) {
-						  lastNewline = i;
-						  break;
-					  }
-				  }
-
-				  if (lastNewline === -1) {
-					  carry = combined;
-					  return;
-				  }
-
-				  const toProcess = combined.subarray(0, lastNewline + 1);
-				  carry = combined.subarray(lastNewline + 1);
-
-				  totalInserted += this.nativeTrie.insertFromBuffer(toProcess);
-			  });
+	  merge(other: Seshat): number {
+		  return this.nativeTrie.merge(this.operand(other));
+	  }
 
-			  stream.on("end", () => {
-				  if (carry.length > 0) {
-					  totalInserted += this.nativeTrie.insertFromBuffer(carry);
-				  }
-				  resolve(totalInserted);
-			  });
+	  /**
+	   * Remove every word that another trie also holds
+	   *
+	   * @param other - The trie whose words to remove; it is left unchanged
+	   * @returns Number of words removed
+	   * @throws {TypeError} If other is not a Seshat
+	   * @throws {Error} If only one of the tries ignores case
+	   */
+	  subtract(other: Seshat): number {
+		  return this.nativeTrie.subtract(this.operand(other));
+	  }
 
-			  stream.on("error", (err: Error) => {
-				  reject(err);
-			  });
-		  });
+	  /**
+	   * Remove every word that another trie does not hold
+	   *
+	   * @param other - The trie to intersect with; it is left unchanged
+	   * @returns Number of words removed
+	   * @throws {TypeError} If other is not a Seshat
+	   * @throws {Error} If only one of the tries ignores case
+	   */
+	  intersect(other: Seshat): number {
+		  return this.nativeTrie.intersect(this.operand(other));
 	  }
 
 	  /**
-	   * Serialize the trie to a Buffer of newline-delimited words.
-	   * This performs serialization entirely in C++, avoiding per-word N-API
-	   * overhead and JSON stringify costs.
+	   * The words of this trie that another does not hold, as a
+	   * newline-delimited Buffer in the format and order of {@link toBuffer}.
+	   * Neither trie is changed.
 	   *
-	   * @returns Buffer containing newline-delimited words
+	   * @param other - The trie to compare against
+	   * @param options.withScores - Append each word's score after a tab
+	   * @returns Buffer of the words only this trie holds
+	   * @throws {TypeError} If other is not a Seshat
+	   * @throws {Error} If only one of the tries ignores case
 	   *
 	   * @example
 	   * ```typescript
-	   * const buf = trie.toBuffer();
-	   * fs.writeFileSync('words.dat', buf);
+	   * const a = new Seshat({ words: ['apple', 'banana'] });
+	   * const b = new Seshat({ words: ['banana'] });
+	   * a.diff(b).toString(); // 'apple\n'
 	   * ```
 	   */
-	  toBuffer(): Buffer {
-		  return this.nativeTrie.toBuffer();
+	  diff(other: Seshat, options: { withScores?: boolean } = {}): Buffer {
+		  return this.nativeTrie.diff(this.operand(other), options.withScores === true);
+	  }
+
+	  private operand(other: Seshat): NativeSeshat {
+		  if (!(other instanceof Seshat)) {
+			  throw new TypeError("Argument must be a Seshat instance");
+		  }
+		  return other.nativeTrie;
 	  }
 
 	  /**
-	   * Create a Seshat instance from a Buffer of newline-delimited words.
-	   * This is the fast counterpart to fromJSON — deserialization happens
-	   * entirely in C++, bypassing per-word N-API overhead.
+	   * Create a Writable that inserts the newline-delimited text written to it.
+	   * Lines are split natively on a libuv worker thread, gzip input is
+	   * inflated on the way without a zlib transform in front, and write()
+	   * applies back-pressure while the trie catches up. The trie is only held
+	   * while a batch of chunks is being inserted; other calls go ahead between
+	   * batches, and a call that lands during one throws as it would during
+	   * insertFromFileAsync. {@link TrieIngest.count} holds the words inserted.
+	   * maxSize is not enforced, as for the other bulk loads.
 	   *
-	   * @param buffer - Buffer containing newline-delimited words
-	   * @param options - Configuration options
-	   * @returns New Seshat instance
+	   * @param options - gzip, assumeSorted, scored, valued and highWaterMark
+	   * @returns A Writable stream
+	   * @throws {RangeError} If highWaterMark is not a positive integer
 	   *
 	   * @example
 	   * ```typescript
-	   * const buf = fs.readFileSync('words.dat');
-	   * const trie = Seshat.fromBuffer(buf);
+	   * import { createReadStream } from 'fs';
+	   * import { pipeline } from 'stream/promises';
+	   *
+	   * const ingest = trie.createIngest();
+	   * await pipeline(createReadStream('words.txt.gz'), ingest);
+	   * console.log(`Inserted ${ingest.count} words`);
 	   * ```
 	   */
-	  static fromBuffer(buffer: Buffer, options: Omit<SeshatOptions, "words"> = {}): Seshat {
-		  if (!Buffer.isBuffer(buffer)) {
-			  throw new TypeError("Argument must be a Buffer");
+	  createIngest(options: IngestOptions = {}): TrieIngest {
+		  const highWaterMark = options.highWaterMark ?? 1024 * 1024;
+		  if (!Number.isInteger(highWaterMark) || highWaterMark < 1) {
+			  throw new RangeError("High water mark must be a positive integer");
 		  }
-		  const trie = new Seshat(options);
-		  trie.insertFromBuffer(buffer);
-		  return trie;
+		  const handle = this.nativeTrie.createIngest(options.gzip, options.assumeSorted === true, options.scored === true, options.valued === true);
+		  return new TrieIngest(this.nativeTrie, handle, highWaterMark);
+	  }
+
+	  /**
+	   * Insert words from a Readable stream of newline-delimited text, plain or
+	   * gzip-compressed, by piping it into {@link createIngest}. Like it, this
+	   * does not enforce maxSize.
+	   *
+	   * @param stream - A Readable stream providing newline-delimited words
+	   * @param options - As for createIngest
+	   * @returns Promise resolving to the total number of words inserted
+	   *
+	   * @example
+	   * ```typescript
+	   * import { createReadStream } from 'fs';
+	   *
+	   * const count = await trie.insertFromStream(createReadStream('words.txt'));
+	   * console.log(`Inserted ${count} words`);
+	   * ```
+	   */
+	  insertFromStream(stream: Readable, options: IngestOptions = {}): Promise<number> {
+		  const ingest = this.createIngest(options);
+		  return new Promise((resolve, reject) => {
+			  pipeline(stream, ingest, error => (error ? reject(error) : resolve(ingest.count)));
+		  });
+	  }
+
+	  /**
+	   * Serialize the trie to a Buffer of newline-delimited words.
+	   * This performs serialization entirely in C++, avoiding per-word N-API
+	   * overhead and JSON stringify costs.
+	   *
+	   * @param options - Set withScores to write each line as `word<TAB>score`,
+	   *   which the bulk loaders read back with `scored: true`, and withValues
+	   *   to add a tab and the value to the lines of words that have one,
+	   *   read back with `valued: true`
+	   * @returns Buffer containing newline-delimited words
+	   *
+	   * @example
+	   * ```typescript
+	   * const buf = trie.toBuffer();
+	   * fs.writeFileSync('words.dat', buf);
+	   * ```
+	   */
+	  toBuffer(options: { withScores?: boolean; withValues?: boolean } = {}): Buffer {
+		  return this.nativeTrie.toBuffer(options.withScores === true, options.withValues === true);
+	  }
+
+	  /**
+	   * toBuffer run on a worker thread; the result is handed over without a
+	   * copy. See {@link Seshat.getWordsWithPrefixAsync} for the concurrency rules.
+	   */
+	  async toBufferAsync(options: { withScores?: boolean; withValues?: boolean } = {}): Promise<Buffer> {
+		  return this.nativeTrie.toBufferAsync(options.withScores === true, options.withValues === true);
+	  }
+
+	  /**
+	   * Write toBuffer's output straight to a file. The lines are produced and
+	   * written a chunk at a time, so the whole dump is never held in memory.
+	   *
+	   * @param filePath - Path of the file to create or overwrite
+	   * @param options - withScores and withValues, as for toBuffer
+	   * @returns Number of words written
+	   * @throws {TypeError} If filePath is not a string
+	   * @throws {Error} If the file cannot be opened or written
+	   *
+	   * @example
+	   * ```typescript
+	   * trie.writeToFile('./words.txt');
+	   * const copy = new Seshat();
+	   * copy.insertFromFile('./words.txt', { assumeSorted: true });
+	   * ```
+	   */
+	  writeToFile(filePath: string, options: { withScores?: boolean; withValues?: boolean } = {}): number {
+		  if (typeof filePath !== "string") {
+			  throw new TypeError("File path must be a string");
+		  }
+		  return this.nativeTrie.writeToFile(filePath, options.withScores === true, options.withValues === true);
+	  }
+
+	  /**
+	   * writeToFile run on a worker thread. See
+	   * {@link Seshat.getWordsWithPrefixAsync} for the concurrency rules.
+	   */
+	  async writeToFileAsync(filePath: string, options: { withScores?: boolean; withValues?: boolean } = {}): Promise<number> {
+		  if (typeof filePath !== "string") {
+			  throw new TypeError("File path must be a string");
+		  }
+		  return this.nativeTrie.writeToFileAsync(filePath, options.withScores === true, options.withValues === true);
+	  }
+
+	  /**
+	   * Stream toBuffer's output as a Readable of Buffer chunks. Each chunk is
+	   * serialized on demand from a native cursor, so memory stays bounded by
+	   * the chunk size however large the trie is. The trie must not be
+	   * modified (or frozen or thawed) while the stream is being read; if it
+	   * is, the stream is destroyed with an error.
+	   *
+	   * @param options - withScores and withValues, as for toBuffer;
+	   *   chunkSize is the approximate number of bytes per chunk (default 64KiB)
+	   * @returns A Readable of newline-delimited words
+	   * @throws {RangeError} If chunkSize is not a positive integer
+	   *
+	   * @example
+	   * ```typescript
+	   * await pipeline(trie.toStream(), fs.createWriteStream('words.txt'));
+	   * ```
+	   */
+	  toStream(options: { withScores?: boolean; withValues?: boolean; chunkSize?: number } = {}): Readable {
+		  const chunkSize = options.chunkSize ?? 64 * 1024;
+		  if (!Number.isInteger(chunkSize) || chunkSize < 1) {
+			  throw new RangeError("Chunk size must be a positive integer");
+		  }
+		  const withScores = options.withScores === true;
+		  const withValues = options.withValues === true;
+		  const native = this.nativeTrie;
+		  const cursor = native.prefixCursor("");
+
+		  return new Readable({
+			  read() {
+				  try {
+					  const chunk = native.cursorChunk(cursor, chunkSize, withScores, withValues);
+					  this.push(chunk.length > 0 ? chunk : null);
+				  } catch (error) {
+					  this.destroy(error instanceof Error ? error : new Error(String(error)));
+				  }
+			  },
+		  });
+	  }
+
+	  /**
+	   * Create a Seshat instance from a Buffer of newline-delimited words.
+	   * This is the fast counterpart to fromJSON — deserialization happens
+	   * entirely in C++, bypassing per-word N-API overhead. Sorted input (such
+	   * as toBuffer() output) takes a faster append-only path; unsorted input
+	   * still loads correctly.
+	   *
+	   * @param buffer - Buffer containing newline-delimited words
+	   * @param options - Configuration options; set scored for toBuffer({ withScores: true })
+	   *   output and valued for toBuffer({ withValues: true }) output
+	   * @returns New Seshat instance
+	   *
+	   * @example
+	   * ```typescript
+	   * const buf = fs.readFileSync('words.dat');
+	   * const trie = Seshat.fromBuffer(buf);
+	   * ```
+	   */
+	  static fromBuffer(buffer: Buffer, options: Omit<SeshatOptions, "words"> & { scored?: boolean; valued?: boolean } = {}): Seshat {
+		  if (!Buffer.isBuffer(buffer)) {
+			  throw new TypeError("Argument must be a Buffer");
+		  }
+		  const { scored, valued, ...trieOptions } = options;
+		  const trie = new Seshat(trieOptions);
+		  // toBuffer() writes words in sorted order
+		  trie.insertFromBuffer(buffer, { assumeSorted: true, scored, valued });
+		  return trie;
+	  }
+
+	  /**
+	   * Serialize the trie's node structure to a versioned binary snapshot.
+	   * Unlike {@link toBuffer}, loading a snapshot does not rebuild the trie:
+	   * the image is queried in place, so it can be written to disk and later
+	   * memory-mapped with {@link fromSnapshotFile} at almost no startup cost.
+	   *
+	   * In an `ignoreCase` trie the snapshot stores the folded words along with
+	   * their original casing. It does not record the option itself, so load it
+	   * into a trie created with the same `ignoreCase`. Scores and values set
+	   * with {@link set} are stored too.
+	   *
+	   * @returns Buffer containing the snapshot image
+	   *
+	   * @example
+	   * ```typescript
+	   * fs.writeFileSync('words.snap', trie.toSnapshot());
+	   * ```
+	   */
+	  toSnapshot(): Buffer {
+		  return this.nativeTrie.toSnapshot();
+	  }
+
+	  /**
+	   * Freeze the trie into an immutable, cache-friendly layout: the nodes are
+	   * flattened into one contiguous breadth-first array with children stored
+	   * as index ranges, and the pointer tree is freed. Lookups get faster and
+	   * memory use drops. Any later mutation transparently thaws the trie
+	   * first, which costs a full rebuild, so freeze after bulk loading.
+	   *
+	   * @example
+	   * ```typescript
+	   * trie.insertFromFile('./words.txt');
+	   * trie.freeze();
+	   * trie.search('hello'); // served from the frozen layout
+	   * ```
+	   */
+	  freeze(): void {
+		  this.nativeTrie.freeze();
+	  }
+
+	  /**
+	   * Rebuild the mutable pointer tree of a frozen trie. Mutations do this
+	   * automatically; calling it up front moves the cost out of the first
+	   * insert/remove.
+	   */
+	  thaw(): void {
+		  this.nativeTrie.thaw();
+	  }
+
+	  /**
+	   * Rebuild the trie's nodes into fresh memory, laid out depth first with
+	   * every children block as small as its kind allows, the label pool and
+	   * the spelling table of an ignoreCase trie packed, and single-child
+	   * chains joined. Worth calling after removing a large share of the
+	   * words; a frozen trie is left as it is.
+	   *
+	   * @returns Bytes given back, also added to getMemoryStats().reclaimedBytes
+	   *
+	   * @example
+	   * ```typescript
+	   * trie.removeFromBuffer(staleWords);
+	   * const freed = trie.compact();
+	   * ```
+	   */
+	  compact(): number {
+		  return this.nativeTrie.compact();
+	  }
+
+	  /**
+	   * Whether the trie is currently frozen (by {@link freeze} or because it
+	   * was loaded from a snapshot)
+	   */
+	  isFrozen(): boolean {
+		  return this.nativeTrie.isFrozen();
+	  }
+
+	  /**
+	   * Create a Seshat instance from a snapshot Buffer produced by
+	   * {@link toSnapshot}. The image is copied and validated, but no nodes are
+	   * allocated: the trie starts out frozen.
+	   *
+	   * @param buffer - Buffer containing a snapshot image
+	   * @param options - Configuration options
+	   * @returns New frozen Seshat instance
+	   * @throws {TypeError} If buffer is not a Buffer
+	   * @throws {Error} If the buffer is not a valid snapshot
+	   */
+	  static fromSnapshot(buffer: Buffer, options: Omit<SeshatOptions, "words"> = {}): Seshat {
+		  if (!Buffer.isBuffer(buffer)) {
+			  throw new TypeError("Argument must be a Buffer");
+		  }
+		  const trie = new Seshat(options);
+		  trie.nativeTrie.loadSnapshot(buffer);
+		  return trie;
+	  }
+
+	  /**
+	   * Create a Seshat instance by memory-mapping a snapshot file. The trie
+	   * starts out frozen and queries run directly against the mapped pages,
+	   * so several processes loading the same file share one page-cache copy
+	   * of it. The first mutation thaws it into private memory.
+	   *
+	   * @param filePath - Path to a file written from {@link toSnapshot}
+	   * @param options - Configuration options
+	   * @returns New frozen Seshat instance
+	   * @throws {TypeError} If filePath is not a string
+	   * @throws {Error} If the file cannot be mapped or is not a valid snapshot
+	   *
+	   * @example
+	   * ```typescript
+	   * const trie = Seshat.fromSnapshotFile('words.snap');
+	   * trie.search('hello');
+	   * ```
+	   */
+	  static fromSnapshotFile(filePath: string, options: Omit<SeshatOptions, "words"> = {}): Seshat {
+		  if (typeof filePath !== "string") {
+			  throw new TypeError("File path must be a string");
+		  }
+		  const trie = new Seshat(options);
+		  trie.nativeTrie.loadSnapshotFile(filePath);
+		  return trie;
+	  }
+
+	  /**
+	   * Make this trie available to other worker threads under `name`, so
+	   * they can {@link Seshat.attach} to it instead of building their own
+	   * copy. Only a trie created with `concurrent: true` can be shared: every
+	   * thread may then read it without locking and write to it, one write at
+	   * a time. A synchronous write never blocks its thread's event loop on
+	   * another thread's write (an insertFromFileAsync or ingest, say): it
+	   * throws "Trie is busy: another thread is writing to it" instead. The
+	   * name does not keep the trie alive; it stays available as long as some
+	   * thread still holds a Seshat for it.
+	   *
+	   * @param name - Process-wide name to share the trie under
+	   * @throws {TypeError} If name is not a string
+	   * @throws {Error} If the trie is not concurrent or the name is taken by another trie
+	   *
+	   * @example
+	   * ```typescript
+	   * const trie = new Seshat({ concurrent: true });
+	   * trie.insertFromFile('words.txt');
+	   * trie.share('dictionary');
+	   * new Worker('./worker.js'); // calls Seshat.attach('dictionary')
+	   * ```
+	   */
+	  share(name: string): void {
+		  if (typeof name !== "string") {
+			  throw new TypeError("Name must be a string");
+		  }
+		  this.nativeTrie.share(name);
+	  }
+
+	  /**
+	   * Get a Seshat, in the calling thread, for the trie another thread
+	   * shared under `name`. Nothing is copied or loaded: every attached
+	   * Seshat works on the same native trie, and sees the others' writes.
+	   *
+	   * @param name - The name passed to {@link share}
+	   * @param options - maxSize for this Seshat; ignoreCase and concurrent come from the shared trie
+	   * @returns Seshat for the shared trie, whose synchronous writes throw
+	   *   "Trie is busy" rather than wait while another thread writes (see {@link share})
+	   * @throws {TypeError} If name is not a string
+	   * @throws {Error} If no live trie is shared under the name
+	   */
+	  static attach(name: string, options: Pick<SeshatOptions, "maxSize"> = {}): Seshat {
+		  if (typeof name !== "string") {
+			  throw new TypeError("Name must be a string");
+		  }
+		  const nativeTrie: NativeSeshat = native.Seshat.attach(name);
+		  const trie: Seshat = Object.create(Seshat.prototype);
+		  return Object.assign(trie, {
+			  nativeTrie,
+			  ignoreCase: nativeTrie.ignoresCase(),
+			  maxSize: options.maxSize,
+		  });
+	  }
+
+	  /**
+	   * Withdraw a name given to {@link share}. Seshat instances already
+	   * attached keep working.
+	   *
+	   * @param name - The shared name
+	   * @returns true if a live trie was shared under the name
+	   */
+	  static unshare(name: string): boolean {
+		  if (typeof name !== "string") {
+			  throw new TypeError("Name must be a string");
+		  }
+		  return native.Seshat.unshare(name);
+	  }
+
+	  /**
+	   * Read the process-wide performance counters: how much trie work was
+	   * done (nodes visited, child probes, splits, orphan cleanups, arena
+	   * blocks and allocations), how many result bytes crossed into JS, and a
+	   * latency histogram summary for each native method called. Async
+	   * methods are timed from the call until their promise or callback
+	   * settles. Reading them is cheap; nothing is walked.
+	   *
+	   * The trie counters exist only in builds made with `npm run build:perf`
+	   * (`countersCompiled` says which); in a regular build they cost nothing
+	   * and read 0. Timings and bytesMarshalled are recorded only between
+	   * setPerfCounters(true) and setPerfCounters(false).
+	   *
+	   * @example
+	   * ```typescript
+	   * Seshat.setPerfCounters(true);
+	   * trie.getWordsWithPrefix('he');
+	   * const { methods } = Seshat.getPerfCounters();
+	   * console.log(methods.wordsWithPrefixPacked.p99Ns);
+	   * ```
+	   */
+	  static getPerfCounters(): PerfCounters {
+		  return native.Seshat.getPerfCounters();
+	  }
+
+	  /**
+	   * Turn method timing and the marshalled byte count on or off for every
+	   * trie in the process. While off, each native call pays one relaxed
+	   * atomic load for them.
+	   *
+	   * @throws {TypeError} If enabled is not a boolean
+	   */
+	  static setPerfCounters(enabled: boolean): void {
+		  if (typeof enabled !== "boolean") {
+			  throw new TypeError("Enabled must be a boolean");
+		  }
+		  native.Seshat.setPerfCounters(enabled);
+	  }
+
+	  /** Start every performance counter and latency histogram over from zero. */
+	  static resetPerfCounters(): void {
+		  native.Seshat.resetPerfCounters();
 	  }
 
 	  /**
@@ -544,8 +1478,7 @@ export class Seshat {
 			  return false;
 		  }
   
-		  const normalizedWord = this.normalizeWord(word);
-		  return this.nativeTrie.search(normalizedWord);
+		  return this.nativeTrie.search(word);
 	  }
   
 	  /**
@@ -567,12 +1500,34 @@ export class Seshat {
 			  throw new TypeError("Words must be an array");
 		  }
   
-		  // Normalize all words before batch search
-		  const normalizedWords = words.map(word =>
-			  word && typeof word === "string" ? this.normalizeWord(word) : ""
-		  );
+		  // Anything that is not a word is looked up as "", which is never found
+		  const checkedWords = words.map(word => (word && typeof word === "string" ? word : ""));
   
-		  return this.nativeTrie.searchBatch(normalizedWords);
+		  const packed = packWords(checkedWords);
+		  return packed
+			  ? unpackBits(this.nativeTrie.searchPacked(packed, checkedWords.length), checkedWords.length)
+			  : this.nativeTrie.searchBatch(checkedWords);
+	  }
+
+	  /**
+	   * Look up every word of a newline-delimited Buffer in one native call.
+	   * Lines are split and trimmed as insertFromBuffer does, and blank lines
+	   * are skipped. In an ignoreCase trie the words are case-folded natively.
+	   *
+	   * @param buffer - Buffer containing newline-delimited words
+	   * @returns A bitmap where bit i % 8 of byte i / 8 is set if the i-th word is in the trie
+	   *
+	   * @example
+	   * ```typescript
+	   * const bits = trie.searchFromBuffer(Buffer.from('hello\nnope\n'));
+	   * const helloFound = (bits[0] & 1) !== 0;
+	   * ```
+	   */
+	  searchFromBuffer(buffer: Buffer): Uint8Array {
+		  if (!Buffer.isBuffer(buffer)) {
+			  throw new TypeError("Argument must be a Buffer");
+		  }
+		  return this.nativeTrie.searchFromBuffer(buffer);
 	  }
   
 	  /**
@@ -598,35 +1553,330 @@ export class Seshat {
 			  return this.size() > 0;
 		  }
   
-		  const normalizedPrefix = this.normalizeWord(prefix);
-		  return this.nativeTrie.startsWith(normalizedPrefix);
+		  return this.nativeTrie.startsWith(prefix);
 	  }
   
 	  /**
-	 * Get all words that start with the given prefix
+	 * Check if any word in the trie ends with the given suffix
+	 *
+	 * @remarks A prefix check on the reversed words in a trie created with
+	 * `suffixIndex`; otherwise a walk over the words that stops at the first
+	 * match.
+	 * @param suffix - The suffix to check
+	 * @returns True if any word ends with the suffix, false otherwise
+	 * @throws {TypeError} If suffix is not a string
+	 *
+	 * @example
+	 * ```typescript
+	 * const trie = new Seshat({ suffixIndex: true, words: ['running'] });
+	 * console.log(trie.endsWith('ing')); // true
+	 * console.log(trie.endsWith('run')); // false
+	 * ```
+	 */
+	  endsWith(suffix: string): boolean {
+		  if (typeof suffix !== "string") {
+			  throw new TypeError("Suffix must be a string");
+		  }
+		  return this.nativeTrie.endsWith(suffix);
+	  }
+
+	  /**
+	 * Get the words that end with the given suffix, in lexicographic order
+	 *
+	 * @remarks Read off the reversed words in a trie created with
+	 * `suffixIndex`; otherwise a walk over every word.
+	 * @param suffix - The suffix to search for
+	 * @returns Array of words that end with the suffix
+	 * @throws {TypeError} If suffix is not a string
+	 *
+	 * @example
+	 * ```typescript
+	 * trie.insertMany(['jumping', 'running', 'ran']);
+	 * console.log(trie.getWordsWithSuffix('ing')); // ['jumping', 'running']
+	 * ```
+	 */
+	  getWordsWithSuffix(suffix: string): string[] {
+		  if (typeof suffix !== "string") {
+			  throw new TypeError("Suffix must be a string");
+		  }
+		  return this.nativeTrie.wordsWithSuffix(suffix);
+	  }
+
+	  /**
+	 * Get the words that start with the given prefix, in lexicographic order
 	 *
 	 * @param prefix - The prefix to search for
+	 * @param options - Optional limit and offset for paging through the matches
 	 * @returns Array of words that start with the prefix
 	 * @throws {TypeError} If prefix is not a string
+	 * @throws {RangeError} If limit or offset is not a non-negative integer
 	 *
 	 * @example
 	 * ```typescript
 	 * trie.insertMany(['hello', 'help', 'world']);
 	 * console.log(trie.getWordsWithPrefix('he')); // ['hello', 'help']
+	 * console.log(trie.getWordsWithPrefix('he', { limit: 1, offset: 1 })); // ['help']
 	 * ```
 	 */
-	  getWordsWithPrefix(prefix: string): string[] {
+	  getWordsWithPrefix(prefix: string, options: PrefixQueryOptions = {}): string[] {
 		  if (typeof prefix !== "string") {
 			  throw new TypeError("Prefix must be a string");
 		  }
+		  const { limit, offset } = options;
+		  this.validateCount(limit, "Limit");
+		  this.validateCount(offset, "Offset");
   
-		  const normalizedPrefix = this.normalizeWord(prefix);
-		  const results = this.nativeTrie.wordsWithPrefix(normalizedPrefix);
+		  return unpackWords(this.nativeTrie.wordsWithPrefixPacked(prefix, limit, offset));
+	  }
+
+	  /**
+	 * Get the words that start with the given prefix together with their
+	 * values, in lexicographic order. Words and values cross from native code
+	 * as two packed buffers rather than an object per word.
+	 *
+	 * @param prefix - The prefix to search for
+	 * @param options - Optional limit and offset, as for getWordsWithPrefix
+	 * @returns [word, value] pairs; value is undefined for a word without one
+	 * @throws {TypeError} If prefix is not a string
+	 * @throws {RangeError} If limit or offset is not a non-negative integer
+	 *
+	 * @example
+	 * ```typescript
+	 * trie.set('hello', 1);
+	 * trie.set('help', 2);
+	 * console.log(trie.getEntriesWithPrefix('he')); // [['hello', 1], ['help', 2]]
+	 * ```
+	 */
+	  getEntriesWithPrefix(prefix: string, options: PrefixQueryOptions = {}): Array<[string, number | undefined]> {
+		  if (typeof prefix !== "string") {
+			  throw new TypeError("Prefix must be a string");
+		  }
+		  const { limit, offset } = options;
+		  this.validateCount(limit, "Limit");
+		  this.validateCount(offset, "Offset");
+
+		  return unpackEntries(this.nativeTrie.entriesWithPrefixPacked(prefix, limit, offset));
+	  }
+
+	  /**
+	 * getWordsWithPrefix run on a libuv worker thread, so a large result does
+	 * not block the event loop. The other *Async queries work the same way.
+	 *
+	 * Any number of async queries may run at once. While one is pending, calls
+	 * that modify the trie (including freeze and thaw) throw a "Trie is busy"
+	 * Error instead of waiting; reads stay available. While insertFromFileAsync
+	 * runs, every other call on the trie throws the same way. A trie created
+	 * with `concurrent: true` stays readable during insertFromFileAsync, and
+	 * refuses a write only while an async query is actually running.
+	 *
+	 * @param prefix - The prefix to search for
+	 * @param options - Optional limit and offset for paging through the matches
+	 * @returns Promise of the words that start with the prefix
+	 *
+	 * @example
+	 * ```typescript
+	 * const words = await trie.getWordsWithPrefixAsync('he', { limit: 10000 });
+	 * ```
+	 */
+	  async getWordsWithPrefixAsync(prefix: string, options: PrefixQueryOptions = {}): Promise<string[]> {
+		  if (typeof prefix !== "string") {
+			  throw new TypeError("Prefix must be a string");
+		  }
+		  const { limit, offset } = options;
+		  this.validateCount(limit, "Limit");
+		  this.validateCount(offset, "Offset");
+
+		  return this.nativeTrie.wordsWithPrefixAsync(prefix, limit, offset);
+	  }
+
+	  /**
+	 * Iterate over the words that start with the given prefix, in lexicographic
+	 * order, without building the whole result. Words are pulled from a native
+	 * cursor one batch at a time, so exporting a large trie holds at most one
+	 * batch of strings. The trie must not be modified (or frozen or thawed)
+	 * while an iterator is in use; advancing it afterwards throws.
+	 *
+	 * @param prefix - The prefix to search for
+	 * @param batchSize - Number of words fetched from the native cursor at a time
+	 * @returns An iterator over the words that start with the prefix
+	 * @throws {TypeError} If prefix is not a string
+	 * @throws {RangeError} If batchSize is not a positive integer
+	 * @throws {Error} If the trie is modified during iteration
+	 *
+	 * @example
+	 * ```typescript
+	 * for (const word of trie.iterPrefix('he')) {
+	 *   console.log(word);
+	 * }
+	 * ```
+	 */
+	  *iterPrefix(prefix: string, batchSize: number = 1024): Generator<string, void, undefined> {
+		  if (typeof prefix !== "string") {
+			  throw new TypeError("Prefix must be a string");
+		  }
+		  if (!Number.isInteger(batchSize) || batchSize < 1) {
+			  throw new RangeError("Batch size must be a positive integer");
+		  }
+
+		  const cursor = this.nativeTrie.prefixCursor(prefix);
+		  for (;;) {
+			  const batch = this.nativeTrie.cursorNext(cursor, batchSize);
+			  yield* batch;
+			  if (batch.length < batchSize) {
+				  return;
+			  }
+		  }
+	  }
+
+	  /**
+	 * Get the first word that sorts at or after the given one, in the byte
+	 * order the trie enumerates (lowercased for an ignoreCase trie)
+	 *
+	 * @param word - The word to look for; it need not be in the trie
+	 * @returns The word itself if present, else its successor, or undefined
+	 *   if every word sorts before it
+	 * @throws {TypeError} If word is not a string
+	 *
+	 * @example
+	 * ```typescript
+	 * trie.insertMany(['apple', 'banana', 'cherry']);
+	 * console.log(trie.lowerBound('b')); // 'banana'
+	 * console.log(trie.lowerBound('d')); // undefined
+	 * ```
+	 */
+	  lowerBound(word: string): string | undefined {
+		  if (typeof word !== "string") {
+			  throw new TypeError("Word must be a string");
+		  }
+		  return this.nativeTrie.lowerBound(word);
+	  }
+
+	  /**
+	 * Get the words from `from` up to, but not including, `to`, in
+	 * lexicographic order. The walk starts where `from` would sit instead of
+	 * at the first word, so paging with `from` costs the same at any depth.
+	 * To start strictly after a word, pass `word + "\0"`.
+	 *
+	 * @param from - Inclusive lower bound; it need not be in the trie
+	 * @param to - Exclusive upper bound, or undefined for no upper bound
+	 * @param options - Optional limit and offset, as for getWordsWithPrefix
+	 * @returns The words in the range
+	 * @throws {TypeError} If from or to is not a string
+	 * @throws {RangeError} If limit or offset is not a non-negative integer
+	 *
+	 * @example
+	 * ```typescript
+	 * trie.insertMany(['apple', 'banana', 'cherry']);
+	 * console.log(trie.range('b', 'c')); // ['banana']
+	 * console.log(trie.range('apple\0')); // ['banana', 'cherry']
+	 * ```
+	 */
+	  range(from: string, to?: string, options: PrefixQueryOptions = {}): string[] {
+		  this.validateRange(from, to);
+		  const { limit, offset } = options;
+		  this.validateCount(limit, "Limit");
+		  this.validateCount(offset, "Offset");
 
-		  if (this.ignoreCase) {
-			  return results.map(word => this.originalCasing.get(word) ?? word);
+		  return unpackWords(this.nativeTrie.rangePacked(from, to, limit, offset, false));
+	  }
+
+	  /**
+	 * range with each word's value alongside, as getEntriesWithPrefix is to
+	 * getWordsWithPrefix
+	 *
+	 * @param from - Inclusive lower bound
+	 * @param to - Exclusive upper bound, or undefined for no upper bound
+	 * @param options - Optional limit and offset
+	 * @returns [word, value] pairs; value is undefined for a word without one
+	 * @throws {TypeError} If from or to is not a string
+	 * @throws {RangeError} If limit or offset is not a non-negative integer
+	 */
+	  getEntriesInRange(from: string, to?: string, options: PrefixQueryOptions = {}): Array<[string, number | undefined]> {
+		  this.validateRange(from, to);
+		  const { limit, offset } = options;
+		  this.validateCount(limit, "Limit");
+		  this.validateCount(offset, "Offset");
+
+		  return unpackEntries(this.nativeTrie.rangePacked(from, to, limit, offset, true));
+	  }
+
+	  /**
+	 * Iterate over the words from `from` up to, but not including, `to`,
+	 * pulled from a native cursor in batches as iterPrefix does
+	 *
+	 * @param from - Inclusive lower bound
+	 * @param to - Exclusive upper bound, or undefined for no upper bound
+	 * @param batchSize - Number of words fetched from the native cursor at a time
+	 * @returns An iterator over the words in the range
+	 * @throws {TypeError} If from or to is not a string
+	 * @throws {RangeError} If batchSize is not a positive integer
+	 * @throws {Error} If the trie is modified during iteration
+	 */
+	  *iterRange(from: string, to?: string, batchSize: number = 1024): Generator<string, void, undefined> {
+		  this.validateRange(from, to);
+		  if (!Number.isInteger(batchSize) || batchSize < 1) {
+			  throw new RangeError("Batch size must be a positive integer");
+		  }
+
+		  const cursor = this.nativeTrie.rangeCursor(from, to);
+		  for (;;) {
+			  const batch = this.nativeTrie.cursorNext(cursor, batchSize);
+			  yield* batch;
+			  if (batch.length < batchSize) {
+				  return;
+			  }
+		  }
+	  }
+
+	  /**
+	 * Count the words that sort before the given one. For a word in the trie
+	 * this is its zero-based position in lexicographic order, so
+	 * `select(rank(word)) === word`.
+	 *
+	 * The first rank or select after a modification rebuilds a per-node index
+	 * of word counts in one pass over the trie; later ones descend it in
+	 * time proportional to the word's length. Calls interleaved with writes
+	 * therefore each cost time linear in the size of the trie; to page
+	 * through a trie that is being updated, use range from the last word
+	 * seen instead.
+	 *
+	 * @param word - The word to rank; it need not be in the trie
+	 * @returns The number of words less than word
+	 * @throws {TypeError} If word is not a string
+	 *
+	 * @example
+	 * ```typescript
+	 * trie.insertMany(['apple', 'banana', 'cherry']);
+	 * console.log(trie.rank('banana')); // 1
+	 * console.log(trie.rank('c')); // 2
+	 * ```
+	 */
+	  rank(word: string): number {
+		  if (typeof word !== "string") {
+			  throw new TypeError("Word must be a string");
 		  }
-		  return results;
+		  return this.nativeTrie.rank(word);
+	  }
+
+	  /**
+	 * Get the word at a zero-based position in lexicographic order, using the
+	 * same index as rank
+	 *
+	 * @param index - The position of the word
+	 * @returns The word, or undefined if index is not less than size()
+	 * @throws {RangeError} If index is not a non-negative integer
+	 *
+	 * @example
+	 * ```typescript
+	 * trie.insertMany(['apple', 'banana', 'cherry']);
+	 * console.log(trie.select(2)); // 'cherry'
+	 * ```
+	 */
+	  select(index: number): string | undefined {
+		  if (!Number.isInteger(index) || index < 0) {
+			  throw new RangeError("Index must be a non-negative integer");
+		  }
+		  return this.nativeTrie.select(index);
 	  }
   
 	  /**
@@ -652,12 +1902,7 @@ export class Seshat {
 			  return false;
 		  }
   
-		  const normalizedWord = this.normalizeWord(word);
-		  const removed = this.nativeTrie.remove(normalizedWord);
-		  if (removed && this.ignoreCase) {
-			  this.originalCasing.delete(normalizedWord);
-		  }
-		  return removed;
+		  return this.nativeTrie.remove(word);
 	  }
   
 	  /**
@@ -679,20 +1924,13 @@ export class Seshat {
 			  throw new TypeError("Words must be an array");
 		  }
   
-		  // Normalize all words before batch remove
-		  const normalizedWords = words.map(word =>
-			  word && typeof word === "string" ? this.normalizeWord(word) : ""
-		  );
+		  // Anything that is not a word is removed as "", which is never found
+		  const checkedWords = words.map(word => (word && typeof word === "string" ? word : ""));
   
-		  const results = this.nativeTrie.removeBatch(normalizedWords);
-		  if (this.ignoreCase) {
-			  for (let i = 0; i < results.length; i++) {
-				  if (results[i]) {
-					  this.originalCasing.delete(normalizedWords[i]);
-				  }
-			  }
-		  }
-		  return results;
+		  const packed = packWords(checkedWords);
+		  return packed
+			  ? unpackBits(this.nativeTrie.removePacked(packed, checkedWords.length), checkedWords.length)
+			  : this.nativeTrie.removeBatch(checkedWords);
 	  }
   
 	  /**
@@ -740,7 +1978,6 @@ export class Seshat {
 	 */
 	  clear(): void {
 		  this.nativeTrie.clear();
-		  this.originalCasing.clear();
 	  }
   
 	  /**
@@ -0,0 +1,285 @@
+#include "Arena.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+// Blocks start small, so that an empty or tiny trie does not pin much, and
+// double up to a size where the per-block cost vanishes.
+constexpr std::size_t kFirstBlock = 16 * 1024;
+constexpr std::size_t kMaxBlock = 4 * 1024 * 1024;
+
+// Blocks bypass malloc so that unmapping one really hands its pages back;
+// a heap allocation of this size may instead stay cached in the process.
+void *map_pages(std::size_t bytes) {
+#ifdef _WIN32
+	void *p =
+		VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+#else
+	void *p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+					 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED)
+		throw std::bad_alloc();
+	return p;
+#endif
+}
+
+void unmap_pages(void *p, std::size_t bytes) noexcept {
+#ifdef _WIN32
+	(void)bytes;
+	VirtualFree(p, 0, MEM_RELEASE);
+#else
+	::munmap(p, bytes);
+#endif
+}
+
+} // namespace
+
+thread_local Arena *Arena::current_ = nullptr;
+
+// Both headers keep the memory after them 16-byte aligned.
+struct Arena::Block {
+	Block *next;
+	std::size_t bytes;
+};
+
+struct Arena::Large {
+	Large *prev;
+	Large *next;
+	std::size_t bytes;
+	std::size_t pad;
+};
+
+void *Arena::refill(std::size_t bytes) {
+	retire_tail();
+	const std::size_t size = next_block_ ? next_block_ : kFirstBlock;
+	SESHAT_COUNT(arena_blocks, 1);
+	Block *block = static_cast<Block *>(map_pages(size));
+	block->next = blocks_;
+	block->bytes = size;
+	blocks_ = block;
+	reserved_ += size;
+	next_block_ = std::min(size * 2, kMaxBlock);
+
+	cursor_ = reinterpret_cast<char *>(block + 1);
+	limit_ = reinterpret_cast<char *>(block) + size;
+	void *p = cursor_;
+	cursor_ += bytes;
+	return p;
+}
+
+// A label that would not fill even a standard block gets a block of its own,
+// and the current block keeps its tail.
+char *Arena::refill_labels(std::size_t n) {
+	const std::size_t standard =
+		next_label_block_ ? next_label_block_ : kFirstBlock;
+	const std::size_t needed = sizeof(Block) + n;
+	const std::size_t size = std::max(standard, needed);
+	SESHAT_COUNT(arena_blocks, 1);
+	Block *block = static_cast<Block *>(map_pages(size));
+	block->bytes = size;
+	reserved_ += size;
+	char *p = reinterpret_cast<char *>(block + 1);
+	if (needed > standard) {
+		block->next = label_blocks_ ? label_blocks_->next : nullptr;
+		if (label_blocks_)
+			label_blocks_->next = block;
+		else
+			label_blocks_ = block;
+		return p;
+	}
+	block->next = label_blocks_;
+	label_blocks_ = block;
+	next_label_block_ = std::min(size * 2, kMaxBlock);
+	label_cursor_ = p + n;
+	label_limit_ = reinterpret_cast<char *>(block) + size;
+	return p;
+}
+
+Arena::Block *Arena::detach_labels() noexcept {
+	Block *old = label_blocks_;
+	label_blocks_ = nullptr;
+	label_cursor_ = label_limit_ = nullptr;
+	next_label_block_ = 0;
+	label_used_ = 0;
+	label_live_ = 0;
+	return old;
+}
+
+void Arena::drop_labels(Block *old) noexcept {
+	while (old) {
+		Block *next = old->next;
+		reserved_ -= old->bytes;
+		unmap_pages(old, old->bytes);
+		old = next;
+	}
+}
+
+// Keys not yet moved still point into the old blocks, so they go back on the
+// list. Counting all of their bytes as live only delays the next repack.
+void Arena::restore_labels(Block *old, std::size_t used) noexcept {
+	if (!old)
+		return;
+	Block *last = old;
+	while (last->next)
+		last = last->next;
+	if (label_blocks_) {
+		last->next = label_blocks_->next;
+		label_blocks_->next = old;
+	} else {
+		label_blocks_ = old;
+	}
+	label_used_ += used;
+	label_live_ += used;
+}
+
+// Every request is a multiple of kGranule, so the tail is too. After a
+// request that did not fit it is a single small slot; a tail given up by
+// absorb() may be longer and is filed in kMaxSmall pieces.
+void Arena::retire_tail() noexcept {
+	while (cursor_ != limit_) {
+		const std::size_t left = static_cast<std::size_t>(limit_ - cursor_);
+		const std::size_t n = std::min(left, kMaxSmall);
+		FreeSlot *slot = reinterpret_cast<FreeSlot *>(cursor_);
+		slot->next = free_[n / kGranule];
+		free_[n / kGranule] = slot;
+		cursor_ += n;
+	}
+	cursor_ = limit_ = nullptr;
+}
+
+void *Arena::allocate_large(std::size_t bytes) {
+	SESHAT_COUNT(arena_blocks, 1);
+	Large *large = static_cast<Large *>(std::malloc(sizeof(Large) + bytes));
+	if (!large)
+		throw std::bad_alloc();
+	large->prev = nullptr;
+	large->next = large_;
+	large->bytes = bytes;
+	if (large_)
+		large_->prev = large;
+	large_ = large;
+	reserved_ += sizeof(Large) + bytes;
+	return large + 1;
+}
+
+void Arena::deallocate_large(void *ptr) noexcept {
+	Large *large = static_cast<Large *>(ptr) - 1;
+	if (large->prev)
+		large->prev->next = large->next;
+	else
+		large_ = large->next;
+	if (large->next)
+		large->next->prev = large->prev;
+	reserved_ -= sizeof(Large) + large->bytes;
+	std::free(large);
+}
+
+void Arena::release() noexcept {
+	while (blocks_) {
+		Block *next = blocks_->next;
+		unmap_pages(blocks_, blocks_->bytes);
+		blocks_ = next;
+	}
+	while (large_) {
+		Large *next = large_->next;
+		std::free(large_);
+		large_ = next;
+	}
+	cursor_ = limit_ = nullptr;
+	next_block_ = 0;
+	free_.fill(nullptr);
+	drop_labels(detach_labels());
+	reserved_ = 0;
+	usage_ = Usage();
+}
+
+// Splicing a singly linked list needs its tail, so this walks the other
+// arena's lists once: O(blocks + free slots), never O(live allocations).
+void Arena::absorb(Arena &other) noexcept {
+	if (&other == this)
+		return;
+	// Keep bumping from whichever current block has more room left.
+	if (other.limit_ - other.cursor_ > limit_ - cursor_) {
+		retire_tail();
+		cursor_ = other.cursor_;
+		limit_ = other.limit_;
+		other.cursor_ = other.limit_ = nullptr;
+	} else {
+		other.retire_tail();
+	}
+
+	if (Block *first = other.blocks_) {
+		Block *last = first;
+		while (last->next)
+			last = last->next;
+		last->next = blocks_;
+		blocks_ = first;
+	}
+	if (Large *first = other.large_) {
+		Large *last = first;
+		while (last->next)
+			last = last->next;
+		last->next = large_;
+		if (large_)
+			large_->prev = last;
+		large_ = first;
+	}
+	for (std::size_t i = 0; i < free_.size(); ++i) {
+		FreeSlot *first = other.free_[i];
+		if (!first)
+			continue;
+		FreeSlot *last = first;
+		while (last->next)
+			last = last->next;
+		last->next = free_[i];
+		free_[i] = first;
+	}
+	// The other pool's unused tail is simply abandoned; it was never counted
+	// as used.
+	if (Block *first = other.label_blocks_) {
+		Block *last = first;
+		while (last->next)
+			last = last->next;
+		if (label_blocks_) {
+			last->next = label_blocks_->next;
+			label_blocks_->next = first;
+		} else {
+			label_blocks_ = first;
+			label_cursor_ = other.label_cursor_;
+			label_limit_ = other.label_limit_;
+		}
+	}
+	label_used_ += other.label_used_;
+	label_live_ += other.label_live_;
+	next_label_block_ = std::max(next_label_block_, other.next_label_block_);
+	reserved_ += other.reserved_;
+	next_block_ = std::max(next_block_, other.next_block_);
+	// A worker may have freed memory it did not allocate, leaving its own
+	// counts short; the sums come out right all the same.
+	for (std::size_t t = 0; t < kTagCount; ++t) {
+		usage_.count[t] += other.usage_.count[t];
+		usage_.bytes[t] += other.usage_.bytes[t];
+	}
+
+	other.detach_labels();
+	other.blocks_ = nullptr;
+	other.large_ = nullptr;
+	other.next_block_ = 0;
+	other.reserved_ = 0;
+	other.usage_ = Usage();
+	other.free_.fill(nullptr);
+}
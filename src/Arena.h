@@ -0,0 +1,221 @@
+#pragma once
+#include "PerfCounters.h"
+#include <array>
+#include <cstddef>
+#include <new>
+
+// Region allocator owned by one trie. Nodes, spilled CompactKey bytes and
+// ChildList blocks are all carved out of large blocks mapped straight from the
+// OS, so the trie's memory can be dropped in one go: release() unmaps every
+// block without visiting a single node, which makes clearing or destroying a
+// trie O(blocks) instead of a recursive walk, and gives the pages back to the
+// OS rather than to a process-wide pool.
+//
+// Requests are rounded up to 8 bytes. Up to kMaxSmall, each size has its own
+// free list, so a slot freed by a removal or a child list that changed kind is
+// reused for the next request of that size; a fresh request is a pointer bump.
+// Larger requests go to the heap individually but are still tracked, so
+// release() frees them too.
+//
+// Edge labels too long for CompactKey's inline buffer are not allocations of
+// their own: they are appended, unaligned, to a separate pool of label blocks
+// and never freed one by one. A key keeps a pointer and length into the pool,
+// so splitting an edge just divides the range between the two halves. The
+// pool only learns how many of its bytes are no longer referenced
+// (label_waste()); the trie copies the live labels into fresh blocks with
+// repack_labels() once that waste dominates.
+//
+// Callers may tag what they allocate with a small number of their choosing
+// (RadixNode and ChildList do), and the arena keeps a running count and byte
+// total of the live allocations under each tag, so a trie can report its
+// memory without walking its nodes. The totals are of requested sizes, before
+// rounding.
+//
+// An arena is not thread-safe. Allocation does not take an arena argument:
+// RadixNode's operator new, ChildList and CompactKey all allocate from the
+// arena installed on the calling thread by an Arena::Scope, and fall back to
+// the global heap when none is. A RadixTrie installs its own arena for the
+// duration of every call that allocates or frees nodes, and memory must be
+// freed under the same arena (or none) that it came from.
+class Arena {
+  public:
+	static constexpr std::size_t kMaxSmall = 4096;
+	static constexpr std::size_t kTagCount = 8;
+
+	// Live allocations per tag.
+	struct Usage {
+		std::array<std::size_t, kTagCount> count{};
+		std::array<std::size_t, kTagCount> bytes{};
+	};
+
+	Arena() = default;
+	~Arena() { release(); }
+	Arena(const Arena &) = delete;
+	Arena &operator=(const Arena &) = delete;
+
+	inline void *allocate(std::size_t bytes, std::size_t tag = 0);
+	// `bytes` and `tag` must be those the memory was allocated with.
+	inline void deallocate(void *ptr, std::size_t bytes,
+						   std::size_t tag = 0) noexcept;
+	// Frees everything the arena ever handed out, at once. No destructors
+	// run, so nothing allocated from it may be used afterwards.
+	void release() noexcept;
+	// Takes over `other`'s blocks, free slots and large allocations, leaving
+	// it empty. Used to adopt what the parallel loader's workers built.
+	void absorb(Arena &other) noexcept;
+	// Bytes obtained from the OS and the heap, whether in use or not.
+	std::size_t reserved_bytes() const noexcept { return reserved_; }
+	const Usage &usage() const noexcept { return usage_; }
+
+	// Appends room for an `n`-byte label to the label pool.
+	inline char *allocate_label(std::size_t n);
+	// Notes that `n` label bytes are no longer referenced by any key.
+	void discard_label(std::size_t n) noexcept { label_live_ -= n; }
+	// Bytes appended to the label pool, and how many of them are garbage.
+	std::size_t label_bytes() const noexcept { return label_used_; }
+	std::size_t label_waste() const noexcept {
+		return label_used_ - label_live_;
+	}
+	std::size_t label_live_bytes() const noexcept { return label_live_; }
+	// Starts a new label pool, calls `move_all`, which must copy every live
+	// label into it (see CompactKey::move_to_pool), and then unmaps the old
+	// pool. If `move_all` throws, the old pool is kept.
+	template <typename F> void repack_labels(F &&move_all);
+
+	// Installs an arena as the current thread's allocation target until the
+	// scope ends, restoring the previous one afterwards.
+	class Scope {
+	  public:
+		explicit Scope(Arena &arena) noexcept : previous_(current_) {
+			current_ = &arena;
+		}
+		~Scope() { current_ = previous_; }
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+
+	  private:
+		Arena *previous_;
+	};
+
+	// The arena installed on this thread, or nullptr.
+	static Arena *current() noexcept { return current_; }
+
+	// Allocate from the current thread's arena, or the global heap.
+	static void *allocate_current(std::size_t bytes, std::size_t tag = 0) {
+		return current_ ? current_->allocate(bytes, tag)
+						: ::operator new(bytes);
+	}
+	static void deallocate_current(void *ptr, std::size_t bytes,
+								   std::size_t tag = 0) noexcept {
+		if (current_)
+			current_->deallocate(ptr, bytes, tag);
+		else
+			::operator delete(ptr);
+	}
+
+  private:
+	struct Block;
+	struct Large;
+	struct FreeSlot {
+		FreeSlot *next;
+	};
+
+	static constexpr std::size_t kGranule = 8;
+	static constexpr std::size_t round_up(std::size_t n) noexcept {
+		return n == 0 ? kGranule : (n + kGranule - 1) & ~(kGranule - 1);
+	}
+
+	// Maps a new block and bumps `bytes` out of it.
+	void *refill(std::size_t bytes);
+	// Files the unused tail of the current block under its size.
+	void retire_tail() noexcept;
+	void *allocate_large(std::size_t bytes);
+	void deallocate_large(void *ptr) noexcept;
+	char *refill_labels(std::size_t n);
+	// Takes the label pool out of the arena, empty, returning its blocks.
+	Block *detach_labels() noexcept;
+	// Unmaps a detached pool, or hands it back after a failed repack.
+	void drop_labels(Block *old) noexcept;
+	void restore_labels(Block *old, std::size_t used) noexcept;
+
+	static thread_local Arena *current_;
+
+	Block *blocks_ = nullptr;
+	Large *large_ = nullptr;
+	char *cursor_ = nullptr;
+	char *limit_ = nullptr;
+	std::size_t next_block_ = 0; // size of the next block to map
+	std::size_t reserved_ = 0;
+	Usage usage_;
+	// free_[n / kGranule] holds freed slots of n bytes
+	std::array<FreeSlot *, kMaxSmall / kGranule + 1> free_{};
+
+	Block *label_blocks_ = nullptr;
+	char *label_cursor_ = nullptr;
+	char *label_limit_ = nullptr;
+	std::size_t next_label_block_ = 0;
+	std::size_t label_used_ = 0;
+	std::size_t label_live_ = 0;
+};
+
+inline void *Arena::allocate(std::size_t bytes, std::size_t tag) {
+	SESHAT_COUNT(arena_allocations, 1);
+	++usage_.count[tag];
+	usage_.bytes[tag] += bytes;
+	const std::size_t n = round_up(bytes);
+	if (n > kMaxSmall)
+		return allocate_large(n);
+	FreeSlot *&head = free_[n / kGranule];
+	if (FreeSlot *slot = head) {
+		head = slot->next;
+		return slot;
+	}
+	if (static_cast<std::size_t>(limit_ - cursor_) >= n) {
+		void *p = cursor_;
+		cursor_ += n;
+		return p;
+	}
+	return refill(n);
+}
+
+inline void Arena::deallocate(void *ptr, std::size_t bytes,
+							  std::size_t tag) noexcept {
+	if (!ptr)
+		return;
+	--usage_.count[tag];
+	usage_.bytes[tag] -= bytes;
+	const std::size_t n = round_up(bytes);
+	if (n > kMaxSmall) {
+		deallocate_large(ptr);
+		return;
+	}
+	FreeSlot *slot = static_cast<FreeSlot *>(ptr);
+	slot->next = free_[n / kGranule];
+	free_[n / kGranule] = slot;
+}
+
+inline char *Arena::allocate_label(std::size_t n) {
+	SESHAT_COUNT(arena_allocations, 1);
+	char *p;
+	if (static_cast<std::size_t>(label_limit_ - label_cursor_) >= n) {
+		p = label_cursor_;
+		label_cursor_ += n;
+	} else {
+		p = refill_labels(n);
+	}
+	label_used_ += n;
+	label_live_ += n;
+	return p;
+}
+
+template <typename F> void Arena::repack_labels(F &&move_all) {
+	const std::size_t used = label_used_;
+	Block *old = detach_labels();
+	try {
+		move_all();
+	} catch (...) {
+		restore_labels(old, used);
+		throw;
+	}
+	drop_labels(old);
+}
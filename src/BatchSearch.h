@@ -0,0 +1,128 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "Descent.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+// Asks for the cache line holding `p` without waiting for it. A hint only:
+// it never faults, so a null or stale pointer is harmless.
+inline void prefetch_read(const void *p) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_prefetch(p, 0, 3);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	_mm_prefetch(static_cast<const char *>(p), _MM_HINT_T0);
+#else
+	(void)p;
+#endif
+}
+
+// Looks up words[0..count) and sets bit i of `bitmap` for each word in the
+// trie; the bitmap must hold count bits and start zeroed.
+//
+// One lookup is a chain of dependent loads (a node, its child list, the
+// child, the child's label, ...), each of which is likely a cache miss on a
+// large trie, so a loop of single lookups mostly waits on memory. Here up to
+// kLanes lookups are in flight at once. Every step of a lookup ends by
+// prefetching the memory its next step reads, and then the other lanes take
+// their turn, so by the time a lane comes round again that memory has
+// usually arrived and the misses of different words overlap instead of
+// adding up. A lane whose word is decided takes the next word at once, so
+// short and long words mix freely.
+//
+// Tree supplies the node type and these accessors, where the prefetch
+// functions announce the memory the named call will read:
+//
+//   using Node = ...;
+//   Node root() const;
+//   void prefetch_children(Node) const;      // for find_child
+//   bool find_child(Node, char, Node &) const;
+//   void prefetch_node(Node) const;          // for prefetch_label, is_end
+//   void prefetch_label(Node) const;         // for label
+//   std::string_view label(Node) const;
+//   bool is_end(Node) const;
+template <typename Tree>
+void interleaved_search(const Tree &tree, const std::string_view *words,
+						size_t count, std::uint8_t *bitmap) {
+	// Enough to cover a miss to DRAM at a few nanoseconds per step, and few
+	// enough that the lanes' own state stays in L1.
+	constexpr size_t kLanes = 16;
+	enum Step : std::uint8_t { kFindChild, kReadNode, kMatchLabel };
+	struct Lane {
+		size_t index;
+		size_t pos; // bytes of the word matched so far
+		typename Tree::Node node;
+		Step step;
+	};
+
+	std::array<Lane, kLanes> lanes;
+	size_t next = 0;
+	// Starts a lane on the next word, if any. The empty word is never in the
+	// trie, just as for a single search.
+	auto start = [&](Lane &lane) {
+		while (next < count) {
+			const size_t index = next++;
+			if (words[index].empty())
+				continue;
+			lane = {index, 0, tree.root(), kFindChild};
+			tree.prefetch_children(lane.node);
+			return true;
+		}
+		return false;
+	};
+	// Takes one step of a lane's lookup; false once its word is decided.
+	auto advance = [&](Lane &lane) {
+		const std::string_view word = words[lane.index];
+		switch (lane.step) {
+		case kFindChild: {
+			typename Tree::Node child;
+			if (!tree.find_child(lane.node, word[lane.pos], child))
+				return false;
+			lane.node = child;
+			tree.prefetch_node(child);
+			lane.step = kReadNode;
+			return true;
+		}
+		case kReadNode:
+			tree.prefetch_label(lane.node);
+			lane.step = kMatchLabel;
+			return true;
+		case kMatchLabel: {
+			const std::string_view label = tree.label(lane.node);
+			if (label.size() > word.size() - lane.pos ||
+				!same_bytes(word.data() + lane.pos, label.data(), label.size()))
+				return false;
+			lane.pos += label.size();
+			if (lane.pos == word.size()) {
+				if (tree.is_end(lane.node))
+					bitmap[lane.index / 8] |=
+						std::uint8_t(1u << (lane.index % 8));
+				return false;
+			}
+			tree.prefetch_children(lane.node);
+			lane.step = kFindChild;
+			return true;
+		}
+		}
+		return false;
+	};
+
+	size_t active = 0;
+	while (active < kLanes && start(lanes[active]))
+		++active;
+	while (active != 0) {
+		for (size_t i = 0; i < active;) {
+			if (advance(lanes[i]) || start(lanes[i])) {
+				++i;
+			} else {
+				--active;
+				lanes[i] = lanes[active];
+			}
+		}
+	}
+}
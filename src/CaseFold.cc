@@ -0,0 +1,133 @@
+#include "CaseFold.h"
+#include <cstddef>
+
+namespace {
+
+// Most case pairs outside ASCII sit next to each other, upper case first,
+// either from an even code point (U+0100 "Ā" -> U+0101 "ā") or from an odd one.
+char32_t even_to_odd(char32_t c) { return c | 1; }
+char32_t odd_to_even(char32_t c) { return (c & 1) ? c + 1 : c; }
+
+char32_t simple_lower(char32_t c) {
+	if (c < 0x100)
+		return c >= 0xC0 && c <= 0xDE && c != 0xD7 ? c + 0x20 : c;
+	if (c < 0x180) {
+		if (c == 0x130)
+			return 'i';
+		if (c == 0x178)
+			return 0xFF;
+		if (c <= 0x137 || (c >= 0x14A && c <= 0x177))
+			return even_to_odd(c);
+		if ((c >= 0x139 && c <= 0x148) || (c >= 0x179 && c <= 0x17E))
+			return odd_to_even(c);
+		return c;
+	}
+	if (c >= 0x386 && c <= 0x3AB) {
+		if (c == 0x386)
+			return 0x3AC;
+		if (c >= 0x388 && c <= 0x38A)
+			return c + 37;
+		if (c == 0x38C)
+			return 0x3CC;
+		if (c == 0x38E || c == 0x38F)
+			return c + 63;
+		return c >= 0x391 && c != 0x3A2 ? c + 32 : c;
+	}
+	if (c >= 0x400 && c <= 0x52F) {
+		if (c < 0x410)
+			return c + 80;
+		if (c < 0x430)
+			return c + 32;
+		if ((c >= 0x460 && c <= 0x481) || (c >= 0x48A && c <= 0x4BF) ||
+			c >= 0x4D0)
+			return even_to_odd(c);
+		if (c == 0x4C0)
+			return 0x4CF;
+		if (c >= 0x4C1 && c <= 0x4CE)
+			return odd_to_even(c);
+		return c;
+	}
+	if (c >= 0x531 && c <= 0x556)
+		return c + 48;
+	if (c >= 0x1E00 && c <= 0x1EFF) {
+		if (c == 0x1E9E)
+			return 0xDF;
+		return c <= 0x1E95 || c >= 0x1EA0 ? even_to_odd(c) : c;
+	}
+	if (c >= 0xFF21 && c <= 0xFF3A)
+		return c + 32;
+	return c;
+}
+
+bool is_continuation(char c) {
+	return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+// Every folded code point is below U+10000, so at most three bytes.
+void append_utf8(char32_t c, std::string &out) {
+	if (c < 0x80) {
+		out.push_back(static_cast<char>(c));
+	} else if (c < 0x800) {
+		out.push_back(static_cast<char>(0xC0 | (c >> 6)));
+		out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+	} else {
+		out.push_back(static_cast<char>(0xE0 | (c >> 12)));
+		out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+		out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+	}
+}
+
+} // namespace
+
+bool needs_folding(std::string_view text) noexcept {
+	for (char ch : text) {
+		const unsigned char b = static_cast<unsigned char>(ch);
+		if (b >= 0x80 || (b >= 'A' && b <= 'Z'))
+			return true;
+	}
+	return false;
+}
+
+void fold_case(std::string_view text, std::string &out) {
+	out.clear();
+	out.reserve(text.size());
+	const size_t n = text.size();
+	size_t i = 0;
+	while (i < n) {
+		const unsigned char b = static_cast<unsigned char>(text[i]);
+		if (b < 0x80) {
+			out.push_back(static_cast<char>(b >= 'A' && b <= 'Z' ? b + 32 : b));
+			++i;
+			continue;
+		}
+
+		// Only two- and three-byte sequences can hold a folded letter;
+		// anything else (four-byte sequences, stray or truncated bytes,
+		// overlong forms) is copied a byte at a time.
+		size_t length = 0;
+		char32_t c = 0;
+		if (b >= 0xC2 && b < 0xE0 && i + 1 < n &&
+			is_continuation(text[i + 1])) {
+			length = 2;
+			c = (char32_t(b & 0x1F) << 6) | (text[i + 1] & 0x3F);
+		} else if (b >= 0xE0 && b < 0xF0 && i + 2 < n &&
+				   is_continuation(text[i + 1]) &&
+				   is_continuation(text[i + 2])) {
+			c = (char32_t(b & 0x0F) << 12) |
+				(char32_t(text[i + 1] & 0x3F) << 6) | (text[i + 2] & 0x3F);
+			length = c >= 0x800 ? 3 : 0;
+		}
+		if (length == 0) {
+			out.push_back(static_cast<char>(b));
+			++i;
+			continue;
+		}
+
+		const char32_t lower = simple_lower(c);
+		if (lower == c)
+			out.append(text.data() + i, length);
+		else
+			append_utf8(lower, out);
+		i += length;
+	}
+}
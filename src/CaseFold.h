@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// Simple, per-code-point lowercase folding of UTF-8 text, used by tries built
+// with ignoreCase.
+//
+// ASCII is folded byte by byte. Above it, the fold covers the scripts with
+// case pairs in common use: Latin-1, Latin Extended-A and Extended Additional,
+// Greek, Cyrillic, Armenian and the fullwidth Latin letters. Each code point
+// maps to at most one code point, so the context-dependent rules of a full
+// Unicode fold (final sigma, the dotted capital I's "i" plus combining dot)
+// are not applied; U+0130 simply folds to "i". Bytes that are not valid UTF-8
+// are copied through unchanged.
+
+// Whether fold_case could change `text`: false only for ASCII text with no
+// uppercase letters, which is the common case and costs one pass.
+bool needs_folding(std::string_view text) noexcept;
+
+// Replaces the contents of `out` with the folded form of `text`.
+void fold_case(std::string_view text, std::string &out);
@@ -0,0 +1,116 @@
+#include "ConcurrentTrie.h"
+#include <string>
+#include <thread>
+
+namespace {
+
+// Each thread keeps to one slot, handed out round robin on first use.
+std::size_t reader_slot(std::size_t slots) noexcept {
+	static std::atomic<std::size_t> next{0};
+	thread_local const std::size_t slot = next.fetch_add(1) % slots;
+	return slot;
+}
+
+} // namespace
+
+ConcurrentTrie::ConcurrentTrie(bool fold_case, bool concurrent,
+							   bool suffix_index) {
+	copies_[0] = std::make_unique<RadixTrie>(fold_case, suffix_index);
+	if (concurrent)
+		copies_[1] = std::make_unique<RadixTrie>(fold_case, suffix_index);
+}
+
+bool ConcurrentTrie::Indicator::empty() const noexcept {
+	for (const Slot &slot : slots) {
+		if (slot.readers.load() != 0)
+			return false;
+	}
+	return true;
+}
+
+// A reader arrives before it looks at which copy is published. So once a
+// writer has switched the copy and seen both indicators drain (in order, see
+// publish), every reader that could have picked the old copy is gone.
+ConcurrentTrie::ReadGuard::ReadGuard(const ConcurrentTrie &trie) noexcept
+	: slot(&trie.indicators_[trie.epoch_.load()].slots[reader_slot(kSlots)]),
+	  side(0) {
+	slot->readers.fetch_add(1);
+	side = trie.published_.load();
+}
+
+ConcurrentTrie::ReadGuard::~ReadGuard() { slot->readers.fetch_sub(1); }
+
+// Both sides announce themselves and then look for the other, with
+// sequentially consistent operations, so at least one of them sees the
+// other. A long read that sees a write backs off and waits on its worker
+// thread; a write that sees a long read gives up with Busy.
+ConcurrentTrie::LongRead::LongRead(const ConcurrentTrie &trie) noexcept
+	: trie(trie) {
+	for (;;) {
+		trie.long_reads_.fetch_add(1);
+		if (!trie.syncing_.load())
+			return;
+		trie.long_reads_.fetch_sub(1);
+		while (trie.syncing_.load())
+			std::this_thread::yield();
+	}
+}
+
+ConcurrentTrie::LongRead::~LongRead() { trie.long_reads_.fetch_sub(1); }
+
+ConcurrentTrie::SyncWrite::SyncWrite(ConcurrentTrie &trie) : trie(trie) {
+	trie.syncing_.store(true);
+	if (trie.long_reads_.load() != 0) {
+		trie.syncing_.store(false);
+		throw Busy("Trie is busy: async queries are in progress");
+	}
+}
+
+ConcurrentTrie::SyncWrite::~SyncWrite() { trie.syncing_.store(false); }
+
+RadixTrie &ConcurrentTrie::prepare() {
+	RadixTrie &next = *copies_[1 - published_.load()];
+	if (stale_) {
+		resync(next, *copies_[published_.load()]);
+		stale_ = false;
+	}
+	return next;
+}
+
+// Readers that arrived on the current epoch's indicator may still be on the
+// old copy, and new readers keep arriving there; flipping the epoch first
+// sends new readers to the other indicator, which must itself have drained
+// of readers from two switches ago, so that the wait below ends.
+RadixTrie &ConcurrentTrie::publish() noexcept {
+	const unsigned old_side = published_.load();
+	published_.store(1 - old_side);
+
+	const unsigned epoch = epoch_.load();
+	while (!indicators_[1 - epoch].empty())
+		std::this_thread::yield();
+	epoch_.store(1 - epoch);
+	while (!indicators_[epoch].empty())
+		std::this_thread::yield();
+	return *copies_[old_side];
+}
+
+// An update that fails partway (a bulk load that cannot read its file, say)
+// may have changed some of the unpublished copy. If copying the published one
+// back over it fails as well, it stays marked stale and prepare() tries again.
+void ConcurrentTrie::abandon() noexcept {
+	stale_ = true;
+	try {
+		resync(*copies_[1 - published_.load()],
+			   *copies_[published_.load()]);
+		stale_ = false;
+	} catch (...) {
+	}
+}
+
+// The published copy is only read, so readers may carry on meanwhile.
+void ConcurrentTrie::resync(RadixTrie &copy, const RadixTrie &source) {
+	const std::string image = source.serialize_snapshot();
+	copy.load_snapshot(image.data(), image.size());
+	if (!source.is_frozen())
+		copy.thaw();
+}
@@ -0,0 +1,259 @@
+#pragma once
+#include "RadixTrie.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// A RadixTrie that other threads can query while it is being updated, without
+// a lock on the read path, or (when not concurrent) just a RadixTrie.
+//
+// Concurrent mode keeps two identical tries, in the manner of the left-right
+// technique. Readers use whichever one is published. A writer applies an
+// update to the other one, publishes it with a single atomic store, waits
+// until no reader can still be inside the old one, and then applies the same
+// update to that too. So a read never waits and never sees a half-done
+// update, however long writes take; only writers wait, for each other and for
+// the readers of the copy they are about to change. Old nodes are never
+// touched while a reader may be using them, which is what lets the trie keep
+// its ordinary in-place mutations (and its arena) on both copies. The price
+// is twice the memory and every update done twice.
+//
+// A thread that must never block (a JS thread) writes with try_write(),
+// which throws Busy rather than wait for another writer or for a read_long()
+// in progress; long reads in turn hold off while such a write runs, on their
+// own (worker) threads. Short reads are only waited out.
+//
+// Without concurrent mode there is a single trie, read() and write() call
+// straight through, and the caller is responsible for not overlapping them.
+class ConcurrentTrie {
+  public:
+	// fold_case and suffix_index are RadixTrie's, and apply to both copies.
+	ConcurrentTrie(bool fold_case, bool concurrent, bool suffix_index = false);
+	ConcurrentTrie(const ConcurrentTrie &) = delete;
+	ConcurrentTrie &operator=(const ConcurrentTrie &) = delete;
+
+	bool concurrent() const noexcept { return copies_[1] != nullptr; }
+
+	// What try_write() throws instead of waiting
+	struct Busy : std::runtime_error {
+		using std::runtime_error::runtime_error;
+	};
+
+	// Calls f(const RadixTrie &) on the published trie and returns its
+	// result. The trie may be replaced by its twin after f returns, so
+	// nothing f hands out may refer into it (a PrefixCursor may, as long as
+	// it checks reads() before each later use).
+	template <typename F> decltype(auto) read(F &&f) const {
+		if (!concurrent())
+			return f(static_cast<const RadixTrie &>(*copies_[0]));
+		const ReadGuard guard(*this);
+		return f(static_cast<const RadixTrie &>(*copies_[guard.side]));
+	}
+
+	// read() for a query that may run for long, such as an async one on a
+	// worker thread: it first waits for any try_write() in progress, and
+	// such writes fail while it runs instead of waiting for it to finish.
+	template <typename F> decltype(auto) read_long(F &&f) const {
+		if (!concurrent())
+			return f(static_cast<const RadixTrie &>(*copies_[0]));
+		const LongRead long_read(*this);
+		return read(std::forward<F>(f));
+	}
+
+	// Calls f(RadixTrie &) and returns its result. In concurrent mode f runs
+	// once per copy, so it must make the same change both times, and its
+	// effects outside the trie must not add up (assign a result rather than
+	// increment one). The result is the first run's. If that run throws, the
+	// update is abandoned: readers never see it and the copy it touched is
+	// brought back in line with the published one. An update that cannot
+	// promise the same change twice goes through write_once().
+	template <typename F> decltype(auto) write(F &&f) {
+		if (!concurrent())
+			return f(*copies_[0]);
+		const std::lock_guard<std::mutex> lock(writer_);
+		return update(f);
+	}
+
+	// write() for an update that would not come out the same if repeated,
+	// such as one that reads a file: f runs once, and the other copy is then
+	// made a copy of the published one. That costs time in the size of the
+	// whole trie rather than of the update.
+	template <typename F> decltype(auto) write_once(F &&f) {
+		if (!concurrent())
+			return f(*copies_[0]);
+		const std::lock_guard<std::mutex> lock(writer_);
+		return update(f, Repeat::kCopy);
+	}
+
+	// write() that throws Busy instead of waiting: for another thread's
+	// write (a bulk load on a worker thread, say, possibly from another
+	// isolate sharing the trie), or for a read_long() in progress, whose
+	// readers the update would have to wait out before repeating itself on
+	// their copy.
+	template <typename F> decltype(auto) try_write(F &&f) {
+		if (!concurrent())
+			return f(*copies_[0]);
+		std::unique_lock<std::mutex> lock(writer_, std::try_to_lock);
+		if (!lock.owns_lock())
+			throw Busy("Trie is busy: another thread is writing to it");
+		const SyncWrite sync(*this);
+		return update(f);
+	}
+
+	// try_write() for an update that would not come out the same if
+	// repeated, made once as by write_once().
+	template <typename F> decltype(auto) try_write_once(F &&f) {
+		if (!concurrent())
+			return f(*copies_[0]);
+		std::unique_lock<std::mutex> lock(writer_, std::try_to_lock);
+		if (!lock.owns_lock())
+			throw Busy("Trie is busy: another thread is writing to it");
+		const SyncWrite sync(*this);
+		return update(f, Repeat::kCopy);
+	}
+
+	// Like try_write(), calling f(RadixTrie &, const RadixTrie &) with
+	// `source`'s published trie as well, which no write may change until f
+	// has run on both copies: the second run must see what the first did.
+	// Both writer locks are tried together, and neither is held if either
+	// is taken.
+	template <typename F>
+	decltype(auto) try_write_from(ConcurrentTrie &source, F &&f) {
+		if (&source == this) {
+			return try_write([&](RadixTrie &trie) {
+				return f(trie, static_cast<const RadixTrie &>(trie));
+			});
+		}
+		std::unique_lock<std::mutex> mine(writer_, std::defer_lock);
+		std::unique_lock<std::mutex> theirs(source.writer_, std::defer_lock);
+		bool locked = true;
+		if (concurrent() && source.concurrent())
+			locked = std::try_lock(mine, theirs) == -1;
+		else if (concurrent())
+			locked = mine.try_lock();
+		else if (source.concurrent())
+			locked = theirs.try_lock();
+		if (!locked)
+			throw Busy("Trie is busy: another thread is writing to it");
+		const RadixTrie &from = *source.copies_[source.published_.load()];
+		auto g = [&](RadixTrie &trie) { return f(trie, from); };
+		if (!concurrent())
+			return g(*copies_[0]);
+		const SyncWrite sync(*this);
+		return update(g);
+	}
+
+  private:
+	// How an update reaches the copy readers have just left: by running it
+	// again, or by copying the published trie over it.
+	enum class Repeat { kRun, kCopy };
+
+	// write()'s concurrent path, with writer_ held
+	template <typename F>
+	decltype(auto) update(F &f, Repeat repeat = Repeat::kRun) {
+		RadixTrie &next = prepare();
+		if constexpr (std::is_void_v<decltype(f(next))>) {
+			try {
+				f(next);
+			} catch (...) {
+				abandon();
+				throw;
+			}
+			follow(publish(), f, repeat);
+		} else {
+			auto result = [&] {
+				try {
+					return f(next);
+				} catch (...) {
+					abandon();
+					throw;
+				}
+			}();
+			follow(publish(), f, repeat);
+			return result;
+		}
+	}
+
+	// Readers announce themselves on one of two indicators, spread over a few
+	// cache lines so that threads reading at once do not all hit one counter.
+	static constexpr std::size_t kSlots = 16;
+	struct alignas(64) Slot {
+		std::atomic<std::size_t> readers{0};
+	};
+	struct Indicator {
+		std::array<Slot, kSlots> slots;
+		bool empty() const noexcept;
+	};
+
+	struct ReadGuard {
+		explicit ReadGuard(const ConcurrentTrie &trie) noexcept;
+		~ReadGuard();
+		ReadGuard(const ReadGuard &) = delete;
+		ReadGuard &operator=(const ReadGuard &) = delete;
+
+		Slot *slot;
+		unsigned side;
+	};
+
+	// Between them, a try_write() and a read_long() never both go ahead:
+	// each announces itself before checking for the other (see LongRead).
+	struct LongRead {
+		explicit LongRead(const ConcurrentTrie &trie) noexcept;
+		~LongRead();
+		LongRead(const LongRead &) = delete;
+		LongRead &operator=(const LongRead &) = delete;
+
+		const ConcurrentTrie &trie;
+	};
+	struct SyncWrite {
+		explicit SyncWrite(ConcurrentTrie &trie);
+		~SyncWrite();
+		SyncWrite(const SyncWrite &) = delete;
+		SyncWrite &operator=(const SyncWrite &) = delete;
+
+		ConcurrentTrie &trie;
+	};
+
+	// The unpublished copy, resynchronised first if an earlier update left it
+	// out of step.
+	RadixTrie &prepare();
+	// Makes the unpublished copy current and returns the old one once no
+	// reader is left in it.
+	RadixTrie &publish() noexcept;
+	// Undoes a failed first run on the unpublished copy.
+	void abandon() noexcept;
+	void resync(RadixTrie &copy, const RadixTrie &source);
+
+	// Repeats an update on the copy readers have just left. It already took
+	// effect on the published copy, so a failure here is not the caller's:
+	// the copy is marked stale and caught up at the start of the next write.
+	template <typename F>
+	void follow(RadixTrie &copy, F &f, Repeat repeat) noexcept {
+		try {
+			if (repeat == Repeat::kRun)
+				f(copy);
+			else
+				resync(copy, *copies_[published_.load()]);
+		} catch (...) {
+			stale_ = true;
+		}
+	}
+
+	std::unique_ptr<RadixTrie> copies_[2];
+	// Which copy readers use, and which indicator they arrive on.
+	std::atomic<unsigned> published_{0};
+	std::atomic<unsigned> epoch_{0};
+	mutable std::array<Indicator, 2> indicators_;
+	std::mutex writer_;
+	// read_long() calls in progress, and whether a try_write() is (only one
+	// can be, as it holds writer_)
+	mutable std::atomic<std::size_t> long_reads_{0};
+	std::atomic<bool> syncing_{false};
+	// Set when the unpublished copy may differ from the published one.
+	bool stale_ = false;
+};
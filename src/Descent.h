@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// How many leading bytes of a[0..n) and b[0..n) agree. Eight bytes are
+// compared per step while at least eight remain, and the first differing
+// byte of a step is read off the XOR of the two words rather than found by
+// rescanning them; the last few bytes go one at a time.
+inline size_t match_length(const char *a, const char *b, size_t n) noexcept {
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		std::uint64_t x, y;
+		std::memcpy(&x, a + i, 8);
+		std::memcpy(&y, b + i, 8);
+		if (x != y) {
+#if (defined(__GNUC__) || defined(__clang__)) &&                              \
+	__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+			return i + static_cast<size_t>(__builtin_ctzll(x ^ y)) / 8;
+#else
+			break;
+#endif
+		}
+	}
+	while (i < n && a[i] == b[i])
+		++i;
+	return i;
+}
+
+// Whether the n bytes at a and b are the same. Only equality is wanted, so
+// this is memcmp, which the C library already vectorizes for any length.
+inline bool same_bytes(const char *a, const char *b, size_t n) noexcept {
+	return std::memcmp(a, b, n) == 0;
+}
+
+// What a descent must find: the key spelled out by whole labels (a word,
+// or the node to remove it from), or the key reaching or ending partway
+// along some label (a prefix).
+enum class Match : std::uint8_t { kWhole, kPrefix };
+
+// Stands in for descend's `step` when the path is not wanted; the calls
+// compile away.
+struct NoStep {
+	template <typename Node> void operator()(Node, Node) const noexcept {}
+};
+
+// Follows `key` down from the root. Returns false if the tree has no such
+// path; otherwise sets `node` to the node reached and `base` to how much of
+// the key lies above that node's label. `step(parent, child)` is called for
+// each edge followed, including those followed before a descent fails, so a
+// caller that records the path gets as much of it as exists.
+//
+// Each caller gets its own instance with the mode and step fixed, so the
+// loop carries no flags: a whole-key descent has no partial-label case and
+// one without a step records nothing. find_child picks a child by its first
+// byte, so the label is compared from its second.
+//
+// Tree supplies the node type and these accessors (the same as
+// interleaved_search's, without the prefetches):
+//
+//   using Node = ...;
+//   Node root() const;
+//   bool find_child(Node, char, Node &) const;
+//   std::string_view label(Node) const;
+template <Match mode, typename Tree, typename Step = NoStep>
+bool descend(const Tree &tree, std::string_view key,
+			 typename Tree::Node &node, size_t &base, Step step = Step()) {
+	node = tree.root();
+	base = 0;
+	size_t pos = 0;
+	while (pos < key.size()) {
+		typename Tree::Node child;
+		if (!tree.find_child(node, key[pos], child))
+			return false;
+		const std::string_view label = tree.label(child);
+		const size_t rest = key.size() - pos;
+		if (label.size() > rest) {
+			if constexpr (mode == Match::kWhole) {
+				return false;
+			} else {
+				if (!same_bytes(key.data() + pos + 1, label.data() + 1,
+								rest - 1))
+					return false;
+				step(node, child);
+				node = child;
+				base = pos;
+				return true;
+			}
+		}
+		if (!same_bytes(key.data() + pos + 1, label.data() + 1,
+						label.size() - 1))
+			return false;
+		step(node, child);
+		node = child;
+		base = pos;
+		pos += label.size();
+	}
+	return true;
+}
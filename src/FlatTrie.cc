@@ -0,0 +1,613 @@
+#include "FlatTrie.h"
+#include "BatchSearch.h"
+#include "Descent.h"
+#include "RadixNode.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+constexpr char kMagic[8] = {'S', 'E', 'S', 'H', 'A', 'T', 'F', 'T'};
+
+} // namespace
+
+std::string FlatTrie::build(const RadixNode *root, size_t word_count,
+						   const std::vector<WordExtra> &extras) {
+	// Breadth-first order puts every node's children in one contiguous run,
+	// which is what lets a node record describe them as {first, count}.
+	std::vector<const RadixNode *> order;
+	order.push_back(root);
+	size_t label_total = 0;
+	size_t casing_total = 0;
+	bool valued = false;
+	for (size_t i = 0; i < order.size(); ++i) {
+		const RadixNode *node = order[i];
+		label_total += node->key.size();
+		if (node->extra) {
+			const WordExtra &extra = extras[node->extra - 1];
+			if (!extra.casing.empty())
+				casing_total += sizeof(std::uint32_t) + extra.casing.size();
+			valued = valued || extra.has_value;
+		}
+		for (const RadixNode *child : node->children) {
+			order.push_back(child);
+		}
+	}
+
+	const size_t limit = std::numeric_limits<std::uint32_t>::max();
+	if (order.size() >= limit || label_total > limit || casing_total >= limit) {
+		throw std::length_error("Trie is too large for the snapshot format");
+	}
+
+	// Every score is bounded by the root's maximum, so a zero there means
+	// there are no scores to store. Each version extends the one before, so
+	// values need the casing sections and casings the score sections.
+	const bool cased = valued || casing_total != 0;
+	const bool scored = cased || root->max_score != 0;
+	const size_t node_count = order.size();
+	const size_t section = node_count * sizeof(std::uint32_t);
+	const size_t nodes_offset = sizeof(Header);
+	const size_t scores_offset = nodes_offset + node_count * sizeof(Node);
+	const size_t max_scores_offset = scores_offset + (scored ? section : 0);
+	const size_t casing_refs_offset = max_scores_offset + (scored ? section : 0);
+	const size_t values_offset = casing_refs_offset + (cased ? section : 0);
+	const size_t first_bytes_offset =
+		values_offset + (valued ? node_count * sizeof(std::uint64_t) : 0);
+	const size_t labels_offset = first_bytes_offset + node_count;
+	const size_t casings_offset = labels_offset + label_total;
+
+	std::string image(casings_offset + casing_total, '\0');
+
+	Header header{};
+	std::memcpy(header.magic, kMagic, sizeof(kMagic));
+	header.version = valued	  ? kVersion
+					 : cased  ? kCasedVersion
+					 : scored ? kScoredVersion
+							  : kUnscoredVersion;
+	header.byte_order = kByteOrderMark;
+	header.word_count = word_count;
+	header.node_count = node_count;
+	header.label_bytes = label_total;
+	std::memcpy(&image[0], &header, sizeof(header));
+
+	std::uint32_t next_child = 1; // the root's children start right after it
+	std::uint32_t label_offset = 0;
+	std::uint32_t casing_offset = 0;
+	for (size_t i = 0; i < node_count; ++i) {
+		const RadixNode *node = order[i];
+
+		Node rec{};
+		rec.label_offset = label_offset;
+		rec.label_length = static_cast<std::uint32_t>(node->key.size());
+		rec.first_child = node->children.empty() ? 0 : next_child;
+		rec.child_count = static_cast<std::uint16_t>(node->children.size());
+		rec.flags = node->is_end ? kEndFlag : 0;
+		const WordExtra *extra = node->extra ? &extras[node->extra - 1] : nullptr;
+		if (extra && extra->has_value) {
+			rec.flags |= kValueFlag;
+			std::memcpy(&image[values_offset + i * sizeof(std::uint64_t)],
+						&extra->value, sizeof(std::uint64_t));
+		}
+		std::memcpy(&image[nodes_offset + i * sizeof(Node)], &rec, sizeof(rec));
+		if (scored) {
+			std::memcpy(&image[scores_offset + i * sizeof(std::uint32_t)],
+						&node->score, sizeof(std::uint32_t));
+			std::memcpy(&image[max_scores_offset + i * sizeof(std::uint32_t)],
+						&node->max_score, sizeof(std::uint32_t));
+		}
+		if (extra && !extra->casing.empty()) {
+			const std::string &casing = extra->casing;
+			const std::uint32_t ref = casing_offset + 1;
+			const std::uint32_t length =
+				static_cast<std::uint32_t>(casing.size());
+			std::memcpy(&image[casing_refs_offset + i * sizeof(std::uint32_t)],
+						&ref, sizeof(ref));
+			std::memcpy(&image[casings_offset + casing_offset], &length,
+						sizeof(length));
+			std::memcpy(&image[casings_offset + casing_offset + sizeof(length)],
+						casing.data(), casing.size());
+			casing_offset += sizeof(length) + length;
+		}
+
+		image[first_bytes_offset + i] = node->key.empty() ? '\0' : node->key.front();
+		if (!node->key.empty()) {
+			std::memcpy(&image[labels_offset + label_offset], node->key.data(),
+						node->key.size());
+		}
+
+		label_offset += rec.label_length;
+		next_child += rec.child_count;
+	}
+
+	return image;
+}
+
+std::unique_ptr<RadixNode>
+FlatTrie::to_tree(std::vector<WordExtra> &extras) const {
+	// Allocate every node up front, then link each one under its parent. In
+	// breadth-first order a node's children are a contiguous run that comes
+	// after it, so walking the records in index order appends every child
+	// list already sorted.
+	std::vector<RadixNode *> made(node_count_);
+	for (size_t i = 0; i < node_count_; ++i) {
+		made[i] = new RadixNode(label(static_cast<std::uint32_t>(i)));
+		made[i]->is_end = is_end(static_cast<std::uint32_t>(i));
+		made[i]->score = score(static_cast<std::uint32_t>(i));
+		made[i]->max_score = max_score(static_cast<std::uint32_t>(i));
+		const std::string_view original =
+			casing(static_cast<std::uint32_t>(i));
+		const std::optional<std::uint64_t> v =
+			value(static_cast<std::uint32_t>(i));
+		if (!original.empty() || v) {
+			WordExtra &extra = extras.emplace_back();
+			extra.casing.assign(original.data(), original.size());
+			extra.value = v.value_or(0);
+			extra.has_value = v.has_value();
+			made[i]->extra = static_cast<std::uint32_t>(extras.size());
+		}
+	}
+	for (size_t i = 0; i < node_count_; ++i) {
+		const Node &rec = nodes_[i];
+		made[i]->children.reserve(rec.child_count);
+		for (std::uint32_t c = 0; c < rec.child_count; ++c) {
+			made[i]->children.push_back(
+				std::unique_ptr<RadixNode>(made[rec.first_child + c]));
+		}
+	}
+	return std::unique_ptr<RadixNode>(made[0]);
+}
+
+std::unique_ptr<FlatTrie> FlatTrie::from_bytes(std::string image) {
+	std::unique_ptr<FlatTrie> flat(new FlatTrie());
+	flat->owned_ = std::move(image);
+	flat->attach(flat->owned_.data(), flat->owned_.size());
+	return flat;
+}
+
+std::unique_ptr<FlatTrie> FlatTrie::map_file(const std::string &path) {
+	std::unique_ptr<FlatTrie> flat(new FlatTrie());
+	flat->map_ = std::make_unique<MappedFile>(path);
+	flat->attach(flat->map_->data(), flat->map_->size());
+	return flat;
+}
+
+// Validates the image once up front so that lookups can index it without
+// bounds checks. The per-node pass is a single sequential scan of the node
+// section; requiring first_child > i also rules out cycles, so every traversal
+// is guaranteed to terminate even on a hostile file.
+void FlatTrie::attach(const char *data, size_t size) {
+	if (size < sizeof(Header)) {
+		throw std::runtime_error("Snapshot is truncated");
+	}
+
+	Header header;
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+		throw std::runtime_error("Not a Seshat snapshot");
+	}
+	if (header.byte_order != kByteOrderMark) {
+		throw std::runtime_error(
+			"Snapshot was written on a host with a different byte order");
+	}
+	if (header.version < kUnscoredVersion || header.version > kVersion) {
+		throw std::runtime_error("Unsupported snapshot version " +
+								 std::to_string(header.version));
+	}
+
+	const std::uint64_t limit = std::numeric_limits<std::uint32_t>::max();
+	if (header.node_count == 0 || header.node_count >= limit ||
+		header.label_bytes > limit) {
+		throw std::runtime_error("Snapshot header is corrupt");
+	}
+
+	const size_t node_count = static_cast<size_t>(header.node_count);
+	const bool scored = header.version >= kScoredVersion;
+	const bool cased = header.version >= kCasedVersion;
+	const bool valued = header.version >= kVersion;
+	const size_t section = node_count * sizeof(std::uint32_t);
+	const size_t scores_offset = sizeof(Header) + node_count * sizeof(Node);
+	const size_t score_bytes = scored ? section : 0;
+	const size_t casing_refs_offset = scores_offset + 2 * score_bytes;
+	const size_t values_offset = casing_refs_offset + (cased ? section : 0);
+	const size_t first_bytes_offset =
+		values_offset + (valued ? node_count * sizeof(std::uint64_t) : 0);
+	const size_t labels_offset = first_bytes_offset + node_count;
+	const size_t casings_offset =
+		labels_offset + static_cast<size_t>(header.label_bytes);
+	// The casings section is the only one whose size the header leaves out:
+	// it runs to the end of the image.
+	if (cased ? size < casings_offset || size - casings_offset >= limit
+			  : size != casings_offset) {
+		throw std::runtime_error("Snapshot size does not match its header");
+	}
+	const size_t casing_bytes = size - casings_offset;
+
+	const Node *nodes = reinterpret_cast<const Node *>(data + sizeof(Header));
+	const char *scores = scored ? data + scores_offset : nullptr;
+	const char *max_scores =
+		scored ? data + scores_offset + score_bytes : nullptr;
+	const char *casing_refs = cased ? data + casing_refs_offset : nullptr;
+	const char *values = valued ? data + values_offset : nullptr;
+	const char *first_bytes = data + first_bytes_offset;
+	const char *labels = data + labels_offset;
+	const char *casings = cased ? data + casings_offset : nullptr;
+
+	// Children must tile the nodes after the root in order, as build lays
+	// them out, so that every node but the root has exactly one parent.
+	std::uint64_t next_child = 1;
+	std::uint64_t words = 0;
+	for (size_t i = 0; i < node_count; ++i) {
+		const Node &n = nodes[i];
+		if (n.child_count != 0) {
+			if (n.first_child != next_child)
+				throw std::runtime_error("Snapshot is not a breadth-first tree");
+			next_child += n.child_count;
+		}
+		if (static_cast<std::uint64_t>(n.label_offset) + n.label_length >
+			header.label_bytes) {
+			throw std::runtime_error("Snapshot node label out of range");
+		}
+		// Only the root has an empty label, and only non-root labels are
+		// mirrored into first_bytes.
+		if ((i == 0) != (n.label_length == 0) ||
+			(i != 0 && first_bytes[i] != labels[n.label_offset])) {
+			throw std::runtime_error("Snapshot node label is inconsistent");
+		}
+		// Every subtree holds a word (rank and select count on it), so the
+		// only leaf that may be a non-word is the root of an empty trie.
+		if (n.child_count == 0 && i != 0 && !(n.flags & kEndFlag))
+			throw std::runtime_error("Snapshot has a leaf that is not a word");
+		words += (n.flags & kEndFlag) ? 1 : 0;
+		if (n.child_count != 0 &&
+			(n.first_child <= i ||
+			 static_cast<std::uint64_t>(n.first_child) + n.child_count >
+				 node_count)) {
+			throw std::runtime_error("Snapshot child range out of bounds");
+		}
+		// Siblings must be strictly ascending by first byte, which is the
+		// order thawing rebuilds them in.
+		for (std::uint32_t c = 1; c < n.child_count; ++c) {
+			const unsigned char *run = reinterpret_cast<const unsigned char *>(
+				first_bytes + n.first_child);
+			if (run[c - 1] >= run[c]) {
+				throw std::runtime_error("Snapshot children are not sorted");
+			}
+		}
+		// top_k prunes on max_scores, so each must be exactly the largest
+		// score at or below its node.
+		if (scored) {
+			const std::uint32_t self = static_cast<std::uint32_t>(i);
+			std::uint32_t max =
+				(n.flags & kEndFlag) ? load_u32(scores, self) : 0;
+			for (std::uint32_t c = 0; c < n.child_count; ++c)
+				max = std::max(max, load_u32(max_scores, n.first_child + c));
+			if (max != load_u32(max_scores, self)) {
+				throw std::runtime_error("Snapshot scores are inconsistent");
+			}
+		}
+		// Only a word has a value, and only a version 4 image has any.
+		if ((n.flags & ~(kEndFlag | kValueFlag)) != 0 ||
+			((n.flags & kValueFlag) && (!valued || !(n.flags & kEndFlag)))) {
+			throw std::runtime_error("Snapshot node flags are invalid");
+		}
+		// Only a word has a spelling, and its entry must fit the section.
+		const std::uint32_t ref =
+			cased ? load_u32(casing_refs, static_cast<std::uint32_t>(i)) : 0;
+		if (ref != 0) {
+			const size_t at = ref - 1;
+			if (!(n.flags & kEndFlag) || at > casing_bytes ||
+				casing_bytes - at < sizeof(std::uint32_t)) {
+				throw std::runtime_error("Snapshot casing out of range");
+			}
+			const std::uint32_t length = load_u32(casings + at, 0);
+			if (length == 0 ||
+				casing_bytes - at - sizeof(std::uint32_t) < length) {
+				throw std::runtime_error("Snapshot casing out of range");
+			}
+		}
+	}
+
+	if (next_child != node_count || words != header.word_count)
+		throw std::runtime_error("Snapshot node and word counts are inconsistent");
+
+	data_ = data;
+	size_ = size;
+	nodes_ = nodes;
+	scores_ = scores;
+	max_scores_ = max_scores;
+	casing_refs_ = casing_refs;
+	values_ = values;
+	casings_ = casings;
+	first_bytes_ = first_bytes;
+	labels_ = labels;
+	word_count_ = header.word_count;
+	node_count_ = node_count;
+	label_bytes_ = static_cast<size_t>(header.label_bytes);
+}
+
+// Sibling first bytes are contiguous and unique, so memchr over the run finds
+// the one candidate child without touching any sibling's node record.
+std::uint32_t FlatTrie::find_child(std::uint32_t n, char c) const noexcept {
+	SESHAT_COUNT(nodes_visited, 1);
+	const Node &node = nodes_[n];
+	if (node.child_count == 0)
+		return kNoNode;
+	const char *run = first_bytes_ + node.first_child;
+	SESHAT_COUNT(child_probes, 1);
+	const void *hit = std::memchr(run, c, node.child_count);
+	if (!hit)
+		return kNoNode;
+	return node.first_child +
+		   static_cast<std::uint32_t>(static_cast<const char *>(hit) - run);
+}
+
+std::uint32_t FlatTrie::lower_child(std::uint32_t n,
+								   char c) const noexcept {
+	const Node &node = nodes_[n];
+	const auto *run =
+		reinterpret_cast<const unsigned char *>(first_bytes_) + node.first_child;
+	return static_cast<std::uint32_t>(
+		std::lower_bound(run, run + node.child_count,
+						 static_cast<unsigned char>(c)) -
+		run);
+}
+
+// The accessors interleaved_search and descend expect. A node's record
+// holds where its children's first bytes and its label are, so each is
+// fetched in a step of its own once the record has arrived.
+struct FlatTrie::SearchView {
+	using Node = std::uint32_t;
+	const FlatTrie *flat;
+	Node root() const { return 0; }
+	void prefetch_children(Node n) const {
+		prefetch_read(flat->first_bytes_ + flat->nodes_[n].first_child);
+	}
+	bool find_child(Node n, char c, Node &child) const {
+		child = flat->find_child(n, c);
+		return child != kNoNode;
+	}
+	void prefetch_node(Node n) const { prefetch_read(flat->nodes_ + n); }
+	void prefetch_label(Node n) const {
+		prefetch_read(flat->labels_ + flat->nodes_[n].label_offset);
+	}
+	std::string_view label(Node n) const { return flat->label(n); }
+	bool is_end(Node n) const { return flat->is_end(n); }
+};
+
+std::uint32_t FlatTrie::find_word(std::string_view word) const noexcept {
+	if (word.empty())
+		return kNoNode;
+
+	std::uint32_t node = 0;
+	size_t base = 0;
+	if (!descend<Match::kWhole>(SearchView{this}, word, node, base))
+		return kNoNode;
+	return is_end(node) ? node : kNoNode;
+}
+
+bool FlatTrie::search(std::string_view word) const {
+	return find_word(word) != kNoNode;
+}
+
+void FlatTrie::search_many(const std::string_view *words, size_t count,
+						   std::uint8_t *bitmap) const {
+	interleaved_search(SearchView{this}, words, count, bitmap);
+}
+
+std::optional<std::uint32_t> FlatTrie::score_of(std::string_view word) const {
+	const std::uint32_t n = find_word(word);
+	if (n == kNoNode)
+		return std::nullopt;
+	return score(n);
+}
+
+std::optional<std::uint64_t> FlatTrie::value_of(std::string_view word) const {
+	const std::uint32_t n = find_word(word);
+	if (n == kNoNode)
+		return std::nullopt;
+	return value(n);
+}
+
+bool FlatTrie::starts_with(std::string_view prefix) const {
+	if (prefix.empty())
+		return word_count_ != 0;
+
+	std::uint32_t node = 0;
+	size_t base = 0;
+	return descend<Match::kPrefix>(SearchView{this}, prefix, node, base);
+}
+
+std::uint32_t FlatTrie::locate(std::string_view prefix,
+							   size_t &base) const noexcept {
+	std::uint32_t node = 0;
+	if (!descend<Match::kPrefix>(SearchView{this}, prefix, node, base))
+		return kNoNode;
+	return node;
+}
+
+FlatTrie::Cursor FlatTrie::cursor(std::string_view prefix) const {
+	Cursor cursor(this);
+	size_t base = 0;
+	const std::uint32_t start = locate(prefix, base);
+	if (start == kNoNode)
+		return cursor;
+
+	cursor.word_.assign(prefix.substr(0, base));
+	cursor.stack_.push_back({start, 0, base});
+	cursor.word_.append(label(start));
+	cursor.pending_ = is_end(start);
+	return cursor;
+}
+
+// Descends along `from` as far as the trie follows it, leaving each frame's
+// next child at the first one whose words are not all less than `from`.
+// Where the path and `from` part ways, the child there either sorts wholly
+// after it (and is next) or wholly before it (and is skipped).
+FlatTrie::Cursor
+FlatTrie::range_cursor(std::string_view from,
+					   std::optional<std::string_view> to) const {
+	Cursor cursor(this);
+	if (to) {
+		cursor.bounded_ = true;
+		cursor.end_.assign(to->data(), to->size());
+	}
+	std::uint32_t n = 0;
+	size_t pos = 0;
+	cursor.stack_.push_back({n, 0, 0});
+	for (;;) {
+		if (pos == from.size()) {
+			cursor.pending_ = is_end(n);
+			break;
+		}
+		const std::uint32_t j = lower_child(n, from[pos]);
+		cursor.stack_.back().next = j;
+		if (j == nodes_[n].child_count)
+			break;
+		const std::uint32_t child = nodes_[n].first_child + j;
+		const std::string_view key = label(child);
+		const std::string_view rest = from.substr(pos);
+		const size_t common = match_length(key.data(), rest.data(),
+										   std::min(key.size(), rest.size()));
+		if (common < key.size()) {
+			if (common < rest.size() &&
+				static_cast<unsigned char>(key[common]) <
+					static_cast<unsigned char>(rest[common]))
+				++cursor.stack_.back().next;
+			break;
+		}
+		++cursor.stack_.back().next;
+		cursor.stack_.push_back({child, 0, cursor.word_.size()});
+		cursor.word_.append(key);
+		n = child;
+		pos += common;
+	}
+	return cursor;
+}
+
+std::vector<std::uint32_t> FlatTrie::word_ranks() const {
+	std::vector<std::uint32_t> ranks(node_count_);
+	std::uint32_t seen = 0;
+	std::vector<std::uint32_t> stack{0};
+	while (!stack.empty()) {
+		const std::uint32_t n = stack.back();
+		stack.pop_back();
+		ranks[n] = seen;
+		if (is_end(n))
+			++seen;
+		const Node &node = nodes_[n];
+		for (std::uint32_t i = node.child_count; i-- > 0;)
+			stack.push_back(node.first_child + i);
+	}
+	return ranks;
+}
+
+// The same descent as range_cursor, tracking the rank of the first word past
+// the current subtree: where the descent stops, the words before that point
+// are the ones counted.
+size_t FlatTrie::rank(std::string_view word,
+					  const std::vector<std::uint32_t> &ranks) const {
+	size_t after = word_count_;
+	std::uint32_t n = 0;
+	size_t pos = 0;
+	for (;;) {
+		SESHAT_COUNT(nodes_visited, 1);
+		if (pos == word.size())
+			return ranks[n];
+		const Node &node = nodes_[n];
+		const std::uint32_t j = lower_child(n, word[pos]);
+		if (j == node.child_count)
+			return after;
+		const std::uint32_t child = node.first_child + j;
+		const size_t next = j + 1 < node.child_count ? ranks[child + 1] : after;
+		const std::string_view key = label(child);
+		const std::string_view rest = word.substr(pos);
+		const size_t common = match_length(key.data(), rest.data(),
+										   std::min(key.size(), rest.size()));
+		if (common < key.size()) {
+			if (common < rest.size() &&
+				static_cast<unsigned char>(key[common]) <
+					static_cast<unsigned char>(rest[common]))
+				return next;
+			return ranks[child];
+		}
+		n = child;
+		pos += common;
+		after = next;
+	}
+}
+
+std::string FlatTrie::select(size_t index,
+							 const std::vector<std::uint32_t> &ranks) const {
+	std::string word;
+	std::uint32_t n = 0;
+	while (!(is_end(n) && ranks[n] == index)) {
+		SESHAT_COUNT(nodes_visited, 1);
+		// Every subtree holds a word, so sibling ranks strictly increase and
+		// the last child starting at or before `index` holds it.
+		const Node &node = nodes_[n];
+		const std::uint32_t *first = ranks.data() + node.first_child;
+		n = static_cast<std::uint32_t>(
+			std::upper_bound(first, first + node.child_count, index) - 1 -
+			ranks.data());
+		word.append(label(n));
+	}
+	return std::string(spelling(n, word));
+}
+
+// The accessors best_first_top_k, glob_search and levenshtein_search expect,
+// over node indices.
+struct FlatTrie::TreeView {
+	using Node = std::uint32_t;
+	const FlatTrie *flat;
+	std::string_view label(Node n) const { return flat->label(n); }
+	bool is_end(Node n) const { return flat->is_end(n); }
+	std::uint32_t score(Node n) const { return flat->score(n); }
+	std::uint32_t max_score(Node n) const { return flat->max_score(n); }
+	std::string_view word(Node n, std::string_view path) const {
+		return flat->spelling(n, path);
+	}
+	template <typename F> void for_each_child(Node n, F &&fn) const {
+		const FlatTrie::Node &rec = flat->nodes_[n];
+		SESHAT_COUNT(nodes_visited, rec.child_count);
+		for (std::uint32_t c = 0; c < rec.child_count; ++c)
+			fn(rec.first_child + c);
+	}
+};
+
+std::vector<ScoredWord> FlatTrie::top_k(std::string_view prefix,
+										size_t k) const {
+	size_t base = 0;
+	const std::uint32_t start = locate(prefix, base);
+	if (start == kNoNode)
+		return {};
+
+	std::string path(prefix.substr(0, base));
+	path.append(label(start));
+	return best_first_top_k(TreeView{this}, start, std::move(path), k);
+}
+
+std::vector<FuzzyMatch> FlatTrie::fuzzy_search(std::string_view word,
+											  std::uint32_t max_distance,
+											  size_t limit) const {
+	return levenshtein_search(TreeView{this}, 0, EditDistance(word),
+							  max_distance, limit);
+}
+
+std::vector<std::string>
+FlatTrie::pattern_search(std::string_view pattern) const {
+	std::vector<std::string> results;
+	const GlobPattern glob(pattern);
+	size_t base = 0;
+	const std::uint32_t start = locate(glob.literal_prefix(), base);
+	if (start == kNoNode)
+		return results;
+
+	std::string path(glob.literal_prefix().substr(0, base));
+	path.append(label(start));
+	glob_search(TreeView{this}, start, std::move(path), glob,
+				[&](std::string_view word) { results.emplace_back(word); });
+	return results;
+}
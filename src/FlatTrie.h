@@ -0,0 +1,331 @@
+#pragma once
+#include "Fuzzy.h"
+#include "Glob.h"
+#include "MappedFile.h"
+#include "PerfCounters.h"
+#include "TopK.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class RadixNode;
+struct WordExtra;
+
+// A read-only, pointer-free image of a radix trie.
+//
+// The pointer tree is flattened breadth-first into one contiguous byte image:
+// every node becomes a fixed 16-byte record, the children of a node occupy a
+// contiguous index range, and all edge labels are packed into a single byte
+// section. Because the image holds offsets rather than pointers it can be
+// written to disk and later used in place straight from an mmap'd file, with no
+// per-node allocation: lookups walk the mapped pages directly, and every
+// process that maps the same file shares one page-cache copy.
+//
+// Image layout (all integers in the producing host's byte order, which is
+// recorded in the header and checked on load):
+//
+//   Header                          40 bytes
+//   Node[node_count]                16 bytes each, breadth-first, root first
+//   scores[node_count]              4 bytes each (version 2 and up)
+//   max_scores[node_count]          4 bytes each (version 2 and up)
+//   casing_refs[node_count]         4 bytes each (version 3 and up)
+//   values[node_count]              8 bytes each (version 4 only)
+//   first_bytes[node_count]         first label byte of each node (root: 0)
+//   labels[label_bytes]             edge labels, concatenated
+//   casings                         the rest of the image (version 3 and up)
+//
+// first_bytes is a side array so that choosing a child is a byte scan over the
+// siblings' contiguous first bytes instead of a hop into each sibling's label.
+// The score sections carry RadixNode::score and max_score. A case-folding
+// trie's original spellings (WordExtra::casing) are stored as {uint32 length,
+// bytes} entries in the casings section, and casing_refs holds 1 + the offset
+// of a terminal's entry, or 0 when it has none. A word's value
+// (WordExtra::value) is in the values section when its node has kValueFlag.
+// Each image is written in the lowest version that holds its contents, so a
+// trie with no scores, casings or values pays nothing for them.
+class FlatTrie {
+  public:
+	static constexpr std::uint32_t kVersion = 4;
+	static constexpr std::uint32_t kCasedVersion = 3;
+	static constexpr std::uint32_t kScoredVersion = 2;
+	static constexpr std::uint32_t kUnscoredVersion = 1;
+	static constexpr std::uint32_t kByteOrderMark = 0x01020304;
+	static constexpr std::uint16_t kEndFlag = 0x0001;
+	static constexpr std::uint16_t kValueFlag = 0x0002; // a word with a value
+
+	struct Header {
+		char magic[8]; // "SESHATFT"
+		std::uint32_t version;
+		std::uint32_t byte_order;
+		std::uint64_t word_count;
+		std::uint64_t node_count;
+		std::uint64_t label_bytes;
+	};
+
+	struct Node {
+		std::uint32_t label_offset;
+		std::uint32_t label_length;
+		std::uint32_t first_child; // index of the first child (if any)
+		std::uint16_t child_count;
+		std::uint16_t flags;
+	};
+
+	static_assert(sizeof(Header) == 40, "snapshot header must stay 40 bytes");
+	static_assert(sizeof(Node) == 16, "snapshot node must stay 16 bytes");
+
+	// Serializes the pointer tree rooted at `root` into a snapshot image,
+	// resolving RadixNode::extra against `extras`. Throws std::length_error
+	// if the trie exceeds the format's 32-bit limits.
+	static std::string build(const RadixNode *root, size_t word_count,
+							 const std::vector<WordExtra> &extras);
+
+	// Adopts an in-memory image. Throws std::runtime_error if it is malformed.
+	static std::unique_ptr<FlatTrie> from_bytes(std::string image);
+	// Maps a snapshot file read-only and uses it in place. Throws
+	// std::runtime_error if the file cannot be mapped or is malformed.
+	static std::unique_ptr<FlatTrie> map_file(const std::string &path);
+
+	// Rebuilds an equivalent pointer tree (the inverse of build()),
+	// appending the original spellings and values to `extras`.
+	std::unique_ptr<RadixNode> to_tree(std::vector<WordExtra> &extras) const;
+
+	// Resumable depth-first enumeration of the words under a prefix, in the
+	// same order as for_each_word. The cursor keeps its own stack and one
+	// word buffer, so words can be pulled a batch at a time; it reads the
+	// image in place and must not outlive it.
+	class Cursor {
+	  public:
+		// Calls emit(word, score) for up to `max` further words and returns
+		// how many were produced; fewer than `max` means the cursor is
+		// exhausted. The view passed to emit is only valid for the duration
+		// of the call.
+		template <typename F> size_t advance(size_t max, F &&emit) {
+			size_t produced = 0;
+			if (pending_ && max != 0) {
+				pending_ = false;
+				if (!before_end()) {
+					stack_.clear();
+					return 0;
+				}
+				const std::uint32_t start = stack_.back().node;
+				emit(flat_->spelling(start, word_), flat_->score(start));
+				++produced;
+			}
+			while (produced < max && !stack_.empty()) {
+				Frame &top = stack_.back();
+				const Node &node = flat_->nodes_[top.node];
+				if (top.next == node.child_count) {
+					word_.resize(top.base);
+					stack_.pop_back();
+					continue;
+				}
+				const std::uint32_t child = node.first_child + top.next++;
+				SESHAT_COUNT(nodes_visited, 1);
+				stack_.push_back({child, 0, word_.size()});
+				word_.append(flat_->label(child));
+				if (flat_->is_end(child)) {
+					if (!before_end()) {
+						stack_.clear();
+						break;
+					}
+					emit(flat_->spelling(child, word_), flat_->score(child));
+					++produced;
+				}
+			}
+			return produced;
+		}
+
+		// The value of the word just passed to emit, if it has one.
+		std::optional<std::uint64_t> value() const noexcept {
+			return flat_->value(stack_.back().node);
+		}
+
+	  private:
+		friend class FlatTrie;
+		struct Frame {
+			std::uint32_t node;
+			std::uint32_t next; // index of the next child to visit
+			size_t base;		// word_ length before this node's label
+		};
+
+		explicit Cursor(const FlatTrie *flat) : flat_(flat) {}
+
+		// Enumeration is in byte order, so the first word at or past the
+		// bound ends it.
+		bool before_end() const noexcept {
+			return !bounded_ || std::string_view(word_) < std::string_view(end_);
+		}
+
+		const FlatTrie *flat_;
+		std::vector<Frame> stack_;
+		std::string word_;
+		bool pending_ = false; // the start node is a word not yet emitted
+		bool bounded_ = false; // stop before the first word >= end_
+		std::string end_;
+	};
+
+	bool search(std::string_view word) const;
+	// See RadixTrie::search_many.
+	void search_many(const std::string_view *words, size_t count,
+					 std::uint8_t *bitmap) const;
+	bool starts_with(std::string_view prefix) const;
+	Cursor cursor(std::string_view prefix) const;
+	// A cursor over the words w with from <= w < to, or every word from
+	// `from` on without `to`.
+	Cursor range_cursor(std::string_view from,
+						std::optional<std::string_view> to) const;
+
+	// Entry n is the number of words before node n in enumeration order,
+	// which rank and select below take to answer in O(depth) steps of a
+	// binary search over siblings. One O(n) pass builds it.
+	std::vector<std::uint32_t> word_ranks() const;
+	// The number of words less than `word`.
+	size_t rank(std::string_view word,
+				const std::vector<std::uint32_t> &ranks) const;
+	// The spelling of the word at position `index` (which must be less than
+	// size()) in enumeration order.
+	std::string select(size_t index,
+					   const std::vector<std::uint32_t> &ranks) const;
+	// The score of `word`, or nullopt if it is not in the trie.
+	std::optional<std::uint32_t> score_of(std::string_view word) const;
+	// The value of `word`, or nullopt if it is not in the trie or has none.
+	std::optional<std::uint64_t> value_of(std::string_view word) const;
+	// See best_first_top_k in TopK.h.
+	std::vector<ScoredWord> top_k(std::string_view prefix, size_t k) const;
+	// Words matching a `*`/`?` pattern, sorted; see glob_search in Glob.h.
+	std::vector<std::string> pattern_search(std::string_view pattern) const;
+	// See levenshtein_search in Fuzzy.h.
+	std::vector<FuzzyMatch> fuzzy_search(std::string_view word,
+										 std::uint32_t max_distance,
+										 size_t limit) const;
+
+	// The spelling reported for `word`, which must be in the trie: its
+	// original casing if one was recorded, else `word` itself.
+	std::string_view spelling_of(std::string_view word) const noexcept {
+		return spelling(find_word(word), word);
+	}
+
+	// Calls fn(word, depth) for every word in lexicographic-by-edge order,
+	// where depth is the node depth of the word's terminal (root = 0).
+	template <typename F> void for_each_word(F &&fn) const {
+		std::string word;
+		for_each_word_from(0, 0, word, fn);
+	}
+	// Whether pred(word) holds for any word, trying them in the same order
+	// and stopping at the first one it holds for.
+	template <typename F> bool any_word(F &&pred) const {
+		std::string word;
+		return any_word_from(0, word, pred);
+	}
+
+	size_t size() const noexcept { return static_cast<size_t>(word_count_); }
+	size_t node_count() const noexcept { return node_count_; }
+	size_t label_bytes() const noexcept { return label_bytes_; }
+	bool is_mapped() const noexcept { return map_ != nullptr; }
+	// The raw image, suitable for writing back out unchanged.
+	std::string_view image() const noexcept { return {data_, size_}; }
+
+  private:
+	static constexpr std::uint32_t kNoNode = 0xFFFFFFFFu;
+
+	struct TreeView;
+	struct SearchView;
+
+	FlatTrie() = default;
+	void attach(const char *data, size_t size);
+
+	std::string_view label(std::uint32_t n) const noexcept {
+		return {labels_ + nodes_[n].label_offset, nodes_[n].label_length};
+	}
+	bool is_end(std::uint32_t n) const noexcept {
+		return (nodes_[n].flags & kEndFlag) != 0;
+	}
+	std::uint32_t score(std::uint32_t n) const noexcept {
+		return scores_ ? load_u32(scores_, n) : 0;
+	}
+	std::uint32_t max_score(std::uint32_t n) const noexcept {
+		return max_scores_ ? load_u32(max_scores_, n) : 0;
+	}
+	std::optional<std::uint64_t> value(std::uint32_t n) const noexcept {
+		if (!(nodes_[n].flags & kValueFlag))
+			return std::nullopt;
+		std::uint64_t v;
+		std::memcpy(&v, values_ + size_t(n) * sizeof(v), sizeof(v));
+		return v;
+	}
+	// The original spelling of the word ending at `n`, or an empty view if
+	// the word was stored as it was inserted.
+	std::string_view casing(std::uint32_t n) const noexcept {
+		const std::uint32_t ref = casing_refs_ ? load_u32(casing_refs_, n) : 0;
+		if (ref == 0)
+			return {};
+		const char *entry = casings_ + (ref - 1);
+		return {entry + sizeof(std::uint32_t), load_u32(entry, 0)};
+	}
+	std::string_view spelling(std::uint32_t n,
+							  std::string_view folded) const noexcept {
+		const std::string_view original = casing(n);
+		return original.empty() ? folded : original;
+	}
+	static std::uint32_t load_u32(const char *base, std::uint32_t n) noexcept {
+		std::uint32_t v;
+		std::memcpy(&v, base + size_t(n) * sizeof(v), sizeof(v));
+		return v;
+	}
+	std::uint32_t find_child(std::uint32_t n, char c) const noexcept;
+	// The position among n's children of the first whose label starts with
+	// a byte not less than `c`; child_count if there is none.
+	std::uint32_t lower_child(std::uint32_t n, char c) const noexcept;
+	// The terminal node for `word`, or kNoNode.
+	std::uint32_t find_word(std::string_view word) const noexcept;
+	// The node whose path first covers `prefix` (kNoNode if none), with
+	// `base` set to the length of the prefix part before that node's label.
+	std::uint32_t locate(std::string_view prefix, size_t &base) const noexcept;
+
+	template <typename F>
+	void for_each_word_from(std::uint32_t n, int depth, std::string &word,
+							F &fn) const {
+		const size_t base = word.size();
+		word.append(label(n));
+		if (is_end(n))
+			fn(std::string_view(word), depth);
+		const Node &node = nodes_[n];
+		for (std::uint32_t i = 0; i < node.child_count; ++i)
+			for_each_word_from(node.first_child + i, depth + 1, word, fn);
+		word.resize(base);
+	}
+	template <typename F>
+	bool any_word_from(std::uint32_t n, std::string &word, F &pred) const {
+		const size_t base = word.size();
+		word.append(label(n));
+		bool found = is_end(n) && pred(std::string_view(word));
+		const Node &node = nodes_[n];
+		for (std::uint32_t i = 0; !found && i < node.child_count; ++i)
+			found = any_word_from(node.first_child + i, word, pred);
+		word.resize(base);
+		return found;
+	}
+
+	// Backing storage: exactly one of owned_ / map_ holds the image.
+	std::string owned_;
+	std::unique_ptr<MappedFile> map_;
+
+	const char *data_ = nullptr;
+	size_t size_ = 0;
+	const Node *nodes_ = nullptr;
+	const char *scores_ = nullptr;	   // null in version 1 images
+	const char *max_scores_ = nullptr; // null in version 1 images
+	const char *casing_refs_ = nullptr; // null before version 3
+	const char *values_ = nullptr;		// null before version 4
+	const char *casings_ = nullptr;
+	const char *first_bytes_ = nullptr;
+	const char *labels_ = nullptr;
+	std::uint64_t word_count_ = 0;
+	size_t node_count_ = 0;
+	size_t label_bytes_ = 0;
+};
@@ -0,0 +1,30 @@
+#include "Fuzzy.h"
+#include <algorithm>
+
+void EditDistance::start(std::uint32_t *row) const noexcept {
+	for (size_t j = 0; j <= word_.size(); ++j)
+		row[j] = static_cast<std::uint32_t>(j);
+}
+
+// Entry j of the next row is the cheapest of deleting the new byte (the entry
+// above), inserting word byte j (the entry to the left) and matching or
+// substituting it (the entry diagonally above), updated in place with the
+// old diagonal kept aside.
+bool EditDistance::step(std::uint32_t *row, std::string_view text,
+						std::uint32_t bound) const noexcept {
+	const size_t m = word_.size();
+	for (char c : text) {
+		std::uint32_t diagonal = row[0];
+		std::uint32_t lowest = ++row[0];
+		for (size_t j = 1; j <= m; ++j) {
+			const std::uint32_t above = row[j];
+			row[j] = std::min({above + 1, row[j - 1] + 1,
+							   diagonal + (word_[j - 1] != c ? 1u : 0u)});
+			diagonal = above;
+			lowest = std::min(lowest, row[j]);
+		}
+		if (lowest > bound)
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct FuzzyMatch {
+	std::string word;
+	std::uint32_t distance;
+	std::uint32_t score;
+};
+
+// Levenshtein distance from a fixed word to a text that arrives in pieces,
+// kept as one row of the dynamic-programming table: after feeding text t,
+// entry j of the row is the distance from t to the first j bytes of the word,
+// and the last entry is the distance to the whole word. Feeding a byte
+// derives the next row from the current one alone, so a walk along edge
+// labels carries one row per depth and siblings restart from their parent's.
+//
+// Feeding more text never lowers the smallest entry of a row, so that entry
+// bounds the distance of every extension of the text fed so far from below,
+// and a subtree can be dropped once it exceeds the bound. Distances count
+// bytes, just as patternSearch's `?` matches one byte.
+class EditDistance {
+  public:
+	explicit EditDistance(std::string_view word) : word_(word) {}
+
+	size_t row_size() const noexcept { return word_.size() + 1; }
+	// Writes the row for the empty text into `row`.
+	void start(std::uint32_t *row) const noexcept;
+	// Advances `row` past `text`; false once every entry exceeds `bound`.
+	bool step(std::uint32_t *row, std::string_view text,
+			  std::uint32_t bound) const noexcept;
+	std::uint32_t distance(const std::uint32_t *row) const noexcept {
+		return row[word_.size()];
+	}
+
+  private:
+	std::string word_;
+};
+
+// The `limit` words in the trie closest to `query`'s word, at most
+// `max_distance` edits away. They come ranked by distance, then by score,
+// highest first, then in lexicographic byte order of the stored words.
+//
+// The walk starts at `root` and steps the row along every edge label,
+// skipping a subtree as soon as no entry of its row is within reach. Once
+// `limit` words are in hand, reach shrinks to the worst of their distances,
+// since nothing further away can displace one of them.
+//
+// Tree supplies the node type and its accessors (word() as in TopK.h):
+//
+//   using Node = ...;
+//   std::string_view label(Node) const;
+//   bool is_end(Node) const;
+//   std::uint32_t score(Node) const;
+//   std::string_view word(Node, std::string_view path) const;
+//   template <typename F> void for_each_child(Node, F &&) const;
+template <typename Tree>
+std::vector<FuzzyMatch> levenshtein_search(const Tree &tree,
+										   typename Tree::Node root,
+										   const EditDistance &query,
+										   std::uint32_t max_distance,
+										   size_t limit) {
+	if (limit == 0)
+		return {};
+
+	struct Entry {
+		FuzzyMatch match;
+		std::string path;
+	};
+	auto better = [](const Entry &a, const Entry &b) {
+		if (a.match.distance != b.match.distance)
+			return a.match.distance < b.match.distance;
+		if (a.match.score != b.match.score)
+			return a.match.score > b.match.score;
+		return a.path < b.path;
+	};
+	// A heap of the matches kept so far, worst on top.
+	std::vector<Entry> best;
+	std::uint32_t reach = max_distance;
+
+	const size_t width = query.row_size();
+	std::vector<std::uint32_t> rows(width);
+	query.start(rows.data());
+	std::string path;
+
+	auto visit = [&](auto &self, typename Tree::Node node,
+					 size_t depth) -> void {
+		const size_t at = depth * width;
+		const std::uint32_t distance = query.distance(rows.data() + at);
+		if (tree.is_end(node) && distance <= reach) {
+			Entry entry{{std::string(tree.word(node, path)), distance,
+						 tree.score(node)},
+						path};
+			const bool full = best.size() == limit;
+			if (!full || better(entry, best.front())) {
+				if (full) {
+					std::pop_heap(best.begin(), best.end(), better);
+					best.pop_back();
+				}
+				best.push_back(std::move(entry));
+				std::push_heap(best.begin(), best.end(), better);
+				if (best.size() == limit)
+					reach = best.front().match.distance;
+			}
+		}
+		tree.for_each_child(node, [&](typename Tree::Node child) {
+			const size_t next = at + width;
+			if (rows.size() < next + width)
+				rows.resize(next + width);
+			std::copy(rows.begin() + at, rows.begin() + next,
+					  rows.begin() + next);
+			const std::string_view label = tree.label(child);
+			if (!query.step(rows.data() + next, label, reach))
+				return;
+			const size_t base = path.size();
+			path.append(label);
+			self(self, child, depth + 1);
+			path.resize(base);
+		});
+	};
+	visit(visit, root, 0);
+
+	std::sort_heap(best.begin(), best.end(), better);
+	std::vector<FuzzyMatch> results;
+	results.reserve(best.size());
+	for (Entry &entry : best)
+		results.push_back(std::move(entry.match));
+	return results;
+}
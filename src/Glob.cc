@@ -0,0 +1,64 @@
+#include "Glob.h"
+
+GlobPattern::GlobPattern(std::string_view pattern) {
+	pattern_.reserve(pattern.size());
+	for (char c : pattern)
+		if (c != '*' || pattern_.empty() || pattern_.back() != '*')
+			pattern_.push_back(c);
+
+	const size_t m = pattern_.size();
+	literal_length_ = std::min(pattern_.find_first_of("*?"), m);
+	words_ = (m + 1 + 63) / 64;
+	trailing_star_ = m != 0 && pattern_.back() == '*';
+	masks_.assign(256 * words_, 0);
+	stars_.assign(words_, 0);
+
+	for (size_t i = 0; i < m; ++i) {
+		const std::uint64_t bit = std::uint64_t(1) << (i % 64);
+		const unsigned char c = static_cast<unsigned char>(pattern_[i]);
+		if (c == '*') {
+			stars_[i / 64] |= bit;
+		} else if (c == '?') {
+			for (size_t b = 0; b < 256; ++b)
+				masks_[b * words_ + i / 64] |= bit;
+		} else {
+			masks_[c * words_ + i / 64] |= bit;
+		}
+	}
+}
+
+// Adds the state past every `*` state. Stars never follow one another, so
+// one pass reaches the closure.
+void GlobPattern::close(std::uint64_t *set) const noexcept {
+	std::uint64_t carry = 0;
+	for (size_t w = 0; w < words_; ++w) {
+		const std::uint64_t starred = set[w] & stars_[w];
+		set[w] |= (starred << 1) | carry;
+		carry = starred >> 63;
+	}
+}
+
+void GlobPattern::start(std::uint64_t *set) const noexcept {
+	std::fill(set, set + words_, 0);
+	set[0] = 1;
+	close(set);
+}
+
+bool GlobPattern::step(std::uint64_t *set,
+					   std::string_view text) const noexcept {
+	for (unsigned char c : text) {
+		const std::uint64_t *mask = masks_.data() + c * words_;
+		std::uint64_t carry = 0;
+		std::uint64_t live = 0;
+		for (size_t w = 0; w < words_; ++w) {
+			const std::uint64_t moved = set[w] & mask[w];
+			set[w] = (moved << 1) | carry | (set[w] & stars_[w]);
+			carry = moved >> 63;
+			live |= set[w];
+		}
+		if (!live)
+			return false;
+		close(set);
+	}
+	return true;
+}
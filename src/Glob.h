@@ -0,0 +1,118 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A `*`/`?` wildcard pattern compiled into a bit-parallel NFA.
+//
+// State i means "the first i pattern bytes are matched", so a pattern of m
+// bytes has m + 1 states and a state set is a bitset of (m + 1) bits held in
+// set_words() 64-bit words. Consuming a byte is a shift-and over those words:
+// literal and `?` states move one bit up when the byte fits, `*` states stay
+// put, and a `*` state is always accompanied by the state just past it. As in
+// the recursive matcher it replaces, `?` matches one byte and `*` any run of
+// bytes.
+//
+// A set goes empty as soon as no word with the text fed so far can match,
+// which lets a walk along edge labels drop the whole subtree below.
+class GlobPattern {
+  public:
+	explicit GlobPattern(std::string_view pattern);
+
+	// The bytes before the first wildcard; every match starts with them.
+	std::string_view literal_prefix() const noexcept {
+		return std::string_view(pattern_).substr(0, literal_length_);
+	}
+	size_t set_words() const noexcept { return words_; }
+
+	// Writes the state set for the empty text into `set`.
+	void start(std::uint64_t *set) const noexcept;
+	// Advances `set` past `text`; false once the set is empty.
+	bool step(std::uint64_t *set, std::string_view text) const noexcept;
+	// Whether the text fed so far matches.
+	bool accepts(const std::uint64_t *set) const noexcept {
+		return test(set, pattern_.size());
+	}
+	// Whether every extension of the text fed so far matches, which holds
+	// once a trailing `*` is reached.
+	bool accepts_all(const std::uint64_t *set) const noexcept {
+		return trailing_star_ && test(set, pattern_.size() - 1);
+	}
+
+  private:
+	static bool test(const std::uint64_t *set, size_t bit) noexcept {
+		return (set[bit / 64] >> (bit % 64)) & 1;
+	}
+	void close(std::uint64_t *set) const noexcept;
+
+	std::string pattern_; // runs of `*` collapsed to one
+	size_t literal_length_ = 0;
+	size_t words_ = 1;
+	bool trailing_star_ = false;
+	std::vector<std::uint64_t> masks_; // [byte][word]: states that byte moves
+	std::vector<std::uint64_t> stars_; // `*` states
+};
+
+// Calls emit(word) for every word below `start` that matches `glob`, in
+// lexicographic order, where `path` is the text of every edge from the root
+// through `start`. The NFA runs along each edge label and a subtree is
+// skipped as soon as its state set dies; once only a trailing `*` is left
+// the rest of the subtree is emitted without matching.
+//
+// Tree supplies the node type and its accessors (word() as in TopK.h):
+//
+//   using Node = ...;
+//   std::string_view label(Node) const;
+//   bool is_end(Node) const;
+//   std::string_view word(Node, std::string_view path) const;
+//   template <typename F> void for_each_child(Node, F &&) const;
+template <typename Tree, typename F>
+void glob_search(const Tree &tree, typename Tree::Node start, std::string path,
+				 const GlobPattern &glob, F &&emit) {
+	const size_t words = glob.set_words();
+	// One state set per depth, so siblings restart from their parent's set.
+	std::vector<std::uint64_t> sets(words);
+	glob.start(sets.data());
+	if (!glob.step(sets.data(), path))
+		return;
+
+	auto emit_all = [&](auto &self, typename Tree::Node node) -> void {
+		if (tree.is_end(node))
+			emit(tree.word(node, path));
+		tree.for_each_child(node, [&](typename Tree::Node child) {
+			const size_t base = path.size();
+			path.append(tree.label(child));
+			self(self, child);
+			path.resize(base);
+		});
+	};
+
+	auto visit = [&](auto &self, typename Tree::Node node,
+					 size_t depth) -> void {
+		const size_t at = depth * words;
+		if (glob.accepts_all(sets.data() + at)) {
+			emit_all(emit_all, node);
+			return;
+		}
+		if (tree.is_end(node) && glob.accepts(sets.data() + at))
+			emit(tree.word(node, path));
+		tree.for_each_child(node, [&](typename Tree::Node child) {
+			const size_t next = at + words;
+			if (sets.size() < next + words)
+				sets.resize(next + words);
+			std::copy(sets.begin() + at, sets.begin() + next,
+					  sets.begin() + next);
+			const std::string_view label = tree.label(child);
+			if (!glob.step(sets.data() + next, label))
+				return;
+			const size_t base = path.size();
+			path.append(label);
+			self(self, child, depth + 1);
+			path.resize(base);
+		});
+	};
+	visit(visit, start, 0);
+}
@@ -0,0 +1,112 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string &path, Access access) {
+	const DWORD flags = access == Access::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN
+													 : FILE_ATTRIBUTE_NORMAL;
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+							  nullptr, OPEN_EXISTING, flags, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Failed to open file: " + path);
+	}
+	if (GetFileType(file) != FILE_TYPE_DISK) {
+		CloseHandle(file);
+		throw std::runtime_error("Not a regular file: " + path);
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size)) {
+		CloseHandle(file);
+		throw std::runtime_error("Failed to stat file: " + path);
+	}
+
+	file_ = file;
+	size_ = static_cast<size_t>(size.QuadPart);
+	if (size_ == 0) {
+		return; // CreateFileMapping rejects empty files; nothing to map
+	}
+
+	HANDLE mapping =
+		CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		CloseHandle(file);
+		throw std::runtime_error("Failed to map file: " + path);
+	}
+	void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		throw std::runtime_error("Failed to map file: " + path);
+	}
+
+	mapping_ = mapping;
+	data_ = static_cast<const char *>(view);
+}
+
+MappedFile::~MappedFile() {
+	if (data_)
+		UnmapViewOfFile(data_);
+	if (mapping_)
+		CloseHandle(mapping_);
+	if (file_)
+		CloseHandle(file_);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &path, Access access) {
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error("Failed to open file: " + path);
+	}
+
+	struct stat st;
+	if (::fstat(fd, &st) != 0) {
+		::close(fd);
+		throw std::runtime_error("Failed to stat file: " + path);
+	}
+	if (!S_ISREG(st.st_mode)) {
+		::close(fd);
+		throw std::runtime_error("Not a regular file: " + path);
+	}
+
+	size_ = static_cast<size_t>(st.st_size);
+	if (size_ == 0) {
+		::close(fd); // mmap rejects zero-length mappings; nothing to map
+		return;
+	}
+
+	void *addr = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+	// The mapping keeps its own reference to the file, so the descriptor is
+	// not needed past this point.
+	::close(fd);
+	if (addr == MAP_FAILED) {
+		throw std::runtime_error("Failed to map file: " + path);
+	}
+	// Only a hint; a kernel that ignores it just reads ahead less.
+	if (access == Access::Sequential)
+		::madvise(addr, size_, MADV_SEQUENTIAL);
+	data_ = static_cast<const char *>(addr);
+}
+
+MappedFile::~MappedFile() {
+	if (data_)
+		::munmap(const_cast<char *>(data_), size_);
+}
+
+#endif
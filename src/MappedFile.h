@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Read-only mapping of a whole file into the address space. Pages are faulted
+// in on first touch and live in the OS page cache, so several processes that
+// map the same file share one physical copy of it. Throws std::runtime_error if
+// the file cannot be opened or mapped, or is not a regular file (a pipe or a
+// device has no size to map).
+class MappedFile {
+  public:
+	// How the caller will touch the pages. Sequential asks the kernel for
+	// aggressive read-ahead, for a single front-to-back pass over the file.
+	enum class Access { Random, Sequential };
+
+	explicit MappedFile(const std::string &path,
+						Access access = Access::Random);
+	~MappedFile();
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	const char *data() const noexcept { return data_; }
+	size_t size() const noexcept { return size_; }
+
+  private:
+	const char *data_ = nullptr;
+	size_t size_ = 0;
+#ifdef _WIN32
+	void *file_ = nullptr;
+	void *mapping_ = nullptr;
+#endif
+};
@@ -0,0 +1,169 @@
+#include "PerfCounters.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+PerfCounters &PerfCounters::operator+=(const PerfCounters &other) noexcept {
+#define SESHAT_PERF_FIELD(field, name) field += other.field;
+	SESHAT_PERF_COUNTER_FIELDS(SESHAT_PERF_FIELD)
+#undef SESHAT_PERF_FIELD
+	return *this;
+}
+
+PerfCounters &PerfCounters::operator-=(const PerfCounters &other) noexcept {
+#define SESHAT_PERF_FIELD(field, name) field -= other.field;
+	SESHAT_PERF_COUNTER_FIELDS(SESHAT_PERF_FIELD)
+#undef SESHAT_PERF_FIELD
+	return *this;
+}
+
+#ifdef SESHAT_PERF_COUNTERS
+namespace {
+
+// The live threads' counters, what exited threads counted, and the total at
+// the last reset, which is subtracted rather than zeroing counters that
+// belong to other threads.
+struct PerfRegistry {
+	std::mutex mutex;
+	std::vector<const ThreadPerfCounters *> threads;
+	PerfCounters retired;
+	PerfCounters baseline;
+
+	PerfCounters sum() const {
+		PerfCounters total = retired;
+		for (const ThreadPerfCounters *t : threads)
+			total += t->load();
+		return total;
+	}
+};
+
+// Never destroyed, so threads that exit during static destruction can
+// still unregister.
+PerfRegistry &registry() {
+	static PerfRegistry *r = new PerfRegistry;
+	return *r;
+}
+
+} // namespace
+
+ThreadPerfCounters::ThreadPerfCounters() {
+	PerfRegistry &r = registry();
+	const std::lock_guard<std::mutex> lock(r.mutex);
+	r.threads.push_back(this);
+}
+
+ThreadPerfCounters::~ThreadPerfCounters() {
+	PerfRegistry &r = registry();
+	const std::lock_guard<std::mutex> lock(r.mutex);
+	r.threads.erase(std::find(r.threads.begin(), r.threads.end(), this));
+	r.retired += load();
+}
+
+PerfCounters ThreadPerfCounters::load() const noexcept {
+	PerfCounters out;
+#define SESHAT_PERF_FIELD(field, name)                                         \
+	out.field = field.load(std::memory_order_relaxed);
+	SESHAT_PERF_COUNTER_FIELDS(SESHAT_PERF_FIELD)
+#undef SESHAT_PERF_FIELD
+	return out;
+}
+
+PerfCounters perf_counters_total() {
+	PerfRegistry &r = registry();
+	const std::lock_guard<std::mutex> lock(r.mutex);
+	PerfCounters total = r.sum();
+	total -= r.baseline;
+	return total;
+}
+
+void perf_counters_reset() {
+	PerfRegistry &r = registry();
+	const std::lock_guard<std::mutex> lock(r.mutex);
+	r.baseline = r.sum();
+}
+#else
+PerfCounters perf_counters_total() { return {}; }
+void perf_counters_reset() {}
+#endif
+
+// Values below 2^kSubBits get a bucket each; above that, bucket groups of
+// kSubBuckets follow one per highest set bit.
+std::size_t LatencyHistogram::bucket_of(std::uint64_t ns) noexcept {
+	if (ns < kSubBuckets)
+		return static_cast<std::size_t>(ns);
+#if defined(_MSC_VER)
+	unsigned long msb;
+	_BitScanReverse64(&msb, ns);
+#else
+	const unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(ns));
+#endif
+	const unsigned shift = static_cast<unsigned>(msb) - kSubBits;
+	return (shift + 1) * kSubBuckets +
+		   static_cast<std::size_t>((ns >> shift) & (kSubBuckets - 1));
+}
+
+std::uint64_t LatencyHistogram::bucket_max(std::size_t bucket) noexcept {
+	if (bucket < kSubBuckets)
+		return bucket;
+	const unsigned shift = static_cast<unsigned>(bucket / kSubBuckets) - 1;
+	const std::uint64_t low = (kSubBuckets + bucket % kSubBuckets) << shift;
+	return low + ((std::uint64_t(1) << shift) - 1);
+}
+
+void LatencyHistogram::record(std::uint64_t ns) noexcept {
+	buckets_[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+	total_.fetch_add(ns, std::memory_order_relaxed);
+	std::uint64_t seen = min_.load(std::memory_order_relaxed);
+	while (ns < seen && !min_.compare_exchange_weak(seen, ns))
+		;
+	seen = max_.load(std::memory_order_relaxed);
+	while (ns > seen && !max_.compare_exchange_weak(seen, ns))
+		;
+}
+
+// Concurrent records may land between the loads, so the count is the sum of
+// the bucket counts as read, which keeps the quantiles consistent with it.
+LatencyHistogram::Summary LatencyHistogram::summarize() const noexcept {
+	std::array<std::uint64_t, kBuckets> counts;
+	std::uint64_t n = 0;
+	for (std::size_t b = 0; b < kBuckets; ++b) {
+		counts[b] = buckets_[b].load(std::memory_order_relaxed);
+		n += counts[b];
+	}
+
+	Summary s{};
+	s.count = n;
+	if (n == 0)
+		return s;
+	s.total_ns = total_.load(std::memory_order_relaxed);
+	s.min_ns = min_.load(std::memory_order_relaxed);
+	s.max_ns = max_.load(std::memory_order_relaxed);
+
+	const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+	std::uint64_t *out[] = {&s.p50_ns, &s.p90_ns, &s.p99_ns, &s.p999_ns};
+	std::uint64_t seen = 0;
+	std::size_t b = 0;
+	for (std::size_t q = 0; q < 4; ++q) {
+		// The smallest bucket at which at least quantile * n values are seen
+		const std::uint64_t rank = std::max<std::uint64_t>(
+			1, static_cast<std::uint64_t>(
+				   std::ceil(quantiles[q] * static_cast<double>(n))));
+		while (seen + counts[b] < rank)
+			seen += counts[b++];
+		*out[q] = std::min(bucket_max(b), s.max_ns);
+	}
+	return s;
+}
+
+void LatencyHistogram::reset() noexcept {
+	for (auto &bucket : buckets_)
+		bucket.store(0, std::memory_order_relaxed);
+	total_.store(0, std::memory_order_relaxed);
+	min_.store(UINT64_MAX, std::memory_order_relaxed);
+	max_.store(0, std::memory_order_relaxed);
+}
\ No newline at end of file
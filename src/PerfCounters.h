@@ -0,0 +1,121 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Event counts from the trie's hot paths, for telling a deep traversal from a
+// split storm from allocator churn. They only exist when SESHAT_PERF_COUNTERS
+// is defined (the native benchmarks always define it; the addon does when
+// built with `npm run build:perf`); otherwise SESHAT_COUNT expands to nothing
+// and the trie carries no trace of them.
+//
+// The counters, as X(field, JS name):
+//   nodes_visited      nodes whose children were probed for one byte
+//                      (ChildList::find, FlatTrie::find_child) plus nodes
+//                      entered by an enumeration (prefix cursors and the
+//                      TopK / Glob / Fuzzy tree walks)
+//   child_probes       key bytes compared to pick a child: one per vector
+//                      compare or direct index, one per byte of a scan
+//   splits             RadixTrie::split_node calls
+//   orphan_cleanups    nodes freed because a remove, subtract or intersect
+//                      left them empty
+//   arena_blocks       blocks the arena mapped, and large allocations it
+//                      took from the heap
+//   arena_allocations  Arena::allocate and allocate_label calls: nodes,
+//                      child blocks and spilled labels, none of which reach
+//                      the global heap
+#define SESHAT_PERF_COUNTER_FIELDS(X)                                          \
+	X(nodes_visited, "nodesVisited")                                           \
+	X(child_probes, "childProbes")                                             \
+	X(splits, "splits")                                                        \
+	X(orphan_cleanups, "orphanCleanups")                                       \
+	X(arena_blocks, "arenaBlocks")                                             \
+	X(arena_allocations, "arenaAllocations")
+
+struct PerfCounters {
+#define SESHAT_PERF_FIELD(field, name) std::uint64_t field = 0;
+	SESHAT_PERF_COUNTER_FIELDS(SESHAT_PERF_FIELD)
+#undef SESHAT_PERF_FIELD
+
+	PerfCounters &operator+=(const PerfCounters &other) noexcept;
+	PerfCounters &operator-=(const PerfCounters &other) noexcept;
+};
+
+#ifdef SESHAT_PERF_COUNTERS
+// One thread's counters. Only the owning thread writes them, so a bump is a
+// relaxed load and store rather than a locked add; the atomics are there so
+// perf_counters_total() may read them from another thread. Each registers
+// itself on first use and folds its counts into a process-wide total when
+// its thread exits.
+class ThreadPerfCounters {
+  public:
+	ThreadPerfCounters();
+	~ThreadPerfCounters();
+	ThreadPerfCounters(const ThreadPerfCounters &) = delete;
+	ThreadPerfCounters &operator=(const ThreadPerfCounters &) = delete;
+
+	PerfCounters load() const noexcept;
+
+#define SESHAT_PERF_FIELD(field, name) std::atomic<std::uint64_t> field{0};
+	SESHAT_PERF_COUNTER_FIELDS(SESHAT_PERF_FIELD)
+#undef SESHAT_PERF_FIELD
+};
+
+inline thread_local ThreadPerfCounters perf_counters;
+
+inline void perf_bump(std::atomic<std::uint64_t> &counter,
+					  std::uint64_t n) noexcept {
+	counter.store(counter.load(std::memory_order_relaxed) + n,
+				  std::memory_order_relaxed);
+}
+
+#define SESHAT_COUNT(field, n) perf_bump(perf_counters.field, (n))
+constexpr bool kPerfCountersCompiled = true;
+#else
+#define SESHAT_COUNT(field, n) ((void)0)
+constexpr bool kPerfCountersCompiled = false;
+#endif
+
+// The counts of every thread, live and exited, since the last
+// perf_counters_reset(). All zero unless the counters are compiled in.
+PerfCounters perf_counters_total();
+void perf_counters_reset();
+
+// Log-linear latency histogram in the manner of HdrHistogram: a value lands
+// in the bucket for its highest set bit and the kSubBits bits below it, so
+// every bucket spans at most 1/2^kSubBits (12.5%) of the values in it, from
+// one nanosecond up to the full 64-bit range, in a fixed 4KB. Recording is
+// lock-free and may happen from any thread.
+class LatencyHistogram {
+  public:
+	static constexpr unsigned kSubBits = 3;
+
+	struct Summary {
+		std::uint64_t count;
+		std::uint64_t total_ns;
+		std::uint64_t min_ns;
+		std::uint64_t max_ns;
+		// Upper bounds of the buckets holding these quantiles, capped at max
+		std::uint64_t p50_ns;
+		std::uint64_t p90_ns;
+		std::uint64_t p99_ns;
+		std::uint64_t p999_ns;
+	};
+
+	void record(std::uint64_t ns) noexcept;
+	Summary summarize() const noexcept;
+	void reset() noexcept;
+
+  private:
+	static constexpr std::size_t kSubBuckets = std::size_t(1) << kSubBits;
+	static constexpr std::size_t kBuckets = (65 - kSubBits) * kSubBuckets;
+
+	static std::size_t bucket_of(std::uint64_t ns) noexcept;
+	static std::uint64_t bucket_max(std::size_t bucket) noexcept;
+
+	std::array<std::atomic<std::uint64_t>, kBuckets> buckets_{};
+	std::atomic<std::uint64_t> total_{0};
+	std::atomic<std::uint64_t> min_{UINT64_MAX};
+	std::atomic<std::uint64_t> max_{0};
+};
\ No newline at end of file
@@ -1,97 +1,270 @@
 #include "RadixNode.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
-#include <mutex>
-#include <new>
-#include <vector>
-
-// Class-scoped pool allocator for RadixNode.
-//
-// A radix trie holds millions of nodes, and the previous one-malloc-per-node
-// scheme paid a per-allocation allocator header plus alignment rounding on
-// every single one (tens of megabytes of resident memory that get_memory_stats
-// never sees, since it only counts bytes the program itself asked for). Handing
-// nodes out of large pre-allocated blocks removes that surcharge and speeds up
-// bulk loads, because the hot path is a pointer bump instead of a trip through
-// the general allocator.
-//
-// Thread-safety: insertFromFileAsync runs a bulk load on a libuv worker thread,
-// and a process may build several independent tries at once, so allocation can
-// happen from more than one thread. The design keeps the per-node path
-// lock-free by giving each thread its own free list and bump pointer; the only
-// shared state is the registry of blocks, which is touched once every
-// kSlotsPerBlock allocations.
-
-namespace {
-
-// One slot is either a live node's storage or, once freed, a link in a free
-// list. Sized and aligned for RadixNode.
-union Slot {
-	Slot *next;
-	alignas(RadixNode) unsigned char storage[sizeof(RadixNode)];
-};
-
-constexpr std::size_t kSlotsPerBlock = 8192;
-
-std::mutex &block_mutex() {
-	static std::mutex m;
-	return m;
-}
 
-// Blocks are owned for the whole process lifetime and never returned to the OS.
-// That permanence is what makes cross-thread frees safe: a node allocated on
-// one thread and destroyed on another lands on the destroying thread's free
-// list, still pointing at memory that stays mapped. Intentionally leaked (never
-// destructed) to sidestep static-destruction-order hazards with nodes that may
-// be torn down as other globals unwind at exit.
-std::vector<Slot *> &global_blocks() {
-	static auto *blocks = new std::vector<Slot *>();
-	return *blocks;
+void *RadixNode::operator new(std::size_t size) {
+	// RadixNode is a leaf type (never subclassed), so the requested size is
+	// always exactly one node.
+	assert(size == sizeof(RadixNode));
+	return Arena::allocate_current(size, kArenaTag);
 }
 
-Slot *acquire_block() {
-	Slot *block = new Slot[kSlotsPerBlock];
-	std::lock_guard<std::mutex> lock(block_mutex());
-	global_blocks().push_back(block);
-	return block;
+void RadixNode::operator delete(void *ptr) noexcept {
+	Arena::deallocate_current(ptr, sizeof(RadixNode), kArenaTag);
 }
 
-// Per-thread allocator state. Both live entirely on the hot path with no
-// synchronization; only acquire_block() ever locks.
-thread_local Slot *tl_free = nullptr;
-thread_local Slot *tl_block = nullptr;
-thread_local std::size_t tl_remaining = 0;
+ChildList::~ChildList() {
+	if (!bits_)
+		return;
+	if (bits_ & kSingleTag) {
+		delete single();
+		return;
+	}
+	for (RadixNode *child : *this)
+		delete child;
+	release(hdr());
+}
 
-} // namespace
+void ChildList::release(Header *h) noexcept {
+	Arena::deallocate_current(
+		h, block_bytes(static_cast<Kind>(h->kind), cap_of(h)), h->kind);
+}
 
-void *RadixNode::operator new(std::size_t size) {
-	// RadixNode is a leaf type (never subclassed), so the requested size is
-	// always exactly one slot. The pool cannot serve any other size.
-	assert(size == sizeof(RadixNode));
-	(void)size;
+ChildList &ChildList::operator=(ChildList &&o) noexcept {
+	if (this != &o) {
+		ChildList dying(std::move(*this));
+		bits_ = o.bits_;
+		o.bits_ = 0;
+	}
+	return *this;
+}
 
-	if (tl_free) {
-		Slot *s = tl_free;
-		tl_free = s->next;
-		return s;
+const char *ChildList::kind_name(Kind k) noexcept {
+	switch (k) {
+	case kLeaf:
+		return "leaf";
+	case kSingle:
+		return "single";
+	case kNode4:
+		return "node4";
+	case kNode16:
+		return "node16";
+	case kNode48:
+		return "node48";
+	default:
+		return "node256";
 	}
+}
 
-	if (tl_remaining == 0) {
-		tl_block = acquire_block();
-		tl_remaining = kSlotsPerBlock;
+// An empty block of kind `k` with `cap` pointer slots. The key bytes are
+// zeroed so that the kNode16 vector load never reads uninitialized memory
+// past `size`; the kNode48 index and kNode256 pointers must start out zero
+// since zero means "absent".
+ChildList::Header *ChildList::allocate(Kind k, std::size_t cap) {
+	assert(k >= kNode4 && cap <= capacity(k));
+	Header *h =
+		static_cast<Header *>(Arena::allocate_current(block_bytes(k, cap), k));
+	h->kind = k;
+	h->cap = static_cast<std::uint8_t>(cap);
+	h->size = 0;
+	if (k == kNode256)
+		std::memset(ptrs(h), 0, kMaxChildren * sizeof(RadixNode *));
+	else
+		std::memset(keys(h), 0, ptrs_offset(k) - sizeof(Header));
+	return h;
+}
+
+void ChildList::become(Kind k, std::size_t n) {
+	RadixNode *moved[kMaxChildren];
+	std::size_t count = 0;
+	for (RadixNode *child : *this)
+		moved[count++] = child;
+	n = std::max(n, count);
+	assert(k != kLeaf && n <= capacity(k));
+	Header *old = (bits_ && !(bits_ & kSingleTag)) ? hdr() : nullptr;
+
+	if (k == kSingle) {
+		assert(count == 1);
+		bits_ = tagged(*begin());
+	} else {
+		const std::size_t half = capacity(k) / 2;
+		const bool small = k != kNode256 && n <= half;
+		Header *h = allocate(k, small ? half : capacity(k));
+		unsigned char *index = keys(h);
+		RadixNode **p = ptrs(h);
+		for (std::size_t i = 0; i < count; ++i) {
+			const unsigned char c =
+				static_cast<unsigned char>(moved[i]->key.front());
+			if (k == kNode256) {
+				p[c] = moved[i];
+			} else if (k == kNode48) {
+				p[i] = moved[i];
+				index[c] = static_cast<unsigned char>(i + 1);
+			} else {
+				p[i] = moved[i];
+				index[i] = c;
+			}
+		}
+		h->size = static_cast<std::uint16_t>(count);
+		bits_ = reinterpret_cast<std::uintptr_t>(h);
 	}
+	if (old)
+		release(old);
+}
+
+void ChildList::reserve(std::size_t n) {
+	if (n <= 1 || (bits_ && !(bits_ & kSingleTag) && n <= cap_of(hdr())))
+		return;
+	become(n <= 4 ? kNode4 : n <= 16 ? kNode16 : n <= 48 ? kNode48 : kNode256,
+		   n);
+}
 
-	Slot *s = tl_block++;
-	--tl_remaining;
-	return s;
+void ChildList::insert(std::unique_ptr<RadixNode> child) {
+	add(child.release(), false);
 }
 
-void RadixNode::operator delete(void *ptr) noexcept {
-	if (!ptr) {
+void ChildList::push_back(std::unique_ptr<RadixNode> child) {
+	add(child.release(), true);
+}
+
+void ChildList::add(RadixNode *child, bool at_end) {
+	const unsigned char c = static_cast<unsigned char>(child->key.front());
+	assert(!find(child->key.front()));
+	if (!bits_) {
+		bits_ = tagged(child);
 		return;
 	}
-	Slot *s = static_cast<Slot *>(ptr);
-	s->next = tl_free;
-	tl_free = s;
+	// A full block first doubles within its kind, then moves up a kind.
+	const Kind k = kind();
+	const std::size_t count = size();
+	if (k == kSingle || count == cap_of(hdr()))
+		become(count < capacity(k) ? k : static_cast<Kind>(k + 1), count + 1);
+
+	Header *h = hdr();
+	const std::size_t n = h->size;
+	RadixNode **p = ptrs(h);
+	switch (h->kind) {
+	case kNode48:
+		p[n] = child;
+		keys(h)[c] = static_cast<unsigned char>(n + 1);
+		break;
+	case kNode256:
+		p[c] = child;
+		break;
+	default: {
+		unsigned char *k = keys(h);
+		const std::size_t pos = at_end ? n : lower_bound(h, c);
+		assert(pos == n || k[pos] > c);
+		assert(!at_end || n == 0 || k[n - 1] < c);
+		std::memmove(k + pos + 1, k + pos, n - pos);
+		std::memmove(p + pos + 1, p + pos, (n - pos) * sizeof(RadixNode *));
+		k[pos] = c;
+		p[pos] = child;
+		break;
+	}
+	}
+	++h->size;
+}
+
+std::unique_ptr<RadixNode> ChildList::replace(char c,
+											  std::unique_ptr<RadixNode> child) {
+	assert(child->key.front() == c);
+	RadixNode *old;
+	if (bits_ & kSingleTag) {
+		old = single();
+		assert(old->key.front() == c);
+		bits_ = tagged(child.release());
+	} else {
+		RadixNode **slot = slot_of(hdr(), static_cast<unsigned char>(c));
+		assert(slot);
+		old = *slot;
+		*slot = child.release();
+	}
+	return std::unique_ptr<RadixNode>(old);
 }
+
+std::unique_ptr<RadixNode> ChildList::take(char ch) {
+	const unsigned char c = static_cast<unsigned char>(ch);
+	if (bits_ & kSingleTag) {
+		RadixNode *only = single();
+		if (only->key.front() != ch)
+			return nullptr;
+		bits_ = 0;
+		return std::unique_ptr<RadixNode>(only);
+	}
+	if (!bits_)
+		return nullptr;
+
+	Header *h = hdr();
+	const std::size_t n = h->size;
+	RadixNode **p = ptrs(h);
+	RadixNode *taken;
+	switch (h->kind) {
+	case kNode48: {
+		// Keep the used slots dense by moving the last one into the hole.
+		unsigned char *index = keys(h);
+		const unsigned s = index[c];
+		if (!s)
+			return nullptr;
+		taken = p[s - 1];
+		if (s != n) {
+			p[s - 1] = p[n - 1];
+			index[static_cast<unsigned char>(p[s - 1]->key.front())] =
+				static_cast<unsigned char>(s);
+		}
+		index[c] = 0;
+		break;
+	}
+	case kNode256:
+		taken = p[c];
+		if (!taken)
+			return nullptr;
+		p[c] = nullptr;
+		break;
+	default: {
+		const std::size_t i = index_of(h, c);
+		if (i == n)
+			return nullptr;
+		unsigned char *k = keys(h);
+		taken = p[i];
+		std::memmove(k + i, k + i + 1, n - i - 1);
+		std::memmove(p + i, p + i + 1, (n - i - 1) * sizeof(RadixNode *));
+		k[n - 1] = 0;
+		break;
+	}
+	}
+	--h->size;
+
+	// Shrink thresholds sit below the smaller kind's capacity (see the class
+	// comment). A node that loses its last child frees its block.
+	const std::size_t left = h->size;
+	switch (h->kind) {
+	case kNode4:
+		if (left <= 1) {
+			if (left == 0) {
+				release(h);
+				bits_ = 0;
+			} else {
+				become(kSingle, 1);
+			}
+		}
+		break;
+	case kNode16:
+		if (left <= 3)
+			become(kNode4, 0);
+		break;
+	case kNode48:
+		if (left <= 12)
+			become(kNode16, 0);
+		break;
+	default:
+		if (left <= 40)
+			become(kNode48, 0);
+		break;
+	}
+	return std::unique_ptr<RadixNode>(taken);
+}
+
+void ChildList::erase(char c) { take(c); }
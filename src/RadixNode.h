@@ -1,8 +1,22 @@
 #pragma once
+#include "Arena.h"
+#include "PerfCounters.h"
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <memory>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                   \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SESHAT_CHILD_SSE2 1
+#elif defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define SESHAT_CHILD_NEON 1
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 #include <string>
 #include <string_view>
 #include <vector>
@@ -14,17 +28,24 @@
 // A 16-byte small-buffer string for radix edge labels. std::string costs 32
 // bytes on libstdc++ regardless of content, and trie keys average ~4 chars, so
 // most of that was inline buffer we never filled. CompactKey inlines up to 15
-// bytes and spills to the heap only for longer keys.
+// bytes; a longer key points into the label pool of the current Arena (see
+// Arena.h), or owns a heap buffer when no arena is installed.
 //
 // Layout: byte 15 is the discriminator. When its high bit is clear it doubles
-// as the inline length (0..15); when set, the key lives on the heap and the
-// first 12 bytes hold {char* ptr, uint32 len}. The discriminator sits at the
-// same fixed offset in both arms, so the type is endianness-independent. Radix
-// keys never need a capacity field (a key is assigned once and then only ever
-// replaced wholesale or shortened to a substring of itself), so the heap arm
-// stores just the pointer and length.
+// as the inline length (0..15); when set, the key lives out of line and the
+// first 12 bytes hold {char* ptr, uint32 len}, with kOwnedFlag telling a heap
+// buffer from a pool range. The discriminator sits at the same fixed offset in
+// both arms, so the type is endianness-independent. Radix keys never need a
+// capacity field (a key is assigned once and then only ever replaced
+// wholesale, shortened to a substring of itself, split in two or joined with
+// its child's), so the out-of-line arm stores just the pointer and length.
+//
+// Every pool range belongs to exactly one key: copies get their own bytes,
+// and split_front() divides a range rather than sharing it. That is what lets
+// destroy() report the discarded bytes to the pool.
 class CompactKey {
 	static constexpr std::uint8_t kHeapFlag = 0x80;
+	static constexpr std::uint8_t kOwnedFlag = 0x40;
 	static constexpr std::size_t kInlineCap = 15;
 
 	union {
@@ -44,22 +65,38 @@ class CompactKey {
 	// at the same offset, and this mirrors how production SSO strings type-pun
 	// their length/flag byte.
 	bool heap() const noexcept { return (inl.disc & kHeapFlag) != 0; }
+	bool owned() const noexcept { return (inl.disc & kOwnedFlag) != 0; }
 	void destroy() noexcept {
-		if (heap())
-			delete[] hp.ptr;
+		if (!heap())
+			return;
+		if (owned())
+			::operator delete(hp.ptr);
+		else if (Arena *arena = Arena::current())
+			arena->discard_label(hp.len);
+	}
+	void set_inline(const char *s, std::size_t n) noexcept {
+		std::memcpy(inl.buf, s, n);
+		inl.disc = static_cast<std::uint8_t>(n);
+	}
+	void set_out_of_line(char *p, std::size_t n, std::uint8_t flags) noexcept {
+		hp.ptr = p;
+		hp.len = static_cast<std::uint32_t>(n);
+		hp.disc = flags;
+	}
+	// Copies `n` bytes out of line, into the pool if there is one.
+	void store(const char *s, std::size_t n) {
+		Arena *arena = Arena::current();
+		char *p = arena ? arena->allocate_label(n)
+						: static_cast<char *>(::operator new(n));
+		std::memcpy(p, s, n);
+		set_out_of_line(p, n, arena ? kHeapFlag : kHeapFlag | kOwnedFlag);
 	}
 	// Initialises from raw bytes assuming no prior heap buffer is owned.
 	void init(const char *s, std::size_t n) {
-		if (n <= kInlineCap) {
-			std::memcpy(inl.buf, s, n);
-			inl.disc = static_cast<std::uint8_t>(n);
-		} else {
-			char *p = new char[n];
-			std::memcpy(p, s, n);
-			hp.ptr = p;
-			hp.len = static_cast<std::uint32_t>(n);
-			hp.disc = kHeapFlag;
-		}
+		if (n <= kInlineCap)
+			set_inline(s, n);
+		else
+			store(s, n);
 	}
 
   public:
@@ -96,53 +133,540 @@ class CompactKey {
 	bool empty() const noexcept { return size() == 0; }
 	char front() const noexcept { return data()[0]; }
 	bool is_inlined() const noexcept { return !heap(); }
-	// Bytes this key requested from the heap (0 when inlined).
+	// Out-of-line bytes this key refers to (0 when inlined).
 	std::size_t heap_bytes() const noexcept { return heap() ? hp.len : 0; }
 
 	operator std::string_view() const noexcept { return {data(), size()}; }
 
-	// Replaces the key. `s` may point into this key's own storage (split_node
-	// shortens a key to a suffix of itself), so the bytes are copied out before
-	// any existing heap buffer is released.
+	// Replaces the key. `s` may point into this key's own storage, so the
+	// bytes are copied before any existing buffer is released.
 	void assign(const char *s, std::size_t n) {
 		if (n <= kInlineCap) {
 			char tmp[kInlineCap];
 			std::memcpy(tmp, s, n);
 			destroy();
-			std::memcpy(inl.buf, tmp, n);
-			inl.disc = static_cast<std::uint8_t>(n);
+			set_inline(tmp, n);
 		} else {
-			char *p = new char[n];
-			std::memcpy(p, s, n);
+			CompactKey fresh;
+			fresh.store(s, n);
+			*this = std::move(fresh);
+		}
+	}
+
+	// Cuts the first `n` bytes (0 < n < size()) off this key and returns
+	// them as a key of their own. A pool range is divided in place, so
+	// splitting a long edge copies at most the part that moves inline.
+	CompactKey split_front(std::size_t n) {
+		CompactKey front;
+		const std::size_t total = size();
+		if (!heap() || owned()) {
+			front.init(data(), n);
+			assign(data() + n, total - n);
+			return front;
+		}
+		char *p = hp.ptr;
+		Arena *arena = Arena::current();
+		if (n <= kInlineCap) {
+			front.set_inline(p, n);
+			if (arena)
+				arena->discard_label(n);
+		} else {
+			front.set_out_of_line(p, n, kHeapFlag);
+		}
+		const std::size_t rest = total - n;
+		if (rest <= kInlineCap) {
+			set_inline(p + n, rest);
+			if (arena)
+				arena->discard_label(rest);
+		} else {
+			set_out_of_line(p + n, rest, kHeapFlag);
+		}
+		return front;
+	}
+
+	// Appends `back`, leaving it empty. Pool ranges that lie end to end, as
+	// split_front() leaves them, are joined without copying, so an edge
+	// split by an insert and rejoined by a removal gets its range back.
+	void append(CompactKey &&back) {
+		const std::size_t n = size(), m = back.size();
+		if (heap() && !owned() && back.heap() && !back.owned() &&
+			hp.ptr + n == back.hp.ptr) {
+			hp.len = static_cast<std::uint32_t>(n + m);
+			back.inl.disc = 0;
+			return;
+		}
+		if (n + m <= kInlineCap) {
+			char tmp[kInlineCap];
+			std::memcpy(tmp, data(), n);
+			std::memcpy(tmp + n, back.data(), m);
+			destroy();
+			set_inline(tmp, n + m);
+		} else {
+			Arena *arena = Arena::current();
+			char *p = arena ? arena->allocate_label(n + m)
+							: static_cast<char *>(::operator new(n + m));
+			std::memcpy(p, data(), n);
+			std::memcpy(p + n, back.data(), m);
 			destroy();
-			hp.ptr = p;
-			hp.len = static_cast<std::uint32_t>(n);
-			hp.disc = kHeapFlag;
+			set_out_of_line(p, n + m,
+							arena ? kHeapFlag : kHeapFlag | kOwnedFlag);
 		}
+		back = CompactKey();
+	}
+
+	// Copies a pool key into the current arena's label pool (used while it
+	// repacks; see Arena::repack_labels).
+	void move_to_pool() {
+		if (!heap() || owned())
+			return;
+		char *p = Arena::current()->allocate_label(hp.len);
+		std::memcpy(p, hp.ptr, hp.len);
+		hp.ptr = p;
 	}
 };
 
 static_assert(sizeof(CompactKey) == 16, "CompactKey must stay 16 bytes");
 
+class RadixNode;
+
+// The children of a node, ordered by the first byte of each child's key
+// (compared as unsigned, so enumeration order matches std::string ordering on
+// every platform regardless of char signedness).
+//
+// The list adapts its representation to its fanout, in the manner of an
+// adaptive radix tree. Most nodes have zero or one child, a few near the root
+// have dozens, and one layout cannot serve both well:
+//
+//   kLeaf     no children; the list is a null word
+//   kSingle   one child, held inline as a tagged pointer (no heap block)
+//   kNode4    up to 4 children: sorted first bytes, then pointers (24/40 bytes)
+//   kNode16   up to 16: the same, searched with one SSE2/NEON compare (88/152)
+//   kNode48   up to 48: a 256-byte slot index, then pointers        (456/648)
+//   kNode256  up to 256: pointers indexed directly by first byte      (2056)
+//
+// The first three allocate their pointer slots in two steps, half and then
+// full capacity: two-child nodes are by far the most common internal node, so
+// sizing every kNode4 for four would cost more than the inline kSingle saves.
+// Choosing a child never dereferences a sibling: the sorted kinds scan packed
+// first bytes, and the indexed kinds are a single array load. A list grows
+// into the next kind when it is full and shrinks back once erase() leaves it
+// well under the smaller kind's capacity; the gap keeps a node whose fanout
+// hovers at a boundary from reallocating on every insert/remove pair.
+//
+// The list itself is one word. Its low bit tags the kSingle case (nodes are at
+// least pointer-aligned, so a real pointer never has it set); otherwise it is
+// null or points at a heap block that starts with {kind, cap, uint16 size}.
+class ChildList {
+  public:
+	enum Kind : std::uint8_t {
+		kLeaf,
+		kSingle,
+		kNode4,
+		kNode16,
+		kNode48,
+		kNode256,
+		kKindCount
+	};
+
+	// Walks the children in sorted order.
+	class iterator {
+	  public:
+		RadixNode *operator*() const noexcept { return list_->at(pos_); }
+		iterator &operator++() noexcept {
+			pos_ = list_->next_pos(pos_);
+			return *this;
+		}
+		bool operator==(const iterator &o) const noexcept {
+			return pos_ == o.pos_;
+		}
+		bool operator!=(const iterator &o) const noexcept {
+			return pos_ != o.pos_;
+		}
+
+	  private:
+		friend class ChildList;
+		iterator(const ChildList *list, unsigned pos) noexcept
+			: list_(list), pos_(pos) {}
+		const ChildList *list_;
+		unsigned pos_;
+	};
+
+	ChildList() noexcept = default;
+	~ChildList();
+	ChildList(ChildList &&o) noexcept : bits_(o.bits_) { o.bits_ = 0; }
+	ChildList &operator=(ChildList &&o) noexcept;
+	ChildList(const ChildList &) = delete;
+	ChildList &operator=(const ChildList &) = delete;
+
+	Kind kind() const noexcept {
+		if (!bits_)
+			return kLeaf;
+		if (bits_ & kSingleTag)
+			return kSingle;
+		return static_cast<Kind>(hdr()->kind);
+	}
+	std::size_t size() const noexcept {
+		if (!bits_)
+			return 0;
+		return (bits_ & kSingleTag) ? 1 : hdr()->size;
+	}
+	bool empty() const noexcept { return size() == 0; }
+	iterator begin() const noexcept { return iterator(this, first_pos()); }
+	iterator end() const noexcept { return iterator(this, end_pos()); }
+
+	// The child whose key starts with `c`, or nullptr.
+	inline RadixNode *find(char c) const noexcept;
+	// The child that sorts last, or nullptr.
+	inline RadixNode *back() const noexcept;
+	// The memory find() reads first: the only child, the heap block's
+	// header, or nullptr for a leaf. Batch lookups prefetch it.
+	const void *probe_address() const noexcept {
+		return (bits_ & kSingleTag) ? static_cast<const void *>(single())
+									: reinterpret_cast<const void *>(bits_);
+	}
+
+	// Adds a child at its sorted position. No existing child may share its
+	// first byte.
+	void insert(std::unique_ptr<RadixNode> child);
+	// Appends a child that sorts after every existing one.
+	void push_back(std::unique_ptr<RadixNode> child);
+	// Swaps in a child for the existing one with first byte `c` (which must
+	// exist; the replacement must start with the same byte), returning it.
+	std::unique_ptr<RadixNode> replace(char c, std::unique_ptr<RadixNode> child);
+	// Unlinks the child with first byte `c` and hands it back, or returns
+	// nullptr if there is none.
+	std::unique_ptr<RadixNode> take(char c);
+	// Destroys the child with first byte `c`, if present.
+	void erase(char c);
+	// Switches up front to a kind that holds `n` children, so that a list
+	// built by n push_backs never passes through the smaller kinds.
+	void reserve(std::size_t n);
+
+	// Bytes this list requested from the heap (0 for kLeaf and kSingle).
+	std::size_t heap_bytes() const noexcept {
+		if (!bits_ || (bits_ & kSingleTag))
+			return 0;
+		return block_bytes(kind(), cap_of(hdr()));
+	}
+
+	// Lower-case name of a kind ("leaf", "single", "node4", ...).
+	static const char *kind_name(Kind k) noexcept;
+
+  private:
+	struct Header {
+		std::uint8_t kind;
+		std::uint8_t cap; // allocated pointer slots (unused by kNode256)
+		std::uint16_t size;
+	};
+	static constexpr std::uintptr_t kSingleTag = 1;
+	static constexpr std::size_t kMaxChildren = 256; // one per byte value
+
+	static constexpr std::size_t capacity(Kind k) noexcept {
+		return k == kLeaf	  ? 0
+			   : k == kSingle ? 1
+			   : k == kNode4  ? 4
+			   : k == kNode16 ? 16
+			   : k == kNode48 ? 48
+							  : 256;
+	}
+	// Offset of the pointer array: past the header and the key bytes (sorted
+	// kinds) or slot index (kNode48), rounded up to pointer alignment.
+	static constexpr std::size_t ptrs_offset(Kind k) noexcept {
+		return k == kNode256   ? 8
+			   : k == kNode48 ? (sizeof(Header) + 256 + 7) & ~std::size_t(7)
+							   : (sizeof(Header) + capacity(k) + 7) &
+									 ~std::size_t(7);
+	}
+	static constexpr std::size_t block_bytes(Kind k, std::size_t cap) noexcept {
+		return ptrs_offset(k) + cap * sizeof(RadixNode *);
+	}
+	static std::size_t cap_of(const Header *h) noexcept {
+		return h->kind == kNode256 ? kMaxChildren : h->cap;
+	}
+
+	Header *hdr() const noexcept { return reinterpret_cast<Header *>(bits_); }
+	RadixNode *single() const noexcept {
+		return reinterpret_cast<RadixNode *>(bits_ & ~kSingleTag);
+	}
+	static std::uintptr_t tagged(RadixNode *child) noexcept {
+		return reinterpret_cast<std::uintptr_t>(child) | kSingleTag;
+	}
+	// Sorted first bytes (kNode4/kNode16) or the slot index (kNode48), which
+	// maps a byte to 1 + its pointer slot, 0 meaning absent.
+	static unsigned char *keys(Header *h) noexcept {
+		return reinterpret_cast<unsigned char *>(h + 1);
+	}
+	static RadixNode **ptrs(Header *h) noexcept {
+		return reinterpret_cast<RadixNode **>(
+			reinterpret_cast<char *>(h) +
+			ptrs_offset(static_cast<Kind>(h->kind)));
+	}
+
+	// The pointer slot holding the child for `c` in a heap block, or nullptr.
+	static inline RadixNode **slot_of(Header *h, unsigned char c) noexcept;
+	// Position of `c` among a sorted kind's keys, or h->size if absent.
+	static inline std::size_t index_of(Header *h, unsigned char c) noexcept;
+	// Number of a sorted kind's keys strictly below `c`.
+	static inline std::size_t lower_bound(Header *h, unsigned char c) noexcept;
+
+	// Iteration positions: an index for kSingle and the sorted kinds, a byte
+	// value for the indexed kinds.
+	inline unsigned first_pos() const noexcept;
+	inline unsigned end_pos() const noexcept;
+	inline unsigned next_pos(unsigned pos) const noexcept;
+	inline RadixNode *at(unsigned pos) const noexcept;
+
+	static Header *allocate(Kind k, std::size_t cap);
+	static void release(Header *h) noexcept;
+	void add(RadixNode *child, bool at_end);
+	// Moves every child into a fresh representation of kind `k` with room
+	// for at least `n` children (and at least the current ones).
+	void become(Kind k, std::size_t n);
+
+	std::uintptr_t bits_ = 0;
+};
+
+// What a few words carry beyond the node itself, kept in a per-trie table
+// rather than in every node: in a case-folding trie, where words are stored
+// folded, the spelling a word was inserted with when that differs; and the
+// value a word was given (see RadixTrie::put), which makes the trie a map.
+struct WordExtra {
+	std::string casing; // empty when the stored word is the spelling
+	std::uint64_t value = 0;
+	bool has_value = false;
+
+	bool empty() const noexcept { return casing.empty() && !has_value; }
+};
+
 class RadixNode {
   public:
 	CompactKey key;
+	ChildList children;
 	bool is_end = false;
-	// Children are stored as bare owning pointers, sorted by the first character
-	// of each child's key. The first character used to be cached alongside the
-	// pointer in a std::pair<char, unique_ptr>, but that char is always equal to
-	// child->key.front() (the radix invariant), and the pair padded out to 16
-	// bytes per edge. Dropping it halves the per-edge cost to 8 bytes.
-	std::vector<std::unique_ptr<RadixNode>> children;
+	// Weight of the word ending here (0 unless one was given), and the
+	// largest score of any word in this subtree, which lets a best-first
+	// top-k search skip subtrees that cannot beat the results it already has.
+	// The trie keeps max_score exact across inserts, score changes and
+	// removals.
+	std::uint32_t score = 0;
+	std::uint32_t max_score = 0;
+	// 1 + the index of the word's entry in the trie's table of WordExtra,
+	// or 0 when the word has neither an original spelling nor a value. It
+	// fills what would otherwise be tail padding, so it costs no node memory.
+	std::uint32_t extra = 0;
 
 	RadixNode() = default;
 	explicit RadixNode(std::string_view k) : key(k) {}
+	explicit RadixNode(CompactKey &&k) noexcept : key(std::move(k)) {}
 
-	// Nodes are allocated by the millions, one malloc per node. A class-scoped
-	// pool allocator (see RadixNode.cc) hands them out from large blocks, which
-	// removes the per-allocation malloc header/rounding overhead from the
-	// resident set and speeds up bulk loads. RadixNode must not be subclassed,
-	// since the pool assumes every allocation is exactly sizeof(RadixNode).
+	// Nodes are allocated by the millions. They come from the owning trie's
+	// Arena (see Arena.h), which hands them out from large blocks with no
+	// per-allocation header and lets the trie drop all of them at once.
+	// RadixNode must not be subclassed, since freeing passes the arena
+	// sizeof(RadixNode) as the allocation's size. Nodes are tallied under
+	// kArenaTag and children blocks under their ChildList::Kind, so the
+	// arena's usage() counts both.
+	static constexpr std::size_t kArenaTag = ChildList::kKindCount;
 	static void *operator new(std::size_t size);
 	static void operator delete(void *ptr) noexcept;
 };
+
+static_assert(RadixNode::kArenaTag < Arena::kTagCount,
+			  "every ChildList kind and RadixNode needs its own arena tag");
+static_assert(alignof(RadixNode) >= 2,
+			  "ChildList tags single-child pointers in the low bit");
+
+namespace child_list_detail {
+
+inline unsigned ctz32(std::uint32_t x) noexcept {
+#if defined(_MSC_VER)
+	unsigned long r;
+	_BitScanForward(&r, x);
+	return static_cast<unsigned>(r);
+#else
+	return static_cast<unsigned>(__builtin_ctz(x));
+#endif
+}
+
+inline unsigned popcount64(std::uint64_t x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+	return static_cast<unsigned>(__builtin_popcountll(x));
+#else
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return static_cast<unsigned>((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+#if SESHAT_CHILD_NEON
+inline unsigned ctz64(std::uint64_t x) noexcept {
+#if defined(_MSC_VER)
+	unsigned long r;
+	_BitScanForward64(&r, x);
+	return static_cast<unsigned>(r);
+#else
+	return static_cast<unsigned>(__builtin_ctzll(x));
+#endif
+}
+
+// NEON has no movemask; narrowing each 16-bit lane by 4 packs one nibble per
+// byte lane into a 64-bit mask.
+inline std::uint64_t nibble_mask(uint8x16_t v) noexcept {
+	return vget_lane_u64(
+		vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(v), 4)), 0);
+}
+#endif
+
+} // namespace child_list_detail
+
+// kNode4 is scanned bytewise, stopping at the first key past `c`. kNode16
+// always has 16 key bytes in its block, so one vector compare tests all of
+// them and the mask drops the unused tail.
+inline std::size_t ChildList::index_of(Header *h, unsigned char c) noexcept {
+	const unsigned char *k = keys(h);
+	const std::size_t n = h->size;
+#if SESHAT_CHILD_SSE2 || SESHAT_CHILD_NEON
+	if (h->kind == kNode16) {
+		using namespace child_list_detail;
+#if SESHAT_CHILD_SSE2
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(k));
+		__m128i needle = _mm_set1_epi8(static_cast<char>(c));
+		std::uint32_t m = static_cast<std::uint32_t>(
+			_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)));
+		m &= (1u << n) - 1;
+		SESHAT_COUNT(child_probes, 1);
+		return m ? ctz32(m) : n;
+#else
+		std::uint64_t m = nibble_mask(vceqq_u8(vld1q_u8(k), vdupq_n_u8(c)));
+		if (n < 16)
+			m &= (std::uint64_t(1) << (4 * n)) - 1;
+		SESHAT_COUNT(child_probes, 1);
+		return m ? ctz64(m) / 4 : n;
+#endif
+	}
+#endif
+	for (std::size_t i = 0; i < n; ++i) {
+		if (k[i] >= c) {
+			SESHAT_COUNT(child_probes, i + 1);
+			return k[i] == c ? i : n;
+		}
+	}
+	SESHAT_COUNT(child_probes, n);
+	return n;
+}
+
+inline std::size_t ChildList::lower_bound(Header *h, unsigned char c) noexcept {
+	const unsigned char *k = keys(h);
+	const std::size_t n = h->size;
+#if SESHAT_CHILD_SSE2 || SESHAT_CHILD_NEON
+	if (h->kind == kNode16) {
+		if (c == 0)
+			return 0;
+		using namespace child_list_detail;
+#if SESHAT_CHILD_SSE2
+		// SSE2 has no unsigned byte compare: v < c  <=>  min(v, c - 1) == v.
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(k));
+		__m128i limit = _mm_set1_epi8(static_cast<char>(c - 1));
+		std::uint32_t m = static_cast<std::uint32_t>(
+			_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, limit), v)));
+		m &= (1u << n) - 1;
+		return popcount64(m);
+#else
+		std::uint64_t m = nibble_mask(vcltq_u8(vld1q_u8(k), vdupq_n_u8(c)));
+		if (n < 16)
+			m &= (std::uint64_t(1) << (4 * n)) - 1;
+		return popcount64(m) / 4;
+#endif
+	}
+#endif
+	std::size_t i = 0;
+	while (i < n && k[i] < c)
+		++i;
+	return i;
+}
+
+inline RadixNode **ChildList::slot_of(Header *h, unsigned char c) noexcept {
+	switch (h->kind) {
+	case kNode48: {
+		SESHAT_COUNT(child_probes, 1);
+		unsigned s = keys(h)[c];
+		return s ? ptrs(h) + (s - 1) : nullptr;
+	}
+	case kNode256:
+		SESHAT_COUNT(child_probes, 1);
+		return ptrs(h)[c] ? ptrs(h) + c : nullptr;
+	default: {
+		std::size_t i = index_of(h, c);
+		return i < h->size ? ptrs(h) + i : nullptr;
+	}
+	}
+}
+
+inline RadixNode *ChildList::find(char c) const noexcept {
+	SESHAT_COUNT(nodes_visited, 1);
+	if (bits_ & kSingleTag) {
+		SESHAT_COUNT(child_probes, 1);
+		RadixNode *only = single();
+		return only->key.front() == c ? only : nullptr;
+	}
+	if (!bits_)
+		return nullptr;
+	RadixNode **slot = slot_of(hdr(), static_cast<unsigned char>(c));
+	return slot ? *slot : nullptr;
+}
+
+inline unsigned ChildList::first_pos() const noexcept {
+	const Kind k = kind();
+	if (k < kNode48)
+		return 0;
+	return k == kNode48 ? (keys(hdr())[0] ? 0 : next_pos(0))
+						: (ptrs(hdr())[0] ? 0 : next_pos(0));
+}
+
+inline unsigned ChildList::end_pos() const noexcept {
+	const Kind k = kind();
+	return k >= kNode48 ? 256 : static_cast<unsigned>(size());
+}
+
+inline unsigned ChildList::next_pos(unsigned pos) const noexcept {
+	const Kind k = kind();
+	if (k < kNode48)
+		return pos + 1;
+	Header *h = hdr();
+	if (k == kNode48) {
+		const unsigned char *index = keys(h);
+		while (++pos < 256 && !index[pos]) {
+		}
+	} else {
+		RadixNode *const *p = ptrs(h);
+		while (++pos < 256 && !p[pos]) {
+		}
+	}
+	return pos;
+}
+
+inline RadixNode *ChildList::at(unsigned pos) const noexcept {
+	if (bits_ & kSingleTag)
+		return single();
+	Header *h = hdr();
+	if (h->kind == kNode48)
+		return ptrs(h)[keys(h)[pos] - 1];
+	return ptrs(h)[pos];
+}
+
+inline RadixNode *ChildList::back() const noexcept {
+	const Kind k = kind();
+	if (k == kLeaf)
+		return nullptr;
+	if (k == kSingle)
+		return single();
+	Header *h = hdr();
+	if (k < kNode48)
+		return h->size ? ptrs(h)[h->size - 1] : nullptr;
+	for (unsigned pos = 256; pos-- > 0;) {
+		if (k == kNode48 ? keys(h)[pos] != 0 : ptrs(h)[pos] != nullptr)
+			return at(pos);
+	}
+	return nullptr;
+}
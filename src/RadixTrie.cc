@@ -1,339 +1,939 @@
 #include "RadixTrie.h"
+#include "BatchSearch.h"
+#include "Descent.h"
+#include "Glob.h"
+#include "MappedFile.h"
+#include "SuffixIndex.h"
 #include <algorithm>
-#include <cctype>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <deque>
+#include <exception>
 #include <fstream>
-#include <numeric>
-#include <unordered_map>
-
-RadixTrie::RadixTrie() : root(std::make_unique<RadixNode>()), word_count_(0) {}
-
-// Children are kept sorted by the first character of their key. Every child's
-// key is non-empty (only the root has an empty key, and the root is never a
-// child), so key.front() is always valid here.
-RadixTrie::ChildVec::iterator RadixTrie::find_child(RadixNode *node, char c) {
-	auto &v = node->children;
-	return std::lower_bound(
-		v.begin(), v.end(), c,
-		[](const std::unique_ptr<RadixNode> &child, char key) {
-			return child->key.front() < key;
-		});
+#include <optional>
+#include <thread>
+
+RadixTrie::RadixTrie(bool fold_case, bool suffix_index)
+	: word_count_(0), fold_case_(fold_case) {
+	if (suffix_index)
+		suffixes_ = std::make_unique<SuffixIndex>();
+	const Arena::Scope scope(arena_);
+	root = std::make_unique<RadixNode>();
 }
 
-RadixTrie::ChildVec::const_iterator RadixTrie::find_child(const RadixNode *node,
-														  char c) {
-	const auto &v = node->children;
-	return std::lower_bound(
-		v.begin(), v.end(), c,
-		[](const std::unique_ptr<RadixNode> &child, char key) {
-			return child->key.front() < key;
-		});
+// Every node lives in arena_, which unmaps all of them when it goes.
+RadixTrie::~RadixTrie() { root.release(); }
+
+// Drops the whole pointer tree at once, without visiting it, and starts over
+// from an empty root.
+void RadixTrie::reset_nodes() {
+	root.release(); // its memory goes with the arena
+	arena_.release();
+	std::vector<WordExtra>().swap(extras_);
+	std::vector<std::uint32_t>().swap(free_extras_);
+	tally_.casing_spill = 0;
+	const Arena::Scope scope(arena_);
+	root = std::make_unique<RadixNode>();
+}
+
+// Children are kept sorted by the first byte of their key, and those bytes are
+// packed next to the child pointers (see ChildList), so choosing a child is a
+// vector compare over contiguous bytes rather than a probe into each sibling.
+RadixNode *RadixTrie::find_child(const RadixNode *node, char c) noexcept {
+	return node->children.find(c);
 }
 
 size_t RadixTrie::common_prefix_length(std::string_view s1,
 									   std::string_view s2) const noexcept {
-	size_t i = 0;
-	const size_t min_len = std::min(s1.length(), s2.length());
-	while (i < min_len && s1[i] == s2[i]) {
-		++i;
+	return match_length(s1.data(), s2.data(),
+						std::min(s1.length(), s2.length()));
+}
+
+std::string_view RadixTrie::fold(std::string_view text,
+								 std::string &buffer) const {
+	if (!fold_case_ || !needs_folding(text))
+		return text;
+	fold_case(text, buffer);
+	return buffer;
+}
+
+namespace {
+
+// Heap bytes behind a string, beyond what its small-string buffer holds.
+size_t spilled_bytes(const std::string &s) noexcept {
+	static const size_t inline_capacity = std::string().capacity();
+	return s.capacity() > inline_capacity ? s.capacity() + 1 : 0;
+}
+
+} // namespace
+
+// Last insert wins: a word re-inserted in folded form forgets its earlier
+// spelling.
+void RadixTrie::record_casing(RadixNode *node, std::string_view original,
+							  std::string_view folded) {
+	if (!fold_case_)
+		return;
+	if (casing_log_) {
+		casing_log_->emplace_back(
+			node, original == folded ? std::string() : std::string(original));
+	} else if (original == folded) {
+		clear_casing(node);
+	} else {
+		set_casing(node, original);
+	}
+}
+
+void RadixTrie::set_casing(RadixNode *node, std::string_view original) {
+	std::string &casing = extra_of(node).casing;
+	tally_.casing_spill -= spilled_bytes(casing);
+	casing.assign(original.data(), original.size());
+	tally_.casing_spill += spilled_bytes(casing);
+}
+
+void RadixTrie::clear_casing(RadixNode *node) {
+	if (!node->extra)
+		return;
+	std::string &casing = extras_[node->extra - 1].casing;
+	tally_.casing_spill -= spilled_bytes(casing);
+	std::string().swap(casing);
+	release_extra(node);
+}
+
+void RadixTrie::set_value(RadixNode *node,
+						  std::optional<std::uint64_t> value) {
+	if (value_log_) {
+		value_log_->emplace_back(node, value);
+	} else if (value) {
+		WordExtra &extra = extra_of(node);
+		extra.value = *value;
+		extra.has_value = true;
+	} else if (node->extra) {
+		extras_[node->extra - 1].has_value = false;
+		release_extra(node);
+	}
+}
+
+WordExtra &RadixTrie::extra_of(RadixNode *node) {
+	if (node->extra)
+		return extras_[node->extra - 1];
+	if (free_extras_.empty()) {
+		if (extras_.size() == std::numeric_limits<std::uint32_t>::max())
+			throw std::length_error("Too many words with extras");
+		extras_.emplace_back();
+		node->extra = static_cast<std::uint32_t>(extras_.size());
+	} else {
+		node->extra = free_extras_.back() + 1;
+		free_extras_.pop_back();
 	}
-	return i;
+	return extras_[node->extra - 1];
 }
 
-RadixNode *RadixTrie::find_node(std::string_view word) const {
+void RadixTrie::release_extra(RadixNode *node, bool always) {
+	if (!node->extra)
+		return;
+	WordExtra &extra = extras_[node->extra - 1];
+	if (!always && !extra.empty())
+		return;
+	tally_.casing_spill -= spilled_bytes(extra.casing);
+	std::string().swap(extra.casing);
+	extra.value = 0;
+	extra.has_value = false;
+	free_extras_.push_back(node->extra - 1);
+	node->extra = 0;
+}
+
+void RadixTrie::copy_extra(RadixNode *node, const WordExtra &extra) {
+	if (!extra.casing.empty())
+		set_casing(node, extra.casing);
+	if (extra.has_value)
+		set_value(node, extra.value);
+}
+
+// Called at the top of every mutation.
+void RadixTrie::ensure_mutable() {
+	++version_;
+	if (frozen_)
+		thaw();
+}
+
+namespace {
+
+// The accessors interleaved_search and descend expect, over the pointer
+// tree. Labels of up to 15 bytes sit inside the node, so for most nodes
+// prefetch_label asks for a line that is already on its way.
+struct PointerSearchView {
+	using Node = RadixNode *;
+	Node start;
+	Node root() const { return start; }
+	void prefetch_children(Node n) const {
+		prefetch_read(n->children.probe_address());
+	}
+	bool find_child(Node n, char c, Node &child) const {
+		child = n->children.find(c);
+		return child != nullptr;
+	}
+	void prefetch_node(Node n) const { prefetch_read(n); }
+	void prefetch_label(Node n) const { prefetch_read(n->key.data()); }
+	std::string_view label(Node n) const { return n->key; }
+	bool is_end(Node n) const { return n->is_end; }
+};
+
+} // namespace
+
+RadixNode *RadixTrie::find_node(std::string_view word, size_t *depth) const {
 	if (!root || word.empty())
 		return nullptr;
 
-	RadixNode *current = root.get();
-	size_t pos = 0;
+	const PointerSearchView tree{root.get()};
+	RadixNode *node = nullptr;
+	size_t base = 0;
+	if (!depth)
+		return descend<Match::kWhole>(tree, word, node, base) ? node : nullptr;
+	size_t level = 0;
+	if (!descend<Match::kWhole>(tree, word, node, base,
+								[&](RadixNode *, RadixNode *) { ++level; }))
+		return nullptr;
+	*depth = level;
+	return node;
+}
 
-	while (pos < word.length()) {
-		char first_char = word[pos];
-		auto it = find_child(current, first_char);
+namespace {
+
+// Below this much input the thread start-up and the bucketing pass cost more
+// than a single-threaded load.
+constexpr size_t kParallelMinBytes = 256 * 1024;
+
+bool is_newline(char c) noexcept { return c == '\n' || c == '\r'; }
+
+// The C locale's isspace, without the locale lookup per byte.
+bool is_space(char c) noexcept { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+// The first '\n' or '\r' in [p, end), or end. Sixteen bytes are tested per
+// step with one compare for each newline byte, so long lines cost a fraction
+// of a bytewise scan; memchr would need a pass per byte value.
+const char *find_newline(const char *p, const char *end) noexcept {
+#if SESHAT_CHILD_SSE2
+	const __m128i lf = _mm_set1_epi8('\n');
+	const __m128i cr = _mm_set1_epi8('\r');
+	for (; end - p >= 16; p += 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		std::uint32_t m = static_cast<std::uint32_t>(_mm_movemask_epi8(
+			_mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr))));
+		if (m)
+			return p + child_list_detail::ctz32(m);
+	}
+#elif SESHAT_CHILD_NEON
+	const uint8x16_t lf = vdupq_n_u8('\n');
+	const uint8x16_t cr = vdupq_n_u8('\r');
+	for (; end - p >= 16; p += 16) {
+		uint8x16_t v = vld1q_u8(reinterpret_cast<const std::uint8_t *>(p));
+		std::uint64_t m = child_list_detail::nibble_mask(
+			vorrq_u8(vceqq_u8(v, lf), vceqq_u8(v, cr)));
+		if (m)
+			return p + child_list_detail::ctz64(m) / 4;
+	}
+#endif
+	while (p < end && !is_newline(*p))
+		++p;
+	return p;
+}
+
+// Appends the line serialize_to_buffer writes for one word.
+void append_line(std::string &out, std::string_view word, std::uint32_t score,
+				 bool with_scores,
+				 std::optional<std::uint64_t> value = std::nullopt) {
+	out.append(word.data(), word.size());
+	char digits[24];
+	if (with_scores) {
+		auto result = std::to_chars(digits, digits + sizeof digits, score);
+		out.push_back('\t');
+		out.append(digits, result.ptr);
+	}
+	if (value) {
+		auto result = std::to_chars(digits, digits + sizeof digits, *value);
+		out.push_back('\t');
+		out.append(digits, result.ptr);
+	}
+	out.push_back('\n');
+}
+
+// Calls fn(word) for every whitespace-trimmed, non-empty line of the input,
+// splitting on '\n' and '\r'. Every newline-delimited loader goes through
+// here, so they all agree on what a line is.
+template <typename F>
+void for_each_line(const char *data, size_t length, F &&fn) {
+	const char *const end = data + length;
+	for (const char *p = data; p < end;) {
+		const char *eol = find_newline(p, end);
+		const char *b = p, *e = eol;
+		while (e > b && is_space(e[-1]))
+			--e;
+		while (b < e && is_space(*b))
+			++b;
+		if (e > b)
+			fn(std::string_view(b, static_cast<size_t>(e - b)));
+		if (eol == end)
+			break;
+		p = eol + 1;
+	}
+}
 
-		if (it == current->children.end() || (*it)->key.front() != first_char) {
-			return nullptr; // Path doesn't exist
+// Runs task(0) .. task(n - 1) concurrently, task(0) on the calling thread,
+// and rethrows the first exception any of them raised once all have finished.
+template <typename F> void run_on_threads(unsigned n, F &&task) {
+	std::vector<std::exception_ptr> errors(n);
+	auto guarded = [&](unsigned i) {
+		try {
+			task(i);
+		} catch (...) {
+			errors[i] = std::current_exception();
 		}
+	};
 
-		RadixNode *child = it->get();
-		std::string_view child_key = child->key;
+	std::vector<std::thread> pool;
+	pool.reserve(n - 1);
+	try {
+		for (unsigned i = 1; i < n; ++i)
+			pool.emplace_back(guarded, i);
+	} catch (...) {
+		for (std::thread &t : pool)
+			t.join();
+		throw;
+	}
+	guarded(0);
+	for (std::thread &t : pool)
+		t.join();
+
+	for (const std::exception_ptr &e : errors) {
+		if (e)
+			std::rethrow_exception(e);
+	}
+}
+
+} // namespace
+
+// Bottom-up construction for input that is already sorted.
+//
+// A word greater than every word in the trie can only attach along the right
+// spine, the path from the root to the greatest word (the last child at each
+// level). The appender keeps that path as a stack of {node, depth} levels,
+// where depth is the word length through the node's key. A new word w shares
+// some prefix of length L with the previous greatest word `last`: the spine
+// up to depth L stays, and w hangs off it at L, either below the node that
+// ends there or by splitting the edge that crosses it. Since w[L] > last[L],
+// the new child sorts after all of its siblings, so it is always appended,
+// and each word touches only the nodes past its common prefix with the one
+// before it.
+//
+// Anything not greater than the current maximum goes through insert(), which
+// is always correct. That insert may split nodes on the spine, so the spine
+// is rebuilt from the root before the next in-order word; `last` itself is
+// unchanged, because the inserted word was smaller. Every spine node is an
+// ancestor of an appended word, so a score only has to raise their maxima.
+class RadixTrie::SortedAppender {
+  public:
+	explicit SortedAppender(RadixTrie &trie) : trie_(trie) { rebuild(); }
+
+	void add(std::string_view original, std::optional<std::uint32_t> score,
+			 std::optional<std::uint64_t> value = std::nullopt) {
+		const std::string_view word = trie_.fold(original, folded_);
+		if (word <= std::string_view(last_)) {
+			// A repeat still has to go through insert_word() when it may
+			// change the score, the value or the recorded casing.
+			if (word != std::string_view(last_) || score || value ||
+				trie_.fold_case_) {
+				trie_.insert_word(original, score.value_or(0),
+								  score.has_value(), value);
+				stale_ = true;
+			}
+			return;
+		}
+		if (stale_)
+			rebuild();
+
+		const size_t common = trie_.common_prefix_length(word, last_);
+		RadixNode *crossing = nullptr;
+		while (spine_.back().depth > common) {
+			crossing = spine_.back().node;
+			spine_.pop_back();
+		}
 
-		if (pos + child_key.length() > word.length()) {
-			return nullptr; // Child key is longer than remaining word
+		RadixNode *parent = spine_.back().node;
+		if (spine_.back().depth < common) {
+			// The common prefix ends partway along crossing's edge
+			parent = trie_.split_node(parent, crossing->key.front(),
+									  common - spine_.back().depth);
+			spine_.push_back({parent, common});
 		}
 
-		// Check if the child's key matches the remaining word portion
-		if (word.substr(pos, child_key.length()) != child_key) {
-			return nullptr; // Keys don't match
+		auto leaf = std::make_unique<RadixNode>(word.substr(common));
+		leaf->is_end = true;
+		RadixNode *added = leaf.get();
+		trie_.tally_leaf(parent, added);
+		parent->children.push_back(std::move(leaf));
+		spine_.push_back({added, word.size()});
+		trie_.tally_.add_word(word.size(), spine_.size() - 1);
+		trie_.record_casing(added, original, word);
+		if (value)
+			trie_.set_value(added, value);
+		if (score && *score != 0) {
+			added->score = *score;
+			for (const Level &level : spine_)
+				level.node->max_score = std::max(level.node->max_score, *score);
 		}
+		++trie_.word_count_;
+		trie_.index_word(word, true);
+		last_.assign(word.data(), word.size());
+	}
 
-		pos += child_key.length();
-		current = child;
+  private:
+	struct Level {
+		RadixNode *node;
+		size_t depth;
+	};
+
+	void rebuild() {
+		spine_.clear();
+		last_.clear();
+		RadixNode *node = trie_.root.get();
+		spine_.push_back({node, 0});
+		while (RadixNode *child = node->children.back()) {
+			last_.append(child->key.data(), child->key.size());
+			spine_.push_back({child, last_.size()});
+			node = child;
+		}
+		stale_ = false;
 	}
 
-	return current;
-}
+	RadixTrie &trie_;
+	std::vector<Level> spine_;
+	std::string last_;
+	std::string folded_;
+	bool stale_ = false;
+};
+
+class RadixTrie::LineInserter {
+  public:
+	LineInserter(RadixTrie &trie, const BulkLoadOptions &options)
+		: trie_(trie), scored_(options.scored), valued_(options.valued),
+		  sorted_(options.assume_sorted
+					  ? std::optional<SortedAppender>(std::in_place, trie)
+					  : std::nullopt) {}
+
+	// `line` is already trimmed and non-empty.
+	void operator()(std::string_view line) {
+		// The value is the last field, after the score if there is one, so
+		// a scored line needs two tabs to carry it.
+		std::optional<std::uint64_t> value;
+		if (valued_ && (!scored_ || line.find('\t') != line.rfind('\t')))
+			value = split_number<std::uint64_t>(line, "value");
+		std::optional<std::uint32_t> score;
+		if (scored_)
+			score = split_number<std::uint32_t>(line, "score");
+		if (sorted_)
+			sorted_->add(line, score, value);
+		else
+			trie_.insert_word(line, score.value_or(0), score.has_value(),
+							  value);
+	}
+
+  private:
+	// Splits `word<TAB>number` at the last tab, leaving the word in `line`.
+	// A line with no tab is a plain word. Throws std::invalid_argument if the
+	// text after the tab is not a decimal integer that fits in a T.
+	template <typename T>
+	static std::optional<T> split_number(std::string_view &line,
+										 const char *what) {
+		const size_t tab = line.rfind('\t');
+		if (tab == std::string_view::npos)
+			return std::nullopt;
+
+		T number = 0;
+		const char *first = line.data() + tab + 1;
+		const char *last = line.data() + line.size();
+		auto [end, error] = std::from_chars(first, last, number);
+		if (first == last || error != std::errc() || end != last) {
+			throw std::invalid_argument(std::string("Invalid ") + what +
+										" in line: " + std::string(line));
+		}
+
+		line = line.substr(0, tab);
+		while (!line.empty() && is_space(line.back()))
+			line.remove_suffix(1);
+		return number;
+	}
 
-// file streaming, but the user decides the size
+	RadixTrie &trie_;
+	bool scored_;
+	bool valued_;
+	std::optional<SortedAppender> sorted_;
+};
+
+// A regular file is mapped and split in place: no copy into a buffer and no
+// line carried across buffer boundaries, and the parallel loader gets the
+// whole input it needs to partition. Only what cannot be mapped (a pipe, a
+// device) is streamed through a buffer of `buffer_size` bytes.
 size_t RadixTrie::bulk_insert_from_file(const std::string &path,
-										size_t buffer_size) {
+										size_t buffer_size,
+										const BulkLoadOptions &options) {
+	const Arena::Scope scope(arena_);
+	ensure_mutable();
+	std::optional<MappedFile> mapped;
+	try {
+		mapped.emplace(path, MappedFile::Access::Sequential);
+	} catch (const std::runtime_error &) {
+		// Fall through; opening it as a stream reports a missing file.
+	}
+	if (mapped)
+		return bulk_insert_from_buffer(mapped->data(), mapped->size(), options);
+
 	std::ifstream file(path, std::ios::binary);
 	if (!file.is_open()) {
 		throw std::runtime_error("Failed to open file: " + path);
 	}
 
-	// Allocate buffer on heap to avoid stack overflow
-	auto buffer = std::make_unique<char[]>(buffer_size);
-	if (!buffer) {
-		throw std::runtime_error("Failed to allocate buffer of size: " +
-								 std::to_string(buffer_size));
-	}
-
+	LineInserter add(*this, options);
 	size_t words_inserted = 0;
-	std::string carry; // carry over a partial line between chunks
-
-	while (!file.eof()) {
-		file.read(buffer.get(), buffer_size);
-		std::streamsize bytes_read = file.gcount();
+	auto insert = [&](std::string_view word) {
+		add(word);
+		++words_inserted;
+	};
 
-		if (bytes_read <= 0) {
+	// Each read fills the buffer after the unfinished line left at its front
+	// by the last one. A line longer than the buffer grows it.
+	std::vector<char> buffer(std::max<size_t>(buffer_size, 1));
+	size_t held = 0;
+	for (;;) {
+		if (held == buffer.size())
+			buffer.resize(buffer.size() * 2);
+		file.read(buffer.data() + held,
+				  static_cast<std::streamsize>(buffer.size() - held));
+		const size_t filled = held + static_cast<size_t>(file.gcount());
+		if (filled == held)
 			break;
+		size_t cut = filled;
+		while (cut > held && !is_newline(buffer[cut - 1]))
+			--cut;
+		if (cut == held) {
+			held = filled; // no line ends in this read
+			continue;
 		}
+		for_each_line(buffer.data(), cut, insert);
+		held = filled - cut;
+		std::memmove(buffer.data(), buffer.data() + cut, held);
+	}
+	for_each_line(buffer.data(), held, insert);
+	return words_inserted;
+}
 
-		std::streamsize line_start = 0;
-		for (std::streamsize i = 0; i < bytes_read; ++i) {
-			char c = buffer[i];
-			if (c == '\n' || c == '\r') {
-				// We found a line boundary: [line_start, i)
-				std::streamsize seg_len = i - line_start;
-				if (seg_len > 0 || !carry.empty()) {
-					if (!carry.empty()) {
-						carry.append(buffer.get() + line_start,
-									 static_cast<size_t>(seg_len));
-						// Trim carry
-						size_t b = 0, e = carry.size();
-						while (e > b && std::isspace(static_cast<unsigned char>(
-											carry[e - 1])))
-							--e;
-						while (b < e && std::isspace(static_cast<unsigned char>(
-											carry[b])))
-							++b;
-						if (e > b) {
-							std::string_view word_view(carry.data() + b, e - b);
-							insert(word_view);
-							++words_inserted;
-						}
-						carry.clear();
-					} else {
-						// Create a view into the current buffer segment and
-						// trim without copying
-						const char *seg_ptr = buffer.get() + line_start;
-						size_t b = 0, e = static_cast<size_t>(seg_len);
-						while (e > b && std::isspace(static_cast<unsigned char>(
-											seg_ptr[e - 1])))
-							--e;
-						while (b < e && std::isspace(static_cast<unsigned char>(
-											seg_ptr[b])))
-							++b;
-						if (e > b) {
-							std::string_view word_view(seg_ptr + b, e - b);
-							insert(word_view);
-							++words_inserted;
-						}
-					}
-				}
+size_t RadixTrie::bulk_insert_from_buffer(const char *data, size_t length,
+										  const BulkLoadOptions &options) {
+	const Arena::Scope scope(arena_);
+	ensure_mutable();
+	if (options.threads > 1 && length >= kParallelMinBytes)
+		return parallel_insert_from_buffer(data, length, options);
 
-				// Skip consecutive CR/LF characters
-				while (i + 1 < bytes_read &&
-					   (buffer[i + 1] == '\n' || buffer[i + 1] == '\r')) {
-					++i;
-				}
-				line_start = i + 1;
-			}
-		}
+	LineInserter add(*this, options);
+	size_t words_inserted = 0;
+	for_each_line(data, length, [&](std::string_view word) {
+		add(word);
+		++words_inserted;
+	});
+	return words_inserted;
+}
 
-		// Handle remaining partial line at the end of the buffer
-		if (line_start < bytes_read) {
-			carry.append(buffer.get() + line_start,
-						 static_cast<size_t>(bytes_read - line_start));
-		}
+// Multi-threaded bulk load. Words that start with different bytes never share
+// a node, so each thread can own a contiguous range of leading bytes and grow
+// its own subtrie with no locking at all:
+//
+//   1. The input is cut into one chunk per thread at line boundaries, and each
+//      thread buckets its chunk's words by first byte (after folding, in a
+//      case-folding trie).
+//   2. The 256 leading bytes are split into contiguous ranges holding roughly
+//      equal numbers of words, one range per thread. Any existing root child
+//      in a range is moved into that thread's worker trie first, so new words
+//      merge with the old ones instead of colliding at the graft.
+//   3. Each thread inserts its range's buckets from every chunk into its
+//      worker trie, allocating from that trie's own arena.
+//   4. The workers' root children are grafted back under the root, in byte
+//      order, and the root's arena absorbs the workers' arenas.
+//
+// Balance is only as good as the spread of leading bytes: input that mostly
+// starts with one byte mostly lands on one thread. A worker may free memory
+// that came from this trie's arena (a split shortens a moved child's key),
+// filing it in the worker's arena; that is harmless, since absorbing the
+// worker's arena brings those slots home along with everything else.
+size_t RadixTrie::parallel_insert_from_buffer(const char *data, size_t length,
+											  const BulkLoadOptions &options) {
+	const unsigned threads = std::min(options.threads, 256u);
+
+	// 1. Chunk boundaries sit just past a line break, so no line is split.
+	std::vector<size_t> bounds(threads + 1, length);
+	bounds[0] = 0;
+	for (unsigned t = 1; t < threads; ++t) {
+		size_t pos = std::max(bounds[t - 1], length / threads * t);
+		while (pos < length && pos > 0 && !is_newline(data[pos - 1]))
+			++pos;
+		bounds[t] = pos;
 	}
 
-	// Process any remaining carry as the last line
-	if (!carry.empty()) {
-		size_t b = 0, e = carry.size();
-		while (e > b && std::isspace(static_cast<unsigned char>(carry[e - 1])))
-			--e;
-		while (b < e && std::isspace(static_cast<unsigned char>(carry[b])))
-			++b;
-		if (e > b) {
-			std::string_view word_view(carry.data() + b, e - b);
-			insert(word_view);
-			++words_inserted;
-		}
+	// The first code point is at most four bytes and folds on its own, so
+	// folding that much gives the folded word's first byte.
+	auto first_byte = [this](std::string_view word, std::string &buffer) {
+		return static_cast<unsigned char>(fold(word.substr(0, 4), buffer)[0]);
+	};
+	using Buckets = std::array<std::vector<std::string_view>, 256>;
+	std::vector<Buckets> chunks(threads);
+	run_on_threads(threads, [&](unsigned t) {
+		std::string buffer;
+		for_each_line(data + bounds[t], bounds[t + 1] - bounds[t],
+					  [&](std::string_view word) {
+						  chunks[t][first_byte(word, buffer)].push_back(word);
+					  });
+	});
+
+	// 2. Worker t owns leading bytes [cut[t], cut[t + 1]).
+	std::array<size_t, 256> per_byte{};
+	size_t total = 0;
+	for (const Buckets &chunk : chunks) {
+		for (unsigned b = 0; b < 256; ++b)
+			per_byte[b] += chunk[b].size();
+	}
+	for (size_t n : per_byte)
+		total += n;
+
+	std::vector<unsigned> cut(threads + 1, 256);
+	cut[0] = 0;
+	unsigned next = 1;
+	size_t seen = 0;
+	for (unsigned b = 0; b < 256 && next < threads; ++b) {
+		seen += per_byte[b];
+		while (next < threads && seen * threads >= total * next)
+			cut[next++] = b + 1;
 	}
 
-	file.close();
-	return words_inserted;
-}
+	std::vector<RadixTrie> parts(threads);
+	std::vector<std::vector<std::pair<RadixNode *, std::string>>> casing_logs(
+		threads);
+	std::vector<std::vector<std::pair<RadixNode *, std::optional<std::uint64_t>>>>
+		value_logs(threads);
+	for (unsigned t = 0; t < threads; ++t) {
+		parts[t].fold_case_ = fold_case_;
+		parts[t].casing_log_ = &casing_logs[t];
+		parts[t].value_log_ = &value_logs[t];
+		for (unsigned b = cut[t]; b < cut[t + 1]; ++b) {
+			if (auto child = root->children.take(static_cast<char>(b)))
+				parts[t].root->children.push_back(std::move(child));
+		}
+	}
 
-size_t RadixTrie::bulk_insert_from_buffer(const char *data, size_t length) {
-	size_t words_inserted = 0;
-	size_t line_start = 0;
-
-	for (size_t i = 0; i < length; ++i) {
-		char c = data[i];
-		if (c == '\n' || c == '\r') {
-			size_t seg_len = i - line_start;
-			if (seg_len > 0) {
-				const char *seg_ptr = data + line_start;
-				size_t b = 0, e = seg_len;
-				while (e > b &&
-					   std::isspace(static_cast<unsigned char>(seg_ptr[e - 1])))
-					--e;
-				while (b < e &&
-					   std::isspace(static_cast<unsigned char>(seg_ptr[b])))
-					++b;
-				if (e > b) {
-					std::string_view word_view(seg_ptr + b, e - b);
-					insert(word_view);
-					++words_inserted;
+	// 3. Build. A failure still falls through to the graft so that no
+	// existing words are lost; the words inserted so far are kept, as in the
+	// single-threaded path.
+	std::exception_ptr error;
+	try {
+		run_on_threads(threads, [&](unsigned t) {
+			// Buckets keep input order within each chunk and the chunks are in
+			// input order, so sorted input stays sorted per worker.
+			const Arena::Scope scope(parts[t].arena_);
+			LineInserter add(parts[t], options);
+			for (unsigned b = cut[t]; b < cut[t + 1]; ++b) {
+				for (const Buckets &chunk : chunks) {
+					for (std::string_view word : chunk[b])
+						add(word);
 				}
 			}
-			while (i + 1 < length &&
-				   (data[i + 1] == '\n' || data[i + 1] == '\r'))
-				++i;
-			line_start = i + 1;
-		}
+		});
+	} catch (...) {
+		error = std::current_exception();
 	}
 
-	if (line_start < length) {
-		const char *seg_ptr = data + line_start;
-		size_t seg_len = length - line_start;
-		size_t b = 0, e = seg_len;
-		while (e > b &&
-			   std::isspace(static_cast<unsigned char>(seg_ptr[e - 1])))
-			--e;
-		while (b < e && std::isspace(static_cast<unsigned char>(seg_ptr[b])))
-			++b;
-		if (e > b) {
-			std::string_view word_view(seg_ptr + b, e - b);
-			insert(word_view);
-			++words_inserted;
+	// 4. Graft. Every byte belongs to some range, so the root is empty here
+	// and the children arrive already sorted.
+	for (unsigned t = 0; t < threads; ++t) {
+		for (unsigned b = cut[t]; b < cut[t + 1]; ++b) {
+			if (auto child = parts[t].root->children.take(static_cast<char>(b)))
+				root->children.push_back(std::move(child));
+		}
+		word_count_ += parts[t].word_count_;
+		tally_.merge(parts[t].tally_);
+		depths_stale_ = depths_stale_ || parts[t].depths_stale_;
+		root->max_score = std::max(root->max_score, parts[t].root->max_score);
+		for (auto &[node, original] : casing_logs[t]) {
+			if (original.empty())
+				clear_casing(node);
+			else
+				set_casing(node, original);
 		}
+		for (auto &[node, value] : value_logs[t])
+			set_value(node, value);
+		arena_.absorb(parts[t].arena_);
+		parts[t].root.reset(); // now empty, and in this trie's arena
 	}
+	invalidate_suffix_index();
 
-	return words_inserted;
+	if (error)
+		std::rethrow_exception(error);
+	return total;
 }
 
 // Mass removal counterpart to bulk_insert_from_buffer. Parses newline-delimited,
 // whitespace-trimmed words from the buffer and removes each one, returning the
 // number of words actually removed (words that were not present are skipped).
 size_t RadixTrie::bulk_remove_from_buffer(const char *data, size_t length) {
+	const Arena::Scope scope(arena_);
+	ensure_mutable();
 	size_t words_removed = 0;
-	size_t line_start = 0;
-
-	for (size_t i = 0; i < length; ++i) {
-		char c = data[i];
-		if (c == '\n' || c == '\r') {
-			size_t seg_len = i - line_start;
-			if (seg_len > 0) {
-				const char *seg_ptr = data + line_start;
-				size_t b = 0, e = seg_len;
-				while (e > b &&
-					   std::isspace(static_cast<unsigned char>(seg_ptr[e - 1])))
-					--e;
-				while (b < e &&
-					   std::isspace(static_cast<unsigned char>(seg_ptr[b])))
-					++b;
-				if (e > b) {
-					std::string_view word_view(seg_ptr + b, e - b);
-					if (remove(word_view))
-						++words_removed;
-				}
-			}
-			while (i + 1 < length &&
-				   (data[i + 1] == '\n' || data[i + 1] == '\r'))
-				++i;
-			line_start = i + 1;
-		}
-	}
+	for_each_line(data, length, [&](std::string_view word) {
+		if (remove(word))
+			++words_removed;
+	});
+	return words_removed;
+}
 
-	if (line_start < length) {
-		const char *seg_ptr = data + line_start;
-		size_t seg_len = length - line_start;
-		size_t b = 0, e = seg_len;
-		while (e > b &&
-			   std::isspace(static_cast<unsigned char>(seg_ptr[e - 1])))
-			--e;
-		while (b < e && std::isspace(static_cast<unsigned char>(seg_ptr[b])))
-			++b;
-		if (e > b) {
-			std::string_view word_view(seg_ptr + b, e - b);
-			if (remove(word_view))
-				++words_removed;
-		}
-	}
+std::vector<std::uint8_t>
+RadixTrie::search_from_buffer(const char *data, size_t length) const {
+	std::vector<std::string_view> words;
+	for_each_line(data, length,
+				  [&](std::string_view word) { words.push_back(word); });
+	std::vector<std::uint8_t> bitmap((words.size() + 7) / 8);
+	search_many(words.data(), words.size(), bitmap.data());
+	return bitmap;
+}
 
-	return words_removed;
+bool RadixTrie::serialize_chunk(PrefixCursor &cursor, std::string &out,
+								size_t min_bytes, bool with_scores,
+								bool with_values) {
+	// Words are pulled a batch at a time, so a chunk overshoots `min_bytes`
+	// by at most one batch of lines.
+	constexpr size_t kBatch = 64;
+	auto line = [&](std::string_view word, std::uint32_t score) {
+		append_line(out, word, score, with_scores,
+					with_values ? cursor.value() : std::nullopt);
+	};
+	do {
+		if (cursor.advance(kBatch, line) < kBatch)
+			return false;
+	} while (out.size() < min_bytes);
+	return true;
 }
 
-std::string RadixTrie::serialize_to_buffer() const {
+std::string RadixTrie::serialize_to_buffer(bool with_scores,
+										   bool with_values) const {
 	std::string output;
 	if (empty())
 		return output;
 
-	std::vector<std::string> words = words_with_prefix("");
-	size_t total_size = 0;
-	for (const auto &w : words)
-		total_size += w.size() + 1;
-	output.reserve(total_size);
+	// Stream straight from the cursor rather than collecting every word first
+	PrefixCursor cursor = prefix_cursor("");
+	serialize_chunk(cursor, output, std::numeric_limits<size_t>::max(),
+					with_scores, with_values);
+	return output;
+}
 
-	for (const auto &w : words) {
-		output.append(w);
-		output.push_back('\n');
+size_t RadixTrie::serialize_to_file(const std::string &path,
+									bool with_scores, bool with_values) const {
+	constexpr size_t kChunkBytes = 1024 * 1024;
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		throw std::runtime_error("Failed to open file for writing: " + path);
+
+	PrefixCursor cursor = prefix_cursor("");
+	std::string chunk;
+	chunk.reserve(kChunkBytes + 64 * 1024);
+	bool more = !empty();
+	while (more) {
+		more = serialize_chunk(cursor, chunk, kChunkBytes, with_scores,
+							   with_values);
+		file.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+		if (!file)
+			throw std::runtime_error("Failed to write file: " + path);
+		chunk.clear();
 	}
-	return output;
+	file.close();
+	if (!file)
+		throw std::runtime_error("Failed to write file: " + path);
+	return word_count_;
+}
+
+std::string RadixTrie::serialize_snapshot() const {
+	if (frozen_)
+		return std::string(frozen_->image());
+	return FlatTrie::build(root.get(), word_count_, extras_);
 }
 
-void RadixTrie::collect_words_from_node(
-	const RadixNode *node, const std::string &prefix,
-	std::vector<std::string> &result) const {
-	if (!node)
+void RadixTrie::load_snapshot(const char *data, size_t length) {
+	// Validate before touching the current contents, so a bad image leaves
+	// the trie as it was.
+	auto flat = FlatTrie::from_bytes(std::string(data, length));
+	++version_;
+	reset_nodes();
+	word_count_ = flat->size();
+	frozen_ = std::move(flat);
+	lengths_stale_ = depths_stale_ = true;
+	invalidate_suffix_index();
+}
+
+void RadixTrie::load_snapshot_file(const std::string &path) {
+	auto flat = FlatTrie::map_file(path);
+	++version_;
+	reset_nodes();
+	word_count_ = flat->size();
+	frozen_ = std::move(flat);
+	lengths_stale_ = depths_stale_ = true;
+	invalidate_suffix_index();
+}
+
+void RadixTrie::freeze() {
+	if (frozen_)
 		return;
+	auto flat = FlatTrie::from_bytes(
+		FlatTrie::build(root.get(), word_count_, extras_));
+	++version_;
+	frozen_ = std::move(flat);
+	reset_nodes();
+}
 
-	std::string full_word = prefix;
-	full_word.append(node->key.data(), node->key.size());
+void RadixTrie::thaw() {
+	if (!frozen_)
+		return;
+	root.release();
+	arena_.release();
+	const Arena::Scope scope(arena_);
+	root = frozen_->to_tree(extras_);
+	frozen_.reset();
+	recount_nodes();
+	++version_;
+}
 
-	if (node->is_end) {
-		result.push_back(full_word);
+std::unique_ptr<RadixNode>
+RadixTrie::compact_copy(const RadixNode *node,
+						std::vector<std::uint32_t> &extras) {
+	auto copy = std::make_unique<RadixNode>(std::string_view(node->key));
+	// A chain left by a tree built before removals joined them, or loaded
+	// from a snapshot of one
+	if (node != root.get()) {
+		while (!node->is_end && node->children.size() == 1) {
+			node = *node->children.begin();
+			copy->key.append(CompactKey(std::string_view(node->key)));
+			depths_stale_ = true;
+		}
 	}
+	copy->is_end = node->is_end;
+	copy->score = node->score;
+	copy->max_score = node->max_score;
+	if (node->extra) {
+		extras.push_back(node->extra - 1);
+		copy->extra = static_cast<std::uint32_t>(extras.size());
+	}
+	copy->children.reserve(node->children.size());
+	for (const RadixNode *child : node->children)
+		copy->children.push_back(compact_copy(child, extras));
+	return copy;
+}
 
-	for (const auto &child : node->children) {
-		collect_words_from_node(child.get(), full_word, result);
+size_t RadixTrie::compact() {
+	if (frozen_)
+		return 0; // the image is as compact as it gets
+	const MemoryStats before = get_memory_stats();
+	++version_;
+
+	// Nothing changes until the copy is complete, so a failed allocation
+	// leaves the trie as it was.
+	Arena fresh;
+	std::unique_ptr<RadixNode> copy;
+	std::vector<std::uint32_t> order;
+	{
+		const Arena::Scope scope(fresh);
+		copy = compact_copy(root.get(), order);
 	}
+	std::vector<WordExtra> extras;
+	extras.reserve(order.size());
+	for (std::uint32_t index : order)
+		extras.push_back(std::move(extras_[index]));
+
+	root.release(); // its memory goes with the arena
+	arena_.release();
+	arena_.absorb(fresh);
+	root = std::move(copy);
+	extras_.swap(extras);
+	std::vector<std::uint32_t>().swap(free_extras_);
+
+	const MemoryStats after = get_memory_stats();
+	const size_t held = before.arena_bytes + before.casing_bytes;
+	const size_t kept = after.arena_bytes + after.casing_bytes;
+	const size_t reclaimed = held > kept ? held - kept : 0;
+	reclaimed_bytes_ += reclaimed;
+	return reclaimed;
 }
 
-void RadixTrie::insert(std::string_view word) {
-	if (word.empty())
+void RadixTrie::insert(std::string_view word) { insert_word(word, 0, false); }
+
+void RadixTrie::insert(std::string_view word, std::uint32_t score) {
+	insert_word(word, score, true);
+}
+
+// Every node on the way down is an ancestor of the word, so its max_score is
+// raised to the new score as the descent passes (a no-op for a plain insert,
+// whose new words score 0). Only lowering an existing word's score needs the
+// bottom-up refresh_max_scores pass.
+void RadixTrie::insert_word(std::string_view original, std::uint32_t score,
+							bool set_score,
+							std::optional<std::uint64_t> value) {
+	const Arena::Scope scope(arena_);
+	ensure_mutable();
+	if (original.empty())
 		return;
+	std::string buffer;
+	const std::string_view word = fold(original, buffer);
 
 	RadixNode *current = root.get();
 	size_t pos = 0;
+	size_t depth = 0;
+
+	// Marks `node`, which the path has reached, as the end of the word.
+	auto finish = [&](RadixNode *node) {
+		current->max_score = std::max(current->max_score, score);
+		if (!node->is_end) {
+			node->is_end = true;
+			node->score = score;
+			++word_count_;
+			tally_.add_word(word.size(), depth);
+			index_word(word, true);
+		} else if (set_score && node->score != score) {
+			const bool lowered = score < node->score;
+			node->score = score;
+			if (lowered)
+				refresh_max_scores(word);
+		}
+		record_casing(node, original, word);
+		if (value)
+			set_value(node, value);
+	};
 
 	while (pos < word.length()) {
+		current->max_score = std::max(current->max_score, score);
 		char first_char = word[pos];
-		auto it = find_child(current, first_char);
+		RadixNode *child = find_child(current, first_char);
 
-		if (it == current->children.end() || (*it)->key.front() != first_char) {
+		if (!child) {
 			// No child with this first character, create new node
 			auto new_node = std::make_unique<RadixNode>(word.substr(pos));
 			new_node->is_end = true;
-			current->children.insert(it, std::move(new_node));
+			new_node->score = score;
+			new_node->max_score = score;
+			record_casing(new_node.get(), original, word);
+			if (value)
+				set_value(new_node.get(), value);
+			tally_leaf(current, new_node.get());
+			current->children.insert(std::move(new_node));
 			++word_count_;
+			tally_.add_word(word.size(), depth + 1);
+			index_word(word, true);
 			return;
 		}
 
-		RadixNode *child = it->get();
 		std::string_view child_key = child->key;
 		std::string_view remaining(word.data() + pos, word.length() - pos);
 
@@ -343,135 +943,479 @@ void RadixTrie::insert(std::string_view word) {
 			// The child's key is a complete prefix of the remaining word
 			pos += common_len;
 			current = child;
+			++depth;
 
 			if (pos == word.length()) {
 				// Word ends here
-				if (!child->is_end) {
-					child->is_end = true;
-					++word_count_;
-				}
+				finish(child);
 				return;
 			}
 		} else {
 			// Need to split the child node - use helper method
-			split_node(current, first_char, common_len, child_key, remaining);
+			current = split_node(current, first_char, common_len);
 			pos += common_len;
-			current = find_child(current, first_char)->get();
+			++depth;
 
 			if (pos == word.length()) {
 				// Word ends at the intermediate node
-				if (!current->is_end) {
-					current->is_end = true;
-					++word_count_;
-				}
+				finish(current);
 				return;
 			}
 		}
 	}
 }
 
-bool RadixTrie::search(std::string_view word) const {
+void RadixTrie::put(std::string_view word, std::uint64_t value) {
+	insert_word(word, 0, false, value);
+}
+
+std::optional<std::uint64_t>
+RadixTrie::value_of(std::string_view original) const {
+	std::string buffer;
+	const std::string_view word = fold(original, buffer);
+	if (frozen_)
+		return frozen_->value_of(word);
+	const RadixNode *node = find_node(word);
+	if (node == nullptr || !node->is_end)
+		return std::nullopt;
+	return value_at(node);
+}
+
+bool RadixTrie::search(std::string_view original) const {
+	std::string buffer;
+	const std::string_view word = fold(original, buffer);
+	if (frozen_)
+		return frozen_->search(word);
 	RadixNode *node = find_node(word);
 	return node != nullptr && node->is_end;
 }
 
-bool RadixTrie::starts_with(std::string_view prefix) const {
+void RadixTrie::search_many(const std::string_view *words, size_t count,
+							std::uint8_t *bitmap) const {
+	// Folded copies go in a deque, whose elements never move, so that the
+	// views of them stay valid while more are added.
+	std::vector<std::string_view> folded;
+	std::deque<std::string> buffers;
+	if (fold_case_) {
+		folded.assign(words, words + count);
+		for (std::string_view &word : folded) {
+			if (needs_folding(word)) {
+				buffers.emplace_back();
+				fold_case(word, buffers.back());
+				word = buffers.back();
+			}
+		}
+		words = folded.data();
+	}
+	if (frozen_)
+		frozen_->search_many(words, count, bitmap);
+	else
+		interleaved_search(PointerSearchView{root.get()}, words, count,
+						   bitmap);
+}
+
+bool RadixTrie::starts_with(std::string_view original) const {
+	std::string buffer;
+	const std::string_view prefix = fold(original, buffer);
+	if (frozen_)
+		return frozen_->starts_with(prefix);
 	if (prefix.empty()) {
 		return !empty();
 	}
 
-	RadixNode *current = root.get();
-	size_t pos = 0;
+	RadixNode *node = nullptr;
+	size_t base = 0;
+	return descend<Match::kPrefix>(PointerSearchView{root.get()}, prefix, node,
+								   base);
+}
 
-	while (pos < prefix.length() && current) {
-		char first_char = prefix[pos];
-		auto it = find_child(current, first_char);
+std::vector<std::string> RadixTrie::words_with_prefix(std::string_view prefix,
+												 size_t limit,
+												 size_t offset) const {
+	std::vector<std::string> result;
+	PrefixCursor cursor = prefix_cursor(prefix);
+	cursor.skip(offset);
+	cursor.next(limit, result);
+	return result;
+}
 
-		if (it == current->children.end() || (*it)->key.front() != first_char) {
-			return false; // Path doesn't exist
-		}
+// Finds the node whose path first covers the whole prefix (null if none), and
+// sets `base` to the length of the part of the prefix before its key.
+const RadixNode *RadixTrie::locate_prefix(std::string_view prefix,
+										  size_t &base) const {
+	RadixNode *node = nullptr;
+	if (!descend<Match::kPrefix>(PointerSearchView{root.get()}, prefix, node,
+								 base))
+		return nullptr;
+	return node;
+}
 
-		RadixNode *child = it->get();
-		std::string_view child_key = child->key;
+RadixTrie::PrefixCursor
+RadixTrie::prefix_cursor(std::string_view original) const {
+	std::string buffer;
+	const std::string_view prefix = fold(original, buffer);
+	PrefixCursor cursor(this);
+	if (frozen_) {
+		cursor.flat_ = frozen_->cursor(prefix);
+		return cursor;
+	}
 
-		if (pos + child_key.length() > prefix.length()) {
-			// Child key is longer than remaining prefix
-			// Check if the prefix matches the beginning of the child key
-			return prefix.substr(pos) ==
-				   child_key.substr(0, prefix.length() - pos);
-		}
+	size_t base = 0;
+	const RadixNode *start = locate_prefix(prefix, base);
+	if (!start)
+		return cursor;
 
-		// Check if the child's key matches the remaining prefix portion
-		if (prefix.substr(pos, child_key.length()) != child_key) {
-			return false; // Keys don't match
-		}
+	cursor.word_.assign(prefix.substr(0, base));
+	cursor.stack_.push_back({start, start->children.begin(), base});
+	cursor.word_.append(start->key.data(), start->key.size());
+	cursor.pending_ = start->is_end;
+	return cursor;
+}
 
-		pos += child_key.length();
-		current = child;
-	}
+namespace {
 
-	// If we've consumed the entire prefix, it's a valid prefix
-	return pos == prefix.length();
+// Whether the subtree of a child whose label first differs from what is
+// left of a sought word at `common` (or holds all of it) sorts before it.
+bool sorts_before(std::string_view label, std::string_view rest,
+				  size_t common) noexcept {
+	return common < rest.size() && static_cast<unsigned char>(label[common]) <
+									   static_cast<unsigned char>(rest[common]);
 }
 
-std::vector<std::string>
-RadixTrie::words_with_prefix(std::string_view prefix) const {
-	std::vector<std::string> result;
-
-	if (prefix.empty()) {
-		// Return all words in the trie
-		collect_words_from_node(root.get(), "", result);
-		return result;
+} // namespace
+
+// Descends along `from` as far as the trie follows it, leaving each frame's
+// next child at the first one whose words are not all less than `from`; see
+// FlatTrie::range_cursor.
+RadixTrie::PrefixCursor
+RadixTrie::range_cursor(std::string_view original_from,
+						std::optional<std::string_view> original_to) const {
+	std::string from_buffer, to_buffer;
+	const std::string_view from = fold(original_from, from_buffer);
+	std::optional<std::string_view> to;
+	if (original_to)
+		to = fold(*original_to, to_buffer);
+	PrefixCursor cursor(this);
+	if (frozen_) {
+		cursor.flat_ = frozen_->range_cursor(from, to);
+		return cursor;
+	}
+	if (to) {
+		cursor.bounded_ = true;
+		cursor.end_.assign(to->data(), to->size());
 	}
 
-	// Find the node that represents the prefix
-	RadixNode *current = root.get();
+	const RadixNode *node = root.get();
 	size_t pos = 0;
+	cursor.stack_.push_back({node, node->children.begin(), 0});
+	for (;;) {
+		if (pos == from.size()) {
+			cursor.pending_ = node->is_end;
+			break;
+		}
+		const unsigned char c = static_cast<unsigned char>(from[pos]);
+		auto next = node->children.begin();
+		const auto end = node->children.end();
+		while (next != end &&
+			   static_cast<unsigned char>((*next)->key.front()) < c)
+			++next;
+		cursor.stack_.back().next = next;
+		if (next == end)
+			break;
+		const RadixNode *child = *next;
+		const std::string_view label = child->key;
+		const std::string_view rest = from.substr(pos);
+		const size_t common = common_prefix_length(label, rest);
+		if (common < label.size()) {
+			if (sorts_before(label, rest, common))
+				++cursor.stack_.back().next;
+			break;
+		}
+		++cursor.stack_.back().next;
+		cursor.stack_.push_back(
+			{child, child->children.begin(), cursor.word_.size()});
+		cursor.word_.append(label.data(), label.size());
+		node = child;
+		pos += common;
+	}
+	return cursor;
+}
 
-	while (pos < prefix.length() && current) {
-		char first_char = prefix[pos];
-		auto it = find_child(current, first_char);
+std::optional<std::string> RadixTrie::lower_bound(std::string_view word) const {
+	std::vector<std::string> first;
+	range_cursor(word).next(1, first);
+	if (first.empty())
+		return std::nullopt;
+	return std::move(first.front());
+}
 
-		if (it == current->children.end() || (*it)->key.front() != first_char) {
-			return result; // Prefix not found
-		}
+std::vector<std::string> RadixTrie::range(std::string_view from,
+										  std::optional<std::string_view> to,
+										  size_t limit, size_t offset) const {
+	std::vector<std::string> result;
+	PrefixCursor cursor = range_cursor(from, to);
+	cursor.skip(offset);
+	cursor.next(limit, result);
+	return result;
+}
 
-		RadixNode *child = it->get();
-		std::string_view child_key = child->key;
+const RadixTrie::RankIndex &RadixTrie::current_rank_index() const {
+	RankIndex &index = rank_index_;
+	const std::lock_guard<std::mutex> lock(index.mutex);
+	if (index.version == version_)
+		return index;
+
+	index.ranks.clear();
+	index.skips.clear();
+	if (frozen_) {
+		index.ranks = frozen_->word_ranks();
+	} else {
+		struct Frame {
+			const RadixNode *node;
+			ChildList::iterator next;
+			std::uint32_t at; // the node's preorder index
+		};
+		std::uint32_t seen = 0;
+		std::vector<Frame> stack;
+		auto visit = [&](const RadixNode *node) {
+			if (index.ranks.size() == std::numeric_limits<std::uint32_t>::max())
+				throw std::length_error("Trie is too large to rank");
+			const auto at = static_cast<std::uint32_t>(index.ranks.size());
+			index.ranks.push_back(seen);
+			index.skips.push_back(0);
+			seen += node->is_end ? 1 : 0;
+			stack.push_back({node, node->children.begin(), at});
+		};
+		visit(root.get());
+		while (!stack.empty()) {
+			Frame &top = stack.back();
+			if (top.next == top.node->children.end()) {
+				index.skips[top.at] =
+					static_cast<std::uint32_t>(index.ranks.size());
+				stack.pop_back();
+				continue;
+			}
+			const RadixNode *child = *top.next;
+			++top.next;
+			visit(child);
+		}
+	}
+	index.version = version_;
+	return index;
+}
 
-		if (pos + child_key.length() > prefix.length()) {
-			// Child key is longer than remaining prefix
-			if (prefix.substr(pos) ==
-				child_key.substr(0, prefix.length() - pos)) {
-				// The prefix ends in the middle of this child's key
-				// Collect all words from this child with the correct prefix
-				collect_words_from_node(
-					child, std::string(prefix.substr(0, pos)), result);
+// The descent of range_cursor, tracking the rank of the first word past the
+// current subtree: where it stops, the words before that point are counted.
+// A child's preorder index is its parent's plus one, then each sibling before
+// it steps over that sibling's subtree.
+size_t RadixTrie::rank(std::string_view original) const {
+	std::string buffer;
+	const std::string_view word = fold(original, buffer);
+	const RankIndex &index = current_rank_index();
+	if (frozen_)
+		return frozen_->rank(word, index.ranks);
+
+	const RadixNode *node = root.get();
+	std::uint32_t at = 0;
+	size_t after = word_count_;
+	size_t pos = 0;
+	for (;;) {
+		SESHAT_COUNT(nodes_visited, 1);
+		if (pos == word.size())
+			return index.ranks[at];
+		const unsigned char c = static_cast<unsigned char>(word[pos]);
+		const std::uint32_t end = index.skips[at];
+		std::uint32_t child_at = at + 1;
+		const RadixNode *child = nullptr;
+		for (const RadixNode *candidate : node->children) {
+			if (static_cast<unsigned char>(candidate->key.front()) >= c) {
+				child = candidate;
+				break;
 			}
-			return result;
+			child_at = index.skips[child_at];
 		}
+		if (!child)
+			return after;
+		const std::uint32_t sibling = index.skips[child_at];
+		const size_t next = sibling != end ? index.ranks[sibling] : after;
+		const std::string_view label = child->key;
+		const std::string_view rest = word.substr(pos);
+		const size_t common = common_prefix_length(label, rest);
+		if (common < label.size())
+			return sorts_before(label, rest, common) ? next
+													 : index.ranks[child_at];
+		node = child;
+		at = child_at;
+		after = next;
+		pos += common;
+	}
+}
 
-		// Check if the child's key matches the remaining prefix portion
-		if (prefix.substr(pos, child_key.length()) != child_key) {
-			return result; // Keys don't match
+std::optional<std::string> RadixTrie::select(size_t position) const {
+	if (position >= word_count_)
+		return std::nullopt;
+	const RankIndex &index = current_rank_index();
+	if (frozen_)
+		return frozen_->select(position, index.ranks);
+
+	// Every subtree holds a word, so the child to take is the last one whose
+	// first word is at or before `position`.
+	const RadixNode *node = root.get();
+	std::uint32_t at = 0;
+	std::string word;
+	while (!(node->is_end && index.ranks[at] == position)) {
+		SESHAT_COUNT(nodes_visited, 1);
+		const std::uint32_t end = index.skips[at];
+		std::uint32_t child_at = at + 1;
+		for (const RadixNode *child : node->children) {
+			const std::uint32_t sibling = index.skips[child_at];
+			if (sibling == end || index.ranks[sibling] > position) {
+				node = child;
+				break;
+			}
+			child_at = sibling;
 		}
+		at = child_at;
+		word.append(node->key.data(), node->key.size());
+	}
+	return std::string(spelling(node, word));
+}
 
-		pos += child_key.length();
-		current = child;
+// Only the reversed trie follows single changes; the trigram index is
+// rebuilt whole on its next use.
+void RadixTrie::update_suffix_index(std::string_view word, bool added) {
+	suffixes_->grams_current = false;
+	if (!suffixes_->reversed_current)
+		return;
+	const std::string reversed(word.rbegin(), word.rend());
+	if (added)
+		suffixes_->reversed.insert(reversed);
+	else
+		suffixes_->reversed.remove(reversed);
+}
+
+void RadixTrie::invalidate_suffix_index() {
+	if (suffixes_)
+		suffixes_->reversed_current = suffixes_->grams_current = false;
+}
+
+template <typename F> void RadixTrie::for_each_folded_word(F &&fn) const {
+	if (frozen_) {
+		frozen_->for_each_word([&fn](std::string_view word, int) { fn(word); });
+		return;
 	}
+	std::string word;
+	auto visit = [&](auto &self, const RadixNode *node) -> void {
+		const size_t base = word.size();
+		word.append(node->key.data(), node->key.size());
+		if (node->is_end)
+			fn(std::string_view(word));
+		for (const RadixNode *child : node->children)
+			self(self, child);
+		word.resize(base);
+	};
+	visit(visit, root.get());
+}
 
-	// If we've consumed the entire prefix, collect from the current node
-	if (pos == prefix.length() && current) {
-		// Calculate the prefix up to (but not including) the current node
-		std::string base_prefix(prefix);
-		if (!current->key.empty() &&
-			base_prefix.length() >= current->key.length()) {
-			base_prefix.resize(base_prefix.length() - current->key.length());
-		}
-		collect_words_from_node(current, base_prefix, result);
+template <typename F> bool RadixTrie::any_folded_word(F &&pred) const {
+	if (frozen_)
+		return frozen_->any_word(pred);
+	std::string word;
+	auto visit = [&](auto &self, const RadixNode *node) -> bool {
+		const size_t base = word.size();
+		word.append(node->key.data(), node->key.size());
+		bool found = node->is_end && pred(std::string_view(word));
+		for (auto it = node->children.begin();
+			 !found && it != node->children.end(); ++it)
+			found = self(self, *it);
+		word.resize(base);
+		return found;
+	};
+	return visit(visit, root.get());
+}
+
+// Readers take the mutex only to get here: a stale part is rebuilt once, by
+// the first reader that needs it, and only a mutation, which no reader
+// overlaps, makes it stale again, so the parts asked for can be read without
+// the lock once this returns.
+const SuffixIndex &RadixTrie::refresh_suffix_index(bool reversed,
+												   bool grams) const {
+	SuffixIndex &index = *suffixes_;
+	const std::lock_guard<std::mutex> lock(index.mutex);
+	if (reversed && !index.reversed_current) {
+		std::vector<std::string> words;
+		words.reserve(word_count_);
+		for_each_folded_word([&words](std::string_view word) {
+			words.emplace_back(word.rbegin(), word.rend());
+		});
+		std::sort(words.begin(), words.end());
+		index.reversed.clear();
+		const Arena::Scope scope(index.reversed.arena_);
+		SortedAppender add(index.reversed);
+		for (const std::string &word : words)
+			add.add(word, std::nullopt);
+		index.reversed_current = true;
+	}
+	if (grams && !index.grams_current) {
+		index.grams.clear();
+		for_each_folded_word(
+			[&index](std::string_view word) { index.grams.add(word); });
+		index.grams_current = true;
+	}
+	return index;
+}
+
+std::vector<std::string>
+RadixTrie::spellings(std::vector<std::string> words) const {
+	if (!fold_case_)
+		return words;
+	for (std::string &word : words) {
+		const std::string_view original =
+			frozen_ ? frozen_->spelling_of(word)
+					: spelling(find_node(word), word);
+		if (original.data() != word.data())
+			word.assign(original.data(), original.size());
 	}
+	return words;
+}
 
-	return result;
+bool RadixTrie::ends_with(std::string_view original) const {
+	std::string buffer;
+	const std::string_view suffix = fold(original, buffer);
+	if (suffix.empty())
+		return !empty();
+	if (suffixes_) {
+		const std::string reversed(suffix.rbegin(), suffix.rend());
+		return refresh_suffix_index(true, false).reversed.starts_with(reversed);
+	}
+	return any_folded_word([&](std::string_view word) {
+		return word.size() >= suffix.size() &&
+			   word.substr(word.size() - suffix.size()) == suffix;
+	});
+}
+
+// The reversed trie lists the matches in the order of their reversed bytes,
+// so they are turned back and sorted again.
+std::vector<std::string>
+RadixTrie::words_with_suffix(std::string_view original) const {
+	std::string buffer;
+	const std::string_view suffix = fold(original, buffer);
+	std::vector<std::string> words;
+	if (suffixes_) {
+		const std::string reversed(suffix.rbegin(), suffix.rend());
+		words = refresh_suffix_index(true, false)
+					.reversed.words_with_prefix(reversed);
+		for (std::string &word : words)
+			std::reverse(word.begin(), word.end());
+		std::sort(words.begin(), words.end());
+	} else {
+		for_each_folded_word([&](std::string_view word) {
+			if (word.size() >= suffix.size() &&
+				word.substr(word.size() - suffix.size()) == suffix)
+				words.emplace_back(word);
+		});
+	}
+	return spellings(std::move(words));
 }
 
 void RadixTrie::cleanup_orphaned_nodes(std::string_view word) {
@@ -487,37 +1431,18 @@ void RadixTrie::cleanup_orphaned_nodes(std::string_view word) {
 	};
 	std::vector<Frame> path;
 
-	RadixNode *current = root.get();
-	size_t pos = 0;
-
 	// Find the node to delete, recording the path as we descend
-	while (pos < word.length() && current) {
-		char first_char = word[pos];
-		auto it = find_child(current, first_char);
-
-		if (it == current->children.end() || (*it)->key.front() != first_char) {
-			return; // Path doesn't exist
-		}
-
-		RadixNode *child = it->get();
-		std::string_view child_key = child->key;
-
-		if (pos + child_key.length() > word.length()) {
-			return; // Child key is longer than remaining word
-		}
-
-		// Check if the child's key matches the remaining word portion
-		if (word.substr(pos, child_key.length()) != child_key) {
-			return; // Keys don't match
-		}
-
-		path.push_back({current, first_char});
-		pos += child_key.length();
-		current = child;
-	}
-
-	// Only clean up if we found the exact node and it's marked as end
-	if (!current || current->is_end)
+	RadixNode *current = nullptr;
+	size_t base = 0;
+	if (!descend<Match::kWhole>(PointerSearchView{root.get()}, word, current,
+								base,
+								[&](RadixNode *parent, RadixNode *child) {
+									path.push_back({parent, child->key.front()});
+								}))
+		return; // Path doesn't exist
+
+	// Only clean up if the node is no longer the end of a word
+	if (current->is_end)
 		return;
 
 	// Walk back up the recorded path, erasing each node that has become
@@ -526,184 +1451,740 @@ void RadixTrie::cleanup_orphaned_nodes(std::string_view word) {
 		Frame frame = path.back();
 		path.pop_back();
 
-		auto pit = find_child(frame.parent, frame.edge_char);
-		if (pit != frame.parent->children.end() &&
-			(*pit)->key.front() == frame.edge_char) {
-			frame.parent->children.erase(pit); // frees `current`
-		}
+		erase_child(frame.parent, frame.edge_char); // frees `current`
 		current = frame.parent; // Move up to parent
 	}
+	// Whatever is left may be a non-word with one child, which a fresh
+	// insert of the remaining words would never have made.
+	if (current != root.get() && !current->is_end &&
+		current->children.size() == 1)
+		join_child(current);
 }
 
-bool RadixTrie::remove(std::string_view word) {
-	if (word.empty() || !root)
+void RadixTrie::join_child(RadixNode *node) {
+	std::unique_ptr<RadixNode> child =
+		node->children.take((*node->children.begin())->key.front());
+	node->key.append(std::move(child->key));
+	node->children = std::move(child->children);
+	node->is_end = child->is_end;
+	node->score = child->score;
+	node->max_score = child->max_score;
+	node->extra = child->extra;
+	// Key bytes and leaves are unchanged, but every word below is now a
+	// level shallower.
+	depths_stale_ = true;
+}
+
+bool RadixTrie::remove(std::string_view original) {
+	const Arena::Scope scope(arena_);
+	ensure_mutable();
+	if (original.empty() || !root)
 		return false;
+	std::string buffer;
+	const std::string_view word = fold(original, buffer);
 
-	RadixNode *node = find_node(word);
+	size_t depth = 0;
+	RadixNode *node = find_node(word, &depth);
 	if (node && node->is_end) {
+		const std::uint32_t score = node->score;
 		node->is_end = false;
+		node->score = 0;
+		release_extra(node, true);
 		--word_count_; // Decrement counter
+		tally_.remove_word(word.size(), depth);
+		index_word(word, false);
 
 		// Clean up orphaned nodes
 		cleanup_orphaned_nodes(word);
+		// A zero score cannot have been any ancestor's maximum above zero
+		if (score != 0)
+			refresh_max_scores(word);
+		repack_labels_if_wasteful();
 		return true;
 	}
 	return false;
 }
 
+// Removals leave the label pool's bytes behind (see Arena.h). Once garbage is
+// both sizeable and the larger part of the pool, the live labels are copied
+// into a fresh one; the walk is paid for by the removals that made it
+// necessary. Splits leave a little garbage too, but only in proportion to the
+// tree's size, so removal is the one path that has to check.
+void RadixTrie::repack_labels_if_wasteful() {
+	constexpr size_t kMinWaste = 1024 * 1024;
+	const size_t waste = arena_.label_waste();
+	if (waste < kMinWaste || waste * 2 < arena_.label_bytes())
+		return;
+	arena_.repack_labels([this] {
+		std::vector<RadixNode *> stack{root.get()};
+		while (!stack.empty()) {
+			RadixNode *node = stack.back();
+			stack.pop_back();
+			node->key.move_to_pool();
+			for (RadixNode *child : node->children)
+				stack.push_back(child);
+		}
+	});
+}
+
+// Recomputes max_score bottom-up along the path of `word`, as far as that path
+// still exists. Only ancestors of a word see its score in their maximum, so
+// this is all that lowering or removing one score can change.
+void RadixTrie::refresh_max_scores(std::string_view word) {
+	std::vector<RadixNode *> path{root.get()};
+	RadixNode *node = nullptr;
+	size_t base = 0;
+	descend<Match::kWhole>(
+		PointerSearchView{root.get()}, word, node, base,
+		[&](RadixNode *, RadixNode *child) { path.push_back(child); });
+
+	for (auto it = path.rbegin(); it != path.rend(); ++it) {
+		RadixNode *node = *it;
+		std::uint32_t max = node->is_end ? node->score : 0;
+		for (const RadixNode *child : node->children)
+			max = std::max(max, child->max_score);
+		node->max_score = max;
+	}
+}
+
+// Set operations. Every walk is at a node boundary in this trie and at some
+// point of the other trie's tree: a node there, and how much of its key has
+// been matched so far. The other trie's node boundaries need not line up with
+// this one's, since an edge here can span several there or end partway along
+// one.
+
+namespace {
+
+// Moves (node, offset) in the other trie along `label`. Returns false if the
+// other trie has no such path, leaving the position unspecified.
+bool follow_label(const RadixNode *&node, size_t &offset,
+				  std::string_view label) noexcept {
+	while (!label.empty()) {
+		std::string_view key = node->key;
+		if (offset == key.size()) {
+			node = node->children.find(label[0]);
+			if (!node)
+				return false;
+			offset = 0;
+			key = node->key;
+		}
+		const size_t n = std::min(label.size(), key.size() - offset);
+		if (!same_bytes(label.data(), key.data() + offset, n))
+			return false;
+		label.remove_prefix(n);
+		offset += n;
+	}
+	return true;
+}
+
+// Whether (node, offset) is the end of a word in the other trie
+bool ends_word(const RadixNode *node, size_t offset) noexcept {
+	return offset == node->key.size() && node->is_end;
+}
+
+} // namespace
+
+void RadixTrie::unmark_word(RadixNode *node, size_t length, size_t depth) {
+	node->is_end = false;
+	node->score = 0;
+	release_extra(node, true);
+	--word_count_;
+	tally_.remove_word(length, depth);
+}
+
+void RadixTrie::erase_child(RadixNode *parent, char c) {
+	tally_.key_bytes -= find_child(parent, c)->key.size();
+	SESHAT_COUNT(orphan_cleanups, 1);
+	parent->children.erase(c);
+	// A parent left childless becomes the leaf in its place.
+	if (parent == root.get() || !parent->children.empty())
+		--tally_.leaves;
+}
+
+// Each child is emptied in turn and so ends up a leaf, which the node then
+// trades for being a leaf itself.
+void RadixTrie::drop_words_below(RadixNode *node, size_t length, size_t depth,
+								 size_t &removed) {
+	if (node->is_end) {
+		unmark_word(node, length, depth);
+		++removed;
+	}
+	if (node->children.empty())
+		return;
+	for (RadixNode *child : node->children) {
+		drop_words_below(child, length + child->key.size(), depth + 1,
+						 removed);
+		tally_.key_bytes -= child->key.size();
+		--tally_.leaves;
+	}
+	SESHAT_COUNT(orphan_cleanups, node->children.size());
+	node->children = ChildList();
+	++tally_.leaves;
+	node->max_score = 0;
+}
+
+const RadixTrie &RadixTrie::pointer_tree(const RadixTrie &trie,
+										 std::optional<RadixTrie> &scratch) {
+	if (!trie.frozen_)
+		return trie;
+	scratch.emplace(trie.fold_case_);
+	const std::string_view image = trie.frozen_->image();
+	scratch->load_snapshot(image.data(), image.size());
+	scratch->thaw();
+	return *scratch;
+}
+
+void RadixTrie::check_compatible(const RadixTrie &other) const {
+	if (other.fold_case_ != fold_case_)
+		throw std::invalid_argument(
+			"Both tries must agree on whether to ignore case");
+}
+
+// A copy of `node`'s subtree from the other trie, keyed by `key`: the part of
+// node's key not yet matched here. `length` and `depth` are the copy's.
+std::unique_ptr<RadixNode>
+RadixTrie::clone_subtree(const RadixTrie &other, const RadixNode *node,
+						 std::string_view key, size_t length, size_t depth,
+						 size_t &added) {
+	auto copy = std::make_unique<RadixNode>(key);
+	copy->max_score = node->max_score;
+	tally_.key_bytes += key.size();
+	if (node->is_end) {
+		copy->is_end = true;
+		copy->score = node->score;
+		if (node->extra)
+			copy_extra(copy.get(), other.extras_[node->extra - 1]);
+		++word_count_;
+		++added;
+		tally_.add_word(length, depth);
+	}
+	if (node->children.empty()) {
+		++tally_.leaves;
+		return copy;
+	}
+	copy->children.reserve(node->children.size());
+	for (const RadixNode *child : node->children) {
+		copy->children.push_back(clone_subtree(other, child, child->key,
+											   length + child->key.size(),
+											   depth + 1, added));
+	}
+	return copy;
+}
+
+// `into` and the other trie's `node` end at the same point.
+void RadixTrie::merge_nodes(const RadixTrie &other, RadixNode *into,
+							const RadixNode *node, size_t length,
+							size_t depth, size_t &added) {
+	if (node->is_end && !into->is_end) {
+		into->is_end = true;
+		into->score = node->score;
+		into->max_score = std::max(into->max_score, node->score);
+		if (node->extra)
+			copy_extra(into, other.extras_[node->extra - 1]);
+		++word_count_;
+		++added;
+		tally_.add_word(length, depth);
+	}
+	for (const RadixNode *child : node->children)
+		merge_below(other, into, child, 0, length, depth, added);
+}
+
+// The other trie's `node`, from `offset` on, continues below `parent`. An
+// edge here that only shares a prefix with it is split exactly as an insert
+// would split it, and where the tries part the rest is copied over whole.
+void RadixTrie::merge_below(const RadixTrie &other, RadixNode *parent,
+							const RadixNode *node, size_t offset,
+							size_t length, size_t depth, size_t &added) {
+	const std::string_view rest = std::string_view(node->key).substr(offset);
+	RadixNode *child = find_child(parent, rest[0]);
+	if (!child) {
+		// The copy's leaves replace the parent as a leaf
+		if (parent != root.get() && parent->children.empty())
+			--tally_.leaves;
+		auto copy = clone_subtree(other, node, rest, length + rest.size(),
+								  depth + 1, added);
+		parent->max_score = std::max(parent->max_score, copy->max_score);
+		parent->children.insert(std::move(copy));
+		return;
+	}
+
+	const size_t common = common_prefix_length(child->key, rest);
+	if (common < child->key.size())
+		child = split_node(parent, rest[0], common);
+	if (common < rest.size()) {
+		merge_below(other, child, node, offset + common, length + common,
+					depth + 1, added);
+	} else {
+		merge_nodes(other, child, node, length + common, depth + 1, added);
+	}
+	parent->max_score = std::max(parent->max_score, child->max_score);
+}
+
+// `node` here and (other, offset) there are at the same point. Keeps the
+// words below `node` that the other trie holds (keep_common) or lacks, and
+// frees whatever that leaves empty. Subtrees the other trie has no path into
+// are all kept or all dropped without a lookup per word.
+void RadixTrie::filter_node(RadixNode *node, const RadixNode *other,
+							size_t offset, bool keep_common, size_t length,
+							size_t depth, size_t &removed) {
+	if (node->is_end && ends_word(other, offset) != keep_common) {
+		unmark_word(node, length, depth);
+		++removed;
+	}
+
+	// First bytes of the children left empty; rarely more than fit inline
+	std::string emptied;
+	for (RadixNode *child : node->children) {
+		const RadixNode *there = other;
+		size_t there_offset = offset;
+		const size_t child_length = length + child->key.size();
+		if (follow_label(there, there_offset, child->key)) {
+			filter_node(child, there, there_offset, keep_common,
+						child_length, depth + 1, removed);
+		} else if (keep_common) {
+			drop_words_below(child, child_length, depth + 1, removed);
+		} else {
+			continue;
+		}
+		if (!child->is_end && child->children.empty())
+			emptied.push_back(child->key.front());
+	}
+	for (char c : emptied)
+		erase_child(node, c);
+
+	std::uint32_t max = node->is_end ? node->score : 0;
+	for (const RadixNode *child : node->children)
+		max = std::max(max, child->max_score);
+	node->max_score = max;
+	if (node != root.get() && !node->is_end && node->children.size() == 1)
+		join_child(node);
+}
+
+void RadixTrie::diff_node(const RadixNode *node, const RadixNode *other,
+						  size_t offset, std::string &word, std::string &out,
+						  bool with_scores) const {
+	if (node->is_end && !ends_word(other, offset))
+		append_line(out, spelling(node, word), node->score, with_scores);
+	for (const RadixNode *child : node->children) {
+		const size_t base = word.size();
+		word.append(child->key.data(), child->key.size());
+		const RadixNode *there = other;
+		size_t there_offset = offset;
+		if (follow_label(there, there_offset, child->key)) {
+			diff_node(child, there, there_offset, word, out, with_scores);
+		} else {
+			// The other trie has nothing below here: every word goes
+			auto visit = [&](auto &self, const RadixNode *n) -> void {
+				if (n->is_end)
+					append_line(out, spelling(n, word), n->score,
+								with_scores);
+				for (const RadixNode *c : n->children) {
+					const size_t mark = word.size();
+					word.append(c->key.data(), c->key.size());
+					self(self, c);
+					word.resize(mark);
+				}
+			};
+			visit(visit, child);
+		}
+		word.resize(base);
+	}
+}
+
+size_t RadixTrie::merge(const RadixTrie &other) {
+	check_compatible(other);
+	if (&other == this)
+		return 0;
+	std::optional<RadixTrie> scratch;
+	const RadixTrie &source = pointer_tree(other, scratch);
+	const Arena::Scope scope(arena_);
+	ensure_mutable();
+	size_t added = 0;
+	merge_nodes(source, root.get(), source.root.get(), 0, 0, added);
+	if (added != 0)
+		invalidate_suffix_index();
+	return added;
+}
+
+size_t RadixTrie::subtract(const RadixTrie &other) {
+	check_compatible(other);
+	if (&other == this) {
+		const size_t removed = word_count_;
+		clear();
+		return removed;
+	}
+	std::optional<RadixTrie> scratch;
+	const RadixTrie &source = pointer_tree(other, scratch);
+	const Arena::Scope scope(arena_);
+	ensure_mutable();
+	size_t removed = 0;
+	filter_node(root.get(), source.root.get(), 0, false, 0, 0, removed);
+	repack_labels_if_wasteful();
+	if (removed != 0)
+		invalidate_suffix_index();
+	return removed;
+}
+
+size_t RadixTrie::intersect(const RadixTrie &other) {
+	check_compatible(other);
+	if (&other == this)
+		return 0;
+	std::optional<RadixTrie> scratch;
+	const RadixTrie &source = pointer_tree(other, scratch);
+	const Arena::Scope scope(arena_);
+	ensure_mutable();
+	size_t removed = 0;
+	filter_node(root.get(), source.root.get(), 0, true, 0, 0, removed);
+	repack_labels_if_wasteful();
+	if (removed != 0)
+		invalidate_suffix_index();
+	return removed;
+}
+
+std::string RadixTrie::diff(const RadixTrie &other, bool with_scores) const {
+	check_compatible(other);
+	std::string out;
+	if (&other == this)
+		return out;
+	std::optional<RadixTrie> own_scratch, other_scratch;
+	const RadixTrie &self = pointer_tree(*this, own_scratch);
+	const RadixTrie &source = pointer_tree(other, other_scratch);
+	std::string word;
+	self.diff_node(self.root.get(), source.root.get(), 0, word, out,
+				   with_scores);
+	return out;
+}
+
+std::optional<std::uint32_t>
+RadixTrie::score_of(std::string_view original) const {
+	std::string buffer;
+	const std::string_view word = fold(original, buffer);
+	if (frozen_)
+		return frozen_->score_of(word);
+	const RadixNode *node = find_node(word);
+	if (!node || !node->is_end)
+		return std::nullopt;
+	return node->score;
+}
+
+namespace {
+
+// The accessors best_first_top_k, glob_search and levenshtein_search expect,
+// over the pointer tree and the trie's table of original spellings.
+struct PointerTreeView {
+	using Node = const RadixNode *;
+	const std::vector<WordExtra> &extras;
+	std::string_view word(Node n, std::string_view path) const {
+		if (!n->extra || extras[n->extra - 1].casing.empty())
+			return path;
+		return extras[n->extra - 1].casing;
+	}
+	std::string_view label(Node n) const { return n->key; }
+	bool is_end(Node n) const { return n->is_end; }
+	std::uint32_t score(Node n) const { return n->score; }
+	std::uint32_t max_score(Node n) const { return n->max_score; }
+	template <typename F> void for_each_child(Node n, F &&fn) const {
+		SESHAT_COUNT(nodes_visited, n->children.size());
+		for (const RadixNode *child : n->children)
+			fn(child);
+	}
+};
+
+} // namespace
+
+std::vector<ScoredWord> RadixTrie::top_k(std::string_view original,
+										 size_t k) const {
+	std::string buffer;
+	const std::string_view prefix = fold(original, buffer);
+	if (frozen_)
+		return frozen_->top_k(prefix, k);
+	size_t base = 0;
+	const RadixNode *start = locate_prefix(prefix, base);
+	if (!start)
+		return {};
+	std::string path(prefix.substr(0, base));
+	path.append(start->key.data(), start->key.size());
+	return best_first_top_k(PointerTreeView{extras_}, start, std::move(path),
+							k);
+}
+
 bool RadixTrie::empty() const noexcept { return word_count_ == 0; }
 
 size_t RadixTrie::size() const noexcept { return word_count_; }
 
 void RadixTrie::clear() {
-	root = std::make_unique<RadixNode>();
+	++version_;
+	frozen_.reset();
+	reset_nodes();
 	word_count_ = 0; // Reset counter
+	tally_ = Tally();
+	lengths_stale_ = depths_stale_ = false;
+	if (suffixes_) {
+		suffixes_->reversed.clear();
+		suffixes_->grams.clear();
+		suffixes_->reversed_current = suffixes_->grams_current = true;
+	}
 }
 
-void RadixTrie::split_node(RadixNode *current, char first_char,
-						   size_t common_len, std::string_view child_key,
-						   std::string_view /* remaining */) {
-	// Create intermediate node with common prefix
+// Returns the new intermediate node.
+RadixNode *RadixTrie::split_node(RadixNode *current, char first_char,
+								 size_t common_len) {
+	SESHAT_COUNT(splits, 1);
+	// Swap an intermediate node in for the old child. It is keyed by the
+	// first byte until it takes the common prefix off the child's key; a long
+	// key keeps its bytes in the label pool and is only divided.
 	auto intermediate =
-		std::make_unique<RadixNode>(child_key.substr(0, common_len));
-
-	// Get the old child before moving it
-	auto it = find_child(current, first_char);
-	auto old_child = std::move(*it);
-
-	// Update child's key to remaining part
-	old_child->key.assign(child_key.data() + common_len,
-						  child_key.length() - common_len);
+		std::make_unique<RadixNode>(std::string_view(&first_char, 1));
+	RadixNode *mid = intermediate.get();
+	auto old_child =
+		current->children.replace(first_char, std::move(intermediate));
+	mid->key = old_child->key.split_front(common_len);
+	mid->max_score = old_child->max_score;
+	// Key bytes are only divided and no leaf appears, but every word below
+	// is now a level deeper.
+	depths_stale_ = true;
 
 	// Move the old child under the intermediate node. The intermediate has no
 	// other children yet, so it becomes the sole (and trivially sorted) child.
-	intermediate->children.push_back(std::move(old_child));
+	mid->children.push_back(std::move(old_child));
+	return mid;
+}
 
-	// Replace the old child with the intermediate node
-	*it = std::move(intermediate);
+void RadixTrie::Tally::add_word(size_t length, size_t depth) {
+	if (lengths.size() <= length)
+		lengths.resize(length + 1);
+	if (depths.size() <= depth)
+		depths.resize(depth + 1);
+	++lengths[length];
+	++depths[depth];
 }
 
-// Helper method to calculate heights recursively
-void RadixTrie::calculate_heights_recursive(const RadixNode *node,
-											int current_depth,
-											std::vector<int> &heights) const {
-	if (!node)
-		return;
+void RadixTrie::Tally::remove_word(size_t length, size_t depth) {
+	// A stale histogram may not have the entry; it is rebuilt before use.
+	if (length < lengths.size() && lengths[length])
+		--lengths[length];
+	if (depth < depths.size() && depths[depth])
+		--depths[depth];
+}
 
-	if (node->is_end) {
-		heights.push_back(current_depth);
+void RadixTrie::Tally::merge(const Tally &other) {
+	auto add = [](std::vector<size_t> &into, const std::vector<size_t> &from) {
+		if (into.size() < from.size())
+			into.resize(from.size());
+		for (size_t i = 0; i < from.size(); ++i)
+			into[i] += from[i];
+	};
+	add(lengths, other.lengths);
+	add(depths, other.depths);
+	key_bytes += other.key_bytes;
+	leaves += other.leaves;
+	casing_spill += other.casing_spill;
+}
+
+// A leaf under a childless parent takes the parent's place as a leaf; the root
+// is not counted either way.
+void RadixTrie::tally_leaf(const RadixNode *parent, const RadixNode *leaf) {
+	tally_.key_bytes += leaf->key.size();
+	if (parent == root.get() || !parent->children.empty())
+		++tally_.leaves;
+}
+
+void RadixTrie::recount_nodes() {
+	tally_.key_bytes = 0;
+	tally_.leaves = 0;
+	tally_.casing_spill = 0;
+	std::vector<const RadixNode *> stack{root.get()};
+	while (!stack.empty()) {
+		const RadixNode *node = stack.back();
+		stack.pop_back();
+		tally_.key_bytes += node->key.size();
+		if (node->children.empty() && node != root.get())
+			++tally_.leaves;
+		for (const RadixNode *child : node->children)
+			stack.push_back(child);
 	}
+	for (const WordExtra &extra : extras_)
+		tally_.casing_spill += spilled_bytes(extra.casing);
+}
+
+template <typename F> void RadixTrie::for_each_terminal(F &&fn) const {
+	if (frozen_) {
+		frozen_->for_each_word([&fn](std::string_view word, int depth) {
+			fn(word.size(), static_cast<size_t>(depth));
+		});
+		return;
+	}
+	auto visit = [&fn](auto &self, const RadixNode *node, size_t length,
+					   size_t depth) -> void {
+		if (node->is_end)
+			fn(length, depth);
+		for (const RadixNode *child : node->children)
+			self(self, child, length + child->key.size(), depth + 1);
+	};
+	visit(visit, root.get(), 0, 0);
+}
+
+void RadixTrie::refresh_histograms() const {
+	if (!lengths_stale_ && !depths_stale_)
+		return;
+	std::vector<size_t> lengths;
+	std::vector<size_t> depths;
+	for_each_terminal([&](size_t length, size_t depth) {
+		if (lengths.size() <= length)
+			lengths.resize(length + 1);
+		if (depths.size() <= depth)
+			depths.resize(depth + 1);
+		++lengths[length];
+		++depths[depth];
+	});
+	if (lengths_stale_)
+		tally_.lengths = std::move(lengths);
+	if (depths_stale_)
+		tally_.depths = std::move(depths);
+	lengths_stale_ = depths_stale_ = false;
+}
 
-	for (const auto &child : node->children) {
-		calculate_heights_recursive(child.get(), current_depth + 1, heights);
+namespace {
+
+// Summary of a histogram whose entry i counts the words with value i. Entries
+// past the last non-zero one are left over from removed words.
+struct HistogramSummary {
+	int min = 0;
+	int max = 0;
+	int mode = 0;
+	size_t count = 0;
+	size_t sum = 0;
+};
+
+HistogramSummary summarize(const std::vector<size_t> &histogram) {
+	HistogramSummary summary;
+	size_t best = 0;
+	bool any = false;
+	for (size_t i = 0; i < histogram.size(); ++i) {
+		const size_t n = histogram[i];
+		if (n == 0)
+			continue;
+		if (!any)
+			summary.min = static_cast<int>(i);
+		any = true;
+		summary.max = static_cast<int>(i);
+		summary.count += n;
+		summary.sum += n * i;
+		if (n > best) {
+			best = n;
+			summary.mode = static_cast<int>(i);
+		}
 	}
+	return summary;
 }
 
+} // namespace
+
 // Get trie height statistics
-RadixTrie::HeightStats RadixTrie::get_height_stats() const {
+RadixTrie::HeightStats RadixTrie::get_height_stats(bool with_all_heights) const {
 	HeightStats stats;
-	std::vector<int> heights;
 
 	if (empty()) {
 		stats.min_height = 0;
 		stats.max_height = 0;
 		stats.average_height = 0.0;
 		stats.mode_height = 0;
+		if (with_all_heights)
+			stats.all_heights.emplace();
 		return stats;
 	}
 
-	calculate_heights_recursive(root.get(), 0, heights);
-
-	stats.all_heights = heights;
-	stats.min_height = *std::min_element(heights.begin(), heights.end());
-	stats.max_height = *std::max_element(heights.begin(), heights.end());
-
-	// Calculate average
-	double sum = std::accumulate(heights.begin(), heights.end(), 0.0);
-	stats.average_height = sum / heights.size();
-
-	// Calculate mode (most frequent height)
-	std::unordered_map<int, int> frequency;
-	for (int height : heights) {
-		frequency[height]++;
+	HistogramSummary summary;
+	{
+		const std::lock_guard<std::mutex> lock(stats_mutex_);
+		refresh_histograms();
+		summary = summarize(tally_.depths);
 	}
-
-	int max_count = 0;
-	for (const auto &[height, count] : frequency) {
-		if (count > max_count) {
-			max_count = count;
-			stats.mode_height = height;
-		}
+	stats.min_height = summary.min;
+	stats.max_height = summary.max;
+	stats.average_height = static_cast<double>(summary.sum) / summary.count;
+	stats.mode_height = summary.mode;
+
+	if (with_all_heights) {
+		std::vector<int> heights;
+		heights.reserve(word_count_);
+		for_each_terminal([&heights](size_t, size_t depth) {
+			heights.push_back(static_cast<int>(depth));
+		});
+		stats.all_heights = std::move(heights);
 	}
-
 	return stats;
 }
 
 // Get memory usage statistics
 RadixTrie::MemoryStats RadixTrie::get_memory_stats() const {
 	MemoryStats stats{};
+	stats.arena_bytes = arena_.reserved_bytes();
+	stats.label_pool_bytes = arena_.label_bytes();
+	stats.reclaimed_bytes = reclaimed_bytes_;
+	if (suffixes_) {
+		const std::lock_guard<std::mutex> lock(suffixes_->mutex);
+		stats.suffix_index_bytes = sizeof(SuffixIndex) +
+								   suffixes_->reversed.arena_.reserved_bytes() +
+								   suffixes_->grams.heap_bytes();
+	}
+	{
+		const std::lock_guard<std::mutex> lock(rank_index_.mutex);
+		stats.rank_index_bytes =
+			(rank_index_.ranks.capacity() + rank_index_.skips.capacity()) *
+			sizeof(std::uint32_t);
+	}
 
-	if (empty()) {
-		stats.node_count = 1;
-		stats.struct_bytes = sizeof(RadixNode);
-		stats.total_bytes = sizeof(*this) + sizeof(RadixNode); // Just the root
-		stats.overhead_bytes = stats.total_bytes;
+	if (frozen_) {
+		// A frozen trie is one image: fixed node records plus packed labels,
+		// with no per-node heap buffers to account for.
+		stats.node_count = frozen_->node_count();
+		stats.string_bytes = frozen_->label_bytes();
+		stats.struct_bytes = stats.node_count * sizeof(FlatTrie::Node);
+		stats.total_bytes = sizeof(*this) + frozen_->image().size();
+		stats.overhead_bytes = stats.total_bytes - stats.string_bytes;
+		stats.bytes_per_word =
+			word_count_ ? static_cast<double>(stats.total_bytes) / word_count_
+						: 0.0;
 		return stats;
 	}
 
-	// Count nodes and the memory each one actually requests from the allocator.
-	// Each node contributes its fixed struct size (which already includes the
-	// inline CompactKey buffer and the std::vector object) plus any heap buffers
-	// those members allocate: the children vector's backing array and, for keys
-	// longer than CompactKey's inline capacity, the key's heap storage.
-	size_t node_count = 0;
-	size_t string_bytes = 0;		// raw character payload
-	size_t child_buffer_bytes = 0;	// heap backing arrays for children vectors
-	size_t string_buffer_bytes = 0; // heap for non-SSO keys
-
-	// Iterative depth-first walk. This used to be a std::function recursion,
-	// which allocated the closure on the heap and called through a type-erased
-	// indirection on every node, making get_memory_stats noticeably slower than
-	// the rest of the analytics. An explicit stack keeps it flat and fast.
-	std::vector<const RadixNode *> stack;
-	stack.push_back(root.get());
-	while (!stack.empty()) {
-		const RadixNode *node = stack.back();
-		stack.pop_back();
-		if (!node)
-			continue;
-
-		node_count++;
-		string_bytes += node->key.size();
-
-		if (!node->key.is_inlined()) {
-			string_buffer_bytes += node->key.heap_bytes();
-		}
-
-		child_buffer_bytes +=
-			node->children.capacity() * sizeof(std::unique_ptr<RadixNode>);
-
-		for (const auto &child : node->children) {
-			stack.push_back(child.get());
-		}
+	// Every node, key spill and children block is in the arena, which counts
+	// nodes under RadixNode::kArenaTag and each children block under its
+	// kind. Leaves and single-child lists allocate nothing: the tally counts
+	// the leaves, and the single-child nodes are what is left over.
+	const Arena::Usage &usage = arena_.usage();
+	stats.node_count = usage.count[RadixNode::kArenaTag];
+	stats.string_bytes = tally_.key_bytes;
+	stats.struct_bytes = stats.node_count * sizeof(RadixNode);
+	// Pool bytes still referenced: exactly the out-of-line keys' bytes.
+	stats.string_buffer_bytes = arena_.label_live_bytes();
+
+	size_t block_nodes = 0;
+	for (unsigned k = ChildList::kNode4; k < ChildList::kKindCount; ++k) {
+		stats.kind_nodes[k] = usage.count[k];
+		stats.kind_bytes[k] = usage.bytes[k];
+		stats.child_buffer_bytes += usage.bytes[k];
+		block_nodes += usage.count[k];
 	}
-
-	stats.node_count = node_count;
-	stats.string_bytes = string_bytes;
-	stats.struct_bytes = node_count * sizeof(RadixNode);
-	stats.child_buffer_bytes = child_buffer_bytes;
-	stats.string_buffer_bytes = string_buffer_bytes;
-	// CAVEAT: total_bytes is the number of bytes *requested* from the allocator,
-	// not the process resident set size (RSS). Real RSS is somewhat higher: each
-	// allocation (one per node, plus one per non-empty children buffer and per
-	// non-SSO key) carries an allocator header and is rounded up to an alignment
-	// boundary. That per-allocation surcharge is allocator-specific (glibc,
-	// jemalloc, the macOS and Windows allocators all differ), so we deliberately
-	// do not fold in a guessed constant here rather than report a figure that is
-	// wrong on every platform but one.
+	stats.kind_nodes[ChildList::kLeaf] =
+		tally_.leaves + (root->children.empty() ? 1 : 0);
+	stats.kind_nodes[ChildList::kSingle] =
+		stats.node_count - stats.kind_nodes[ChildList::kLeaf] - block_nodes;
+
+	// Spellings short enough for the small-string buffer live inside the
+	// table's own slots.
+	stats.casing_bytes = extras_.capacity() * sizeof(WordExtra) +
+						 free_extras_.capacity() * sizeof(std::uint32_t) +
+						 tally_.casing_spill;
+	// CAVEAT: total_bytes is the number of bytes *requested*, not what the
+	// trie occupies. Each request is rounded up to 8 bytes inside the arena,
+	// which also holds freed slots and the unused end of its newest block;
+	// arena_bytes is that larger, real figure for the node structure.
 	stats.total_bytes = sizeof(*this) + stats.struct_bytes +
-						child_buffer_bytes + string_buffer_bytes;
-	stats.overhead_bytes = stats.total_bytes - string_bytes;
+						stats.child_buffer_bytes + stats.string_buffer_bytes +
+						stats.casing_bytes;
+	stats.overhead_bytes = stats.total_bytes - stats.string_bytes;
 	stats.bytes_per_word =
 		word_count_ ? static_cast<double>(stats.total_bytes) / word_count_
 					: 0.0;
@@ -711,28 +2192,9 @@ RadixTrie::MemoryStats RadixTrie::get_memory_stats() const {
 	return stats;
 }
 
-// Helper method to collect word lengths recursively
-void RadixTrie::collect_word_lengths_recursive(
-	const RadixNode *node, int current_length,
-	std::vector<int> &lengths) const {
-	if (!node)
-		return;
-
-	int new_length = current_length + static_cast<int>(node->key.length());
-
-	if (node->is_end) {
-		lengths.push_back(new_length);
-	}
-
-	for (const auto &child : node->children) {
-		collect_word_lengths_recursive(child.get(), new_length, lengths);
-	}
-}
-
 // Get word metrics
 RadixTrie::WordMetrics RadixTrie::get_word_metrics() const {
 	WordMetrics metrics;
-	std::vector<int> lengths;
 
 	if (empty()) {
 		metrics.min_length = 0;
@@ -743,114 +2205,105 @@ RadixTrie::WordMetrics RadixTrie::get_word_metrics() const {
 		return metrics;
 	}
 
-	collect_word_lengths_recursive(root.get(), 0, lengths);
-
-	metrics.min_length = *std::min_element(lengths.begin(), lengths.end());
-	metrics.max_length = *std::max_element(lengths.begin(), lengths.end());
-
-	// Calculate average
-	size_t total_chars = std::accumulate(lengths.begin(), lengths.end(), 0);
-	metrics.total_characters = total_chars;
-	metrics.average_length = static_cast<double>(total_chars) / lengths.size();
-
-	// Calculate mode (most frequent length)
-	std::unordered_map<int, int> frequency;
-	for (int length : lengths) {
-		frequency[length]++;
-	}
-
-	int max_count = 0;
-	for (const auto &[length, count] : frequency) {
-		if (count > max_count) {
-			max_count = count;
-			metrics.mode_length = length;
-		}
-	}
-
-	// Create length distribution
-	int max_length = metrics.max_length;
-	metrics.length_distribution.resize(max_length + 1, 0);
-	for (int length : lengths) {
-		metrics.length_distribution[length]++;
-	}
-
+	const std::lock_guard<std::mutex> lock(stats_mutex_);
+	refresh_histograms();
+	const HistogramSummary summary = summarize(tally_.lengths);
+	metrics.min_length = summary.min;
+	metrics.max_length = summary.max;
+	metrics.total_characters = summary.sum;
+	metrics.average_length = static_cast<double>(summary.sum) / summary.count;
+	metrics.mode_length = summary.mode;
+	metrics.length_distribution.assign(
+		tally_.lengths.begin(), tally_.lengths.begin() + summary.max + 1);
 	return metrics;
 }
 
-// Pattern matching helper - checks if word matches pattern with wildcards
-bool RadixTrie::matches_pattern(const std::string &word,
-								const std::string &pattern) const {
-	size_t word_idx = 0, pattern_idx = 0;
-	size_t word_len = word.length(), pattern_len = pattern.length();
-
-	while (word_idx < word_len && pattern_idx < pattern_len) {
-		if (pattern[pattern_idx] == '?') {
-			// '?' matches any single character
-			word_idx++;
-			pattern_idx++;
-		} else if (pattern[pattern_idx] == '*') {
-			// '*' matches zero or more characters
-			if (pattern_idx + 1 == pattern_len) {
-				return true; // '*' at end matches everything
-			}
-
-			// Try to match the rest of the pattern with remaining word
-			for (size_t i = word_idx; i <= word_len; ++i) {
-				if (matches_pattern(word.substr(i),
-									pattern.substr(pattern_idx + 1))) {
-					return true;
-				}
-			}
-			return false;
-		} else if (pattern[pattern_idx] == word[word_idx]) {
-			// Exact character match
-			word_idx++;
-			pattern_idx++;
-		} else {
-			return false; // Mismatch
+// A `*`/`?` pattern matches a word exactly when the reversed pattern matches
+// the reversed word, so a pattern that ends in a literal becomes one that
+// starts with it, and the reversed trie descends to it as pattern_search does
+// to a literal prefix. A pattern that ends in a wildcard can still be cut
+// down to the words holding the trigrams of its literals, which are then
+// matched one by one. Whichever literal is longer picks the index.
+std::optional<std::vector<std::string>>
+RadixTrie::indexed_pattern_search(std::string_view pattern) const {
+	const std::string_view tail =
+		pattern.substr(pattern.find_last_of("*?") + 1);
+	std::vector<std::string_view> literals; // of three bytes or more
+	size_t longest = 0;
+	for (size_t pos = 0; pos < pattern.size();) {
+		const size_t end =
+			std::min(pattern.find_first_of("*?", pos), pattern.size());
+		if (end - pos >= 3) {
+			literals.push_back(pattern.substr(pos, end - pos));
+			longest = std::max(longest, end - pos);
 		}
+		pos = end + 1;
 	}
 
-	// Handle trailing '*'
-	while (pattern_idx < pattern_len && pattern[pattern_idx] == '*') {
-		pattern_idx++;
+	if (!tail.empty() && tail.size() >= longest) {
+		const std::string reversed(pattern.rbegin(), pattern.rend());
+		std::vector<std::string> words =
+			refresh_suffix_index(true, false).reversed.pattern_search(reversed);
+		for (std::string &word : words)
+			std::reverse(word.begin(), word.end());
+		std::sort(words.begin(), words.end());
+		return spellings(std::move(words));
 	}
-
-	return word_idx == word_len && pattern_idx == pattern_len;
-}
-
-// Recursive pattern matching
-void RadixTrie::pattern_match_recursive(
-	const RadixNode *node, const std::string &current_word,
-	const std::string &pattern, std::vector<std::string> &results) const {
-	if (!node)
-		return;
-
-	std::string full_word = current_word;
-	full_word.append(node->key.data(), node->key.size());
-
-	if (node->is_end && matches_pattern(full_word, pattern)) {
-		results.push_back(full_word);
-	}
-
-	for (const auto &child : node->children) {
-		pattern_match_recursive(child.get(), full_word, pattern, results);
+	if (literals.empty())
+		return std::nullopt;
+
+	const SuffixIndex &index = refresh_suffix_index(false, true);
+	const GlobPattern glob(pattern);
+	std::vector<std::uint64_t> set(glob.set_words());
+	std::vector<std::string> words;
+	for (std::string_view word : index.grams.candidates(literals)) {
+		glob.start(set.data());
+		if (glob.step(set.data(), word) && glob.accepts(set.data()))
+			words.emplace_back(word);
 	}
+	return spellings(std::move(words));
 }
 
 // Pattern search with wildcards (* and ?)
 std::vector<std::string>
-RadixTrie::pattern_search(const std::string &pattern) const {
+RadixTrie::pattern_search(const std::string &original) const {
 	std::vector<std::string> results;
+	std::string buffer;
+	const std::string_view pattern = fold(original, buffer);
 
 	if (pattern.empty() || empty()) {
 		return results;
 	}
 
-	pattern_match_recursive(root.get(), "", pattern, results);
-
-	// Sort results for consistent output
-	std::sort(results.begin(), results.end());
-
+	if (suffixes_ && (pattern.front() == '*' || pattern.front() == '?')) {
+		if (auto words = indexed_pattern_search(pattern))
+			return std::move(*words);
+	}
+	if (frozen_)
+		return frozen_->pattern_search(pattern);
+
+	// Only the subtree under the literal prefix can match; below it, the
+	// walk follows edges the pattern's NFA still accepts and emits words in
+	// sorted order.
+	const GlobPattern glob(pattern);
+	size_t base = 0;
+	const RadixNode *start = locate_prefix(glob.literal_prefix(), base);
+	if (!start)
+		return results;
+	std::string path(glob.literal_prefix().substr(0, base));
+	path.append(start->key.data(), start->key.size());
+	glob_search(PointerTreeView{extras_}, start, std::move(path), glob,
+				[&](std::string_view word) { results.emplace_back(word); });
 	return results;
+}
+
+std::vector<FuzzyMatch> RadixTrie::fuzzy_search(std::string_view original,
+												std::uint32_t max_distance,
+												size_t limit) const {
+	std::string buffer;
+	const std::string_view word = fold(original, buffer);
+	if (frozen_)
+		return frozen_->fuzzy_search(word, max_distance, limit);
+	return levenshtein_search(PointerTreeView{extras_}, root.get(),
+							  EditDistance(word), max_distance, limit);
 }
\ No newline at end of file
@@ -1,42 +1,259 @@
 #pragma once
+#include "Arena.h"
+#include "CaseFold.h"
+#include "FlatTrie.h"
+#include "Fuzzy.h"
 #include "RadixNode.h"
+#include "TopK.h"
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+// Options for the bulk loaders. With more than one thread they build a
+// disjoint subtrie per thread (see parallel_insert_from_buffer); a file is then
+// mapped whole and the buffer size is not used. With assume_sorted, lines in
+// ascending byte order (as serialize_to_buffer writes them) are appended
+// without descending from the root; lines out of order are still inserted,
+// just without the shortcut. With scored, each line is `word<TAB>score` (as
+// serialize_to_buffer(true) writes them) and sets that word's score; a line
+// with no tab is a plain word. With valued, a last field after a tab is the
+// word's value (see RadixTrie::put): `word<TAB>value`, or with scored too
+// `word<TAB>score<TAB>value`, as serialize_to_buffer writes them with values;
+// a line without that field gives no value.
+struct BulkLoadOptions {
+	unsigned threads = 1;
+	bool assume_sorted = false;
+	bool scored = false;
+	bool valued = false;
+};
+
+struct SuffixIndex;
+
 class RadixTrie {
   private:
+	// Owns every node, key spill and child list of the pointer tree, so it is
+	// declared before root (see Arena.h).
+	Arena arena_;
 	std::unique_ptr<RadixNode> root;
 	size_t word_count_;
+	// Set while the trie is frozen: the node structure lives in this flat,
+	// breadth-first image (see FlatTrie.h), queries are answered from it, and
+	// `root` is left empty until the next mutation thaws the trie.
+	std::unique_ptr<FlatTrie> frozen_;
+	// Bumped by every mutation and by freeze/thaw, so that a PrefixCursor can
+	// tell that the nodes it points into may have changed.
+	std::uint64_t version_ = 0;
+
+	// With fold_case_, every word is folded (see CaseFold.h) before it is
+	// stored or looked up. A word inserted with other casing keeps its
+	// original spelling in extras_, indexed by RadixNode::extra, and that
+	// spelling is what enumeration returns. A word given a value keeps it in
+	// the same entry. Slots freed by removals are reused; words with neither
+	// cost nothing extra.
+	bool fold_case_ = false;
+	std::vector<WordExtra> extras_;
+	std::vector<std::uint32_t> free_extras_;
+	// Set on the worker tries of a parallel load, whose terminals end up in
+	// this trie: their spellings and values are logged here (an empty string
+	// or nullopt forgets one) and recorded in the parent's table after the
+	// graft.
+	std::vector<std::pair<RadixNode *, std::string>> *casing_log_ = nullptr;
+	std::vector<std::pair<RadixNode *, std::optional<std::uint64_t>>>
+		*value_log_ = nullptr;
+
+	// Running totals behind the analytics, kept current by every mutation so
+	// that the stats calls read histograms instead of walking the trie. Node
+	// counts and children-block bytes are the arena's usage(); these are the
+	// rest. The parallel loader adds its workers' tallies to the parent's.
+	struct Tally {
+		std::vector<size_t> lengths; // words per folded length in bytes
+		std::vector<size_t> depths;	 // words per terminal node depth
+		size_t key_bytes = 0;		 // sum of every node's key length
+		// Nodes without children, not counting the root, whose state is
+		// read off the tree; that keeps workers' counts additive.
+		size_t leaves = 0;
+		// Heap bytes of spellings in extras_ too long for the inline buffer.
+		size_t casing_spill = 0;
 
-	// When i found out about "using", i was like: "don't tell me using uint64 =
-	// long long; is proably a thing" and it is, and that amazes me for some
-	// reason (i came from C)
-	using ChildVec = std::vector<std::unique_ptr<RadixNode>>;
-	static ChildVec::iterator find_child(RadixNode *node, char c);
-	static ChildVec::const_iterator find_child(const RadixNode *node, char c);
+		void add_word(size_t length, size_t depth);
+		void remove_word(size_t length, size_t depth);
+		void merge(const Tally &other);
+	};
+	// A split moves every word below it one level down, and a join (see
+	// join_child) one level up, which the depth histogram cannot follow
+	// without visiting them, so either only marks the
+	// histogram stale; a snapshot load marks both. The next stats call
+	// rebuilds a stale histogram in one walk, under stats_mutex_ since
+	// readers may call it side by side.
+	mutable Tally tally_;
+	mutable bool depths_stale_ = false;
+	mutable bool lengths_stale_ = false;
+	mutable std::mutex stats_mutex_;
+	// Summed over every compact() (see MemoryStats::reclaimed_bytes)
+	size_t reclaimed_bytes_ = 0;
+	// Present when the trie was created with a suffix index (see
+	// SuffixIndex.h).
+	std::unique_ptr<SuffixIndex> suffixes_;
+
+	// What rank and select descend by, for the trie as of `version`. In the
+	// pointer tree, entry i of `ranks` belongs to the i-th node in
+	// enumeration (pre)order and counts the words before it, and entry i of
+	// `skips` is the preorder index just past that node's subtree, which is
+	// how a descent steps over a sibling. A frozen trie indexes `ranks` by
+	// image node instead (see FlatTrie::word_ranks) and needs no skips. It
+	// is rebuilt under `mutex` by the first query after any change, since
+	// readers may call side by side, and read without it afterwards: no
+	// write runs while readers do.
+	struct RankIndex {
+		std::mutex mutex;
+		std::uint64_t version = std::numeric_limits<std::uint64_t>::max();
+		std::vector<std::uint32_t> ranks;
+		std::vector<std::uint32_t> skips;
+	};
+	mutable RankIndex rank_index_;
+	const RankIndex &current_rank_index() const;
+
+	static RadixNode *find_child(const RadixNode *node, char c) noexcept;
 
 	size_t common_prefix_length(std::string_view s1,
 								std::string_view s2) const noexcept;
-	RadixNode *find_node(std::string_view word) const;
+	// The node `word` leads to, if any; `depth` receives its node depth.
+	RadixNode *find_node(std::string_view word, size_t *depth = nullptr) const;
+	const RadixNode *locate_prefix(std::string_view prefix,
+								   size_t &base) const;
+	void insert_word(std::string_view word, std::uint32_t score,
+					 bool set_score,
+					 std::optional<std::uint64_t> value = std::nullopt);
+	void refresh_max_scores(std::string_view word);
+
+	// `text` itself, or its folded form written into `buffer`.
+	std::string_view fold(std::string_view text, std::string &buffer) const;
+	// Remembers how the word ending at `node` was spelled before folding.
+	void record_casing(RadixNode *node, std::string_view original,
+					   std::string_view folded);
+	void set_casing(RadixNode *node, std::string_view original);
+	void clear_casing(RadixNode *node);
+	void set_value(RadixNode *node, std::optional<std::uint64_t> value);
+	// node's entry in extras_, made if it has none
+	WordExtra &extra_of(RadixNode *node);
+	// Frees node's entry if nothing is left in it, or unconditionally when
+	// its word goes.
+	void release_extra(RadixNode *node, bool always = false);
+	// Gives `node` what `extra`, from another trie's table, holds.
+	void copy_extra(RadixNode *node, const WordExtra &extra);
+	// The spelling to report for the word `folded` ending at `node`.
+	std::string_view spelling(const RadixNode *node,
+							  std::string_view folded) const noexcept {
+		if (!node->extra)
+			return folded;
+		const std::string &casing = extras_[node->extra - 1].casing;
+		return casing.empty() ? folded : std::string_view(casing);
+	}
+	std::optional<std::uint64_t> value_at(const RadixNode *node) const noexcept {
+		if (!node->extra || !extras_[node->extra - 1].has_value)
+			return std::nullopt;
+		return extras_[node->extra - 1].value;
+	}
 
-	void collect_words_from_node(const RadixNode *node,
-								 const std::string &prefix,
-								 std::vector<std::string> &result) const;
 	void cleanup_orphaned_nodes(std::string_view word);
-	void split_node(RadixNode *current, char first_char, size_t common_len,
-					std::string_view child_key, std::string_view remaining);
-	void calculate_heights_recursive(const RadixNode *node, int current_depth,
-									 std::vector<int> &heights) const;
-	void collect_word_lengths_recursive(const RadixNode *node,
-										int current_length,
-										std::vector<int> &lengths) const;
-
-	void pattern_match_recursive(const RadixNode *node,
-								 const std::string &current_word,
-								 const std::string &pattern,
-								 std::vector<std::string> &results) const;
-	bool matches_pattern(const std::string &word,
-						 const std::string &pattern) const;
+	// Folds the only child of `node`, a non-root node that no longer ends a
+	// word, into it, so that removals leave no chains of single-child nodes.
+	void join_child(RadixNode *node);
+	// The copy compact() builds of `node`'s subtree in the current arena,
+	// with single-child chains joined; each extra's old index is appended to
+	// `extras` and the copy numbers it by its position there.
+	std::unique_ptr<RadixNode> compact_copy(const RadixNode *node,
+											std::vector<std::uint32_t> &extras);
+	// Clears the word ending at `node`, whose word is `length` bytes long
+	// and `depth` nodes deep, without touching the structure.
+	void unmark_word(RadixNode *node, size_t length, size_t depth);
+	// Frees the child of `parent` with first byte `c`, which must be a
+	// childless non-word.
+	void erase_child(RadixNode *parent, char c);
+	// Unmarks every word under `node`, inclusive, and frees its descendants.
+	void drop_words_below(RadixNode *node, size_t length, size_t depth,
+						  size_t &removed);
+
+	// The walks behind merge, subtract, intersect and diff. Each descends
+	// both pointer trees together, visiting only the paths they share (see
+	// RadixTrie.cc).
+	std::unique_ptr<RadixNode> clone_subtree(const RadixTrie &other,
+											 const RadixNode *node,
+											 std::string_view key,
+											 size_t length, size_t depth,
+											 size_t &added);
+	void merge_nodes(const RadixTrie &other, RadixNode *into,
+					 const RadixNode *node, size_t length, size_t depth,
+					 size_t &added);
+	void merge_below(const RadixTrie &other, RadixNode *parent,
+					 const RadixNode *node, size_t offset, size_t length,
+					 size_t depth, size_t &added);
+	void filter_node(RadixNode *node, const RadixNode *other, size_t offset,
+					 bool keep_common, size_t length, size_t depth,
+					 size_t &removed);
+	void diff_node(const RadixNode *node, const RadixNode *other,
+				   size_t offset, std::string &word, std::string &out,
+				   bool with_scores) const;
+	// `trie` itself, or a thawed copy of it built in `scratch` if it is
+	// frozen, since the walks need a pointer tree.
+	static const RadixTrie &pointer_tree(const RadixTrie &trie,
+										 std::optional<RadixTrie> &scratch);
+	void check_compatible(const RadixTrie &other) const;
+	void repack_labels_if_wasteful();
+	RadixNode *split_node(RadixNode *current, char first_char,
+						  size_t common_len);
+	// Counts a leaf about to be attached under `parent`.
+	void tally_leaf(const RadixNode *parent, const RadixNode *leaf);
+	// Recounts the node totals of a freshly built pointer tree.
+	void recount_nodes();
+	// Calls fn(length, depth) for every word, in lexicographic order.
+	template <typename F> void for_each_terminal(F &&fn) const;
+	// Rebuilds whichever histograms are stale; stats_mutex_ must be held.
+	void refresh_histograms() const;
+
+	// Keeps the suffix index, if any, in step with a folded word just added
+	// or removed.
+	void index_word(std::string_view word, bool added) {
+		if (suffixes_)
+			update_suffix_index(word, added);
+	}
+	void update_suffix_index(std::string_view word, bool added);
+	// After a change to many words at once: the next query that needs the
+	// suffix index rebuilds it.
+	void invalidate_suffix_index();
+	// Rebuilds the parts of the suffix index asked for if they are stale.
+	const SuffixIndex &refresh_suffix_index(bool reversed, bool grams) const;
+	// Calls fn(word) for every folded word, in lexicographic order.
+	template <typename F> void for_each_folded_word(F &&fn) const;
+	// Whether pred(word) holds for any folded word, trying them in the same
+	// order and stopping at the first one it holds for.
+	template <typename F> bool any_folded_word(F &&pred) const;
+	// Replaces each of `words`, folded words of this trie, with the spelling
+	// to report for it.
+	std::vector<std::string> spellings(std::vector<std::string> words) const;
+	// pattern_search through the suffix index for a pattern that starts with
+	// a wildcard, or nullopt if neither side index narrows it down.
+	std::optional<std::vector<std::string>>
+	indexed_pattern_search(std::string_view pattern) const;
+
+	void ensure_mutable();
+	// Frees the pointer tree wholesale and leaves just an empty root.
+	void reset_nodes();
+	size_t parallel_insert_from_buffer(const char *data, size_t length,
+									   const BulkLoadOptions &options);
+
+	// Appends words that arrive in ascending order along the trie's right
+	// spine (see RadixTrie.cc).
+	class SortedAppender;
+	// Feeds bulk-load lines to insert() or a SortedAppender, parsing scores
+	// when the options ask for them.
+	class LineInserter;
 
   public:
 	struct HeightStats {
@@ -44,7 +261,8 @@ class RadixTrie {
 		int max_height;
 		double average_height;
 		int mode_height;
-		std::vector<int> all_heights;
+		// Every word's depth in lexicographic order, only when asked for.
+		std::optional<std::vector<int>> all_heights;
 	};
 
 	struct MemoryStats {
@@ -52,10 +270,36 @@ class RadixTrie {
 		size_t node_count;
 		size_t string_bytes;	   // raw character payload (sum of key sizes)
 		size_t struct_bytes;	   // node_count * sizeof(RadixNode)
-		size_t child_buffer_bytes; // heap backing arrays for children vectors
-		size_t string_buffer_bytes; // heap for non-SSO key allocations
+		size_t child_buffer_bytes; // heap blocks behind each node's ChildList
+		size_t string_buffer_bytes; // label pool bytes used by non-SSO keys
 		size_t overhead_bytes;	   // total_bytes - string_bytes
 		double bytes_per_word;
+		// Per ChildList::Kind: how many nodes hold their children in that
+		// representation, and the heap bytes those lists requested. Both are
+		// zero while the trie is frozen.
+		size_t kind_nodes[ChildList::kKindCount];
+		size_t kind_bytes[ChildList::kKindCount];
+		// The per-word side table: original spellings kept by a case-folding
+		// trie (see RadixTrie(bool)) and values (see put); zero while
+		// frozen, when they live in the image.
+		size_t casing_bytes;
+		// Bytes the trie's arena holds from the OS, in use or free: the
+		// memory the pointer tree actually occupies, and what clear() gives
+		// back.
+		size_t arena_bytes;
+		// Bytes appended to the label pool, including those of edges since
+		// removed or split; the excess over string_buffer_bytes is garbage
+		// awaiting a repack.
+		size_t label_pool_bytes;
+		// Arena and spelling table bytes that compact() has given back, in
+		// total over the trie's lifetime.
+		size_t reclaimed_bytes;
+		// Bytes held by the suffix index, if any, and not counted in
+		// total_bytes: the reversed trie's arena and the trigram index.
+		size_t suffix_index_bytes;
+		// Bytes of the counts behind rank and select, once either has
+		// run; not counted in total_bytes either.
+		size_t rank_index_bytes;
 	};
 
 	struct WordMetrics {
@@ -67,26 +311,275 @@ class RadixTrie {
 		size_t total_characters;
 	};
 
-	RadixTrie();
+	// Resumable depth-first enumeration of the words under a prefix, in
+	// lexicographic byte order. The cursor holds the DFS stack and a single
+	// word buffer, so a large result can be pulled a batch at a time instead
+	// of being materialized. It must not outlive its trie; any mutation of
+	// the trie (including freeze and thaw) invalidates it, and advancing it
+	// afterwards throws std::logic_error.
+	class PrefixCursor {
+	  public:
+		// Calls emit(word, score) for up to `max` further words and returns
+		// how many were produced; fewer than `max` means the cursor is
+		// exhausted. The view passed to emit is only valid for the duration
+		// of the call.
+		template <typename F> size_t advance(size_t max, F &&emit) {
+			if (trie_->version_ != version_)
+				throw std::logic_error("Trie was modified during iteration");
+			if (flat_)
+				return flat_->advance(max, emit);
+
+			size_t produced = 0;
+			if (pending_ && max != 0) {
+				pending_ = false;
+				if (!before_end()) {
+					stack_.clear();
+					return 0;
+				}
+				const RadixNode *start = stack_.back().node;
+				emit(trie_->spelling(start, word_), start->score);
+				++produced;
+			}
+			while (produced < max && !stack_.empty()) {
+				Frame &top = stack_.back();
+				if (top.next == top.node->children.end()) {
+					word_.resize(top.base);
+					stack_.pop_back();
+					continue;
+				}
+				const RadixNode *child = *top.next;
+				++top.next;
+				SESHAT_COUNT(nodes_visited, 1);
+				stack_.push_back(
+					{child, child->children.begin(), word_.size()});
+				word_.append(child->key.data(), child->key.size());
+				if (child->is_end) {
+					if (!before_end()) {
+						stack_.clear();
+						break;
+					}
+					emit(trie_->spelling(child, word_), child->score);
+					++produced;
+				}
+			}
+			return produced;
+		}
+
+		// Appends up to `max` further words to `out`.
+		size_t next(size_t max, std::vector<std::string> &out) {
+			return advance(max, [&out](std::string_view w, std::uint32_t) {
+				out.emplace_back(w);
+			});
+		}
+		// The value of the word just passed to emit, if it has one. Only
+		// meaningful from inside emit.
+		std::optional<std::uint64_t> value() const noexcept {
+			if (flat_)
+				return flat_->value();
+			return trie_->value_at(stack_.back().node);
+		}
+		// Steps over up to `n` words without copying them out.
+		size_t skip(size_t n) {
+			return advance(n, [](std::string_view, std::uint32_t) {});
+		}
+		// Whether this cursor walks `trie` (see ConcurrentTrie::read).
+		bool reads(const RadixTrie &trie) const noexcept {
+			return trie_ == &trie;
+		}
+
+	  private:
+		friend class RadixTrie;
+		struct Frame {
+			const RadixNode *node;
+			ChildList::iterator next; // the next child to visit
+			size_t base;			  // word_ length before this node's key
+		};
+
+		explicit PrefixCursor(const RadixTrie *trie)
+			: trie_(trie), version_(trie->version_) {}
+
+		// Enumeration is in byte order, so the first word at or past the
+		// bound ends it.
+		bool before_end() const noexcept {
+			return !bounded_ || std::string_view(word_) < std::string_view(end_);
+		}
+
+		const RadixTrie *trie_;
+		std::uint64_t version_;
+		std::vector<Frame> stack_;
+		std::string word_;
+		bool pending_ = false; // the start node is a word not yet emitted
+		bool bounded_ = false; // stop before the first word >= end_
+		std::string end_;
+		// Used instead of the stack while the trie is frozen.
+		std::optional<FlatTrie::Cursor> flat_;
+	};
+
+	// A case-folding trie stores and looks up every word in folded form,
+	// so words that differ only in case are the same word, and reports each
+	// word with the casing of its latest insert. A trie with a suffix index
+	// keeps the side indexes of SuffixIndex.h, which ends_with,
+	// words_with_suffix and pattern_search use.
+	explicit RadixTrie(bool fold_case = false, bool suffix_index = false);
+	~RadixTrie();
+	bool folds_case() const noexcept { return fold_case_; }
+	bool has_suffix_index() const noexcept { return suffixes_ != nullptr; }
+	// Changes whenever the trie may have (see version_)
+	std::uint64_t version() const noexcept { return version_; }
+	RadixTrie(const RadixTrie &) = delete;
+	RadixTrie &operator=(const RadixTrie &) = delete;
 
 	void insert(std::string_view word);
+	// Inserts `word` if needed and sets its score, replacing any earlier one.
+	// A plain insert() gives new words a score of 0 and leaves existing
+	// scores alone.
+	void insert(std::string_view word, std::uint32_t score);
+	std::optional<std::uint32_t> score_of(std::string_view word) const;
+	// Inserts `word` if needed and sets its value, replacing any earlier
+	// one, which turns the trie into a map from words to 64-bit values
+	// (IDs, or offsets into the caller's own storage). Values live in the
+	// per-word side table, so words without one cost nothing. Removing the
+	// word drops its value; its score is left alone.
+	void put(std::string_view word, std::uint64_t value);
+	// The value of `word`, or nullopt if it is absent or has none.
+	std::optional<std::uint64_t> value_of(std::string_view word) const;
+	// The k highest-scoring words under `prefix`, best first, ties in
+	// lexicographic order (see best_first_top_k in TopK.h).
+	std::vector<ScoredWord> top_k(std::string_view prefix, size_t k) const;
 	bool search(std::string_view word) const;
+	// Looks up words[0..count) and sets bit i % 8 of bitmap[i / 8] for each
+	// one present; `bitmap` must be zeroed. The answers are search()'s, but
+	// the lookups run interleaved so that their cache misses overlap (see
+	// interleaved_search in BatchSearch.h).
+	void search_many(const std::string_view *words, size_t count,
+					 std::uint8_t *bitmap) const;
 	bool starts_with(std::string_view prefix) const;
-	std::vector<std::string> words_with_prefix(std::string_view prefix) const;
+	// Words under `prefix` in lexicographic byte order, skipping the first
+	// `offset` matches and stopping after `limit`; the walk ends as soon as
+	// the limit is reached rather than visiting the whole subtree.
+	std::vector<std::string> words_with_prefix(
+		std::string_view prefix,
+		size_t limit = std::numeric_limits<size_t>::max(),
+		size_t offset = 0) const;
+	PrefixCursor prefix_cursor(std::string_view prefix) const;
+
+	// Ordered queries. Words compare as their folded bytes, the order every
+	// enumeration returns them in.
+	//
+	// A cursor over the words w with from <= w < to, or every word from
+	// `from` on without `to`, positioned in O(depth) rather than by skipping.
+	PrefixCursor range_cursor(
+		std::string_view from,
+		std::optional<std::string_view> to = std::nullopt) const;
+	// The first word not less than `word`, or nullopt if there is none.
+	std::optional<std::string> lower_bound(std::string_view word) const;
+	// Up to `limit` words of [from, to), after skipping `offset` of them.
+	std::vector<std::string>
+	range(std::string_view from, std::optional<std::string_view> to,
+		  size_t limit = std::numeric_limits<size_t>::max(),
+		  size_t offset = 0) const;
+	// The number of words less than `word`, and the word at position
+	// `index` (nullopt past the end). Both descend once, using counts of the
+	// words before every node that the first of them after a change builds
+	// in one O(n) walk (see RankIndex). So they take O(depth) only between
+	// writes: with a write before every call, each call is O(n).
+	size_t rank(std::string_view word) const;
+	std::optional<std::string> select(size_t index) const;
+	// Whether any word ends with `suffix`, and every such word in
+	// lexicographic byte order. With a suffix index these are prefix queries
+	// on the reversed words; without one they walk the words in order, which
+	// ends_with stops at the first match.
+	bool ends_with(std::string_view suffix) const;
+	std::vector<std::string> words_with_suffix(std::string_view suffix) const;
 	bool remove(std::string_view word);
 	bool empty() const noexcept;
 	size_t size() const noexcept;
 	void clear();
 
-	// default buffer size of 1MB
+	// default buffer size of 1MB; see BulkLoadOptions for the rest
 	size_t bulk_insert_from_file(const std::string &path,
-								 size_t buffer_size = 1024 * 1024);
-	size_t bulk_insert_from_buffer(const char *data, size_t length);
+								 size_t buffer_size = 1024 * 1024,
+								 const BulkLoadOptions &options = {});
+	size_t bulk_insert_from_buffer(const char *data, size_t length,
+								   const BulkLoadOptions &options = {});
 	size_t bulk_remove_from_buffer(const char *data, size_t length);
-	std::string serialize_to_buffer() const;
+	// Looks up every line of a newline-delimited buffer, split and trimmed as
+	// the bulk loaders do, and sets bit i % 8 of byte i / 8 when the i-th word
+	// is present.
+	std::vector<std::uint8_t> search_from_buffer(const char *data,
+												 size_t length) const;
+	// One word per line in lexicographic order; with_scores appends a tab and
+	// the word's score to every line, and with_values a tab and the value to
+	// every line of a word that has one (see BulkLoadOptions::valued).
+	std::string serialize_to_buffer(bool with_scores = false,
+									bool with_values = false) const;
+	// Appends the lines serialize_to_buffer writes for the cursor's next
+	// words to `out`, stopping once `out` holds at least `min_bytes` and at
+	// least one batch has been taken, so a dump can be produced a chunk at a
+	// time from prefix_cursor(""). Returns false once the cursor has no words
+	// left.
+	static bool serialize_chunk(PrefixCursor &cursor, std::string &out,
+								size_t min_bytes, bool with_scores,
+								bool with_values = false);
+	// Writes serialize_to_buffer's output to a file through one fixed-size
+	// buffer, replacing the file, and returns the number of words written.
+	size_t serialize_to_file(const std::string &path, bool with_scores = false,
+							 bool with_values = false) const;
+
+	// Set operations with another trie that folds case the same way (they
+	// throw std::invalid_argument otherwise). They walk both tries together
+	// edge by edge, so the cost follows the structure the two share or that
+	// differs between them rather than the number of words. A frozen trie
+	// is thawed into a scratch copy first.
+	//
+	// merge adds the other trie's words, with their scores and spellings;
+	// words already here keep theirs. Returns the number of words added.
+	size_t merge(const RadixTrie &other);
+	// Removes every word the other trie holds; returns how many went.
+	size_t subtract(const RadixTrie &other);
+	// Removes every word the other trie does not hold; returns how many went.
+	size_t intersect(const RadixTrie &other);
+	// The words here that the other trie does not hold, as the lines
+	// serialize_to_buffer would write for them.
+	std::string diff(const RadixTrie &other, bool with_scores = false) const;
+
+	// Binary snapshot of the node structure (format described in FlatTrie.h).
+	// Loading one replaces the trie's contents and leaves it frozen.
+	std::string serialize_snapshot() const;
+	void load_snapshot(const char *data, size_t length);
+	void load_snapshot_file(const std::string &path);
+
+	// Freezing flattens the pointer tree into a contiguous breadth-first image
+	// and frees the nodes; lookups then touch a few cache lines per level
+	// instead of chasing a heap pointer per edge. Any mutation thaws the trie
+	// again first, rebuilding the pointer tree from the image.
+	void freeze();
+	void thaw();
+	bool is_frozen() const noexcept { return frozen_ != nullptr; }
+
+	// Rebuilds the pointer tree into a fresh arena: nodes laid out in
+	// depth-first order, each next to its children block, every children
+	// block of the smallest kind that holds it, labels repacked, the table
+	// of spellings and values renumbered without its free slots, and any
+	// remaining single-child chains joined. Returns the bytes given back
+	// (the drop in arena_bytes plus casing_bytes, if any).
+	size_t compact();
 
-	HeightStats get_height_stats() const;
+	// The stats below are read off running totals rather than a walk;
+	// with_all_heights adds the one output that needs a walk.
+	HeightStats get_height_stats(bool with_all_heights = false) const;
 	MemoryStats get_memory_stats() const;
 	WordMetrics get_word_metrics() const;
+	// Words matching a `*`/`?` pattern, in lexicographic order. A pattern
+	// that starts with a wildcard has no literal prefix to descend to; with
+	// a suffix index it is answered from the reversed words when it ends in
+	// a literal, or from the trigram index when it holds a literal of three
+	// bytes or more, instead of from a walk of the whole trie.
 	std::vector<std::string> pattern_search(const std::string &pattern) const;
+	// The `limit` words closest to `word`, at most `max_distance` byte edits
+	// away, ranked by distance, then score, then lexicographically (see
+	// levenshtein_search in Fuzzy.h).
+	std::vector<FuzzyMatch> fuzzy_search(std::string_view word,
+										 std::uint32_t max_distance,
+										 size_t limit) const;
 };
\ No newline at end of file
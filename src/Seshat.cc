@@ -1,82 +1,1444 @@
 #include "Seshat.h"
+#include "PerfCounters.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
 #include <limits>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+// Node's headers ship zlib, and the addon resolves it against Node's own copy
+#include <zlib.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Runtime switch for the per-method latency histograms and the count of
+// result bytes handed to JS (see Seshat::SetPerfCounters). While it is off,
+// an exported method pays one relaxed load for it. Both are process-wide, so
+// every isolate's calls add to the same numbers.
+std::atomic<bool> perf_enabled{false};
+std::atomic<std::uint64_t> bytes_marshalled{0};
+
+void note_marshalled(size_t bytes) {
+	if (perf_enabled.load(std::memory_order_relaxed))
+		bytes_marshalled.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+// One histogram per exported method name, created when a class is defined
+// and never freed, since any isolate may still be recording into it.
+struct MethodLatencies {
+	std::mutex mutex;
+	std::map<std::string, std::unique_ptr<LatencyHistogram>> byName;
+};
+
+MethodLatencies &method_latencies() {
+	static MethodLatencies *latencies = new MethodLatencies;
+	return *latencies;
+}
+
+LatencyHistogram *latency_of(const char *name) {
+	MethodLatencies &latencies = method_latencies();
+	const std::lock_guard<std::mutex> lock(latencies.mutex);
+	std::unique_ptr<LatencyHistogram> &slot = latencies.byName[name];
+	if (!slot)
+		slot = std::make_unique<LatencyHistogram>();
+	return slot.get();
+}
+
+std::uint64_t elapsed_ns(Clock::time_point start) {
+	return static_cast<std::uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+															 start)
+			.count());
+}
+
+// The histogram of the exported method running on this thread, while timing
+// is on. An async method's worker takes it over (setting it to null) and
+// records from queueing to settling instead.
+thread_local LatencyHistogram *timed_call = nullptr;
+
+LatencyHistogram *claim_timed_call() {
+	return std::exchange(timed_call, nullptr);
+}
+
+// Tries shared by name between the isolates (main thread and worker threads)
+// of this process. An entry does not keep its trie alive: the trie lives as
+// long as some Seshat object, in any isolate, still uses it.
+struct SharedTries {
+	std::mutex mutex;
+	std::unordered_map<std::string, std::weak_ptr<ConcurrentTrie>> byName;
+};
+
+SharedTries &shared_tries() {
+	static SharedTries tries;
+	return tries;
+}
+
+using TrieHandle = Napi::External<std::shared_ptr<ConcurrentTrie>>;
+
+// Reads the optional thread count for the bulk loaders at info[index]. An
+// absent or undefined argument means a single-threaded load. Returns false,
+// with a RangeError pending, if the value is not a positive integer.
+bool read_thread_count(const Napi::CallbackInfo &info, size_t index,
+					   unsigned &threads) {
+	threads = 1;
+	if (info.Length() <= index || info[index].IsUndefined())
+		return true;
+
+	double value = info[index].IsNumber()
+					   ? info[index].As<Napi::Number>().DoubleValue()
+					   : 0;
+	if (!(value >= 1 && value <= 1024) ||
+		value != static_cast<unsigned>(value)) {
+		Napi::RangeError::New(info.Env(),
+							  "Thread count must be an integer from 1 to 1024")
+			.ThrowAsJavaScriptException();
+		return false;
+	}
+	threads = static_cast<unsigned>(value);
+	return true;
+}
+
+// Reads an optional boolean flag at info[index]; anything but `true` is false.
+bool read_flag(const Napi::CallbackInfo &info, size_t index) {
+	return info.Length() > index && info[index].IsBoolean() &&
+		   info[index].As<Napi::Boolean>().Value();
+}
+
+// Reads a word score at info[index]. Returns false, with a RangeError pending,
+// if the value is not an integer that fits in 32 bits.
+bool read_score(const Napi::CallbackInfo &info, size_t index,
+				std::uint32_t &score) {
+	double value = info[index].IsNumber()
+					   ? info[index].As<Napi::Number>().DoubleValue()
+					   : -1;
+	if (!(value >= 0 && value <= 4294967295.0) || value != std::floor(value)) {
+		Napi::RangeError::New(info.Env(),
+							  "Score must be an integer from 0 to 4294967295")
+			.ThrowAsJavaScriptException();
+		return false;
+	}
+	score = static_cast<std::uint32_t>(value);
+	return true;
+}
+
+// Reads a word value at info[index]. Returns false, with a RangeError pending,
+// if the value is not an integer a JS number holds exactly.
+bool read_value(const Napi::CallbackInfo &info, size_t index,
+				std::uint64_t &value) {
+	constexpr double kMaxSafe = 9007199254740991.0; // 2^53 - 1
+	double number = info.Length() > index && info[index].IsNumber()
+						? info[index].As<Napi::Number>().DoubleValue()
+						: -1;
+	if (!(number >= 0 && number <= kMaxSafe) ||
+		number != std::floor(number)) {
+		Napi::RangeError::New(
+			info.Env(), "Value must be an integer from 0 to 9007199254740991")
+			.ThrowAsJavaScriptException();
+		return false;
+	}
+	value = static_cast<std::uint64_t>(number);
+	return true;
+}
+
+// Reads an optional word count (a limit, offset or batch size) at
+// info[index]. An absent or undefined argument leaves `count` unchanged, and
+// Infinity stands for no limit. Returns false, with a RangeError pending, if
+// the value is not a non-negative integer.
+bool read_count(const Napi::CallbackInfo &info, size_t index, size_t &count,
+				const char *error) {
+	if (info.Length() <= index || info[index].IsUndefined())
+		return true;
+
+	double value = info[index].IsNumber()
+					   ? info[index].As<Napi::Number>().DoubleValue()
+					   : -1;
+	if (!(value >= 0) || value != std::floor(value)) {
+		Napi::RangeError::New(info.Env(), error).ThrowAsJavaScriptException();
+		return false;
+	}
+	count = value >= 9007199254740992.0 ? std::numeric_limits<size_t>::max()
+										: static_cast<size_t>(value);
+	return true;
+}
+
+// Reads the optional end of a range at info[index]: absent, undefined or
+// null leaves it unbounded. Returns false, with a TypeError pending, if it is
+// anything else but a string.
+bool read_bound(const Napi::CallbackInfo &info, size_t index,
+				std::optional<std::string> &bound) {
+	if (info.Length() <= index || info[index].IsUndefined() ||
+		info[index].IsNull())
+		return true;
+	if (!info[index].IsString()) {
+		Napi::TypeError::New(info.Env(), "Range end must be a string")
+			.ThrowAsJavaScriptException();
+		return false;
+	}
+	bound = info[index].As<Napi::String>().Utf8Value();
+	return true;
+}
+
+// Pulls up to `max` words from the cursor straight into a new JS array, with
+// no intermediate std::vector<std::string>.
+Napi::Array take_words(Napi::Env env, RadixTrie::PrefixCursor &cursor,
+					   size_t max) {
+	Napi::Array result = Napi::Array::New(env);
+	uint32_t i = 0;
+	size_t bytes = 0;
+	cursor.advance(max, [&](std::string_view word, std::uint32_t) {
+		result.Set(i++, Napi::String::New(env, word.data(), word.size()));
+		bytes += word.size();
+	});
+	note_marshalled(bytes);
+	return result;
+}
+
+Napi::Value strings_to_js(Napi::Env env, std::vector<std::string> &words) {
+	Napi::Array result = Napi::Array::New(env, words.size());
+	size_t bytes = 0;
+	for (size_t i = 0; i < words.size(); ++i) {
+		result[i] = Napi::String::New(env, words[i].data(), words[i].size());
+		bytes += words[i].size();
+	}
+	note_marshalled(bytes);
+	return result;
+}
+
+// Hands the bytes to a Buffer without copying; the Buffer frees them.
+Napi::Value bytes_to_js(Napi::Env env, std::string &bytes) {
+	note_marshalled(bytes.size());
+	auto *owned = new std::string(std::move(bytes));
+	return Napi::Buffer<char>::New(
+		env, owned->data(), owned->size(),
+		[](Napi::Env, char *, std::string *s) { delete s; }, owned);
+}
+
+Napi::Value count_to_js(Napi::Env env, size_t &count) {
+	return Napi::Number::New(env, static_cast<double>(count));
+}
+
+Napi::Value height_stats_to_js(Napi::Env env, RadixTrie::HeightStats &stats) {
+	Napi::Object result = Napi::Object::New(env);
+	result.Set("minHeight", Napi::Number::New(env, stats.min_height));
+	result.Set("maxHeight", Napi::Number::New(env, stats.max_height));
+	result.Set("averageHeight", Napi::Number::New(env, stats.average_height));
+	result.Set("modeHeight", Napi::Number::New(env, stats.mode_height));
+
+	// Only present when asked for: it holds a number per word
+	if (stats.all_heights) {
+		const std::vector<int> &heights = *stats.all_heights;
+		Napi::Array heights_array = Napi::Array::New(env, heights.size());
+		for (size_t i = 0; i < heights.size(); ++i)
+			heights_array[i] = Napi::Number::New(env, heights[i]);
+		result.Set("allHeights", heights_array);
+	}
+	return result;
+}
+
+Napi::Value word_metrics_to_js(Napi::Env env, RadixTrie::WordMetrics &metrics) {
+	Napi::Object result = Napi::Object::New(env);
+	result.Set("minLength", Napi::Number::New(env, metrics.min_length));
+	result.Set("maxLength", Napi::Number::New(env, metrics.max_length));
+	result.Set("averageLength", Napi::Number::New(env, metrics.average_length));
+	result.Set("modeLength", Napi::Number::New(env, metrics.mode_length));
+	result.Set("totalCharacters",
+			   Napi::Number::New(
+				   env, static_cast<double>(metrics.total_characters)));
+
+	// Convert length distribution to JS array
+	Napi::Array dist_array =
+		Napi::Array::New(env, metrics.length_distribution.size());
+	for (size_t i = 0; i < metrics.length_distribution.size(); ++i) {
+		dist_array[i] = Napi::Number::New(env, metrics.length_distribution[i]);
+	}
+	result.Set("lengthDistribution", dist_array);
+	return result;
+}
+
+// Reads a batch packed by the JS wrapper: a Buffer at info[0] holding the
+// number of words at info[1], joined by '\n'. Returns false, with an exception
+// pending, if the arguments are malformed or the word count does not match.
+bool read_packed(const Napi::CallbackInfo &info, std::string_view &data,
+				 size_t &count) {
+	Napi::Env env = info.Env();
+	if (info.Length() < 2 || !info[0].IsBuffer() || !info[1].IsNumber()) {
+		Napi::TypeError::New(env, "Expected (words: Buffer, count: number)")
+			.ThrowAsJavaScriptException();
+		return false;
+	}
+	Napi::Buffer<char> buf = info[0].As<Napi::Buffer<char>>();
+	data = std::string_view(buf.Data(), buf.Length());
+	count = 0;
+	if (!read_count(info, 1, count, "Count must be a non-negative integer"))
+		return false;
+
+	const size_t separators = std::count(data.begin(), data.end(), '\n');
+	if (count == 0 ? !data.empty() : separators != count - 1) {
+		Napi::RangeError::New(env, "Packed words do not match the count")
+			.ThrowAsJavaScriptException();
+		return false;
+	}
+	return true;
+}
+
+// Calls fn(i, word) for each word of a batch checked by read_packed. Words are
+// taken exactly as they are, so the i-th one is the JS array's i-th element.
+template <typename F> void for_each_packed(std::string_view data, F &&fn) {
+	size_t i = 0;
+	for (;;) {
+		const size_t end = data.find('\n');
+		fn(i++, data.substr(0, end));
+		if (end == std::string_view::npos)
+			return;
+		data.remove_prefix(end + 1);
+	}
+}
+
+// A bitmap with one bit per word, word i at bit i % 8 of byte i / 8
+Napi::Uint8Array new_bitmap(Napi::Env env, size_t count) {
+	Napi::Uint8Array bitmap = Napi::Uint8Array::New(env, (count + 7) / 8);
+	note_marshalled(bitmap.ElementLength());
+	std::fill_n(bitmap.Data(), bitmap.ElementLength(), std::uint8_t(0));
+	return bitmap;
+}
+
+// Collects words into one byte run plus their offsets, so a whole result
+// crosses into JS as two objects instead of one string per word.
+class WordPacker {
+  public:
+	void add(std::string_view word) {
+		bytes_.append(word);
+		if (bytes_.size() > std::numeric_limits<std::uint32_t>::max())
+			throw std::length_error("Result is too large to pack");
+		offsets_.push_back(static_cast<std::uint32_t>(bytes_.size()));
+	}
+
+	// Returns [bytes: Buffer, offsets: Uint32Array], where word i spans
+	// offsets[i] .. offsets[i + 1].
+	Napi::Value finish(Napi::Env env) {
+		Napi::Uint32Array offsets = Napi::Uint32Array::New(env, offsets_.size());
+		note_marshalled(offsets.ByteLength());
+		std::copy(offsets_.begin(), offsets_.end(), offsets.Data());
+		Napi::Array result = Napi::Array::New(env, 2);
+		result[0u] = bytes_to_js(env, bytes_);
+		result[1u] = offsets;
+		return result;
+	}
+
+  private:
+	std::string bytes_;
+	std::vector<std::uint32_t> offsets_{0};
+};
+
+// A WordPacker that also packs each word's value, for the prefix-map queries.
+// Values cross as doubles, exact up to 2^53 (everything set from JS), with
+// NaN for a word that has none.
+class EntryPacker {
+  public:
+	void add(std::string_view word, std::optional<std::uint64_t> value) {
+		words_.add(word);
+		values_.push_back(value ? static_cast<double>(*value)
+								: std::numeric_limits<double>::quiet_NaN());
+	}
+
+	// Returns [bytes: Buffer, offsets: Uint32Array, values: Float64Array].
+	Napi::Value finish(Napi::Env env) {
+		Napi::Array result = words_.finish(env).As<Napi::Array>();
+		Napi::Float64Array values = Napi::Float64Array::New(env, values_.size());
+		note_marshalled(values.ByteLength());
+		std::copy(values_.begin(), values_.end(), values.Data());
+		result[2u] = values;
+		return result;
+	}
+
+  private:
+	WordPacker words_;
+	std::vector<double> values_;
+};
+
+bool is_newline(char c) noexcept { return c == '\n' || c == '\r'; }
+
+// Cuts a byte stream that arrives in arbitrary pieces into runs of whole
+// lines, holding the unfinished last line of each piece until the rest of it
+// arrives; only that line is ever copied. Gzip input, recognized by its magic
+// bytes unless the format is given, is inflated on the way through a window
+// at a time, and concatenated members (as `cat a.gz b.gz` makes) follow one
+// another. No UTF-8 text starts with 1f 8b, since 8b cannot follow an ASCII
+// byte, so detection never mistakes a word list for gzip.
+class LineStream {
+  public:
+	enum class Format { Detect, Plain, Gzip };
+
+	explicit LineStream(Format format) : format_(format) {}
+	~LineStream() {
+		if (inflater_)
+			inflateEnd(inflater_.get());
+	}
+	LineStream(const LineStream &) = delete;
+	LineStream &operator=(const LineStream &) = delete;
+
+	// Calls emit(text) for each run of whole lines that the piece completes.
+	// Throws std::runtime_error on corrupt gzip data.
+	template <typename Emit>
+	void write(const char *data, size_t length, Emit &&emit) {
+		if (format_ == Format::Detect) {
+			if (head_.size() + length < 2) {
+				head_.append(data, length);
+				return;
+			}
+			const std::string head = std::move(head_);
+			head_.clear();
+			const char b0 = head.empty() ? data[0] : head[0];
+			const char b1 = head.size() > 1 ? head[1] : data[1 - head.size()];
+			format_ = b0 == '\x1f' && b1 == '\x8b' ? Format::Gzip
+												   : Format::Plain;
+			decode(head.data(), head.size(), emit);
+		}
+		decode(data, length, emit);
+	}
+
+	// Emits the last line if it had no newline. Throws std::runtime_error if
+	// the input stopped partway through a gzip member.
+	template <typename Emit> void end(Emit &&emit) {
+		if (format_ == Format::Detect) {
+			format_ = Format::Plain;
+			decode(head_.data(), head_.size(), emit);
+		}
+		if (in_member_)
+			throw std::runtime_error("Truncated gzip data");
+		if (!carry_.empty()) {
+			emit(std::string_view(carry_));
+			carry_.clear();
+		}
+	}
+
+  private:
+	static constexpr uInt kWindow = 256 * 1024;
+
+	template <typename Emit>
+	void decode(const char *data, size_t length, Emit &emit) {
+		if (format_ == Format::Plain) {
+			split(data, length, emit);
+			return;
+		}
+		if (!inflater_) {
+			auto z = std::make_unique<z_stream>(); // zeroed, as zlib wants
+			if (inflateInit2(z.get(), 16 + MAX_WBITS) != Z_OK) // gzip only
+				throw std::runtime_error("Failed to start the gzip decoder");
+			inflater_ = std::move(z);
+			window_ = std::make_unique<char[]>(kWindow);
+		}
+		// zlib counts input in uInt, so a huge piece goes in slices
+		while (length > 0) {
+			const size_t slice =
+				std::min<size_t>(length, std::numeric_limits<uInt>::max());
+			inflate_slice(data, slice, emit);
+			data += slice;
+			length -= slice;
+		}
+	}
+
+	template <typename Emit>
+	void inflate_slice(const char *data, size_t length, Emit &emit) {
+		z_stream &z = *inflater_;
+		z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+		z.avail_in = static_cast<uInt>(length);
+		for (;;) {
+			if (!in_member_) {
+				if (z.avail_in == 0)
+					return;
+				inflateReset(&z);
+				in_member_ = true;
+			}
+			z.next_out = reinterpret_cast<Bytef *>(window_.get());
+			z.avail_out = kWindow;
+			const int rc = inflate(&z, Z_NO_FLUSH);
+			if (rc == Z_STREAM_END) {
+				in_member_ = false;
+			} else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+				throw std::runtime_error(
+					std::string("Invalid gzip data") +
+					(z.msg ? std::string(": ") + z.msg : std::string()));
+			}
+			split(window_.get(), kWindow - z.avail_out, emit);
+			// Input used up, and the window not filled: nothing is pending
+			if (in_member_ && z.avail_in == 0 && z.avail_out != 0)
+				return;
+		}
+	}
+
+	template <typename Emit>
+	void split(const char *data, size_t length, Emit &emit) {
+		const char *end = data + length;
+		if (!carry_.empty()) {
+			const char *eol = std::find_if(data, end, is_newline);
+			carry_.append(data, eol);
+			if (eol == end)
+				return;
+			emit(std::string_view(carry_));
+			carry_.clear();
+			data = eol;
+		}
+		const char *last = end;
+		while (last > data && !is_newline(last[-1]))
+			--last;
+		if (last > data)
+			emit(std::string_view(data, static_cast<size_t>(last - data)));
+		carry_.assign(last, end);
+	}
+
+	Format format_;
+	std::string head_;	// the first byte, while it alone has arrived
+	std::string carry_; // the current line, while it is unfinished
+	std::unique_ptr<z_stream> inflater_;
+	std::unique_ptr<char[]> window_;
+	bool in_member_ = false;
+};
+
+// The state behind a createIngest() stream
+struct Ingest {
+	LineStream lines;
+	BulkLoadOptions options;
+	size_t count = 0;
+};
+
+using IngestHandle = Napi::External<Ingest>;
+
+} // namespace
+
+// Runs a read-only query on a libuv worker thread and settles a promise with
+// its result. The worker holds a read lock from construction until it
+// settles, so any number of queries run side by side while writes are
+// refused, and a reference to the JS object so the trie outlives it.
+template <typename Result> class QueryWorker : public Napi::AsyncWorker {
+  public:
+	using Run = std::function<Result(const RadixTrie &)>;
+	using Convert = Napi::Value (*)(Napi::Env, Result &);
+
+	QueryWorker(Seshat *instance, const char *failure, Run run,
+				Convert convert)
+		: Napi::AsyncWorker(instance->Env()), instance_(instance),
+		  self_(Napi::Persistent(instance->Value())), failure_(failure),
+		  run_(std::move(run)), convert_(convert),
+		  deferred_(Napi::Promise::Deferred::New(instance->Env())),
+		  latency_(claim_timed_call()), queued_(Clock::now()) {
+		++instance_->readers_;
+	}
+
+	Napi::Promise Promise() const { return deferred_.Promise(); }
+
+	void Execute() override {
+		try {
+			result_ = instance_->trie_->read_long(run_);
+		} catch (const std::exception &e) {
+			SetError(std::string(failure_) + e.what());
+		}
+	}
+
+	void OnOK() override {
+		Napi::HandleScope scope(Env());
+		--instance_->readers_;
+		deferred_.Resolve(convert_(Env(), result_));
+		if (latency_)
+			latency_->record(elapsed_ns(queued_));
+	}
+
+	void OnError(const Napi::Error &e) override {
+		Napi::HandleScope scope(Env());
+		--instance_->readers_;
+		deferred_.Reject(e.Value());
+		if (latency_)
+			latency_->record(elapsed_ns(queued_));
+	}
+
+  private:
+	Seshat *instance_;
+	Napi::ObjectReference self_;
+	const char *failure_;
+	Run run_;
+	Convert convert_;
+	Napi::Promise::Deferred deferred_;
+	LatencyHistogram *latency_; // null unless timing was on when queued
+	Clock::time_point queued_;
+	Result result_;
+};
+
+// Queues a query and returns its promise
+template <typename Result>
+Napi::Value queue_query(Seshat *instance, const char *failure,
+						typename QueryWorker<Result>::Run run,
+						typename QueryWorker<Result>::Convert convert) {
+	auto *worker = new QueryWorker<Result>(instance, failure, std::move(run),
+										   convert);
+	Napi::Promise promise = worker->Promise();
+	worker->Queue();
+	return promise;
+}
+
+// new Seshat(ignoreCase?, concurrent?, suffixIndex?): the first flag makes
+// the trie fold case natively, the second lets reads and writes overlap (see
+// ConcurrentTrie.h), the third keeps a suffix index (see SuffixIndex.h).
+// Attach passes a handle to an existing trie instead.
+Seshat::Seshat(const Napi::CallbackInfo &info)
+	: Napi::ObjectWrap<Seshat>(info),
+	  trie_(info.Length() > 0 && info[0].IsExternal()
+				? *info[0].As<TrieHandle>().Data()
+				: std::make_shared<ConcurrentTrie>(read_flag(info, 0),
+												   read_flag(info, 1),
+												   read_flag(info, 2))) {}
+
+bool Seshat::readable(Napi::Env env) {
+	if (!writer_ || trie_->concurrent())
+		return true;
+	Napi::Error::New(env, "Trie is busy: an async insert is in progress")
+		.ThrowAsJavaScriptException();
+	return false;
+}
+
+bool Seshat::writable(Napi::Env env) {
+	if (writer_) {
+		Napi::Error::New(env, "Trie is busy: an async insert is in progress")
+			.ThrowAsJavaScriptException();
+		return false;
+	}
+	if (readers_ == 0 || trie_->concurrent())
+		return true;
+	Napi::Error::New(env, "Trie is busy: async queries are in progress")
+		.ThrowAsJavaScriptException();
+	return false;
+}
+
+template <Seshat::Method M>
+Seshat::PropertyDescriptor Seshat::TimedMethod(const char *name) {
+	latency_<M> = latency_of(name);
+	return InstanceMethod(name, &Seshat::Timed<M>);
+}
+
+template <Seshat::Method M>
+Napi::Value Seshat::Timed(const Napi::CallbackInfo &info) {
+	if (!perf_enabled.load(std::memory_order_relaxed))
+		return (this->*M)(info);
+
+	// Restores the caller's timed_call even if M throws
+	struct Scope {
+		LatencyHistogram *outer;
+		~Scope() { timed_call = outer; }
+	} scope{std::exchange(timed_call, latency_<M>)};
+	const Clock::time_point start = Clock::now();
+	Napi::Value result = (this->*M)(info);
+	if (timed_call) // not claimed by an async worker
+		timed_call->record(elapsed_ns(start));
+	return result;
+}
+
+Napi::Object Seshat::Init(Napi::Env env, Napi::Object exports) {
+	Napi::Function func = DefineClass(
+		env, "Seshat",
+		{TimedMethod<&Seshat::Insert>("insert"),
+		 TimedMethod<&Seshat::InsertBatch>("insertBatch"),
+		 TimedMethod<&Seshat::InsertFromFile>("insertFromFile"),
+		 TimedMethod<&Seshat::InsertFromFileAsync>("insertFromFileAsync"),
+		 TimedMethod<&Seshat::Search>("search"),
+		 TimedMethod<&Seshat::SearchBatch>("searchBatch"),
+		 TimedMethod<&Seshat::StartsWith>("startsWith"),
+		 TimedMethod<&Seshat::EndsWith>("endsWith"),
+		 TimedMethod<&Seshat::WordsWithPrefix>("wordsWithPrefix"),
+		 TimedMethod<&Seshat::WordsWithSuffix>("wordsWithSuffix"),
+		 TimedMethod<&Seshat::WordsWithPrefixAsync>("wordsWithPrefixAsync"),
+		 TimedMethod<&Seshat::PrefixCursor>("prefixCursor"),
+		 TimedMethod<&Seshat::RangeCursor>("rangeCursor"),
+		 TimedMethod<&Seshat::TopK>("topK"),
+		 TimedMethod<&Seshat::FuzzySearch>("fuzzySearch"),
+		 TimedMethod<&Seshat::GetScore>("getScore"),
+		 TimedMethod<&Seshat::Put>("put"),
+		 TimedMethod<&Seshat::Get>("get"),
+		 TimedMethod<&Seshat::CursorNext>("cursorNext"),
+		 TimedMethod<&Seshat::CursorChunk>("cursorChunk"),
+		 TimedMethod<&Seshat::Remove>("remove"),
+		 TimedMethod<&Seshat::RemoveBatch>("removeBatch"),
+		 TimedMethod<&Seshat::InsertPacked>("insertPacked"),
+		 TimedMethod<&Seshat::SearchPacked>("searchPacked"),
+		 TimedMethod<&Seshat::RemovePacked>("removePacked"),
+		 TimedMethod<&Seshat::WordsWithPrefixPacked>("wordsWithPrefixPacked"),
+		 TimedMethod<&Seshat::EntriesWithPrefixPacked>(
+			 "entriesWithPrefixPacked"),
+		 TimedMethod<&Seshat::LowerBound>("lowerBound"),
+		 TimedMethod<&Seshat::RangePacked>("rangePacked"),
+		 TimedMethod<&Seshat::Rank>("rank"),
+		 TimedMethod<&Seshat::Select>("select"),
+		 TimedMethod<&Seshat::PatternSearchPacked>("patternSearchPacked"),
+		 TimedMethod<&Seshat::SearchFromBuffer>("searchFromBuffer"),
+		 TimedMethod<&Seshat::Empty>("empty"),
+		 TimedMethod<&Seshat::Size>("size"),
+		 TimedMethod<&Seshat::Clear>("clear"),
+		 // New analytics methods
+		 TimedMethod<&Seshat::GetHeightStats>("getHeightStats"),
+		 TimedMethod<&Seshat::GetHeightStatsAsync>("getHeightStatsAsync"),
+		 TimedMethod<&Seshat::GetMemoryStats>("getMemoryStats"),
+		 TimedMethod<&Seshat::GetWordMetrics>("getWordMetrics"),
+		 TimedMethod<&Seshat::GetWordMetricsAsync>("getWordMetricsAsync"),
+		 TimedMethod<&Seshat::PatternSearch>("patternSearch"),
+		 TimedMethod<&Seshat::PatternSearchAsync>("patternSearchAsync"),
+		 TimedMethod<&Seshat::InsertFromBuffer>("insertFromBuffer"),
+		 TimedMethod<&Seshat::CreateIngest>("createIngest"),
+		 TimedMethod<&Seshat::IngestWrite>("ingestWrite"),
+		 TimedMethod<&Seshat::IngestEnd>("ingestEnd"),
+		 TimedMethod<&Seshat::RemoveFromBuffer>("removeFromBuffer"),
+		 TimedMethod<&Seshat::Merge>("merge"),
+		 TimedMethod<&Seshat::Subtract>("subtract"),
+		 TimedMethod<&Seshat::Intersect>("intersect"),
+		 TimedMethod<&Seshat::Diff>("diff"),
+		 TimedMethod<&Seshat::ToBuffer>("toBuffer"),
+		 TimedMethod<&Seshat::ToBufferAsync>("toBufferAsync"),
+		 TimedMethod<&Seshat::WriteToFile>("writeToFile"),
+		 TimedMethod<&Seshat::WriteToFileAsync>("writeToFileAsync"),
+		 TimedMethod<&Seshat::ToSnapshot>("toSnapshot"),
+		 TimedMethod<&Seshat::LoadSnapshot>("loadSnapshot"),
+		 TimedMethod<&Seshat::LoadSnapshotFile>("loadSnapshotFile"),
+		 TimedMethod<&Seshat::Freeze>("freeze"),
+		 TimedMethod<&Seshat::Thaw>("thaw"),
+		 TimedMethod<&Seshat::Compact>("compact"),
+		 TimedMethod<&Seshat::IsFrozen>("isFrozen"),
+		 TimedMethod<&Seshat::Share>("share"),
+		 TimedMethod<&Seshat::IgnoresCase>("ignoresCase"),
+		 StaticMethod("attach", &Seshat::Attach),
+		 StaticMethod("unshare", &Seshat::Unshare),
+		 StaticMethod("getPerfCounters", &Seshat::GetPerfCounters),
+		 StaticMethod("setPerfCounters", &Seshat::SetPerfCounters),
+		 StaticMethod("resetPerfCounters", &Seshat::ResetPerfCounters)});
+
+	// Each isolate loads the addon and gets its own class; Attach needs the
+	// one belonging to the isolate it is called in.
+	env.SetInstanceData(new Napi::FunctionReference(Napi::Persistent(func)));
+
+	exports.Set("Seshat", func);
+	return exports;
+}
+
+// Insert method - uses string_view to avoid copies
+Napi::Value Seshat::Insert(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "String argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	// An optional second argument sets the word's score
+	std::uint32_t score = 0;
+	const bool scored = info.Length() >= 2 && !info[1].IsUndefined();
+	if (scored && !read_score(info, 1, score))
+		return env.Undefined();
+
+	// Use string_view to avoid unnecessary string copy
+	std::string word = info[0].As<Napi::String>().Utf8Value();
+	std::string_view word_view(word);
+	try {
+		trie_->try_write([&](RadixTrie &trie) {
+			if (scored)
+				trie.insert(word_view, score);
+			else
+				trie.insert(word_view);
+		});
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to insert: ") + e.what())
+			.ThrowAsJavaScriptException();
+	}
+
+	return env.Undefined();
+}
+
+// Search method - uses string_view to avoid copies
+Napi::Value Seshat::Search(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "String argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	// Use string_view to avoid unnecessary string copy
+	std::string word = info[0].As<Napi::String>().Utf8Value();
+	std::string_view word_view(word);
+	bool found = trie_->read(
+		[&](const RadixTrie &trie) { return trie.search(word_view); });
+
+	return Napi::Boolean::New(env, found);
+}
+
+// StartsWith method
+Napi::Value Seshat::StartsWith(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "String argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	std::string prefix = info[0].As<Napi::String>().Utf8Value();
+	bool hasPrefix = trie_->read(
+		[&](const RadixTrie &trie) { return trie.starts_with(prefix); });
+
+	return Napi::Boolean::New(env, hasPrefix);
+}
+
+// EndsWith method
+Napi::Value Seshat::EndsWith(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "String argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	std::string suffix = info[0].As<Napi::String>().Utf8Value();
+	bool hasSuffix = trie_->read(
+		[&](const RadixTrie &trie) { return trie.ends_with(suffix); });
+
+	return Napi::Boolean::New(env, hasSuffix);
+}
+
+// WordsWithSuffix method
+Napi::Value Seshat::WordsWithSuffix(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "String argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	try {
+		std::string suffix = info[0].As<Napi::String>().Utf8Value();
+		std::vector<std::string> words = trie_->read(
+			[&](const RadixTrie &trie) { return trie.words_with_suffix(suffix); });
+		return strings_to_js(env, words);
+	} catch (const std::exception &e) {
+		Napi::Error::New(
+			env, std::string("Failed to get words with suffix: ") + e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+}
+
+// WordsWithPrefix method - optional limit and offset stop the walk early
+Napi::Value Seshat::WordsWithPrefix(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "String argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	size_t limit = std::numeric_limits<size_t>::max();
+	size_t offset = 0;
+	if (!read_count(info, 1, limit, "Limit must be a non-negative integer") ||
+		!read_count(info, 2, offset, "Offset must be a non-negative integer"))
+		return env.Undefined();
+
+	std::string prefix = info[0].As<Napi::String>().Utf8Value();
+	return trie_->read([&](const RadixTrie &trie) {
+		RadixTrie::PrefixCursor cursor = trie.prefix_cursor(prefix);
+		cursor.skip(offset);
+		return take_words(env, cursor, limit);
+	});
+}
+
+// WordsWithPrefixAsync method - WordsWithPrefix on a worker thread
+Napi::Value Seshat::WordsWithPrefixAsync(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "String argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	size_t limit = std::numeric_limits<size_t>::max();
+	size_t offset = 0;
+	if (!read_count(info, 1, limit, "Limit must be a non-negative integer") ||
+		!read_count(info, 2, offset, "Offset must be a non-negative integer"))
+		return env.Undefined();
+
+	std::string prefix = info[0].As<Napi::String>().Utf8Value();
+	return queue_query<std::vector<std::string>>(
+		this, "Failed to get words with prefix: ",
+		[prefix, limit, offset](const RadixTrie &trie) {
+			return trie.words_with_prefix(prefix, limit, offset);
+		},
+		strings_to_js);
+}
+
+// PrefixCursor method - returns an opaque handle for CursorNext. The handle
+// owns the cursor; the JS side keeps the trie alive while it holds one.
+Napi::Value Seshat::PrefixCursor(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "String argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	std::string prefix = info[0].As<Napi::String>().Utf8Value();
+	auto *cursor = trie_->read([&](const RadixTrie &trie) {
+		return new RadixTrie::PrefixCursor(trie.prefix_cursor(prefix));
+	});
+	return Napi::External<RadixTrie::PrefixCursor>::New(
+		env, cursor,
+		[](Napi::Env, RadixTrie::PrefixCursor *c) { delete c; });
+}
+
+// RangeCursor method - PrefixCursor over the words from `from` up to, but
+// not including, an optional `to`
+Napi::Value Seshat::RangeCursor(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "String argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	std::optional<std::string> to;
+	if (!read_bound(info, 1, to))
+		return env.Undefined();
+
+	std::string from = info[0].As<Napi::String>().Utf8Value();
+	auto *cursor = trie_->read([&](const RadixTrie &trie) {
+		return new RadixTrie::PrefixCursor(trie.range_cursor(from, to));
+	});
+	return Napi::External<RadixTrie::PrefixCursor>::New(
+		env, cursor,
+		[](Napi::Env, RadixTrie::PrefixCursor *c) { delete c; });
+}
+
+// CursorNext method - the next batch of at most `max` words; a shorter batch
+// means the cursor is exhausted
+Napi::Value Seshat::CursorNext(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsExternal()) {
+		Napi::TypeError::New(env, "Cursor argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	size_t max = 1024;
+	if (!read_count(info, 1, max, "Batch size must be a non-negative integer"))
+		return env.Undefined();
+
+	auto *cursor =
+		info[0].As<Napi::External<RadixTrie::PrefixCursor>>().Data();
+	try {
+		// A write to a concurrent trie publishes the other copy, which the
+		// cursor does not walk; that is a modification like any other.
+		return trie_->read([&](const RadixTrie &trie) {
+			if (!cursor->reads(trie))
+				throw std::logic_error("Trie was modified during iteration");
+			return take_words(env, *cursor, max);
+		});
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to advance cursor: ") +
+								  e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+}
+
+// CursorChunk method - the cursor's next words as toBuffer lines, in a Buffer
+// of at least `bytes` bytes unless the cursor runs out; an empty Buffer means
+// it is exhausted
+Napi::Value Seshat::CursorChunk(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsExternal()) {
+		Napi::TypeError::New(env, "Cursor argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	size_t bytes = 64 * 1024;
+	if (!read_count(info, 1, bytes, "Chunk size must be a non-negative integer"))
+		return env.Undefined();
+	const bool with_scores = read_flag(info, 2);
+	const bool with_values = read_flag(info, 3);
+
+	auto *cursor =
+		info[0].As<Napi::External<RadixTrie::PrefixCursor>>().Data();
+	try {
+		std::string chunk = trie_->read([&](const RadixTrie &trie) {
+			if (!cursor->reads(trie))
+				throw std::logic_error("Trie was modified during iteration");
+			std::string out;
+			RadixTrie::serialize_chunk(*cursor, out, bytes, with_scores,
+									   with_values);
+			return out;
+		});
+		return bytes_to_js(env, chunk);
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to advance cursor: ") +
+								  e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+}
+
+// TopK method - the k highest-scoring words under a prefix, best first
+Napi::Value Seshat::TopK(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	if (info.Length() < 2 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "Expected (prefix: string, k: number)")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	size_t k = 0;
+	if (!read_count(info, 1, k, "k must be a non-negative integer"))
+		return env.Undefined();
+
+	std::string prefix = info[0].As<Napi::String>().Utf8Value();
+	std::vector<ScoredWord> top = trie_->read(
+		[&](const RadixTrie &trie) { return trie.top_k(prefix, k); });
+
+	Napi::Array result = Napi::Array::New(env, top.size());
+	for (size_t i = 0; i < top.size(); ++i) {
+		Napi::Object entry = Napi::Object::New(env);
+		entry.Set("word", Napi::String::New(env, top[i].word.data(),
+											top[i].word.size()));
+		note_marshalled(top[i].word.size());
+		entry.Set("score", Napi::Number::New(env, top[i].score));
+		result[i] = entry;
+	}
+	return result;
+}
+
+// FuzzySearch method - the words closest to a word by edit distance
+Napi::Value Seshat::FuzzySearch(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	if (info.Length() < 2 || !info[0].IsString()) {
+		Napi::TypeError::New(
+			env, "Expected (word: string, maxDistance: number, limit?: number)")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	size_t max_distance = 0;
+	size_t limit = 10;
+	if (!read_count(info, 1, max_distance,
+					"maxDistance must be a non-negative integer") ||
+		!read_count(info, 2, limit, "Limit must be a non-negative integer"))
+		return env.Undefined();
+
+	std::string word = info[0].As<Napi::String>().Utf8Value();
+	const auto bound = static_cast<std::uint32_t>(std::min<size_t>(
+		max_distance, std::numeric_limits<std::uint32_t>::max()));
+	std::vector<FuzzyMatch> matches =
+		trie_->read([&](const RadixTrie &trie) {
+			return trie.fuzzy_search(word, bound, limit);
+		});
+
+	Napi::Array result = Napi::Array::New(env, matches.size());
+	for (size_t i = 0; i < matches.size(); ++i) {
+		Napi::Object entry = Napi::Object::New(env);
+		entry.Set("word", Napi::String::New(env, matches[i].word.data(),
+											matches[i].word.size()));
+		note_marshalled(matches[i].word.size());
+		entry.Set("distance", Napi::Number::New(env, matches[i].distance));
+		entry.Set("score", Napi::Number::New(env, matches[i].score));
+		result[i] = entry;
+	}
+	return result;
+}
+
+// GetScore method - a word's score, or undefined if it is not in the trie
+Napi::Value Seshat::GetScore(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "String argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	std::string word = info[0].As<Napi::String>().Utf8Value();
+	std::optional<std::uint32_t> score = trie_->read(
+		[&](const RadixTrie &trie) { return trie.score_of(word); });
+	if (!score)
+		return env.Undefined();
+	return Napi::Number::New(env, *score);
+}
+
+// Put method - inserts a word if needed and sets its value
+Napi::Value Seshat::Put(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
+
+	if (info.Length() < 2 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "Expected (word: string, value: number)")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	std::uint64_t value = 0;
+	if (!read_value(info, 1, value))
+		return env.Undefined();
+
+	std::string word = info[0].As<Napi::String>().Utf8Value();
+	try {
+		trie_->try_write([&](RadixTrie &trie) { trie.put(word, value); });
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to set value: ") + e.what())
+			.ThrowAsJavaScriptException();
+	}
+	return env.Undefined();
+}
+
+// Get method - a word's value, or undefined if it has none or is not in the
+// trie
+Napi::Value Seshat::Get(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "String argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	std::string word = info[0].As<Napi::String>().Utf8Value();
+	std::optional<std::uint64_t> value = trie_->read(
+		[&](const RadixTrie &trie) { return trie.value_of(word); });
+	if (!value)
+		return env.Undefined();
+	return Napi::Number::New(env, static_cast<double>(*value));
+}
+
+// Remove method
+Napi::Value Seshat::Remove(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "String argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	std::string word = info[0].As<Napi::String>().Utf8Value();
+	try {
+		bool removed = trie_->try_write(
+			[&](RadixTrie &trie) { return trie.remove(word); });
+		return Napi::Boolean::New(env, removed);
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to remove: ") + e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+}
+
+// Empty method
+Napi::Value Seshat::Empty(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+	bool isEmpty =
+		trie_->read([](const RadixTrie &trie) { return trie.empty(); });
+	return Napi::Boolean::New(env, isEmpty);
+}
+
+// Size method
+Napi::Value Seshat::Size(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+	size_t size =
+		trie_->read([](const RadixTrie &trie) { return trie.size(); });
+	// Use safe conversion for large numbers
+	// Check if size can be safely converted to double (use a reasonable upper
+	// bound)
+	const size_t MAX_SAFE_SIZE =
+		1ULL << 53; // 2^53 is the max safe integer in JavaScript
+	if (size > MAX_SAFE_SIZE) {
+		Napi::TypeError::New(env,
+							 "Size too large to represent as JavaScript number")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+	return Napi::Number::New(env, static_cast<double>(size));
+}
+
+// Clear method
+Napi::Value Seshat::Clear(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
+	try {
+		trie_->try_write([](RadixTrie &trie) { trie.clear(); });
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to clear: ") + e.what())
+			.ThrowAsJavaScriptException();
+	}
+	return env.Undefined();
+}
+
+// Batch Insert method - reduces N-API overhead
+Napi::Value Seshat::InsertBatch(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsArray()) {
+		Napi::TypeError::New(env, "Array argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	Napi::Array words = info[0].As<Napi::Array>();
+	std::vector<std::string> batch;
+	for (uint32_t i = 0; i < words.Length(); ++i) {
+		if (words.Get(i).IsString()) {
+			std::string word = words.Get(i).As<Napi::String>().Utf8Value();
+			if (!word.empty())
+				batch.push_back(std::move(word));
+		}
+	}
+	const uint32_t count = static_cast<uint32_t>(batch.size());
+
+	// Process all words in a single C++ call
+	try {
+		trie_->try_write([&](RadixTrie &trie) {
+			for (const std::string &word : batch)
+				trie.insert(word);
+		});
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to insert batch: ") + e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	return Napi::Number::New(env, count);
+}
+
+// Batch Search method - returns array of results
+Napi::Value Seshat::SearchBatch(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsArray()) {
+		Napi::TypeError::New(env, "Array argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	Napi::Array words = info[0].As<Napi::Array>();
+	Napi::Array results = Napi::Array::New(env, words.Length());
+
+	// Convert every word first, then process all searches in a single C++
+	// call. A non-string becomes the empty word, which is never found.
+	const uint32_t count = words.Length();
+	std::vector<std::string> converted(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		if (words.Get(i).IsString())
+			converted[i] = words.Get(i).As<Napi::String>().Utf8Value();
+	}
+	std::vector<std::string_view> views(converted.begin(), converted.end());
+	std::vector<std::uint8_t> bits((count + 7) / 8);
+	trie_->read([&](const RadixTrie &trie) {
+		trie.search_many(views.data(), count, bits.data());
+	});
+	for (uint32_t i = 0; i < count; ++i)
+		results.Set(i, Napi::Boolean::New(env, (bits[i / 8] >> (i % 8)) & 1u));
+
+	return results;
+}
+
+// Batch Remove method - returns array of success flags
+Napi::Value Seshat::RemoveBatch(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
 
-Napi::FunctionReference Seshat::constructor;
+	if (info.Length() < 1 || !info[0].IsArray()) {
+		Napi::TypeError::New(env, "Array argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
 
-Seshat::Seshat(const Napi::CallbackInfo &info)
-	: Napi::ObjectWrap<Seshat>(info) {}
+	Napi::Array words = info[0].As<Napi::Array>();
 
-Napi::Object Seshat::Init(Napi::Env env, Napi::Object exports) {
-	Napi::Function func = DefineClass(
-		env, "Seshat",
-		{InstanceMethod("insert", &Seshat::Insert),
-		 InstanceMethod("insertBatch", &Seshat::InsertBatch),
-		 InstanceMethod("insertFromFile", &Seshat::InsertFromFile),
-		 InstanceMethod("insertFromFileAsync", &Seshat::InsertFromFileAsync),
-		 InstanceMethod("search", &Seshat::Search),
-		 InstanceMethod("searchBatch", &Seshat::SearchBatch),
-		 InstanceMethod("startsWith", &Seshat::StartsWith),
-		 InstanceMethod("wordsWithPrefix", &Seshat::WordsWithPrefix),
-		 InstanceMethod("remove", &Seshat::Remove),
-		 InstanceMethod("removeBatch", &Seshat::RemoveBatch),
-		 InstanceMethod("empty", &Seshat::Empty),
-		 InstanceMethod("size", &Seshat::Size),
-		 InstanceMethod("clear", &Seshat::Clear),
-		 // New analytics methods
-		 InstanceMethod("getHeightStats", &Seshat::GetHeightStats),
-		 InstanceMethod("getMemoryStats", &Seshat::GetMemoryStats),
-		 InstanceMethod("getWordMetrics", &Seshat::GetWordMetrics),
-		 InstanceMethod("patternSearch", &Seshat::PatternSearch),
-		 InstanceMethod("insertFromBuffer", &Seshat::InsertFromBuffer),
-		 InstanceMethod("removeFromBuffer", &Seshat::RemoveFromBuffer),
-		 InstanceMethod("toBuffer", &Seshat::ToBuffer)});
+	// Convert every word first, as the removal runs once per copy of a
+	// concurrent trie and must see the same words both times. A non-string
+	// becomes the empty word, which is never removed.
+	const uint32_t count = words.Length();
+	std::vector<std::string> converted(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		if (words.Get(i).IsString())
+			converted[i] = words.Get(i).As<Napi::String>().Utf8Value();
+	}
 
-	constructor = Napi::Persistent(func);
-	constructor.SuppressDestruct();
+	// Process all removals in a single C++ call. Both copies of a concurrent
+	// trie give the same answers, so setting the bits twice is harmless.
+	std::vector<std::uint8_t> bits((count + 7) / 8);
+	try {
+		trie_->try_write([&](RadixTrie &trie) {
+			for (uint32_t i = 0; i < count; ++i) {
+				if (trie.remove(converted[i]))
+					bits[i / 8] |= std::uint8_t(1u << (i % 8));
+			}
+		});
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to remove batch: ") + e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
 
-	exports.Set("Seshat", func);
-	return exports;
+	Napi::Array results = Napi::Array::New(env, count);
+	for (uint32_t i = 0; i < count; ++i)
+		results.Set(i, Napi::Boolean::New(env, (bits[i / 8] >> (i % 8)) & 1u));
+	return results;
 }
 
-// Insert method - uses string_view to avoid copies
-Napi::Value Seshat::Insert(const Napi::CallbackInfo &info) {
+// InsertPacked method - InsertBatch over a packed batch; returns the number
+// of non-empty words
+Napi::Value Seshat::InsertPacked(const Napi::CallbackInfo &info) {
 	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
 
-	if (info.Length() < 1 || !info[0].IsString()) {
-		Napi::TypeError::New(env, "String argument expected")
+	std::string_view data;
+	size_t count = 0;
+	if (!read_packed(info, data, count))
+		return env.Undefined();
+
+	size_t inserted = 0;
+	try {
+		if (count != 0)
+			inserted = trie_->try_write([&](RadixTrie &trie) {
+				size_t n = 0;
+				for_each_packed(data, [&](size_t, std::string_view word) {
+					if (!word.empty()) {
+						trie.insert(word);
+						++n;
+					}
+				});
+				return n;
+			});
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to insert batch: ") + e.what())
 			.ThrowAsJavaScriptException();
 		return env.Undefined();
 	}
+	return Napi::Number::New(env, static_cast<double>(inserted));
+}
 
-	// Use string_view to avoid unnecessary string copy
-	std::string word = info[0].As<Napi::String>().Utf8Value();
-	std::string_view word_view(word);
-	trie_.insert(word_view);
+// SearchPacked method - SearchBatch over a packed batch, answered as a bitmap
+Napi::Value Seshat::SearchPacked(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
 
-	return env.Undefined();
+	std::string_view data;
+	size_t count = 0;
+	if (!read_packed(info, data, count))
+		return env.Undefined();
+
+	Napi::Uint8Array bitmap = new_bitmap(env, count);
+	std::uint8_t *bits = bitmap.Data();
+	if (count != 0) {
+		// The views point into the caller's buffer, which stays put until
+		// this call returns.
+		std::vector<std::string_view> words;
+		words.reserve(count);
+		for_each_packed(data, [&](size_t, std::string_view word) {
+			words.push_back(word);
+		});
+		trie_->read([&](const RadixTrie &trie) {
+			trie.search_many(words.data(), words.size(), bits);
+		});
+	}
+	return bitmap;
 }
 
-// Search method - uses string_view to avoid copies
-Napi::Value Seshat::Search(const Napi::CallbackInfo &info) {
+// RemovePacked method - RemoveBatch over a packed batch, answered as a bitmap
+Napi::Value Seshat::RemovePacked(const Napi::CallbackInfo &info) {
 	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
 
-	if (info.Length() < 1 || !info[0].IsString()) {
-		Napi::TypeError::New(env, "String argument expected")
+	std::string_view data;
+	size_t count = 0;
+	if (!read_packed(info, data, count))
+		return env.Undefined();
+
+	Napi::Uint8Array bitmap = new_bitmap(env, count);
+	std::uint8_t *bits = bitmap.Data();
+	try {
+		if (count != 0)
+			trie_->try_write([&](RadixTrie &trie) {
+				for_each_packed(data, [&](size_t i, std::string_view word) {
+					if (trie.remove(word))
+						bits[i / 8] |= std::uint8_t(1u << (i % 8));
+				});
+			});
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to remove batch: ") + e.what())
 			.ThrowAsJavaScriptException();
 		return env.Undefined();
 	}
-
-	// Use string_view to avoid unnecessary string copy
-	std::string word = info[0].As<Napi::String>().Utf8Value();
-	std::string_view word_view(word);
-	bool found = trie_.search(word_view);
-
-	return Napi::Boolean::New(env, found);
+	return bitmap;
 }
 
-// StartsWith method
-Napi::Value Seshat::StartsWith(const Napi::CallbackInfo &info) {
+// WordsWithPrefixPacked method - WordsWithPrefix as one packed result
+Napi::Value Seshat::WordsWithPrefixPacked(const Napi::CallbackInfo &info) {
 	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
 
 	if (info.Length() < 1 || !info[0].IsString()) {
 		Napi::TypeError::New(env, "String argument expected")
@@ -84,15 +1446,37 @@ Napi::Value Seshat::StartsWith(const Napi::CallbackInfo &info) {
 		return env.Undefined();
 	}
 
-	std::string prefix = info[0].As<Napi::String>().Utf8Value();
-	bool hasPrefix = trie_.starts_with(prefix);
+	size_t limit = std::numeric_limits<size_t>::max();
+	size_t offset = 0;
+	if (!read_count(info, 1, limit, "Limit must be a non-negative integer") ||
+		!read_count(info, 2, offset, "Offset must be a non-negative integer"))
+		return env.Undefined();
 
-	return Napi::Boolean::New(env, hasPrefix);
+	std::string prefix = info[0].As<Napi::String>().Utf8Value();
+	try {
+		WordPacker packer;
+		trie_->read([&](const RadixTrie &trie) {
+			RadixTrie::PrefixCursor cursor = trie.prefix_cursor(prefix);
+			cursor.skip(offset);
+			cursor.advance(limit, [&](std::string_view word, std::uint32_t) {
+				packer.add(word);
+			});
+		});
+		return packer.finish(env);
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to get words with prefix: ") +
+								  e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
 }
 
-// WordsWithPrefix method
-Napi::Value Seshat::WordsWithPrefix(const Napi::CallbackInfo &info) {
+// EntriesWithPrefixPacked method - WordsWithPrefixPacked with each word's
+// value alongside
+Napi::Value Seshat::EntriesWithPrefixPacked(const Napi::CallbackInfo &info) {
 	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
 
 	if (info.Length() < 1 || !info[0].IsString()) {
 		Napi::TypeError::New(env, "String argument expected")
@@ -100,21 +1484,37 @@ Napi::Value Seshat::WordsWithPrefix(const Napi::CallbackInfo &info) {
 		return env.Undefined();
 	}
 
-	std::string prefix = info[0].As<Napi::String>().Utf8Value();
-	std::vector<std::string> words = trie_.words_with_prefix(prefix);
+	size_t limit = std::numeric_limits<size_t>::max();
+	size_t offset = 0;
+	if (!read_count(info, 1, limit, "Limit must be a non-negative integer") ||
+		!read_count(info, 2, offset, "Offset must be a non-negative integer"))
+		return env.Undefined();
 
-	// Pre-allocate array for batch string creation
-	Napi::Array result = Napi::Array::New(env, words.size());
-	for (size_t i = 0; i < words.size(); ++i) {
-		result[i] = Napi::String::New(env, words[i].c_str(), words[i].length());
+	std::string prefix = info[0].As<Napi::String>().Utf8Value();
+	try {
+		EntryPacker packer;
+		trie_->read([&](const RadixTrie &trie) {
+			RadixTrie::PrefixCursor cursor = trie.prefix_cursor(prefix);
+			cursor.skip(offset);
+			cursor.advance(limit, [&](std::string_view word, std::uint32_t) {
+				packer.add(word, cursor.value());
+			});
+		});
+		return packer.finish(env);
+	} catch (const std::exception &e) {
+		Napi::Error::New(env,
+						 std::string("Failed to get entries with prefix: ") +
+							 e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
 	}
-
-	return result;
 }
 
-// Remove method
-Napi::Value Seshat::Remove(const Napi::CallbackInfo &info) {
+// LowerBound method - the first word at or after the argument, or undefined
+Napi::Value Seshat::LowerBound(const Napi::CallbackInfo &info) {
 	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
 
 	if (info.Length() < 1 || !info[0].IsString()) {
 		Napi::TypeError::New(env, "String argument expected")
@@ -123,130 +1523,168 @@ Napi::Value Seshat::Remove(const Napi::CallbackInfo &info) {
 	}
 
 	std::string word = info[0].As<Napi::String>().Utf8Value();
-	bool removed = trie_.remove(word);
-
-	return Napi::Boolean::New(env, removed);
+	std::optional<std::string> found = trie_->read(
+		[&](const RadixTrie &trie) { return trie.lower_bound(word); });
+	if (!found)
+		return env.Undefined();
+	return Napi::String::New(env, *found);
 }
 
-// Empty method
-Napi::Value Seshat::Empty(const Napi::CallbackInfo &info) {
+// RangePacked method - the words from `from` up to an optional `to`, with an
+// optional limit and offset, packed like WordsWithPrefixPacked; with values,
+// packed like EntriesWithPrefixPacked
+Napi::Value Seshat::RangePacked(const Napi::CallbackInfo &info) {
 	Napi::Env env = info.Env();
-	bool isEmpty = trie_.empty();
-	return Napi::Boolean::New(env, isEmpty);
-}
+	if (!readable(env))
+		return env.Undefined();
 
-// Size method
-Napi::Value Seshat::Size(const Napi::CallbackInfo &info) {
-	Napi::Env env = info.Env();
-	size_t size = trie_.size();
-	// Use safe conversion for large numbers
-	// Check if size can be safely converted to double (use a reasonable upper
-	// bound)
-	const size_t MAX_SAFE_SIZE =
-		1ULL << 53; // 2^53 is the max safe integer in JavaScript
-	if (size > MAX_SAFE_SIZE) {
-		Napi::TypeError::New(env,
-							 "Size too large to represent as JavaScript number")
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "String argument expected")
 			.ThrowAsJavaScriptException();
 		return env.Undefined();
 	}
-	return Napi::Number::New(env, static_cast<double>(size));
-}
 
-// Clear method
-Napi::Value Seshat::Clear(const Napi::CallbackInfo &info) {
-	Napi::Env env = info.Env();
-	trie_.clear();
-	return env.Undefined();
+	std::optional<std::string> to;
+	size_t limit = std::numeric_limits<size_t>::max();
+	size_t offset = 0;
+	if (!read_bound(info, 1, to) ||
+		!read_count(info, 2, limit, "Limit must be a non-negative integer") ||
+		!read_count(info, 3, offset, "Offset must be a non-negative integer"))
+		return env.Undefined();
+	const bool with_values = read_flag(info, 4);
+
+	std::string from = info[0].As<Napi::String>().Utf8Value();
+	try {
+		WordPacker words;
+		EntryPacker entries;
+		trie_->read([&](const RadixTrie &trie) {
+			RadixTrie::PrefixCursor cursor = trie.range_cursor(from, to);
+			cursor.skip(offset);
+			cursor.advance(limit, [&](std::string_view word, std::uint32_t) {
+				if (with_values)
+					entries.add(word, cursor.value());
+				else
+					words.add(word);
+			});
+		});
+		return with_values ? entries.finish(env) : words.finish(env);
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to get range: ") + e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
 }
 
-// Batch Insert method - reduces N-API overhead
-Napi::Value Seshat::InsertBatch(const Napi::CallbackInfo &info) {
+// Rank method - how many words sort before the argument
+Napi::Value Seshat::Rank(const Napi::CallbackInfo &info) {
 	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
 
-	if (info.Length() < 1 || !info[0].IsArray()) {
-		Napi::TypeError::New(env, "Array argument expected")
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "String argument expected")
 			.ThrowAsJavaScriptException();
 		return env.Undefined();
 	}
 
-	Napi::Array words = info[0].As<Napi::Array>();
-	uint32_t count = 0;
-
-	// Process all words in a single C++ call
-	for (uint32_t i = 0; i < words.Length(); ++i) {
-		if (words.Get(i).IsString()) {
-			std::string word = words.Get(i).As<Napi::String>().Utf8Value();
-			if (!word.empty()) {
-				std::string_view word_view(word);
-				trie_.insert(word_view);
-				count++;
-			}
-		}
+	std::string word = info[0].As<Napi::String>().Utf8Value();
+	try {
+		size_t rank = trie_->read(
+			[&](const RadixTrie &trie) { return trie.rank(word); });
+		return Napi::Number::New(env, static_cast<double>(rank));
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to rank: ") + e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
 	}
-
-	return Napi::Number::New(env, count);
 }
 
-// Batch Search method - returns array of results
-Napi::Value Seshat::SearchBatch(const Napi::CallbackInfo &info) {
+// Select method - the word at a zero-based position in sorted order, or
+// undefined past the end
+Napi::Value Seshat::Select(const Napi::CallbackInfo &info) {
 	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
 
-	if (info.Length() < 1 || !info[0].IsArray()) {
-		Napi::TypeError::New(env, "Array argument expected")
+	if (info.Length() < 1 || !info[0].IsNumber()) {
+		Napi::TypeError::New(env, "Number argument expected")
 			.ThrowAsJavaScriptException();
 		return env.Undefined();
 	}
 
-	Napi::Array words = info[0].As<Napi::Array>();
-	Napi::Array results = Napi::Array::New(env, words.Length());
+	size_t index = 0;
+	if (!read_count(info, 0, index, "Index must be a non-negative integer"))
+		return env.Undefined();
 
-	// Process all searches in a single C++ call
-	for (uint32_t i = 0; i < words.Length(); ++i) {
-		if (words.Get(i).IsString()) {
-			std::string word = words.Get(i).As<Napi::String>().Utf8Value();
-			std::string_view word_view(word);
-			bool found = trie_.search(word_view);
-			results.Set(i, Napi::Boolean::New(env, found));
-		} else {
-			results.Set(i, Napi::Boolean::New(env, false));
-		}
+	try {
+		std::optional<std::string> word = trie_->read(
+			[&](const RadixTrie &trie) { return trie.select(index); });
+		if (!word)
+			return env.Undefined();
+		return Napi::String::New(env, *word);
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to select: ") + e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
 	}
-
-	return results;
 }
 
-// Batch Remove method - returns array of success flags
-Napi::Value Seshat::RemoveBatch(const Napi::CallbackInfo &info) {
+// PatternSearchPacked method - PatternSearch as one packed result
+Napi::Value Seshat::PatternSearchPacked(const Napi::CallbackInfo &info) {
 	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
 
-	if (info.Length() < 1 || !info[0].IsArray()) {
-		Napi::TypeError::New(env, "Array argument expected")
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "Pattern string argument expected")
 			.ThrowAsJavaScriptException();
 		return env.Undefined();
 	}
 
-	Napi::Array words = info[0].As<Napi::Array>();
-	Napi::Array results = Napi::Array::New(env, words.Length());
+	try {
+		std::string pattern = info[0].As<Napi::String>().Utf8Value();
+		WordPacker packer;
+		for (const std::string &word : trie_->read([&](const RadixTrie &trie) {
+				 return trie.pattern_search(pattern);
+			 }))
+			packer.add(word);
+		return packer.finish(env);
+	} catch (const std::exception &e) {
+		Napi::Error::New(
+			env, std::string("Failed to perform pattern search: ") + e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+}
 
-	// Process all removals in a single C++ call
-	for (uint32_t i = 0; i < words.Length(); ++i) {
-		if (words.Get(i).IsString()) {
-			std::string word = words.Get(i).As<Napi::String>().Utf8Value();
-			std::string_view word_view(word);
-			bool removed = trie_.remove(word_view);
-			results.Set(i, Napi::Boolean::New(env, removed));
-		} else {
-			results.Set(i, Napi::Boolean::New(env, false));
-		}
+// SearchFromBuffer method - look up every line of a newline-delimited Buffer,
+// answered as a bitmap
+Napi::Value Seshat::SearchFromBuffer(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsBuffer()) {
+		Napi::TypeError::New(env, "Buffer argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
 	}
 
-	return results;
+	Napi::Buffer<char> buf = info[0].As<Napi::Buffer<char>>();
+	std::vector<std::uint8_t> bits = trie_->read([&](const RadixTrie &trie) {
+		return trie.search_from_buffer(buf.Data(), buf.Length());
+	});
+	Napi::Uint8Array bitmap = Napi::Uint8Array::New(env, bits.size());
+	note_marshalled(bits.size());
+	std::copy(bits.begin(), bits.end(), bitmap.Data());
+	return bitmap;
 }
 
 // InsertFromFile method
 Napi::Value Seshat::InsertFromFile(const Napi::CallbackInfo &info) {
 	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
 
 	// Validate arguments
 	if (info.Length() < 1 || !info[0].IsString()) {
@@ -280,9 +1718,18 @@ Napi::Value Seshat::InsertFromFile(const Napi::CallbackInfo &info) {
 		}
 	}
 
+	BulkLoadOptions options;
+	if (!read_thread_count(info, 2, options.threads))
+		return env.Undefined();
+	options.assume_sorted = read_flag(info, 3);
+	options.scored = read_flag(info, 4);
+	options.valued = read_flag(info, 5);
+
 	try {
-		size_t words_inserted =
-			trie_.bulk_insert_from_file(file_path, buffer_size);
+		// The file may change between reads, so it is read only once.
+		size_t words_inserted = trie_->try_write_once([&](RadixTrie &trie) {
+			return trie.bulk_insert_from_file(file_path, buffer_size, options);
+		});
 		return Napi::Number::New(env, static_cast<double>(words_inserted));
 	} catch (const std::exception &e) {
 		Napi::Error::New(env,
@@ -296,15 +1743,24 @@ Napi::Value Seshat::InsertFromFile(const Napi::CallbackInfo &info) {
 class InsertFromFileWorker : public Napi::AsyncWorker {
   public:
 	InsertFromFileWorker(Seshat *instance, std::string filePath,
-						 size_t bufferSize, Napi::Function &callback)
+						 size_t bufferSize, const BulkLoadOptions &options,
+						 Napi::Function &callback)
 		: Napi::AsyncWorker(callback), instance_(instance),
+		  self_(Napi::Persistent(instance->Value())),
 		  filePath_(std::move(filePath)), bufferSize_(bufferSize),
-		  wordsInserted_(0) {}
+		  options_(options), wordsInserted_(0),
+		  latency_(claim_timed_call()), queued_(Clock::now()) {
+		instance_->writer_ = true;
+	}
 
 	void Execute() override {
 		try {
+			// As in InsertFromFile, the file is read only once.
 			wordsInserted_ =
-				instance_->trie_.bulk_insert_from_file(filePath_, bufferSize_);
+				instance_->trie_->write_once([this](RadixTrie &trie) {
+					return trie.bulk_insert_from_file(filePath_, bufferSize_,
+													  options_);
+				});
 		} catch (const std::exception &e) {
 			SetError(e.what());
 		}
@@ -312,6 +1768,9 @@ class InsertFromFileWorker : public Napi::AsyncWorker {
 
 	void OnOK() override {
 		Napi::HandleScope scope(Env());
+		instance_->writer_ = false;
+		if (latency_)
+			latency_->record(elapsed_ns(queued_));
 		Callback().Call(
 			{Env().Null(),
 			 Napi::Number::New(Env(), static_cast<double>(wordsInserted_))});
@@ -319,24 +1778,36 @@ class InsertFromFileWorker : public Napi::AsyncWorker {
 
 	void OnError(const Napi::Error &e) override {
 		Napi::HandleScope scope(Env());
+		instance_->writer_ = false;
+		if (latency_)
+			latency_->record(elapsed_ns(queued_));
 		Callback().Call({e.Value(), Env().Undefined()});
 	}
 
   private:
 	Seshat *instance_;
+	Napi::ObjectReference self_;
 	std::string filePath_;
 	size_t bufferSize_;
+	BulkLoadOptions options_;
 	size_t wordsInserted_;
+	LatencyHistogram *latency_; // null unless timing was on when queued
+	Clock::time_point queued_;
 };
 
 // InsertFromFileAsync method
 Napi::Value Seshat::InsertFromFileAsync(const Napi::CallbackInfo &info) {
 	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
 
 	if (info.Length() < 2 || !info[0].IsString() ||
 		!info[info.Length() - 1].IsFunction()) {
 		Napi::TypeError::New(env, "Expected (filePath: string, [bufferSize?: "
-								  "number], callback: Function)")
+								  "number], [threads?: number], "
+								  "[assumeSorted?: boolean], [scored?: "
+								  "boolean], [valued?: boolean], callback: "
+								  "Function)")
 			.ThrowAsJavaScriptException();
 		return env.Undefined();
 	}
@@ -347,7 +1818,7 @@ Napi::Value Seshat::InsertFromFileAsync(const Napi::CallbackInfo &info) {
 	size_t buffer_size = 1024 * 1024;
 
 	// If a numeric second arg before callback is provided, treat as bufferSize
-	if (info.Length() == 3 && info[1].IsNumber()) {
+	if (info.Length() >= 3 && info[1].IsNumber()) {
 		double buffer_size_double = info[1].As<Napi::Number>().DoubleValue();
 		if (buffer_size_double <= 0 || buffer_size_double > SIZE_MAX) {
 			Napi::RangeError::New(
@@ -360,9 +1831,158 @@ Napi::Value Seshat::InsertFromFileAsync(const Napi::CallbackInfo &info) {
 			buffer_size = 1024;
 	}
 
-	Napi::Function cb = info[info.Length() - 1].As<Napi::Function>();
-
-	auto *worker = new InsertFromFileWorker(this, file_path, buffer_size, cb);
+	// The thread count and flags sit between bufferSize and the callback
+	BulkLoadOptions options;
+	if (info.Length() >= 4 && !read_thread_count(info, 2, options.threads))
+		return env.Undefined();
+	options.assume_sorted = info.Length() >= 5 && read_flag(info, 3);
+	options.scored = info.Length() >= 6 && read_flag(info, 4);
+	options.valued = info.Length() >= 7 && read_flag(info, 5);
+
+	Napi::Function cb = info[info.Length() - 1].As<Napi::Function>();
+
+	auto *worker =
+		new InsertFromFileWorker(this, file_path, buffer_size, options, cb);
+	worker->Queue();
+	return env.Undefined();
+}
+
+// Feeds a batch of createIngest chunks, or the end of the stream, to the
+// trie on a libuv worker thread. Like InsertFromFileWorker it holds the write
+// lock until it settles, but only for that batch: between batches the trie
+// takes other calls. Each run of whole lines is a write of its own, since a
+// concurrent trie repeats a write on its second copy and the line stream must
+// only see the input once.
+class IngestWorker : public Napi::AsyncWorker {
+  public:
+	IngestWorker(Seshat *instance, IngestHandle ingest, Napi::Array chunks,
+				 bool end, Napi::Function &callback)
+		: Napi::AsyncWorker(callback), instance_(instance),
+		  self_(Napi::Persistent(instance->Value())),
+		  ingestRef_(Napi::Persistent(ingest)), ingest_(ingest.Data()),
+		  end_(end), latency_(claim_timed_call()), queued_(Clock::now()) {
+		if (!chunks.IsEmpty()) {
+			chunksRef_ = Napi::Persistent(chunks);
+			for (uint32_t i = 0; i < chunks.Length(); ++i) {
+				Napi::Buffer<char> chunk = chunks.Get(i).As<Napi::Buffer<char>>();
+				chunks_.emplace_back(chunk.Data(), chunk.Length());
+			}
+		}
+		instance_->writer_ = true;
+	}
+
+	void Execute() override {
+		try {
+			auto insert = [this](std::string_view text) {
+				ingest_->count += instance_->trie_->write([&](RadixTrie &trie) {
+					return trie.bulk_insert_from_buffer(
+						text.data(), text.size(), ingest_->options);
+				});
+			};
+			for (std::string_view chunk : chunks_)
+				ingest_->lines.write(chunk.data(), chunk.size(), insert);
+			if (end_)
+				ingest_->lines.end(insert);
+		} catch (const std::exception &e) {
+			SetError(std::string("Failed to insert from stream: ") + e.what());
+		}
+	}
+
+	void OnOK() override {
+		Napi::HandleScope scope(Env());
+		instance_->writer_ = false;
+		if (latency_)
+			latency_->record(elapsed_ns(queued_));
+		Callback().Call(
+			{Env().Null(),
+			 Napi::Number::New(Env(), static_cast<double>(ingest_->count))});
+	}
+
+	void OnError(const Napi::Error &e) override {
+		Napi::HandleScope scope(Env());
+		instance_->writer_ = false;
+		if (latency_)
+			latency_->record(elapsed_ns(queued_));
+		Callback().Call({e.Value(), Env().Undefined()});
+	}
+
+  private:
+	Seshat *instance_;
+	Napi::ObjectReference self_;
+	Napi::Reference<IngestHandle> ingestRef_;
+	Napi::ObjectReference chunksRef_; // keeps the chunks' memory alive
+	Ingest *ingest_;
+	std::vector<std::string_view> chunks_;
+	bool end_;
+	LatencyHistogram *latency_; // null unless timing was on when queued
+	Clock::time_point queued_;
+};
+
+// CreateIngest method - createIngest(gzip?: boolean, assumeSorted?: boolean,
+// scored?: boolean, valued?: boolean) returns an opaque handle for
+// IngestWrite and IngestEnd. An undefined gzip flag means detect it from the
+// input.
+Napi::Value Seshat::CreateIngest(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	const LineStream::Format format =
+		info.Length() < 1 || !info[0].IsBoolean()
+			? LineStream::Format::Detect
+		: info[0].As<Napi::Boolean>().Value() ? LineStream::Format::Gzip
+											  : LineStream::Format::Plain;
+	BulkLoadOptions options;
+	options.assume_sorted = read_flag(info, 1);
+	options.scored = read_flag(info, 2);
+	options.valued = read_flag(info, 3);
+	return IngestHandle::New(env, new Ingest{LineStream(format), options},
+							 [](Napi::Env, Ingest *ingest) { delete ingest; });
+}
+
+// IngestWrite method - ingestWrite(handle, chunks: Buffer[], callback) inserts
+// every line the chunks complete and calls back with (err, count so far)
+Napi::Value Seshat::IngestWrite(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
+
+	if (info.Length() < 3 || !info[0].IsExternal() || !info[1].IsArray() ||
+		!info[2].IsFunction()) {
+		Napi::TypeError::New(env, "Expected (ingest, chunks: Buffer[], "
+								  "callback: Function)")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+	Napi::Array chunks = info[1].As<Napi::Array>();
+	for (uint32_t i = 0; i < chunks.Length(); ++i) {
+		if (!chunks.Get(i).IsBuffer()) {
+			Napi::TypeError::New(env, "Chunks must be Buffers")
+				.ThrowAsJavaScriptException();
+			return env.Undefined();
+		}
+	}
+
+	Napi::Function cb = info[2].As<Napi::Function>();
+	auto *worker = new IngestWorker(this, info[0].As<IngestHandle>(), chunks,
+									false, cb);
+	worker->Queue();
+	return env.Undefined();
+}
+
+// IngestEnd method - ingestEnd(handle, callback) inserts the last line and
+// calls back with (err, total count)
+Napi::Value Seshat::IngestEnd(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
+
+	if (info.Length() < 2 || !info[0].IsExternal() || !info[1].IsFunction()) {
+		Napi::TypeError::New(env, "Expected (ingest, callback: Function)")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	Napi::Function cb = info[1].As<Napi::Function>();
+	auto *worker = new IngestWorker(this, info[0].As<IngestHandle>(),
+									Napi::Array(), true, cb);
 	worker->Queue();
 	return env.Undefined();
 }
@@ -370,26 +1990,15 @@ Napi::Value Seshat::InsertFromFileAsync(const Napi::CallbackInfo &info) {
 // Get height statistics
 Napi::Value Seshat::GetHeightStats(const Napi::CallbackInfo &info) {
 	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
 
+	const bool all_heights = read_flag(info, 0);
 	try {
-		auto stats = trie_.get_height_stats();
-
-		Napi::Object result = Napi::Object::New(env);
-		result.Set("minHeight", Napi::Number::New(env, stats.min_height));
-		result.Set("maxHeight", Napi::Number::New(env, stats.max_height));
-		result.Set("averageHeight",
-				   Napi::Number::New(env, stats.average_height));
-		result.Set("modeHeight", Napi::Number::New(env, stats.mode_height));
-
-		// Convert heights vector to JS array
-		Napi::Array heights_array =
-			Napi::Array::New(env, stats.all_heights.size());
-		for (size_t i = 0; i < stats.all_heights.size(); ++i) {
-			heights_array[i] = Napi::Number::New(env, stats.all_heights[i]);
-		}
-		result.Set("allHeights", heights_array);
-
-		return result;
+		auto stats = trie_->read([all_heights](const RadixTrie &trie) {
+			return trie.get_height_stats(all_heights);
+		});
+		return height_stats_to_js(env, stats);
 	} catch (const std::exception &e) {
 		Napi::Error::New(env,
 						 std::string("Failed to get height stats: ") + e.what())
@@ -398,12 +2007,30 @@ Napi::Value Seshat::GetHeightStats(const Napi::CallbackInfo &info) {
 	}
 }
 
+// Get height statistics on a worker thread
+Napi::Value Seshat::GetHeightStatsAsync(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	const bool all_heights = read_flag(info, 0);
+	return queue_query<RadixTrie::HeightStats>(
+		this, "Failed to get height stats: ",
+		[all_heights](const RadixTrie &trie) {
+			return trie.get_height_stats(all_heights);
+		},
+		height_stats_to_js);
+}
+
 // Get memory statistics
 Napi::Value Seshat::GetMemoryStats(const Napi::CallbackInfo &info) {
 	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
 
 	try {
-		auto stats = trie_.get_memory_stats();
+		auto stats = trie_->read(
+			[](const RadixTrie &trie) { return trie.get_memory_stats(); });
 
 		Napi::Object result = Napi::Object::New(env);
 		result.Set(
@@ -423,12 +2050,42 @@ Napi::Value Seshat::GetMemoryStats(const Napi::CallbackInfo &info) {
 		result.Set("stringBufferBytes",
 				   Napi::Number::New(
 					   env, static_cast<double>(stats.string_buffer_bytes)));
+		result.Set(
+			"casingBytes",
+			Napi::Number::New(env, static_cast<double>(stats.casing_bytes)));
+		result.Set(
+			"arenaBytes",
+			Napi::Number::New(env, static_cast<double>(stats.arena_bytes)));
+		result.Set("labelPoolBytes",
+				   Napi::Number::New(
+					   env, static_cast<double>(stats.label_pool_bytes)));
+		result.Set("reclaimedBytes",
+				   Napi::Number::New(
+					   env, static_cast<double>(stats.reclaimed_bytes)));
+		result.Set("suffixIndexBytes",
+				   Napi::Number::New(
+					   env, static_cast<double>(stats.suffix_index_bytes)));
+		result.Set("rankIndexBytes",
+				   Napi::Number::New(
+					   env, static_cast<double>(stats.rank_index_bytes)));
 		result.Set(
 			"overheadBytes",
 			Napi::Number::New(env, static_cast<double>(stats.overhead_bytes)));
 		result.Set("bytesPerWord",
 				   Napi::Number::New(env, stats.bytes_per_word));
 
+		Napi::Object kinds = Napi::Object::New(env);
+		for (int k = 0; k < ChildList::kKindCount; ++k) {
+			Napi::Object entry = Napi::Object::New(env);
+			entry.Set("nodes", Napi::Number::New(
+								   env, static_cast<double>(stats.kind_nodes[k])));
+			entry.Set("bytes", Napi::Number::New(
+								   env, static_cast<double>(stats.kind_bytes[k])));
+			kinds.Set(ChildList::kind_name(static_cast<ChildList::Kind>(k)),
+					  entry);
+		}
+		result.Set("childKinds", kinds);
+
 		return result;
 	} catch (const std::exception &e) {
 		Napi::Error::New(env,
@@ -441,30 +2098,13 @@ Napi::Value Seshat::GetMemoryStats(const Napi::CallbackInfo &info) {
 // Get word metrics
 Napi::Value Seshat::GetWordMetrics(const Napi::CallbackInfo &info) {
 	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
 
 	try {
-		auto metrics = trie_.get_word_metrics();
-
-		Napi::Object result = Napi::Object::New(env);
-		result.Set("minLength", Napi::Number::New(env, metrics.min_length));
-		result.Set("maxLength", Napi::Number::New(env, metrics.max_length));
-		result.Set("averageLength",
-				   Napi::Number::New(env, metrics.average_length));
-		result.Set("modeLength", Napi::Number::New(env, metrics.mode_length));
-		result.Set("totalCharacters",
-				   Napi::Number::New(
-					   env, static_cast<double>(metrics.total_characters)));
-
-		// Convert length distribution to JS array
-		Napi::Array dist_array =
-			Napi::Array::New(env, metrics.length_distribution.size());
-		for (size_t i = 0; i < metrics.length_distribution.size(); ++i) {
-			dist_array[i] =
-				Napi::Number::New(env, metrics.length_distribution[i]);
-		}
-		result.Set("lengthDistribution", dist_array);
-
-		return result;
+		auto metrics = trie_->read(
+			[](const RadixTrie &trie) { return trie.get_word_metrics(); });
+		return word_metrics_to_js(env, metrics);
 	} catch (const std::exception &e) {
 		Napi::Error::New(env,
 						 std::string("Failed to get word metrics: ") + e.what())
@@ -473,9 +2113,23 @@ Napi::Value Seshat::GetWordMetrics(const Napi::CallbackInfo &info) {
 	}
 }
 
+// Get word metrics on a worker thread
+Napi::Value Seshat::GetWordMetricsAsync(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	return queue_query<RadixTrie::WordMetrics>(
+		this, "Failed to get word metrics: ",
+		[](const RadixTrie &trie) { return trie.get_word_metrics(); },
+		word_metrics_to_js);
+}
+
 // Pattern search with wildcards
 Napi::Value Seshat::PatternSearch(const Napi::CallbackInfo &info) {
 	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
 
 	if (info.Length() < 1 || !info[0].IsString()) {
 		Napi::TypeError::New(env, "Pattern string argument expected")
@@ -485,16 +2139,9 @@ Napi::Value Seshat::PatternSearch(const Napi::CallbackInfo &info) {
 
 	try {
 		std::string pattern = info[0].As<Napi::String>().Utf8Value();
-		std::vector<std::string> matches = trie_.pattern_search(pattern);
-
-		// Convert results to JS array
-		Napi::Array result = Napi::Array::New(env, matches.size());
-		for (size_t i = 0; i < matches.size(); ++i) {
-			result[i] =
-				Napi::String::New(env, matches[i].c_str(), matches[i].length());
-		}
-
-		return result;
+		std::vector<std::string> matches = trie_->read(
+			[&](const RadixTrie &trie) { return trie.pattern_search(pattern); });
+		return strings_to_js(env, matches);
 	} catch (const std::exception &e) {
 		Napi::Error::New(
 			env, std::string("Failed to perform pattern search: ") + e.what())
@@ -503,9 +2150,32 @@ Napi::Value Seshat::PatternSearch(const Napi::CallbackInfo &info) {
 	}
 }
 
+// Pattern search on a worker thread
+Napi::Value Seshat::PatternSearchAsync(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "Pattern string argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	std::string pattern = info[0].As<Napi::String>().Utf8Value();
+	return queue_query<std::vector<std::string>>(
+		this, "Failed to perform pattern search: ",
+		[pattern](const RadixTrie &trie) {
+			return trie.pattern_search(pattern);
+		},
+		strings_to_js);
+}
+
 // InsertFromBuffer method - bulk insert from a Node.js Buffer
 Napi::Value Seshat::InsertFromBuffer(const Napi::CallbackInfo &info) {
 	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
 
 	if (info.Length() < 1 || !info[0].IsBuffer()) {
 		Napi::TypeError::New(env, "Buffer argument expected")
@@ -517,8 +2187,17 @@ Napi::Value Seshat::InsertFromBuffer(const Napi::CallbackInfo &info) {
 	const char *data = buf.Data();
 	size_t length = buf.Length();
 
+	BulkLoadOptions options;
+	if (!read_thread_count(info, 1, options.threads))
+		return env.Undefined();
+	options.assume_sorted = read_flag(info, 2);
+	options.scored = read_flag(info, 3);
+	options.valued = read_flag(info, 4);
+
 	try {
-		size_t words_inserted = trie_.bulk_insert_from_buffer(data, length);
+		size_t words_inserted = trie_->try_write([&](RadixTrie &trie) {
+			return trie.bulk_insert_from_buffer(data, length, options);
+		});
 		return Napi::Number::New(env, static_cast<double>(words_inserted));
 	} catch (const std::exception &e) {
 		Napi::Error::New(
@@ -531,6 +2210,8 @@ Napi::Value Seshat::InsertFromBuffer(const Napi::CallbackInfo &info) {
 // RemoveFromBuffer method - bulk remove from a Node.js Buffer
 Napi::Value Seshat::RemoveFromBuffer(const Napi::CallbackInfo &info) {
 	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
 
 	if (info.Length() < 1 || !info[0].IsBuffer()) {
 		Napi::TypeError::New(env, "Buffer argument expected")
@@ -543,7 +2224,9 @@ Napi::Value Seshat::RemoveFromBuffer(const Napi::CallbackInfo &info) {
 	size_t length = buf.Length();
 
 	try {
-		size_t words_removed = trie_.bulk_remove_from_buffer(data, length);
+		size_t words_removed = trie_->try_write([&](RadixTrie &trie) {
+			return trie.bulk_remove_from_buffer(data, length);
+		});
 		return Napi::Number::New(env, static_cast<double>(words_removed));
 	} catch (const std::exception &e) {
 		Napi::Error::New(
@@ -553,14 +2236,97 @@ Napi::Value Seshat::RemoveFromBuffer(const Napi::CallbackInfo &info) {
 	}
 }
 
+// The Seshat passed as info[0] for a set operation, or nullptr with an Error
+// pending. Its trie is only read, so an async query on it may be running.
+Seshat *Seshat::Operand(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	Napi::FunctionReference *constructor =
+		env.GetInstanceData<Napi::FunctionReference>();
+	if (info.Length() < 1 || !info[0].IsObject() ||
+		!info[0].As<Napi::Object>().InstanceOf(constructor->Value())) {
+		Napi::TypeError::New(env, "Seshat argument expected")
+			.ThrowAsJavaScriptException();
+		return nullptr;
+	}
+	Seshat *other = Unwrap(info[0].As<Napi::Object>());
+	return other->readable(env) ? other : nullptr;
+}
+
+// Merge, Subtract and Intersect: update this trie from another in one
+// native walk over both, returning the number of words added or removed
+Napi::Value Seshat::Combine(const Napi::CallbackInfo &info,
+							size_t (RadixTrie::*op)(const RadixTrie &),
+							const char *what) {
+	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
+	Seshat *other = Operand(info);
+	if (!other)
+		return env.Undefined();
+
+	try {
+		size_t count = trie_->try_write_from(
+			*other->trie_, [&](RadixTrie &trie, const RadixTrie &source) {
+				return (trie.*op)(source);
+			});
+		return count_to_js(env, count);
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to ") + what + ": " +
+								  e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+}
+
+Napi::Value Seshat::Merge(const Napi::CallbackInfo &info) {
+	return Combine(info, &RadixTrie::merge, "merge");
+}
+
+Napi::Value Seshat::Subtract(const Napi::CallbackInfo &info) {
+	return Combine(info, &RadixTrie::subtract, "subtract");
+}
+
+Napi::Value Seshat::Intersect(const Napi::CallbackInfo &info) {
+	return Combine(info, &RadixTrie::intersect, "intersect");
+}
+
+// Diff method - the words not in another trie, as toBuffer would write them
+Napi::Value Seshat::Diff(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+	Seshat *other = Operand(info);
+	if (!other)
+		return env.Undefined();
+
+	try {
+		const bool with_scores = read_flag(info, 1);
+		std::string diff = trie_->read([&](const RadixTrie &trie) {
+			return other->trie_->read([&](const RadixTrie &source) {
+				return trie.diff(source, with_scores);
+			});
+		});
+		return bytes_to_js(env, diff);
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to diff: ") + e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+}
+
 // ToBuffer method - serialize trie to a newline-delimited Buffer
 Napi::Value Seshat::ToBuffer(const Napi::CallbackInfo &info) {
 	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
 
 	try {
-		std::string serialized = trie_.serialize_to_buffer();
-		return Napi::Buffer<char>::Copy(env, serialized.data(),
-										serialized.size());
+		const bool with_scores = read_flag(info, 0);
+		const bool with_values = read_flag(info, 1);
+		std::string serialized = trie_->read([&](const RadixTrie &trie) {
+			return trie.serialize_to_buffer(with_scores, with_values);
+		});
+		return bytes_to_js(env, serialized);
 	} catch (const std::exception &e) {
 		Napi::Error::New(env,
 						 std::string("Failed to serialize to buffer: ") +
@@ -570,10 +2336,365 @@ Napi::Value Seshat::ToBuffer(const Napi::CallbackInfo &info) {
 	}
 }
 
+// ToBufferAsync method - serialize on a worker thread
+Napi::Value Seshat::ToBufferAsync(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	const bool with_scores = read_flag(info, 0);
+	const bool with_values = read_flag(info, 1);
+	return queue_query<std::string>(
+		this, "Failed to serialize to buffer: ",
+		[with_scores, with_values](const RadixTrie &trie) {
+			return trie.serialize_to_buffer(with_scores, with_values);
+		},
+		bytes_to_js);
+}
+
+// WriteToFile method - write toBuffer's output to a file a chunk at a time
+Napi::Value Seshat::WriteToFile(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "File path string argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	try {
+		std::string path = info[0].As<Napi::String>().Utf8Value();
+		const bool with_scores = read_flag(info, 1);
+		const bool with_values = read_flag(info, 2);
+		size_t written = trie_->read([&](const RadixTrie &trie) {
+			return trie.serialize_to_file(path, with_scores, with_values);
+		});
+		return count_to_js(env, written);
+	} catch (const std::exception &e) {
+		Napi::Error::New(env,
+						 std::string("Failed to write to file: ") + e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+}
+
+// WriteToFileAsync method - WriteToFile on a worker thread
+Napi::Value Seshat::WriteToFileAsync(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "File path string argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	std::string path = info[0].As<Napi::String>().Utf8Value();
+	const bool with_scores = read_flag(info, 1);
+	const bool with_values = read_flag(info, 2);
+	return queue_query<size_t>(
+		this, "Failed to write to file: ",
+		[path, with_scores, with_values](const RadixTrie &trie) {
+			return trie.serialize_to_file(path, with_scores, with_values);
+		},
+		count_to_js);
+}
+
+// ToSnapshot method - serialize the node structure to a binary snapshot Buffer
+Napi::Value Seshat::ToSnapshot(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+
+	try {
+		std::string image = trie_->read(
+			[](const RadixTrie &trie) { return trie.serialize_snapshot(); });
+		note_marshalled(image.size());
+		return Napi::Buffer<char>::Copy(env, image.data(), image.size());
+	} catch (const std::exception &e) {
+		Napi::Error::New(env,
+						 std::string("Failed to serialize snapshot: ") + e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+}
+
+// LoadSnapshot method - replace the contents with a snapshot held in a Buffer.
+// The image is copied, so the Buffer may be released afterwards.
+Napi::Value Seshat::LoadSnapshot(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsBuffer()) {
+		Napi::TypeError::New(env, "Buffer argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	Napi::Buffer<char> buf = info[0].As<Napi::Buffer<char>>();
+
+	try {
+		trie_->try_write([&](RadixTrie &trie) {
+			trie.load_snapshot(buf.Data(), buf.Length());
+		});
+		return env.Undefined();
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to load snapshot: ") + e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+}
+
+// LoadSnapshotFile method - mmap a snapshot file and query it in place
+Napi::Value Seshat::LoadSnapshotFile(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
+
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "File path string argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	std::string file_path = info[0].As<Napi::String>().Utf8Value();
+
+	try {
+		trie_->try_write_once(
+			[&](RadixTrie &trie) { trie.load_snapshot_file(file_path); });
+		return env.Undefined();
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to load snapshot: ") + e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+}
+
+// Freeze method - flatten the trie into its read-optimized layout
+Napi::Value Seshat::Freeze(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
+
+	try {
+		trie_->try_write([](RadixTrie &trie) { trie.freeze(); });
+		return env.Undefined();
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to freeze: ") + e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+}
+
+// Thaw method - rebuild the mutable pointer tree of a frozen trie
+Napi::Value Seshat::Thaw(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
+	try {
+		trie_->try_write([](RadixTrie &trie) { trie.thaw(); });
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to thaw: ") + e.what())
+			.ThrowAsJavaScriptException();
+	}
+	return env.Undefined();
+}
+
+// Compact method - rebuild the pointer tree tightly; returns bytes given back
+Napi::Value Seshat::Compact(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!writable(env))
+		return env.Undefined();
+	try {
+		size_t reclaimed =
+			trie_->try_write([](RadixTrie &trie) { return trie.compact(); });
+		return count_to_js(env, reclaimed);
+	} catch (const std::exception &e) {
+		Napi::Error::New(env, std::string("Failed to compact: ") + e.what())
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+}
+
+// IsFrozen method
+Napi::Value Seshat::IsFrozen(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (!readable(env))
+		return env.Undefined();
+	return Napi::Boolean::New(env, trie_->read([](const RadixTrie &trie) {
+								  return trie.is_frozen();
+							  }));
+}
+
+// Share method - publish this trie under a name for other worker threads to
+// attach. Only a concurrent trie can be shared, since the busy lock cannot
+// see calls made from other isolates.
+Napi::Value Seshat::Share(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "Name string argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+	if (!trie_->concurrent()) {
+		Napi::Error::New(env, "Only a concurrent trie can be shared")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	std::string name = info[0].As<Napi::String>().Utf8Value();
+	SharedTries &tries = shared_tries();
+	const std::lock_guard<std::mutex> lock(tries.mutex);
+	std::weak_ptr<ConcurrentTrie> &entry = tries.byName[name];
+	const std::shared_ptr<ConcurrentTrie> current = entry.lock();
+	if (current && current != trie_) {
+		Napi::Error::New(env, "A trie is already shared as \"" + name + "\"")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+	entry = trie_;
+	return env.Undefined();
+}
+
+// IgnoresCase method - whether the trie folds case (an attached trie keeps
+// the setting it was created with)
+Napi::Value Seshat::IgnoresCase(const Napi::CallbackInfo &info) {
+	return Napi::Boolean::New(info.Env(),
+							  trie_->read([](const RadixTrie &trie) {
+								  return trie.folds_case();
+							  }));
+}
+
+// Seshat.attach(name) - a new Seshat in this isolate over the trie shared
+// under `name`
+Napi::Value Seshat::Attach(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "Name string argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	std::string name = info[0].As<Napi::String>().Utf8Value();
+	std::shared_ptr<ConcurrentTrie> trie;
+	{
+		SharedTries &tries = shared_tries();
+		const std::lock_guard<std::mutex> lock(tries.mutex);
+		auto it = tries.byName.find(name);
+		if (it != tries.byName.end()) {
+			trie = it->second.lock();
+			if (!trie)
+				tries.byName.erase(it);
+		}
+	}
+	if (!trie) {
+		Napi::Error::New(env, "No trie is shared as \"" + name + "\"")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	Napi::FunctionReference *constructor =
+		env.GetInstanceData<Napi::FunctionReference>();
+	return constructor->New({TrieHandle::New(env, &trie)});
+}
+
+// Seshat.unshare(name) - withdraw a name; tries already attached keep working.
+// Returns whether the name was in use.
+Napi::Value Seshat::Unshare(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (info.Length() < 1 || !info[0].IsString()) {
+		Napi::TypeError::New(env, "Name string argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+
+	std::string name = info[0].As<Napi::String>().Utf8Value();
+	SharedTries &tries = shared_tries();
+	const std::lock_guard<std::mutex> lock(tries.mutex);
+	auto it = tries.byName.find(name);
+	const bool live = it != tries.byName.end() && !it->second.expired();
+	if (it != tries.byName.end())
+		tries.byName.erase(it);
+	return Napi::Boolean::New(env, live);
+}
+
 // Module initialization
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
 	return Seshat::Init(env, exports);
 }
 
 // Register the module
-NODE_API_MODULE(seshat, Init)
\ No newline at end of file
+NODE_API_MODULE(seshat, Init)
+
+// GetPerfCounters static method - the hot-path counters (when compiled in),
+// the result bytes handed to JS and each method's latency histogram
+Napi::Value Seshat::GetPerfCounters(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	Napi::Object result = Napi::Object::New(env);
+	result.Set("enabled", Napi::Boolean::New(
+							  env, perf_enabled.load(std::memory_order_relaxed)));
+	result.Set("countersCompiled",
+			   Napi::Boolean::New(env, kPerfCountersCompiled));
+
+	const PerfCounters counters = perf_counters_total();
+#define SESHAT_PERF_FIELD(field, name)                                         \
+	result.Set(name, Napi::Number::New(env, static_cast<double>(counters.field)));
+	SESHAT_PERF_COUNTER_FIELDS(SESHAT_PERF_FIELD)
+#undef SESHAT_PERF_FIELD
+	result.Set("bytesMarshalled",
+			   Napi::Number::New(env, static_cast<double>(bytes_marshalled.load(
+										  std::memory_order_relaxed))));
+
+	// Only the methods that have recorded a call
+	Napi::Object methods = Napi::Object::New(env);
+	MethodLatencies &latencies = method_latencies();
+	const std::lock_guard<std::mutex> lock(latencies.mutex);
+	for (const auto &[name, histogram] : latencies.byName) {
+		const LatencyHistogram::Summary s = histogram->summarize();
+		if (s.count == 0)
+			continue;
+		Napi::Object entry = Napi::Object::New(env);
+		entry.Set("count", Napi::Number::New(env, static_cast<double>(s.count)));
+		entry.Set("totalNs",
+				  Napi::Number::New(env, static_cast<double>(s.total_ns)));
+		entry.Set("minNs", Napi::Number::New(env, static_cast<double>(s.min_ns)));
+		entry.Set("maxNs", Napi::Number::New(env, static_cast<double>(s.max_ns)));
+		entry.Set("p50Ns", Napi::Number::New(env, static_cast<double>(s.p50_ns)));
+		entry.Set("p90Ns", Napi::Number::New(env, static_cast<double>(s.p90_ns)));
+		entry.Set("p99Ns", Napi::Number::New(env, static_cast<double>(s.p99_ns)));
+		entry.Set("p999Ns",
+				  Napi::Number::New(env, static_cast<double>(s.p999_ns)));
+		methods.Set(name, entry);
+	}
+	result.Set("methods", methods);
+	return result;
+}
+
+// SetPerfCounters static method - turns method timing and the marshalled
+// byte count on or off, process-wide
+Napi::Value Seshat::SetPerfCounters(const Napi::CallbackInfo &info) {
+	Napi::Env env = info.Env();
+	if (info.Length() < 1 || !info[0].IsBoolean()) {
+		Napi::TypeError::New(env, "Boolean argument expected")
+			.ThrowAsJavaScriptException();
+		return env.Undefined();
+	}
+	perf_enabled.store(info[0].As<Napi::Boolean>().Value(),
+					   std::memory_order_relaxed);
+	return env.Undefined();
+}
+
+// ResetPerfCounters static method - starts every count and histogram over
+Napi::Value Seshat::ResetPerfCounters(const Napi::CallbackInfo &info) {
+	perf_counters_reset();
+	bytes_marshalled.store(0, std::memory_order_relaxed);
+	MethodLatencies &latencies = method_latencies();
+	const std::lock_guard<std::mutex> lock(latencies.mutex);
+	for (const auto &entry : latencies.byName)
+		entry.second->reset();
+	return info.Env().Undefined();
+}
\ No newline at end of file
@@ -1,7 +1,11 @@
 #pragma once
-#include "RadixTrie.h"
+#include "ConcurrentTrie.h"
+#include <memory>
 #include <napi.h>
 
+template <typename Result> class QueryWorker;
+class LatencyHistogram;
+
 class Seshat : public Napi::ObjectWrap<Seshat> {
   public:
 	static Napi::Object Init(Napi::Env env, Napi::Object exports);
@@ -9,11 +13,54 @@ class Seshat : public Napi::ObjectWrap<Seshat> {
 	~Seshat() = default;
 
   private:
-	static Napi::FunctionReference constructor;
-	RadixTrie trie_;
+	// Every access goes through trie_->read() or trie_->write(). A shared
+	// trie (see Share) is held by one Seshat per isolate that attached it.
+	std::shared_ptr<ConcurrentTrie> trie_;
+
+	// A reader/writer lock over trie_, owned by the JS thread. Async workers
+	// take it when they are queued and release it when they settle, and both
+	// happen on the JS thread, so plain counters suffice; a synchronous method
+	// holds it only for its own call. No caller ever waits on it: a request
+	// that conflicts with a running async operation throws instead of
+	// blocking the event loop. A concurrent trie needs it only to keep writes
+	// apart: reads go ahead during an async insert, and writes during async
+	// queries that have not started yet. Once one is running, a synchronous
+	// write fails in ConcurrentTrie::try_write rather than wait for it, which
+	// also covers other isolates' queries on a shared trie. The lock is per
+	// object, so it cannot see those; sharing is limited to concurrent tries
+	// for that reason.
+	size_t readers_ = 0;
+	bool writer_ = false;
+
+	// Return false, with an Error pending, if an async operation holds the
+	// lock in a conflicting mode.
+	bool readable(Napi::Env env);
+	bool writable(Napi::Env env);
 
-	// Allow async worker to access trie_
+	// Allow async workers to access trie_ and the lock
 	friend class InsertFromFileWorker;
+	friend class IngestWorker;
+	template <typename Result> friend class QueryWorker;
+
+	// Every instance method is exported through TimedMethod, which records
+	// its calls into a latency histogram named after it while perf counters
+	// are on (see SetPerfCounters); an async method is timed until it
+	// settles.
+	using Method = Napi::Value (Seshat::*)(const Napi::CallbackInfo &);
+	template <Method M> static inline LatencyHistogram *latency_ = nullptr;
+	template <Method M> static PropertyDescriptor TimedMethod(const char *name);
+	template <Method M> Napi::Value Timed(const Napi::CallbackInfo &info);
+
+	// Process-wide performance counters and method latencies
+	static Napi::Value GetPerfCounters(const Napi::CallbackInfo &info);
+	static Napi::Value SetPerfCounters(const Napi::CallbackInfo &info);
+	static Napi::Value ResetPerfCounters(const Napi::CallbackInfo &info);
+
+	// Sharing one trie between worker threads, by name
+	Napi::Value Share(const Napi::CallbackInfo &info);
+	Napi::Value IgnoresCase(const Napi::CallbackInfo &info);
+	static Napi::Value Attach(const Napi::CallbackInfo &info);
+	static Napi::Value Unshare(const Napi::CallbackInfo &info);
 
 	// Methods exposed to JavaScript
 	Napi::Value Insert(const Napi::CallbackInfo &info);
@@ -23,21 +70,76 @@ class Seshat : public Napi::ObjectWrap<Seshat> {
 			&info); // this is primarily used for benchmarking and testing
 	Napi::Value InsertFromFileAsync(const Napi::CallbackInfo &info);
 	Napi::Value InsertFromBuffer(const Napi::CallbackInfo &info);
+	// Incremental ingest of a stream of chunks, for createIngest()
+	Napi::Value CreateIngest(const Napi::CallbackInfo &info);
+	Napi::Value IngestWrite(const Napi::CallbackInfo &info);
+	Napi::Value IngestEnd(const Napi::CallbackInfo &info);
 	Napi::Value ToBuffer(const Napi::CallbackInfo &info);
+	Napi::Value ToBufferAsync(const Napi::CallbackInfo &info);
+	Napi::Value WriteToFile(const Napi::CallbackInfo &info);
+	Napi::Value WriteToFileAsync(const Napi::CallbackInfo &info);
+	Napi::Value ToSnapshot(const Napi::CallbackInfo &info);
+	Napi::Value LoadSnapshot(const Napi::CallbackInfo &info);
+	Napi::Value LoadSnapshotFile(const Napi::CallbackInfo &info);
+	Napi::Value Freeze(const Napi::CallbackInfo &info);
+	Napi::Value Thaw(const Napi::CallbackInfo &info);
+	Napi::Value Compact(const Napi::CallbackInfo &info);
+	Napi::Value IsFrozen(const Napi::CallbackInfo &info);
 	Napi::Value Search(const Napi::CallbackInfo &info);
 	Napi::Value SearchBatch(const Napi::CallbackInfo &info);
 	Napi::Value StartsWith(const Napi::CallbackInfo &info);
+	Napi::Value EndsWith(const Napi::CallbackInfo &info);
 	Napi::Value WordsWithPrefix(const Napi::CallbackInfo &info);
+	Napi::Value WordsWithSuffix(const Napi::CallbackInfo &info);
+	Napi::Value WordsWithPrefixAsync(const Napi::CallbackInfo &info);
+	Napi::Value PrefixCursor(const Napi::CallbackInfo &info);
+	Napi::Value RangeCursor(const Napi::CallbackInfo &info);
+	Napi::Value CursorNext(const Napi::CallbackInfo &info);
+	Napi::Value CursorChunk(const Napi::CallbackInfo &info);
+	Napi::Value TopK(const Napi::CallbackInfo &info);
+	Napi::Value FuzzySearch(const Napi::CallbackInfo &info);
+	Napi::Value GetScore(const Napi::CallbackInfo &info);
+	// Words as keys of a map to 64-bit values (see RadixTrie::put)
+	Napi::Value Put(const Napi::CallbackInfo &info);
+	Napi::Value Get(const Napi::CallbackInfo &info);
 	Napi::Value Remove(const Napi::CallbackInfo &info);
 	Napi::Value RemoveBatch(const Napi::CallbackInfo &info);
 	Napi::Value RemoveFromBuffer(const Napi::CallbackInfo &info);
+
+	// Set operations with another Seshat's trie (see RadixTrie::merge)
+	Seshat *Operand(const Napi::CallbackInfo &info);
+	Napi::Value Combine(const Napi::CallbackInfo &info,
+						size_t (RadixTrie::*op)(const RadixTrie &),
+						const char *what);
+	Napi::Value Merge(const Napi::CallbackInfo &info);
+	Napi::Value Subtract(const Napi::CallbackInfo &info);
+	Napi::Value Intersect(const Napi::CallbackInfo &info);
+	Napi::Value Diff(const Napi::CallbackInfo &info);
+
+	// Batch transports that move a whole batch as one Buffer each way
+	Napi::Value InsertPacked(const Napi::CallbackInfo &info);
+	Napi::Value SearchPacked(const Napi::CallbackInfo &info);
+	Napi::Value RemovePacked(const Napi::CallbackInfo &info);
+	Napi::Value WordsWithPrefixPacked(const Napi::CallbackInfo &info);
+	Napi::Value EntriesWithPrefixPacked(const Napi::CallbackInfo &info);
+
+	// Ordered queries over the trie's byte order (see RadixTrie::rank)
+	Napi::Value LowerBound(const Napi::CallbackInfo &info);
+	Napi::Value RangePacked(const Napi::CallbackInfo &info);
+	Napi::Value Rank(const Napi::CallbackInfo &info);
+	Napi::Value Select(const Napi::CallbackInfo &info);
+	Napi::Value PatternSearchPacked(const Napi::CallbackInfo &info);
+	Napi::Value SearchFromBuffer(const Napi::CallbackInfo &info);
 	Napi::Value Empty(const Napi::CallbackInfo &info);
 	Napi::Value Size(const Napi::CallbackInfo &info);
 	Napi::Value Clear(const Napi::CallbackInfo &info);
 
 	// analytics methods
 	Napi::Value GetHeightStats(const Napi::CallbackInfo &info);
+	Napi::Value GetHeightStatsAsync(const Napi::CallbackInfo &info);
 	Napi::Value GetMemoryStats(const Napi::CallbackInfo &info);
 	Napi::Value GetWordMetrics(const Napi::CallbackInfo &info);
+	Napi::Value GetWordMetricsAsync(const Napi::CallbackInfo &info);
 	Napi::Value PatternSearch(const Napi::CallbackInfo &info);
+	Napi::Value PatternSearchAsync(const Napi::CallbackInfo &info);
 };
\ No newline at end of file
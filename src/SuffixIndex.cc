@@ -0,0 +1,78 @@
+#include "SuffixIndex.h"
+#include <algorithm>
+#include <iterator>
+
+void TrigramIndex::clear() {
+	text_.clear();
+	starts_.assign(1, 0);
+	postings_.clear();
+}
+
+void TrigramIndex::add(std::string_view word) {
+	const auto index = static_cast<std::uint32_t>(starts_.size() - 1);
+	text_.append(word);
+	starts_.push_back(text_.size());
+	if (word.size() < 3)
+		return;
+
+	// A trigram repeated within the word is posted once.
+	scratch_.clear();
+	for (size_t i = 0; i + 3 <= word.size(); ++i)
+		scratch_.push_back(gram(word.data() + i));
+	std::sort(scratch_.begin(), scratch_.end());
+	scratch_.erase(std::unique(scratch_.begin(), scratch_.end()),
+				   scratch_.end());
+	for (std::uint32_t g : scratch_)
+		postings_[g].push_back(index);
+}
+
+// Shortest posting list first, so each intersection is at most as long as
+// it and the result shrinks from the start.
+std::vector<std::string_view>
+TrigramIndex::candidates(const std::vector<std::string_view> &literals) const {
+	std::vector<std::uint32_t> grams;
+	for (std::string_view literal : literals) {
+		for (size_t i = 0; i + 3 <= literal.size(); ++i)
+			grams.push_back(gram(literal.data() + i));
+	}
+	if (grams.empty())
+		return {};
+	std::sort(grams.begin(), grams.end());
+	grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+
+	std::vector<const std::vector<std::uint32_t> *> lists;
+	for (std::uint32_t g : grams) {
+		const auto it = postings_.find(g);
+		if (it == postings_.end())
+			return {};
+		lists.push_back(&it->second);
+	}
+	std::sort(lists.begin(), lists.end(),
+			  [](const auto *a, const auto *b) { return a->size() < b->size(); });
+
+	std::vector<std::uint32_t> words = *lists.front();
+	std::vector<std::uint32_t> kept;
+	for (size_t i = 1; i < lists.size() && !words.empty(); ++i) {
+		kept.clear();
+		std::set_intersection(words.begin(), words.end(), lists[i]->begin(),
+							  lists[i]->end(), std::back_inserter(kept));
+		words.swap(kept);
+	}
+
+	std::vector<std::string_view> out;
+	out.reserve(words.size());
+	for (std::uint32_t i : words)
+		out.push_back(word(i));
+	return out;
+}
+
+size_t TrigramIndex::heap_bytes() const noexcept {
+	size_t bytes = text_.capacity() + starts_.capacity() * sizeof(size_t) +
+				   postings_.bucket_count() * sizeof(void *);
+	for (const auto &[g, list] : postings_) {
+		// Each entry is a heap node holding the key, the list and a link.
+		bytes += sizeof(void *) + sizeof(g) + sizeof(list) +
+				 list.capacity() * sizeof(std::uint32_t);
+	}
+	return bytes;
+}
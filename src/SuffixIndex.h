@@ -0,0 +1,70 @@
+#pragma once
+#include "RadixTrie.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Words by the 3-byte substrings (trigrams) they contain. Every word that
+// contains a literal of three or more bytes contains each of its trigrams, so
+// intersecting their posting lists leaves a small candidate set to check
+// against the full pattern, where otherwise every word would be.
+//
+// Words are numbered in the order they are added, which RadixTrie keeps
+// lexicographic, so candidates come out sorted. Words of under three bytes
+// have no trigrams and are never candidates, which is right: no literal the
+// index is asked about fits in them.
+class TrigramIndex {
+  public:
+	void clear();
+	void add(std::string_view word);
+	// The words holding every trigram of `literals` (each at least three
+	// bytes long), in the order they were added: a superset of the words
+	// that contain all of them.
+	std::vector<std::string_view>
+	candidates(const std::vector<std::string_view> &literals) const;
+	// Heap bytes of the words and posting lists.
+	size_t heap_bytes() const noexcept;
+
+  private:
+	static std::uint32_t gram(const char *p) noexcept {
+		return static_cast<std::uint32_t>(static_cast<unsigned char>(p[0])) |
+			   static_cast<std::uint32_t>(static_cast<unsigned char>(p[1]))
+				   << 8 |
+			   static_cast<std::uint32_t>(static_cast<unsigned char>(p[2]))
+				   << 16;
+	}
+	std::string_view word(std::uint32_t i) const noexcept {
+		return std::string_view(text_).substr(starts_[i],
+											  starts_[i + 1] - starts_[i]);
+	}
+
+	std::string text_;				  // every word, back to back
+	std::vector<size_t> starts_{0};	  // word i is [starts_[i], starts_[i+1])
+	std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> postings_;
+	std::vector<std::uint32_t> scratch_; // one word's distinct trigrams
+};
+
+// The side indexes of a trie created with a suffix index (see
+// RadixTrie::enable_suffix_index): the trie's words reversed, in a trie of
+// their own, which turns a suffix into a prefix, and a trigram index for
+// literals in the middle of a pattern. Both hold folded words.
+//
+// Single inserts and removals keep the reversed trie in step as they go.
+// Changes that touch many words at once (a parallel bulk load, a set
+// operation, a snapshot load) only mark it stale, and the next query that
+// needs it rebuilds it in one sorted pass, which costs no more than following
+// each word would have. The trigram index is rebuilt the same way after any
+// change to the words, so it suits tries that are read far more often than
+// written. Rebuilds happen inside const queries, possibly from several
+// readers at once, and are serialised by `mutex`.
+struct SuffixIndex {
+	mutable std::mutex mutex;
+	mutable RadixTrie reversed;
+	mutable bool reversed_current = true;
+	mutable TrigramIndex grams;
+	mutable bool grams_current = false;
+};
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct ScoredWord {
+	std::string word;
+	std::uint32_t score;
+};
+
+// Best-first search for the `k` highest-scoring words in the subtree below
+// `start`, where `path` is the text of every edge from the root through
+// `start`. Ties are broken by lexicographic byte order, so the result is
+// exactly the first k words of the subtree sorted by (score desc, word asc).
+//
+// The frontier is a priority queue of subtrees keyed by their cached maximum
+// score, mixed with finished words keyed by their own score. Whatever pops
+// first can be beaten by nothing left in the queue, so the search stops after
+// the k-th word and never expands a subtree whose maximum is below it. A
+// subtree's path sorts before every word in it, which is what makes the
+// lexicographic tie-break come out right when a word and a subtree tie.
+//
+// Tree supplies the node type and its accessors, where word() gives the
+// spelling to report for the word ending at a node whose path is `path`:
+//
+//   using Node = ...;
+//   std::string_view label(Node) const;
+//   bool is_end(Node) const;
+//   std::uint32_t score(Node) const;
+//   std::uint32_t max_score(Node) const;
+//   std::string_view word(Node, std::string_view path) const;
+//   template <typename F> void for_each_child(Node, F &&) const;
+template <typename Tree>
+std::vector<ScoredWord> best_first_top_k(const Tree &tree,
+										 typename Tree::Node start,
+										 std::string path, size_t k) {
+	// Paths live in one side vector that only grows, so queue entries stay
+	// small and are never mutated in place.
+	std::vector<std::string> paths;
+	struct Entry {
+		std::uint32_t priority;
+		bool is_word;
+		typename Tree::Node node;
+		size_t path;
+	};
+	// std::priority_queue pops the greatest element, so "less" means popped
+	// later: lower score, then greater path, then a subtree after the word
+	// that starts it.
+	auto later = [&paths](const Entry &a, const Entry &b) {
+		if (a.priority != b.priority)
+			return a.priority < b.priority;
+		const int order = paths[a.path].compare(paths[b.path]);
+		if (order != 0)
+			return order > 0;
+		return !a.is_word && b.is_word;
+	};
+	std::priority_queue<Entry, std::vector<Entry>, decltype(later)> frontier(
+		later);
+
+	std::vector<ScoredWord> result;
+	if (k == 0)
+		return result;
+	paths.push_back(std::move(path));
+	frontier.push({tree.max_score(start), false, start, 0});
+
+	while (!frontier.empty() && result.size() < k) {
+		const Entry entry = frontier.top();
+		frontier.pop();
+
+		if (entry.is_word) {
+			result.push_back(
+				{std::string(tree.word(entry.node, paths[entry.path])),
+				 entry.priority});
+			continue;
+		}
+
+		tree.for_each_child(entry.node, [&](typename Tree::Node child) {
+			std::string_view label = tree.label(child);
+			std::string child_path;
+			child_path.reserve(paths[entry.path].size() + label.size());
+			child_path.append(paths[entry.path]).append(label);
+			paths.push_back(std::move(child_path));
+			frontier.push(
+				{tree.max_score(child), false, child, paths.size() - 1});
+		});
+		if (tree.is_end(entry.node))
+			frontier.push(
+				{tree.score(entry.node), true, entry.node, entry.path});
+	}
+	return result;
+}
@@ -2,6 +2,7 @@ import { Seshat } from "../lib/index";
 import fs from "fs";
 import os from "os";
 import { Readable } from "stream";
+import zlib from "zlib";
 
 describe("Seshat", () => {
 	let trie: Seshat;
@@ -201,6 +202,37 @@ describe("Seshat", () => {
 			expect(() => trie.getWordsWithPrefix(null as any)).toThrow("Prefix must be a string");
 			expect(() => trie.getWordsWithPrefix(123 as any)).toThrow("Prefix must be a string");
 		});
+
+		test("should page through words with limit and offset", () => {
+			expect(trie.getWordsWithPrefix("", { limit: 2 })).toEqual(["hello", "help"]);
+			expect(trie.getWordsWithPrefix("", { limit: 2, offset: 2 })).toEqual(["test", "world"]);
+			expect(trie.getWordsWithPrefix("he", { offset: 1 })).toEqual(["help"]);
+			expect(trie.getWordsWithPrefix("he", { limit: 0 })).toEqual([]);
+			expect(trie.getWordsWithPrefix("he", { offset: 5 })).toEqual([]);
+			expect(trie.getWordsWithPrefix("", { limit: Infinity })).toHaveLength(4);
+		});
+
+		test("should reject invalid limit and offset", () => {
+			expect(() => trie.getWordsWithPrefix("he", { limit: -1 })).toThrow(RangeError);
+			expect(() => trie.getWordsWithPrefix("he", { limit: 1.5 })).toThrow("Limit must be a non-negative integer");
+			expect(() => trie.getWordsWithPrefix("he", { offset: "1" as any })).toThrow("Offset must be a non-negative integer");
+		});
+
+		test("should iterate words with a prefix in batches", () => {
+			expect([...trie.iterPrefix("he")]).toEqual(["hello", "help"]);
+			expect([...trie.iterPrefix("", 1)]).toEqual(trie.getWordsWithPrefix(""));
+			expect([...trie.iterPrefix("", 4)]).toEqual(trie.getWordsWithPrefix(""));
+			expect([...trie.iterPrefix("xyz")]).toEqual([]);
+			expect(() => trie.iterPrefix(123 as any).next()).toThrow("Prefix must be a string");
+			expect(() => trie.iterPrefix("he", 0).next()).toThrow(RangeError);
+		});
+
+		test("should stop iterating once the trie is modified", () => {
+			const iter = trie.iterPrefix("", 1);
+			expect(iter.next().value).toBe("hello");
+			trie.insert("zebra");
+			expect(() => iter.next()).toThrow("Trie was modified during iteration");
+		});
 	});
 
 	describe("Remove Operations", () => {
@@ -262,7 +294,8 @@ describe("Seshat", () => {
 			expect(stats.minHeight).toBeGreaterThanOrEqual(1);
 			expect(stats.maxHeight).toBeGreaterThanOrEqual(stats.minHeight);
 			expect(stats.averageHeight).toBeGreaterThanOrEqual(stats.minHeight);
-			expect(Array.isArray(stats.allHeights)).toBe(true);
+			expect(stats.allHeights).toBeUndefined();
+			expect(Array.isArray(trie.getHeightStats({ allHeights: true }).allHeights)).toBe(true);
 		});
 
 		test("should get memory statistics", () => {
@@ -273,6 +306,130 @@ describe("Seshat", () => {
 			expect(mem.bytesPerWord).toBeGreaterThan(0);
 		});
 
+		test("should break memory down by child list kind", () => {
+			const mem = trie.getMemoryStats();
+			const kinds = Object.values(mem.childKinds);
+			expect(kinds.reduce((sum, k) => sum + k.nodes, 0)).toBe(mem.nodeCount);
+			expect(kinds.reduce((sum, k) => sum + k.bytes, 0)).toBe(mem.childBufferBytes);
+			expect(mem.childKinds.leaf.nodes).toBe(3);
+			expect(mem.childKinds.node4.nodes).toBe(1);
+		});
+
+		test("should grow and shrink wide nodes between kinds", () => {
+			const words: string[] = [];
+			for (let c = 33; c < 127; c++) words.push("x" + String.fromCharCode(c));
+			trie.insertBatch(words);
+			expect(trie.getMemoryStats().childKinds.node256.nodes).toBe(1);
+			expect(trie.getWordsWithPrefix("x")).toEqual([...words].sort());
+
+			trie.removeBatch(words.slice(10));
+			const kinds = trie.getMemoryStats().childKinds;
+			expect(kinds.node256.nodes).toBe(0);
+			expect(kinds.node48.nodes).toBe(0);
+			expect(kinds.node16.nodes).toBe(1);
+			expect(trie.getWordsWithPrefix("x")).toEqual(words.slice(0, 10));
+			words.slice(0, 10).forEach(word => expect(trie.search(word)).toBe(true));
+		});
+
+		test("should keep analytics in step with inserts, splits and removals", () => {
+			const expectConsistent = () => {
+				const words = trie.getWordsWithPrefix("");
+				const lengths = words.map(word => Buffer.byteLength(word));
+				const metrics = trie.getWordMetrics();
+				expect(metrics.totalCharacters).toBe(lengths.reduce((sum, n) => sum + n, 0));
+				expect(metrics.minLength).toBe(Math.min(...lengths));
+				expect(metrics.maxLength).toBe(Math.max(...lengths));
+				expect(metrics.lengthDistribution.reduce((sum, n) => sum + n, 0)).toBe(words.length);
+
+				const { allHeights, ...heights } = trie.getHeightStats({ allHeights: true });
+				expect(allHeights).toHaveLength(words.length);
+				expect(heights.minHeight).toBe(Math.min(...allHeights!));
+				expect(heights.maxHeight).toBe(Math.max(...allHeights!));
+				expect(heights.averageHeight).toBeCloseTo(allHeights!.reduce((sum, n) => sum + n, 0) / words.length);
+
+				const mem = trie.getMemoryStats();
+				expect(Object.values(mem.childKinds).reduce((sum, k) => sum + k.nodes, 0)).toBe(mem.nodeCount);
+			};
+
+			trie.insertBatch(["romane", "romanus", "romulus", "rubens", "ruber", "rubicon", "rubicundus"]);
+			expectConsistent();
+			trie.insert("rom");
+			trie.insert("r");
+			expectConsistent();
+			trie.removeBatch(["romulus", "rubicon", "hello"]);
+			expectConsistent();
+			trie.freeze();
+			expectConsistent();
+			trie.insert("rubber");
+			expectConsistent();
+		});
+
+		test("should hand the arena back on clear", () => {
+			const long = "k".repeat(10000);
+			const words = Array.from({ length: 20000 }, (_, i) => `word${i}`);
+			trie.insertBatch([...words, long, long + "s"]);
+			const loaded = trie.getMemoryStats().arenaBytes;
+			expect(loaded).toBeGreaterThan(0);
+			expect(trie.remove(long)).toBe(true);
+			expect(trie.search(long + "s")).toBe(true);
+
+			trie.clear();
+			expect(trie.getMemoryStats().arenaBytes).toBeLessThan(loaded);
+			trie.insertBatch(words);
+			expect(trie.size()).toBe(words.length);
+			expect(trie.getWordsWithPrefix("word1999")).toEqual(["word1999"]);
+		});
+
+		test("should keep long edge labels in the label pool across splits", () => {
+			const base = "https://example.com/a/very/long/path/";
+			const urls = [base, base + "index.html", base + "images/logo.png", "https://example.com/about"];
+			trie.insertBatch(urls);
+			const mem = trie.getMemoryStats();
+			expect(mem.stringBufferBytes).toBeGreaterThan(0);
+			expect(mem.labelPoolBytes).toBeGreaterThanOrEqual(mem.stringBufferBytes);
+			expect(trie.getWordsWithPrefix("https://")).toEqual([...urls].sort());
+
+			expect(trie.remove(base + "images/logo.png")).toBe(true);
+			expect(trie.getWordsWithPrefix(base)).toEqual([base, base + "index.html"]);
+		});
+
+		test("should fold a single child back into its parent on removal", () => {
+			const chain = new Seshat();
+			chain.insertBatch(["test", "testing", "tester"]);
+			expect(chain.getMemoryStats().nodeCount).toBe(4);
+			chain.remove("tester");
+			chain.remove("test");
+			expect(chain.getMemoryStats().nodeCount).toBe(Seshat.fromWords(["testing"]).getMemoryStats().nodeCount);
+			expect(chain.getHeightStats({ allHeights: true }).allHeights).toEqual([1]);
+			expect(chain.search("testing")).toBe(true);
+			expect(chain.startsWith("testi")).toBe(true);
+			expect(chain.search("test")).toBe(false);
+		});
+
+		test("should give memory back on compact after heavy removal", () => {
+			const churned = new Seshat();
+			const words = Array.from({ length: 20000 }, (_, i) => `entry-${i}-with-a-long-enough-label`);
+			churned.insertBatch(words);
+			churned.removeBatch(words.filter((_, i) => i % 10 !== 0));
+			const kept = words.filter((_, i) => i % 10 === 0);
+			const before = churned.getMemoryStats();
+			expect(before.reclaimedBytes).toBe(0);
+
+			const reclaimed = churned.compact();
+			const after = churned.getMemoryStats();
+			expect(reclaimed).toBeGreaterThan(0);
+			expect(after.reclaimedBytes).toBe(reclaimed);
+			expect(after.arenaBytes).toBeLessThan(before.arenaBytes);
+			expect(after.labelPoolBytes).toBe(after.stringBufferBytes);
+			expect(after.nodeCount).toBe(Seshat.fromWords(kept).getMemoryStats().nodeCount);
+			expect(churned.getWordsWithPrefix("")).toEqual([...kept].sort());
+
+			churned.insert("entry-new");
+			expect(churned.search("entry-new")).toBe(true);
+			churned.freeze();
+			expect(churned.compact()).toBe(0);
+		});
+
 		test("should get word metrics", () => {
 			const metrics = trie.getWordMetrics();
 			expect(metrics.minLength).toBeGreaterThan(0);
@@ -294,6 +451,29 @@ describe("Seshat", () => {
 			expect(results3).toContain("world");
 		});
 
+		test("should match patternSearch results against a full scan", () => {
+			const words: string[] = [];
+			let seed = 11;
+			for (let i = 0; i < 1500; i++) {
+				let word = "";
+				for (let j = 0; j <= i % 9; j++) {
+					seed = (seed * 1103515245 + 12345) % 2147483648;
+					word += "abcd"[seed % 4];
+				}
+				words.push(word);
+			}
+			const sorted = Seshat.fromWords(words).getWordsWithPrefix("");
+			const large = Seshat.fromWords(words);
+			const patterns = ["a?c", "ab*", "*ab", "*a*d*", "????", "?*?", "d*a?", "abcd", "b**c", "*", "x*"];
+			for (const frozen of [false, true]) {
+				if (frozen) large.freeze();
+				for (const pattern of patterns) {
+					const regex = new RegExp("^" + pattern.replace(/\*/g, ".*").replace(/\?/g, ".") + "$");
+					expect(large.patternSearch(pattern)).toEqual(sorted.filter(word => regex.test(word)));
+				}
+			}
+		});
+
 		test("should get all words", () => {
 			const allWords = trie.getWordsWithPrefix("");
 			expect(allWords).toHaveLength(3);
@@ -422,6 +602,67 @@ describe("Seshat", () => {
 			expect(json.words).toContain("Hello");
 			expect(json.words).not.toContain("hello");
 		});
+
+		test("should keep the casing of the latest insert", () => {
+			const trie = new Seshat({ ignoreCase: true });
+			trie.insert("Hello");
+			trie.insert("HELLO");
+			expect(trie.size()).toBe(1);
+			expect(trie.getWordsWithPrefix("")).toEqual(["HELLO"]);
+			trie.insert("hello");
+			expect(trie.getWordsWithPrefix("")).toEqual(["hello"]);
+			expect(trie.getMemoryStats().casingBytes).toBeGreaterThanOrEqual(0);
+		});
+
+		test("should fold case on the buffer paths", () => {
+			const trie = new Seshat({ ignoreCase: true });
+			expect(trie.insertFromBuffer(Buffer.from("Apple\nBANANA\ncherry\n"))).toBe(3);
+			expect(trie.search("apple")).toBe(true);
+			expect(trie.search("Banana")).toBe(true);
+			expect(trie.searchFromBuffer(Buffer.from("APPLE\nbanana\ngrape\n"))).toEqual(new Uint8Array([0b011]));
+			expect(trie.removeFromBuffer(Buffer.from("aPPLE\nCHERRY\n"))).toBe(2);
+			expect(trie.getWordsWithPrefix("")).toEqual(["BANANA"]);
+		});
+
+		test("should fold letters beyond ASCII", () => {
+			const trie = new Seshat({ ignoreCase: true });
+			trie.insertBatch(["ÉCOLE", "Straße", "ΑΘΗΝΑ", "Москва"]);
+			expect(trie.search("école")).toBe(true);
+			expect(trie.search("STRASSE")).toBe(false);
+			expect(trie.search("straße")).toBe(true);
+			expect(trie.search("αθηνα")).toBe(true);
+			expect(trie.search("МОСКВА")).toBe(true);
+			expect(trie.getWordsWithPrefix("éc")).toEqual(["ÉCOLE"]);
+			expect(trie.patternSearch("м*")).toEqual(["Москва"]);
+		});
+
+		test("should keep original casing through snapshots and freezing", () => {
+			const trie = new Seshat({ ignoreCase: true });
+			trie.insert("Hello", 2);
+			trie.insert("world");
+			const restored = Seshat.fromSnapshot(trie.toSnapshot(), { ignoreCase: true });
+			expect(restored.search("HELLO")).toBe(true);
+			expect(restored.getWordsWithPrefix("")).toEqual(["Hello", "world"]);
+			expect(restored.topK("h", 1)).toEqual([{ word: "Hello", score: 2 }]);
+
+			restored.insert("Help");
+			expect(restored.isFrozen()).toBe(false);
+			expect(restored.getWordsWithPrefix("hel")).toEqual(["Hello", "Help"]);
+			restored.freeze();
+			expect(restored.getWordsWithPrefix("HEL")).toEqual(["Hello", "Help"]);
+		});
+
+		test("should fold case in a parallel bulk load", () => {
+			const lines: string[] = [];
+			for (let i = 0; i < 40000; i++) {
+				lines.push((i % 2 ? "Word" : "word") + i);
+			}
+			const trie = new Seshat({ ignoreCase: true });
+			trie.insertFromBuffer(Buffer.from(lines.join("\n")), { threads: 4 });
+			expect(trie.size()).toBe(40000);
+			expect(trie.search("WORD7")).toBe(true);
+			expect(trie.getWordsWithPrefix("word1", { limit: 3 })).toEqual(["Word1", "word10", "word100"]);
+		});
 	});
 
 	describe("Max Size", () => {
@@ -773,6 +1014,34 @@ describe("Seshat", () => {
 				expect(results).toEqual([true, false, true, false, false]);
 			});
 
+			test("should answer large and unusual batches like single searches", () => {
+				const words = Array.from({ length: 1000 }, (_, i) => `w${i}`);
+				trie.insertBatch(words.filter((_, i) => i % 3 === 0));
+				trie.insert("multi\nline");
+				trie.insert("café");
+				const queries = [...words, "multi\nline", "café", "caf", " hello"];
+				expect(trie.searchBatch(queries)).toEqual(queries.map(word => trie.search(word)));
+				expect(trie.searchBatch(words.slice(0, 9))).toEqual(words.slice(0, 9).map((_, i) => i % 3 === 0));
+			});
+
+			test("should agree with single searches when case-folded or frozen", () => {
+				const words = Array.from({ length: 500 }, (_, i) => `Word${i}-${"x".repeat(i % 40)}`);
+				const folded = Seshat.fromWords(words.filter((_, i) => i % 2 === 0), { ignoreCase: true });
+				const queries = [...words.map(word => word.toUpperCase()), "", "WORD", "word1-x"];
+				const expected = queries.map(word => folded.search(word));
+				expect(expected.filter(Boolean)).toHaveLength(250);
+				expect(folded.searchBatch(queries)).toEqual(expected);
+				folded.freeze();
+				expect(folded.searchBatch(queries)).toEqual(expected);
+			});
+
+			test("should search a newline-delimited buffer into a bitmap", () => {
+				const bits = trie.searchFromBuffer(Buffer.from("hello\r\nmissing\n\n  world  \nnope\ntest"));
+				expect(Array.from(bits)).toEqual([0b10101]);
+				expect(trie.searchFromBuffer(Buffer.alloc(0))).toHaveLength(0);
+				expect(() => trie.searchFromBuffer("hello" as any)).toThrow(TypeError);
+			});
+
 			test("should throw error for non-array input", () => {
 				expect(() => trie.searchBatch("not an array" as any)).toThrow("Words must be an array");
 			});
@@ -806,6 +1075,14 @@ describe("Seshat", () => {
 				expect(trie.size()).toBe(2);
 			});
 
+			test("should round-trip non-ASCII and multi-line words through packed results", () => {
+				trie.insertBatch(["héllo", "he\nllo", "hélp"]);
+				expect(trie.getWordsWithPrefix("h")).toEqual(["he\nllo", "hello", "héllo", "hélp"]);
+				expect(trie.patternSearch("he*")).toEqual(["he\nllo", "hello"]);
+				expect(trie.removeBatch(["he\nllo", "hélp", "hélp"])).toEqual([true, true, false]);
+				expect(trie.getWordsWithPrefix("h")).toEqual(["hello", "héllo"]);
+			});
+
 			test("should throw error for non-array input", () => {
 				expect(() => trie.removeBatch("not an array" as any)).toThrow("Words must be an array");
 			});
@@ -1037,6 +1314,27 @@ describe("Buffer Operations", () => {
 			expect(trie.search("test")).toBe(true);
 		});
 
+		test("should build the same trie with assumeSorted", () => {
+			const words = Array.from({ length: 2000 }, (_, i) => `w${(i * 7919) % 2000}x`).sort();
+			const buf = Buffer.from(["alpha", "al", ...words, "zeta", "zeta"].join("\n"));
+
+			const plain = new Seshat();
+			const sorted = new Seshat();
+			expect(sorted.insertFromBuffer(buf, { assumeSorted: true })).toBe(plain.insertFromBuffer(buf));
+			expect(sorted.size()).toBe(plain.size());
+			expect(sorted.getWordsWithPrefix("")).toEqual(plain.getWordsWithPrefix(""));
+			expect(sorted.getMemoryStats().nodeCount).toBe(plain.getMemoryStats().nodeCount);
+		});
+
+		test("should fall back for unsorted lines with assumeSorted", () => {
+			const trie = Seshat.fromWords(["mango"]);
+			const count = trie.insertFromBuffer(Buffer.from("zebra\napple\nmangos\nman\nzoo\nzebra\n"), { assumeSorted: true });
+
+			expect(count).toBe(6);
+			expect(trie.getWordsWithPrefix("")).toEqual(["apple", "man", "mango", "mangos", "zebra", "zoo"]);
+			expect(() => trie.insertFromBuffer(Buffer.from("a"), { assumeSorted: "yes" as any })).toThrow(TypeError);
+		});
+
 		test("should handle buffer without trailing newline", () => {
 			const trie = new Seshat();
 			const buf = Buffer.from("hello\nworld\ntest");
@@ -1302,6 +1600,75 @@ describe("Buffer Operations", () => {
 		});
 	});
 
+	describe("toStream / writeToFile", () => {
+		const collect = async (stream: Readable): Promise<Buffer> => {
+			const chunks: Buffer[] = [];
+			for await (const chunk of stream) {
+				chunks.push(chunk as Buffer);
+			}
+			return Buffer.concat(chunks);
+		};
+
+		test("should stream the same bytes as toBuffer", async () => {
+			const trie = new Seshat();
+			Array.from({ length: 5000 }, (_, i) => `word${i}`).forEach((w, i) => trie.insert(w, i % 7));
+			trie.insert("café");
+
+			expect((await collect(trie.toStream())).equals(trie.toBuffer())).toBe(true);
+			expect((await collect(trie.toStream({ chunkSize: 16 }))).equals(trie.toBuffer())).toBe(true);
+			expect((await collect(trie.toStream({ withScores: true, chunkSize: 100 }))).equals(trie.toBuffer({ withScores: true }))).toBe(true);
+		});
+
+		test("should end an empty trie's stream without data", async () => {
+			expect((await collect(new Seshat().toStream())).length).toBe(0);
+		});
+
+		test("should reject a bad chunk size", () => {
+			const trie = new Seshat();
+			expect(() => trie.toStream({ chunkSize: 0 })).toThrow(RangeError);
+			expect(() => trie.toStream({ chunkSize: 1.5 })).toThrow(RangeError);
+		});
+
+		test("should error the stream if the trie is modified while it is read", async () => {
+			// Far more than the stream buffers ahead, so reads remain after the insert
+			const trie = Seshat.fromWords(Array.from({ length: 100000 }, (_, i) => `word${i}`));
+			const stream = trie.toStream({ chunkSize: 16 });
+			await new Promise(resolve => stream.once("readable", resolve));
+			trie.insert("zebra");
+
+			await expect(collect(stream)).rejects.toThrow("modified");
+		});
+
+		test("should write toBuffer's bytes to a file", async () => {
+			const dir = fs.mkdtempSync(`${os.tmpdir()}${require("path").sep}seshat-`);
+			const file = require("path").join(dir, "words.txt");
+			const trie = new Seshat();
+			Array.from({ length: 3000 }, (_, i) => `word${i}`).forEach((w, i) => trie.insert(w, i));
+
+			try {
+				expect(trie.writeToFile(file)).toBe(3000);
+				expect(fs.readFileSync(file).equals(trie.toBuffer())).toBe(true);
+
+				expect(await trie.writeToFileAsync(file, { withScores: true })).toBe(3000);
+				expect(fs.readFileSync(file).equals(trie.toBuffer({ withScores: true }))).toBe(true);
+
+				const copy = new Seshat();
+				copy.insertFromFile(file, { assumeSorted: true, scored: true });
+				expect(copy.toBuffer({ withScores: true }).equals(trie.toBuffer({ withScores: true }))).toBe(true);
+			} finally {
+				fs.rmSync(dir, { recursive: true, force: true });
+			}
+		});
+
+		test("should fail to write to a missing directory", async () => {
+			const trie = Seshat.fromWords(["hello"]);
+			const file = require("path").join(os.tmpdir(), "seshat-missing-dir", "nested", "words.txt");
+			expect(() => trie.writeToFile(file)).toThrow();
+			await expect(trie.writeToFileAsync(file)).rejects.toThrow();
+			expect(() => trie.writeToFile(42 as unknown as string)).toThrow(TypeError);
+		});
+	});
+
 	describe("toBuffer / fromBuffer roundtrip", () => {
 		test("should roundtrip a trie through buffer serialization", () => {
 			const original = new Seshat();
@@ -1319,6 +1686,11 @@ describe("Buffer Operations", () => {
 			expect(restored.search("missing")).toBe(false);
 		});
 
+		test("should load an unsorted buffer correctly", () => {
+			const restored = Seshat.fromBuffer(Buffer.from("pear\napple\nbanana\napp\n"));
+			expect(restored.getWordsWithPrefix("")).toEqual(["app", "apple", "banana", "pear"]);
+		});
+
 		test("should roundtrip empty trie", () => {
 			const original = new Seshat();
 			const buf = original.toBuffer();
@@ -1536,6 +1908,55 @@ describe("Stream Insertion", () => {
 		expect(trie.search("word999")).toBe(true);
 		expect(duration).toBeLessThan(1000);
 	});
+
+	test("should inflate gzip input without being told", async () => {
+		const text = Array.from({ length: 5000 }, (_, i) => `word${i}`).join("\n");
+		const gz = zlib.gzipSync(text);
+		const chunks: Buffer[] = [];
+		for (let i = 0; i < gz.length; i += 97) {
+			chunks.push(gz.subarray(i, i + 97));
+		}
+		const trie = new Seshat();
+		const count = await trie.insertFromStream(Readable.from(chunks));
+
+		expect(count).toBe(5000);
+		expect(trie.search("word0")).toBe(true);
+		expect(trie.search("word4999")).toBe(true);
+	});
+
+	test("should read concatenated gzip members as one stream", async () => {
+		const gz = Buffer.concat([zlib.gzipSync("alpha\nbe"), zlib.gzipSync("ta\ngamma\n")]);
+		const trie = new Seshat();
+		const count = await trie.insertFromStream(Readable.from([gz]), { gzip: true });
+
+		expect(count).toBe(3);
+		expect(trie.search("beta")).toBe(true);
+	});
+
+	test("should reject truncated gzip input", async () => {
+		const gz = zlib.gzipSync("alpha\nbeta\ngamma\n".repeat(100));
+		const trie = new Seshat();
+
+		await expect(trie.insertFromStream(Readable.from([gz.subarray(0, gz.length - 8)]))).rejects.toThrow("Truncated gzip data");
+	});
+
+	test("should count words through createIngest", done => {
+		const trie = new Seshat();
+		const ingest = trie.createIngest({ highWaterMark: 4 });
+
+		expect(ingest.write("hello\nwor")).toBe(false);
+		ingest.end("ld\n", () => {
+			expect(ingest.count).toBe(2);
+			expect(trie.search("world")).toBe(true);
+			done();
+		});
+	});
+
+	test("should validate createIngest options", () => {
+		const trie = new Seshat();
+
+		expect(() => trie.createIngest({ highWaterMark: 0 })).toThrow(RangeError);
+	});
 });
 
 describe("Async File Insertion", () => {
@@ -1566,3 +1987,1016 @@ describe("Async File Insertion", () => {
 		});
 	});
 });
+
+describe("Mapped File Insertion", () => {
+	const lines = (): string => {
+		const words: string[] = [];
+		for (let i = 0; i < 2000; i++) {
+			words.push(`word${i}`.padEnd(5 + (i % 40), "x"));
+		}
+		// Every line ending and padding the loaders accept, at every offset
+		const endings = ["\n", "\r\n", "\r", "\n\n", " \t\n", "\n  "];
+		return words.map((w, i) => (i % 3 === 0 ? "  " : "") + w + endings[i % endings.length]).join("") + "last";
+	};
+
+	test("should split a mapped file exactly as insertFromBuffer does", () => {
+		const dir = fs.mkdtempSync(`${os.tmpdir()}${require("path").sep}seshat-`);
+		const file = require("path").join(dir, "words.txt");
+		const contents = lines();
+		fs.writeFileSync(file, contents, "utf8");
+		try {
+			const fromFile = new Seshat();
+			const fromBuffer = new Seshat();
+			const count = fromFile.insertFromFile(file);
+			expect(count).toBe(fromBuffer.insertFromBuffer(Buffer.from(contents, "utf8")));
+			expect(count).toBe(2001);
+			expect(fromFile.toBuffer().equals(fromBuffer.toBuffer())).toBe(true);
+			expect(fromFile.search("last")).toBe(true);
+		} finally {
+			fs.rmSync(dir, { recursive: true, force: true });
+		}
+	});
+
+	(process.platform === "win32" ? test.skip : test)("should stream a named pipe through the buffer", () => {
+		const { execFileSync, spawn } = require("child_process");
+		const dir = fs.mkdtempSync(`${os.tmpdir()}${require("path").sep}seshat-`);
+		const fifo = require("path").join(dir, "words.fifo");
+		const contents = lines();
+		execFileSync("mkfifo", [fifo]);
+		const writer = spawn("sh", ["-c", 'cat > "$0"', fifo]);
+		writer.stdin.end(contents);
+		try {
+			const fromPipe = new Seshat();
+			const fromBuffer = new Seshat();
+			expect(fromPipe.insertFromFile(fifo, 7)).toBe(fromBuffer.insertFromBuffer(Buffer.from(contents, "utf8")));
+			expect(fromPipe.toBuffer().equals(fromBuffer.toBuffer())).toBe(true);
+		} finally {
+			fs.rmSync(dir, { recursive: true, force: true });
+		}
+	});
+});
+
+describe("Async Queries", () => {
+	const words = Array.from({ length: 5000 }, (_, i) => `word${i}`);
+
+	test("should resolve with the same results as the synchronous queries", async () => {
+		const trie = Seshat.fromWords(words);
+		expect(await trie.getWordsWithPrefixAsync("word1", { limit: 50, offset: 5 }))
+			.toEqual(trie.getWordsWithPrefix("word1", { limit: 50, offset: 5 }));
+		expect(await trie.patternSearchAsync("word?2")).toEqual(trie.patternSearch("word?2"));
+		expect((await trie.toBufferAsync()).equals(trie.toBuffer())).toBe(true);
+		expect(await trie.getHeightStatsAsync()).toEqual(trie.getHeightStats());
+		expect(await trie.getWordMetricsAsync()).toEqual(trie.getWordMetrics());
+
+		trie.freeze();
+		expect(await trie.getWordsWithPrefixAsync("word49")).toEqual(trie.getWordsWithPrefix("word49"));
+	});
+
+	test("should run concurrent queries and refuse writes until they settle", async () => {
+		const trie = Seshat.fromWords(words);
+		const pending = Promise.all([
+			trie.getWordsWithPrefixAsync(""),
+			trie.patternSearchAsync("*9"),
+			trie.toBufferAsync(),
+		]);
+		expect(trie.search("word1")).toBe(true);
+		expect(() => trie.insert("late")).toThrow(/busy/);
+		expect(() => trie.remove("word1")).toThrow(/busy/);
+		expect(() => trie.freeze()).toThrow(/busy/);
+
+		const [all, nines] = await pending;
+		expect(all).toHaveLength(words.length);
+		expect(nines).toEqual(words.filter(word => word.endsWith("9")).sort());
+		trie.insert("late");
+		expect(trie.search("late")).toBe(true);
+	});
+
+	test("should refuse other calls while an async insert runs", async () => {
+		const tmpFile = fs.mkdtempSync(`${os.tmpdir()}${require("path").sep}seshat-`) + require("path").sep + "words.txt";
+		fs.writeFileSync(tmpFile, words.join("\n") + "\n", "utf8");
+
+		const trie = new Seshat();
+		const finished = new Promise<number | undefined>((resolve, reject) => {
+			trie.insertFromFileAsync(tmpFile, (err, count) => (err ? reject(err) : resolve(count)));
+		});
+		try {
+			expect(() => trie.search("word42")).toThrow(/busy/);
+			expect(() => trie.insert("other")).toThrow(/busy/);
+			await expect(trie.getWordsWithPrefixAsync("")).rejects.toThrow(/busy/);
+			expect(await finished).toBe(words.length);
+			expect(trie.search("word42")).toBe(true);
+		} finally {
+			try { fs.unlinkSync(tmpFile); } catch {}
+		}
+	});
+
+	test("should preserve original casing when ignoring case", async () => {
+		const trie = new Seshat({ ignoreCase: true });
+		trie.insertBatch(["Hello", "HELP", "world"]);
+		expect(await trie.getWordsWithPrefixAsync("he")).toEqual(["Hello", "HELP"]);
+		expect(await trie.patternSearchAsync("H*")).toEqual(["Hello", "HELP"]);
+	});
+});
+
+describe("Concurrent Mode", () => {
+	const words = Array.from({ length: 5000 }, (_, i) => `word${i}`);
+
+	test("should refuse rather than wait for a running async query", async () => {
+		const trie = Seshat.fromWords(words, { concurrent: true });
+		const pending = trie.getWordsWithPrefixAsync("");
+		// The write goes ahead if the query has not started on its worker
+		// thread yet, and throws if it has; it never blocks
+		let inserted = true;
+		try {
+			trie.insert("late");
+		} catch (e) {
+			expect(String(e)).toMatch(/busy/);
+			inserted = false;
+		}
+		expect(trie.search("late")).toBe(inserted);
+
+		// The query saw the trie either before or after the write
+		expect(await pending).toContain("word0");
+		trie.insert("late");
+		expect(trie.remove("word1")).toBe(true);
+		expect(trie.search("word1")).toBe(false);
+		expect(trie.size()).toBe(words.length);
+		expect(trie.getWordsWithPrefix("late")).toEqual(["late"]);
+	});
+
+	test("should keep answering reads during an async insert", async () => {
+		const tmpFile = fs.mkdtempSync(`${os.tmpdir()}${require("path").sep}seshat-`) + require("path").sep + "words.txt";
+		fs.writeFileSync(tmpFile, words.join("\n") + "\n", "utf8");
+
+		const trie = new Seshat({ concurrent: true, words: ["before"] });
+		const finished = new Promise<number | undefined>((resolve, reject) => {
+			trie.insertFromFileAsync(tmpFile, (err, count) => (err ? reject(err) : resolve(count)));
+		});
+		try {
+			expect(trie.search("before")).toBe(true);
+			expect(await trie.getWordsWithPrefixAsync("bef")).toEqual(["before"]);
+			expect(() => trie.insert("other")).toThrow(/busy/);
+			expect(await finished).toBe(words.length);
+			expect(trie.size()).toBe(words.length + 1);
+			expect(trie.search("word42")).toBe(true);
+		} finally {
+			try { fs.unlinkSync(tmpFile); } catch {}
+		}
+	});
+
+	test("should keep both copies in step across writes", () => {
+		const trie = new Seshat({ concurrent: true, ignoreCase: true });
+		trie.insertBatch(["Alpha", "beta", "Gamma"]);
+		trie.insert("delta", 7);
+		trie.removeBatch(["BETA"]);
+		trie.freeze();
+		// Consecutive writes land on alternate copies first, so each check
+		// below reads a different one
+		const expected = ["Alpha", "delta", "Gamma"];
+		for (const word of ["epsilon", "eta", "theta"]) {
+			trie.insert(word);
+			expected.push(word);
+			expect(trie.getWordsWithPrefix("")).toEqual([...expected].sort((a, b) => a.toLowerCase().localeCompare(b.toLowerCase())));
+			expect(trie.topK("d", 1)).toEqual([{ word: "delta", score: 7 }]);
+		}
+		expect(trie.isFrozen()).toBe(false);
+	});
+
+	test("should load a file once and copy it to the other copy", () => {
+		const tmpFile = fs.mkdtempSync(`${os.tmpdir()}${require("path").sep}seshat-`) + require("path").sep + "words.txt";
+		fs.writeFileSync(tmpFile, "apple\nbanana\n", "utf8");
+
+		const trie = new Seshat({ concurrent: true, words: ["cherry"] });
+		try {
+			expect(trie.insertFromFile(tmpFile)).toBe(2);
+			// Rewriting the file afterwards must not reach either copy
+			fs.writeFileSync(tmpFile, "durian\n", "utf8");
+			// Consecutive writes land on alternate copies first
+			const expected = ["apple", "banana", "cherry"];
+			for (const word of ["elder", "fig"]) {
+				trie.insert(word);
+				expected.push(word);
+				expect(trie.getWordsWithPrefix("")).toEqual(expected);
+			}
+		} finally {
+			try { fs.unlinkSync(tmpFile); } catch {}
+		}
+	});
+
+	test("should invalidate cursors on write", () => {
+		const trie = Seshat.fromWords(words, { concurrent: true });
+		const iter = trie.iterPrefix("word", 1);
+		expect(iter.next().value).toBe("word0");
+		trie.insert("wordy");
+		expect(() => iter.next()).toThrow("Trie was modified during iteration");
+	});
+});
+describe("Worker Thread Sharing", () => {
+	const { Worker } = require("worker_threads");
+	const root = require("path").resolve(__dirname, "..");
+
+	// Workers import the native addon directly, since they do not load the TS sources
+	function runWorker(code: string): Promise<unknown> {
+		return new Promise((resolve, reject) => {
+			const worker = new Worker(`const native = require("node-gyp-build")(${JSON.stringify(root)}); ${code}`, { eval: true });
+			worker.once("message", resolve);
+			worker.once("error", reject);
+		});
+	}
+
+	test("should let another thread attach to a shared trie", async () => {
+		const trie = Seshat.fromWords(["alpha", "beta"], { concurrent: true, ignoreCase: true });
+		trie.share("test-dictionary");
+		const seen = await runWorker(`
+			const { parentPort } = require("worker_threads");
+			const shared = native.Seshat.attach("test-dictionary");
+			shared.insert("Gamma");
+			parentPort.postMessage([shared.search("ALPHA"), shared.size()]);
+		`);
+		expect(seen).toEqual([true, 3]);
+		expect(trie.getWordsWithPrefix("")).toEqual(["alpha", "beta", "Gamma"]);
+
+		const attached = Seshat.attach("test-dictionary");
+		expect(attached.search("gamma")).toBe(true);
+		expect(attached.toJSON().options.ignoreCase).toBe(true);
+		expect(Seshat.unshare("test-dictionary")).toBe(true);
+		expect(() => Seshat.attach("test-dictionary")).toThrow(/No trie is shared/);
+		expect(attached.size()).toBe(3);
+	});
+
+	test("should only share concurrent tries under free names", () => {
+		expect(() => new Seshat().share("plain")).toThrow(/concurrent/);
+		const first = new Seshat({ concurrent: true });
+		first.share("taken");
+		first.share("taken");
+		expect(() => new Seshat({ concurrent: true }).share("taken")).toThrow(/already shared/);
+		expect(Seshat.unshare("taken")).toBe(true);
+		expect(Seshat.unshare("taken")).toBe(false);
+	});
+});
+
+
+describe("Parallel Bulk Load", () => {
+	// Large enough (over 256KB) that the loaders actually fan out
+	const words: string[] = [];
+	let seed = 42;
+	for (let i = 0; i < 60000; i++) {
+		let word = "";
+		const length = 3 + (i % 8);
+		for (let j = 0; j < length; j++) {
+			seed = (seed * 1103515245 + 12345) % 2147483648;
+			word += String.fromCharCode(97 + (seed % 26));
+		}
+		words.push(word);
+	}
+	const contents = words.join("\r\n") + "\n";
+	const expected = Seshat.fromBuffer(Buffer.from(contents));
+
+	let tmpFile: string;
+	beforeAll(() => {
+		tmpFile = fs.mkdtempSync(`${os.tmpdir()}${require("path").sep}seshat-`) + require("path").sep + "words.txt";
+		fs.writeFileSync(tmpFile, contents, "utf8");
+	});
+	afterAll(() => {
+		try { fs.unlinkSync(tmpFile); } catch {}
+	});
+
+	test("should build the same trie from a buffer on several threads", () => {
+		const trie = new Seshat();
+		expect(trie.insertFromBuffer(Buffer.from(contents), { threads: 4 })).toBe(words.length);
+		expect(trie.size()).toBe(expected.size());
+		expect(trie.getWordsWithPrefix("")).toEqual(expected.getWordsWithPrefix(""));
+	});
+
+	test("should merge a threaded file load into existing words", () => {
+		const trie = Seshat.fromWords(["aardvark", words[0], "zzz"]);
+		expect(trie.insertFromFile(tmpFile, { threads: 3 })).toBe(words.length);
+		expect(trie.search("aardvark")).toBe(true);
+		expect(trie.search("zzz")).toBe(true);
+		words.slice(0, 500).forEach(word => expect(trie.search(word)).toBe(true));
+		expect(trie.getMemoryStats().nodeCount).toBe(
+			Seshat.fromWords([...expected.getWordsWithPrefix(""), "aardvark", "zzz"]).getMemoryStats().nodeCount);
+	});
+
+	test("should accept a thread count asynchronously", done => {
+		const trie = new Seshat();
+		trie.insertFromFileAsync(tmpFile, { threads: 2 }, (err, count) => {
+			try {
+				expect(err).toBeNull();
+				expect(count).toBe(words.length);
+				expect(trie.getWordsWithPrefix("")).toEqual(expected.getWordsWithPrefix(""));
+				done();
+			} catch (e) {
+				done(e);
+			}
+		});
+	});
+
+	test("should reject invalid thread counts", () => {
+		const trie = new Seshat();
+		expect(() => trie.insertFromFile(tmpFile, { threads: 0 })).toThrow(RangeError);
+		expect(() => trie.insertFromFile(tmpFile, { threads: 1.5 })).toThrow(RangeError);
+		expect(() => trie.insertFromBuffer(Buffer.from("a\n"), { threads: -2 })).toThrow(RangeError);
+		expect(trie.size()).toBe(0);
+	});
+});
+
+describe("Snapshot Operations", () => {
+	const words = ["hello", "help", "heap", "world", "word", "test", "café"];
+
+	test("should roundtrip a trie through a snapshot buffer", () => {
+		const original = Seshat.fromWords(words);
+		const restored = Seshat.fromSnapshot(original.toSnapshot());
+
+		expect(restored.isFrozen()).toBe(true);
+		expect(restored.size()).toBe(original.size());
+		for (const w of words) {
+			expect(restored.search(w)).toBe(true);
+		}
+		expect(restored.search("hel")).toBe(false);
+		expect(restored.startsWith("wor")).toBe(true);
+		expect(restored.startsWith("xyz")).toBe(false);
+		expect(restored.getWordsWithPrefix("he")).toEqual(original.getWordsWithPrefix("he"));
+		expect(restored.getWordsWithPrefix("")).toEqual(original.getWordsWithPrefix(""));
+		expect(restored.patternSearch("w*d")).toEqual(original.patternSearch("w*d"));
+		expect(restored.toBuffer().equals(original.toBuffer())).toBe(true);
+	});
+
+	test("should memory-map a snapshot file", () => {
+		const dir = fs.mkdtempSync(`${os.tmpdir()}${require("path").sep}seshat-`);
+		const file = require("path").join(dir, "words.snap");
+		const original = Seshat.fromWords(Array.from({ length: 2000 }, (_, i) => `word${i}`));
+		fs.writeFileSync(file, original.toSnapshot());
+
+		try {
+			const mapped = Seshat.fromSnapshotFile(file);
+			expect(mapped.isFrozen()).toBe(true);
+			expect(mapped.size()).toBe(2000);
+			expect(mapped.search("word1999")).toBe(true);
+			expect(mapped.search("word2000")).toBe(false);
+			expect(mapped.getWordsWithPrefix("word199")).toEqual(original.getWordsWithPrefix("word199"));
+			expect(mapped.toSnapshot().equals(fs.readFileSync(file))).toBe(true);
+		} finally {
+			fs.rmSync(dir, { recursive: true, force: true });
+		}
+	});
+
+	test("should report analytics for a snapshot-backed trie", () => {
+		const original = Seshat.fromWords(words);
+		const restored = Seshat.fromSnapshot(original.toSnapshot());
+
+		expect(restored.getWordMetrics()).toEqual(original.getWordMetrics());
+		expect(restored.getHeightStats({ allHeights: true }).allHeights).toHaveLength(words.length);
+		expect(restored.getHeightStats()).toEqual(original.getHeightStats());
+		expect(restored.getMemoryStats().nodeCount).toBe(original.getMemoryStats().nodeCount);
+	});
+
+	test("should thaw a loaded snapshot on mutation", () => {
+		const restored = Seshat.fromSnapshot(Seshat.fromWords(words).toSnapshot());
+
+		restored.insert("new");
+		expect(restored.isFrozen()).toBe(false);
+		expect(restored.search("new")).toBe(true);
+		expect(restored.remove("hello")).toBe(true);
+		expect(restored.size()).toBe(words.length);
+		expect(restored.search("help")).toBe(true);
+	});
+
+	test("should roundtrip an empty trie", () => {
+		const restored = Seshat.fromSnapshot(new Seshat().toSnapshot());
+		expect(restored.size()).toBe(0);
+		expect(restored.startsWith("")).toBe(false);
+		expect(restored.getWordsWithPrefix("")).toEqual([]);
+	});
+
+	test("should reject malformed snapshots", () => {
+		const image = Seshat.fromWords(words).toSnapshot();
+		expect(() => Seshat.fromSnapshot(Buffer.alloc(64, "hello\n"))).toThrow("Not a Seshat snapshot");
+		expect(() => Seshat.fromSnapshot(image.subarray(0, image.length - 1))).toThrow("Failed to load snapshot");
+		expect(() => Seshat.fromSnapshot("nope" as any)).toThrow("Argument must be a Buffer");
+		expect(() => Seshat.fromSnapshotFile("/definitely/not/here.snap")).toThrow("Failed to load snapshot");
+	});
+});
+
+describe("Frozen Tries", () => {
+	const words = Array.from({ length: 3000 }, (_, i) => `word${i}`).concat(["hello", "help", "heap"]);
+
+	test("should answer queries identically once frozen", () => {
+		const reference = Seshat.fromWords(words);
+		const trie = Seshat.fromWords(words);
+		trie.freeze();
+
+		expect(trie.isFrozen()).toBe(true);
+		expect(trie.size()).toBe(reference.size());
+		expect(trie.search("word2999")).toBe(true);
+		expect(trie.search("word3000")).toBe(false);
+		expect(trie.startsWith("hel")).toBe(true);
+		expect(trie.getWordsWithPrefix("word29")).toEqual(reference.getWordsWithPrefix("word29"));
+		expect(trie.getWordsWithPrefix("word", { limit: 5, offset: 10 })).toEqual(reference.getWordsWithPrefix("word", { limit: 5, offset: 10 }));
+		expect([...trie.iterPrefix("word1", 7)]).toEqual(reference.getWordsWithPrefix("word1"));
+		expect(trie.patternSearch("h?l*")).toEqual(reference.patternSearch("h?l*"));
+		expect(trie.getWordMetrics()).toEqual(reference.getWordMetrics());
+		expect(trie.toBuffer().equals(reference.toBuffer())).toBe(true);
+	});
+
+	test("should use less memory when frozen", () => {
+		const trie = Seshat.fromWords(words);
+		const before = trie.getMemoryStats().totalBytes;
+		trie.freeze();
+		expect(trie.getMemoryStats().totalBytes).toBeLessThan(before);
+	});
+
+	test("should thaw transparently on mutation", () => {
+		const trie = Seshat.fromWords(words);
+		trie.freeze();
+
+		trie.insert("brandnew");
+		expect(trie.isFrozen()).toBe(false);
+		expect(trie.search("brandnew")).toBe(true);
+		expect(trie.search("word0")).toBe(true);
+		expect(trie.size()).toBe(words.length + 1);
+
+		trie.freeze();
+		expect(trie.remove("brandnew")).toBe(true);
+		expect(trie.isFrozen()).toBe(false);
+		expect(trie.size()).toBe(words.length);
+	});
+
+	test("should support explicit thaw and repeated freeze", () => {
+		const trie = Seshat.fromWords(words);
+		trie.freeze();
+		trie.freeze();
+		trie.thaw();
+		expect(trie.isFrozen()).toBe(false);
+		trie.thaw();
+		expect(trie.getWordsWithPrefix("")).toEqual(Seshat.fromWords(words).getWordsWithPrefix(""));
+	});
+
+	test("clear should leave an empty mutable trie", () => {
+		const trie = Seshat.fromWords(words);
+		trie.freeze();
+		trie.clear();
+		expect(trie.isFrozen()).toBe(false);
+		expect(trie.size()).toBe(0);
+	});
+});
+
+describe("Set Operations", () => {
+	const left = ["apple", "applet", "application", "banana", "band", "cherry"];
+	const right = ["apple", "apply", "band", "bandana", "cherry", "date"];
+	const sorted = (words: string[]) => [...words].sort();
+
+	test("merge should add the other trie's words, splitting shared edges", () => {
+		const a = Seshat.fromWords(left);
+		const b = Seshat.fromWords(right);
+		expect(a.merge(b)).toBe(3);
+		expect(a.getWordsWithPrefix("")).toEqual(sorted([...new Set([...left, ...right])]));
+		expect(b.getWordsWithPrefix("")).toEqual(sorted(right));
+		expect(a.merge(b)).toBe(0);
+	});
+
+	test("merge should carry scores over and keep this trie's for shared words", () => {
+		const a = new Seshat();
+		a.insert("help", 5);
+		const b = new Seshat();
+		b.insert("help", 1);
+		b.insert("helpful", 9);
+		b.insert("hello", 7);
+		a.merge(b);
+		expect(a.getScore("help")).toBe(5);
+		expect(a.getScore("helpful")).toBe(9);
+		expect(a.topK("hel", 2)).toEqual([
+			{ word: "helpful", score: 9 },
+			{ word: "hello", score: 7 },
+		]);
+	});
+
+	test("subtract and intersect should count what they remove", () => {
+		const a = Seshat.fromWords(left);
+		expect(a.subtract(Seshat.fromWords(right))).toBe(3);
+		expect(a.getWordsWithPrefix("")).toEqual(["applet", "application", "banana"]);
+
+		const c = Seshat.fromWords(left);
+		expect(c.intersect(Seshat.fromWords(right))).toBe(3);
+		expect(c.getWordsWithPrefix("")).toEqual(["apple", "band", "cherry"]);
+		expect(c.search("banana")).toBe(false);
+		expect(c.startsWith("bana")).toBe(false);
+	});
+
+	test("should leave the same structure as removing word by word", () => {
+		const words = Array.from({ length: 2000 }, (_, i) => `w${i * 7}`);
+		const others = words.filter((_, i) => i % 3 === 0).concat(["w", "x1", "w00"]);
+		const a = Seshat.fromWords(words);
+		const reference = Seshat.fromWords(words);
+		a.subtract(Seshat.fromWords(others));
+		reference.removeBatch(others);
+		expect(a.getWordsWithPrefix("")).toEqual(reference.getWordsWithPrefix(""));
+		expect(a.getMemoryStats().nodeCount).toBe(reference.getMemoryStats().nodeCount);
+		expect(a.getHeightStats({ allHeights: true })).toEqual(reference.getHeightStats({ allHeights: true }));
+	});
+
+	test("diff should list the words the other trie lacks without changing either", () => {
+		const a = Seshat.fromWords(left);
+		const b = Seshat.fromWords(right);
+		a.insert("banana", 4);
+		expect(a.diff(b).toString()).toBe("applet\napplication\nbanana\n");
+		expect(a.diff(b, { withScores: true }).toString()).toBe("applet\t0\napplication\t0\nbanana\t4\n");
+		expect(a.diff(a).length).toBe(0);
+		expect(a.size()).toBe(left.length);
+	});
+
+	test("should work with a frozen trie on either side", () => {
+		const a = Seshat.fromWords(left);
+		const b = Seshat.fromWords(right);
+		a.freeze();
+		b.freeze();
+		expect(a.diff(b).toString()).toBe("applet\napplication\nbanana\n");
+		expect(a.merge(b)).toBe(3);
+		expect(a.isFrozen()).toBe(false);
+		expect(b.isFrozen()).toBe(true);
+		expect(a.size()).toBe(9);
+	});
+
+	test("should keep spellings in an ignoreCase trie", () => {
+		const a = new Seshat({ ignoreCase: true, words: ["Hello"] });
+		const b = new Seshat({ ignoreCase: true, words: ["HELLO", "World"] });
+		expect(a.merge(b)).toBe(1);
+		expect(a.getWordsWithPrefix("")).toEqual(["Hello", "World"]);
+		expect(b.diff(a).length).toBe(0);
+	});
+
+	test("should handle a trie combined with itself", () => {
+		const a = Seshat.fromWords(left);
+		expect(a.merge(a)).toBe(0);
+		expect(a.intersect(a)).toBe(0);
+		expect(a.size()).toBe(left.length);
+		expect(a.subtract(a)).toBe(left.length);
+		expect(a.isEmpty()).toBe(true);
+	});
+
+	test("should work between concurrent tries", () => {
+		const a = new Seshat({ concurrent: true, words: left });
+		const b = new Seshat({ concurrent: true, words: right });
+		expect(a.intersect(b)).toBe(3);
+		expect(a.merge(b)).toBe(3);
+		expect(a.getWordsWithPrefix("")).toEqual(sorted(right));
+	});
+
+	test("should reject other arguments and mismatched case handling", () => {
+		const a = Seshat.fromWords(left);
+		expect(() => a.merge(["apple"] as any)).toThrow(TypeError);
+		expect(() => a.diff(null as any)).toThrow(TypeError);
+		expect(() => a.merge(new Seshat({ ignoreCase: true }))).toThrow(/ignore case/);
+	});
+});
+
+describe("Suffix Index", () => {
+	const words = ["jumping", "running", "ran", "sing", "station", "nation", "rationale", "ring"];
+	const bySuffix = (list: string[], suffix: string) => list.filter((w) => w.endsWith(suffix)).sort();
+
+	test("should answer suffix queries with and without the index", () => {
+		for (const suffixIndex of [true, false]) {
+			const trie = Seshat.fromWords(words, { suffixIndex });
+			expect(trie.endsWith("ing")).toBe(true);
+			expect(trie.endsWith("xyz")).toBe(false);
+			expect(trie.getWordsWithSuffix("ing")).toEqual(bySuffix(words, "ing"));
+			expect(trie.getWordsWithSuffix("ation")).toEqual(["nation", "station"]);
+			expect(trie.getWordsWithSuffix("")).toEqual([...words].sort());
+		}
+	});
+
+	test("should follow inserts, removals and bulk loads", () => {
+		const trie = new Seshat({ suffixIndex: true, words });
+		trie.insert("bring");
+		trie.remove("sing");
+		expect(trie.getWordsWithSuffix("ing")).toEqual(["bring", "jumping", "ring", "running"]);
+		trie.insertFromBuffer(Buffer.from(Array.from({ length: 20000 }, (_, i) => `w${i}ing`).join("\n")), { threads: 4 });
+		expect(trie.getWordsWithSuffix("9ing")).toHaveLength(2000);
+		trie.clear();
+		expect(trie.endsWith("ing")).toBe(false);
+	});
+
+	test("should answer leading-wildcard patterns as a full walk would", () => {
+		const indexed = Seshat.fromWords(words, { suffixIndex: true });
+		const plain = Seshat.fromWords(words);
+		for (const pattern of ["*ing", "*a?ion", "*ation*", "?ing", "*at*n*", "*", "*ng*"]) {
+			expect(indexed.patternSearch(pattern)).toEqual(plain.patternSearch(pattern));
+		}
+		indexed.freeze();
+		expect(indexed.patternSearch("*tion")).toEqual(["nation", "station"]);
+	});
+
+	test("should report original spellings in an ignoreCase trie", () => {
+		const trie = Seshat.fromWords(["Running", "JUMPING", "sing"], { ignoreCase: true, suffixIndex: true });
+		expect(trie.endsWith("ING")).toBe(true);
+		expect(trie.getWordsWithSuffix("Ing")).toEqual(["JUMPING", "Running", "sing"]);
+		expect(trie.patternSearch("*UMP*")).toEqual(["JUMPING"]);
+		expect(trie.getMemoryStats().suffixIndexBytes).toBeGreaterThan(0);
+	});
+
+	test("should reject non-string suffixes", () => {
+		const trie = new Seshat({ suffixIndex: true });
+		expect(() => trie.endsWith(1 as any)).toThrow(TypeError);
+		expect(() => trie.getWordsWithSuffix(null as any)).toThrow(TypeError);
+	});
+});
+
+describe("Prefix Map Values", () => {
+	test("should set, replace and get values", () => {
+		const trie = new Seshat();
+		trie.set("apple", 17);
+		trie.insert("apricot", 5);
+		expect(trie.get("apple")).toBe(17);
+		expect(trie.get("apricot")).toBeUndefined();
+		expect(trie.get("missing")).toBeUndefined();
+		trie.set("apple", Number.MAX_SAFE_INTEGER);
+		trie.insert("apple", 3);
+		expect(trie.get("apple")).toBe(Number.MAX_SAFE_INTEGER);
+		expect(trie.getScore("apple")).toBe(3);
+		trie.remove("apple");
+		trie.insert("apple");
+		expect(trie.get("apple")).toBeUndefined();
+	});
+
+	test("should return entries under a prefix in order", () => {
+		const trie = new Seshat({ words: ["help"] });
+		trie.set("hello", 1);
+		trie.set("helium", 2);
+		trie.set("world", 3);
+		expect(trie.getEntriesWithPrefix("hel")).toEqual([
+			["helium", 2],
+			["hello", 1],
+			["help", undefined],
+		]);
+		expect(trie.getEntriesWithPrefix("hel", { limit: 1, offset: 1 })).toEqual([["hello", 1]]);
+		trie.freeze();
+		expect(trie.getEntriesWithPrefix("w")).toEqual([["world", 3]]);
+		expect(trie.get("helium")).toBe(2);
+	});
+
+	test("should keep values through snapshots, buffers and set operations", () => {
+		const trie = new Seshat({ ignoreCase: true });
+		trie.set("Alpha", 10);
+		trie.set("beta", 20);
+		trie.insert("gamma", 7);
+
+		const snapshot = Seshat.fromSnapshot(trie.toSnapshot(), { ignoreCase: true });
+		expect(snapshot.getEntriesWithPrefix("")).toEqual([
+			["Alpha", 10],
+			["beta", 20],
+			["gamma", undefined],
+		]);
+
+		const lines = trie.toBuffer({ withScores: true, withValues: true });
+		expect(lines.toString()).toBe("Alpha\t0\t10\nbeta\t0\t20\ngamma\t7\n");
+		const copy = Seshat.fromBuffer(lines, { ignoreCase: true, scored: true, valued: true });
+		expect(copy.get("ALPHA")).toBe(10);
+		expect(copy.getScore("gamma")).toBe(7);
+
+		const merged = new Seshat();
+		merged.merge(Seshat.fromBuffer(trie.toBuffer({ withValues: true }), { valued: true }));
+		expect(merged.get("beta")).toBe(20);
+		merged.compact();
+		expect(merged.get("Alpha")).toBe(10);
+	});
+
+	test("should reject invalid values", () => {
+		const trie = new Seshat();
+		expect(() => trie.set("word", -1)).toThrow(RangeError);
+		expect(() => trie.set("word", 1.5)).toThrow(RangeError);
+		expect(() => trie.set("word", 2 ** 53)).toThrow(RangeError);
+		expect(() => trie.get(1 as any)).toThrow(TypeError);
+		expect(() => trie.insertFromBuffer(Buffer.from("word\tx\n"), { valued: true })).toThrow();
+	});
+});
+
+describe("Ordered Queries", () => {
+	const words = ["apple", "apricot", "banana", "band", "bandana", "cherry", "date"];
+
+	test("should find the first word at or after a key", () => {
+		const trie = new Seshat({ words });
+		expect(trie.lowerBound("")).toBe("apple");
+		expect(trie.lowerBound("b")).toBe("banana");
+		expect(trie.lowerBound("band")).toBe("band");
+		expect(trie.lowerBound("bandb")).toBe("cherry");
+		expect(trie.lowerBound("e")).toBeUndefined();
+	});
+
+	test("should return half-open ranges with limit and offset", () => {
+		const trie = new Seshat({ words });
+		expect(trie.range("b", "c")).toEqual(["banana", "band", "bandana"]);
+		expect(trie.range("band", "bandana")).toEqual(["band"]);
+		expect(trie.range("band\0")).toEqual(["bandana", "cherry", "date"]);
+		expect(trie.range("apricot", "date", { limit: 2, offset: 1 })).toEqual(["banana", "band"]);
+		expect(trie.range("c", "b")).toEqual([]);
+		expect([...trie.iterRange("az", "cz", 2)]).toEqual(["banana", "band", "bandana", "cherry"]);
+		trie.set("band", 7);
+		expect(trie.getEntriesInRange("ban", "bandz")).toEqual([
+			["banana", undefined],
+			["band", 7],
+			["bandana", undefined],
+		]);
+	});
+
+	test("should rank and select words in sorted order", () => {
+		const trie = new Seshat({ words });
+		words.forEach((word, i) => {
+			expect(trie.rank(word)).toBe(i);
+			expect(trie.select(i)).toBe(word);
+		});
+		expect(trie.rank("")).toBe(0);
+		expect(trie.rank("bandb")).toBe(5);
+		expect(trie.rank("zzz")).toBe(words.length);
+		expect(trie.select(words.length)).toBeUndefined();
+
+		trie.insert("aardvark");
+		expect(trie.rank("apple")).toBe(1);
+		expect(trie.select(0)).toBe("aardvark");
+		trie.remove("aardvark");
+		expect(trie.getMemoryStats().rankIndexBytes).toBeGreaterThan(0);
+	});
+
+	test("should answer the same way while frozen", () => {
+		const trie = new Seshat({ words });
+		trie.freeze();
+		expect(trie.lowerBound("bandb")).toBe("cherry");
+		expect(trie.range("b", "c", { offset: 1 })).toEqual(["band", "bandana"]);
+		words.forEach((word, i) => {
+			expect(trie.rank(word)).toBe(i);
+			expect(trie.select(i)).toBe(word);
+		});
+		expect(trie.rank("bandb")).toBe(5);
+	});
+
+	test("should order folded words in an ignoreCase trie", () => {
+		const trie = new Seshat({ ignoreCase: true, words: ["Zebra", "apple", "Mango"] });
+		expect(trie.range("A", "n")).toEqual(["apple", "Mango"]);
+		expect(trie.rank("ZEBRA")).toBe(2);
+		expect(trie.select(1)).toBe("Mango");
+	});
+
+	test("should reject invalid arguments", () => {
+		const trie = new Seshat({ words });
+		expect(() => trie.range(1 as any)).toThrow(TypeError);
+		expect(() => trie.range("a", 1 as any)).toThrow(TypeError);
+		expect(() => trie.select(-1)).toThrow(RangeError);
+		expect(() => trie.select(1.5)).toThrow(RangeError);
+		expect(() => trie.rank(null as any)).toThrow(TypeError);
+	});
+});
+
+describe("Top-K Autocomplete", () => {
+	// Deterministic words with varied scores, including ties
+	const scored: Array<[string, number]> = [];
+	let seed = 7;
+	for (let i = 0; i < 2000; i++) {
+		let word = "";
+		const length = 1 + (i % 7);
+		for (let j = 0; j < length; j++) {
+			seed = (seed * 1103515245 + 12345) % 2147483648;
+			word += String.fromCharCode(97 + (seed % 5));
+		}
+		scored.push([word, seed % 50]);
+	}
+
+	function bruteForce(trie: Seshat, prefix: string, k: number) {
+		return trie.getWordsWithPrefix(prefix)
+			.map(word => ({ word, score: trie.getScore(word)! }))
+			.sort((a, b) => b.score - a.score || (a.word < b.word ? -1 : a.word > b.word ? 1 : 0))
+			.slice(0, k);
+	}
+
+	function build() {
+		const trie = new Seshat();
+		scored.forEach(([word, score]) => trie.insert(word, score));
+		return trie;
+	}
+
+	test("should return the best words first, breaking ties lexicographically", () => {
+		const trie = new Seshat();
+		trie.insert("help", 9);
+		trie.insert("hello", 5);
+		trie.insert("helm", 5);
+		trie.insert("hex", 20);
+		trie.insert("heap");
+		expect(trie.topK("hel", 2)).toEqual([{ word: "help", score: 9 }, { word: "hello", score: 5 }]);
+		expect(trie.topK("he")).toEqual([
+			{ word: "hex", score: 20 },
+			{ word: "help", score: 9 },
+			{ word: "hello", score: 5 },
+			{ word: "helm", score: 5 },
+			{ word: "heap", score: 0 },
+		]);
+		expect(trie.topK("xyz", 3)).toEqual([]);
+		expect(trie.topK("he", 0)).toEqual([]);
+	});
+
+	test("should match a full sort of the prefix matches", () => {
+		const trie = build();
+		for (const prefix of ["", "a", "ab", "cc", "e", "dab"]) {
+			for (const k of [1, 5, 50, Infinity]) {
+				expect(trie.topK(prefix, k)).toEqual(bruteForce(trie, prefix, k));
+			}
+		}
+	});
+
+	test("should track score updates and removals", () => {
+		const trie = build();
+		const [best] = trie.topK("", 1);
+		trie.insert(best.word, 0);
+		expect(trie.getScore(best.word)).toBe(0);
+		expect(trie.topK("", 20)).toEqual(bruteForce(trie, "", 20));
+
+		trie.insert("a", 1000);
+		expect(trie.topK("", 1)).toEqual([{ word: "a", score: 1000 }]);
+		trie.insert("a");
+		expect(trie.getScore("a")).toBe(1000);
+
+		trie.remove("a");
+		expect(trie.getScore("a")).toBeUndefined();
+		expect(trie.topK("", 20)).toEqual(bruteForce(trie, "", 20));
+		trie.insert("a");
+		expect(trie.getScore("a")).toBe(0);
+	});
+
+	test("should keep scores through freeze, snapshots and scored buffers", () => {
+		const trie = build();
+		const expected = trie.topK("", 30);
+
+		trie.freeze();
+		expect(trie.topK("", 30)).toEqual(expected);
+		expect(Seshat.fromSnapshot(trie.toSnapshot()).topK("", 30)).toEqual(expected);
+
+		const buffer = trie.toBuffer({ withScores: true });
+		expect(buffer.toString("utf8")).toContain("\t");
+		expect(Seshat.fromBuffer(buffer, { scored: true }).topK("", 30)).toEqual(expected);
+		const threaded = new Seshat();
+		threaded.insertFromBuffer(buffer, { threads: 4, scored: true });
+		expect(threaded.topK("", 30)).toEqual(expected);
+		expect(trie.toBuffer().toString("utf8")).not.toContain("\t");
+	});
+
+	test("should preserve original casing when ignoring case", () => {
+		const trie = new Seshat({ ignoreCase: true });
+		trie.insert("Hello", 3);
+		trie.insert("HELP", 8);
+		expect(trie.topK("he", 2)).toEqual([{ word: "HELP", score: 8 }, { word: "Hello", score: 3 }]);
+		expect(trie.getScore("hello")).toBe(3);
+	});
+
+	test("should validate scores and k", () => {
+		const trie = new Seshat();
+		expect(() => trie.insert("a", -1)).toThrow(RangeError);
+		expect(() => trie.insert("a", 1.5)).toThrow(RangeError);
+		expect(() => trie.insert("a", 2 ** 32)).toThrow(RangeError);
+		expect(() => trie.topK("a", -1)).toThrow(RangeError);
+		expect(() => trie.topK(5 as any, 1)).toThrow(TypeError);
+		expect(() => trie.insertFromBuffer(Buffer.from("a\tx\n"), { scored: true })).toThrow();
+		expect(() => trie.insertFromBuffer(Buffer.from("a\n"), { scored: "yes" as any })).toThrow(TypeError);
+		expect(trie.size()).toBe(0);
+	});
+});
+
+describe("Seshat fuzzySearch", () => {
+	const words = ["hello", "help", "helm", "hell", "held", "yellow", "world", "word", "sword", "a", "ab", "abc", "banana", "bandana"];
+
+	function levenshtein(a: string, b: string): number {
+		let row = Array.from({ length: b.length + 1 }, (_, j) => j);
+		for (let i = 1; i <= a.length; i++) {
+			const next = [i];
+			for (let j = 1; j <= b.length; j++) {
+				next[j] = Math.min(row[j] + 1, next[j - 1] + 1, row[j - 1] + (a[i - 1] === b[j - 1] ? 0 : 1));
+			}
+			row = next;
+		}
+		return row[b.length];
+	}
+
+	function bruteForce(trie: Seshat, word: string, maxDistance: number, limit: number) {
+		return trie.getWordsWithPrefix("")
+			.map(candidate => ({ word: candidate, distance: levenshtein(candidate, word), score: trie.getScore(candidate)! }))
+			.filter(match => match.distance <= maxDistance)
+			.sort((a, b) => a.distance - b.distance || b.score - a.score || (a.word < b.word ? -1 : a.word > b.word ? 1 : 0))
+			.slice(0, limit);
+	}
+
+	test("should rank by distance, then score, then lexicographically", () => {
+		const trie = Seshat.fromWords(words);
+		trie.insert("help", 4);
+		expect(trie.fuzzySearch("helo", 1)).toEqual([
+			{ word: "help", distance: 1, score: 4 },
+			{ word: "held", distance: 1, score: 0 },
+			{ word: "hell", distance: 1, score: 0 },
+			{ word: "hello", distance: 1, score: 0 },
+			{ word: "helm", distance: 1, score: 0 },
+		]);
+		expect(trie.fuzzySearch("hello", 0)).toEqual([{ word: "hello", distance: 0, score: 0 }]);
+		expect(trie.fuzzySearch("zzzzzz", 2)).toEqual([]);
+		expect(trie.fuzzySearch("hello", 2, 0)).toEqual([]);
+	});
+
+	test("should match a brute-force scan, pointer tree and frozen", () => {
+		const trie = Seshat.fromWords(words);
+		trie.insert("word", 7);
+		for (const frozen of [false, true]) {
+			if (frozen) trie.freeze();
+			for (const query of ["", "helo", "wrld", "bannana", "x", "abcd"]) {
+				for (const maxDistance of [0, 1, 2, 3]) {
+					for (const limit of [1, 3, Infinity]) {
+						expect(trie.fuzzySearch(query, maxDistance, limit)).toEqual(bruteForce(trie, query, maxDistance, limit));
+					}
+				}
+			}
+		}
+	});
+
+	test("should fold the query and return original casing when ignoring case", () => {
+		const trie = new Seshat({ ignoreCase: true });
+		trie.insert("Hello");
+		expect(trie.fuzzySearch("HELO", 1)).toEqual([{ word: "Hello", distance: 1, score: 0 }]);
+	});
+
+	test("should validate arguments", () => {
+		const trie = Seshat.fromWords(words);
+		expect(() => trie.fuzzySearch(5 as any)).toThrow(TypeError);
+		expect(() => trie.fuzzySearch("a", -1)).toThrow(RangeError);
+		expect(() => trie.fuzzySearch("a", 1.5)).toThrow(RangeError);
+		expect(() => trie.fuzzySearch("a", 1, -1)).toThrow(RangeError);
+	});
+});
+
+describe("Performance Counters", () => {
+	beforeEach(() => Seshat.resetPerfCounters());
+	afterEach(() => Seshat.setPerfCounters(false));
+
+	test("should record nothing while disabled", () => {
+		const trie = Seshat.fromWords(["hello", "help"]);
+		trie.search("hello");
+		trie.toBuffer();
+		const counters = Seshat.getPerfCounters();
+		expect(counters.enabled).toBe(false);
+		expect(counters.bytesMarshalled).toBe(0);
+		expect(counters.methods).toEqual({});
+	});
+
+	test("should time every call of a method", () => {
+		const trie = Seshat.fromWords(["hello", "help", "world"]);
+		Seshat.setPerfCounters(true);
+		for (let i = 0; i < 5; i++) trie.search("hello");
+
+		const { enabled, methods } = Seshat.getPerfCounters();
+		expect(enabled).toBe(true);
+		const search = methods.search;
+		expect(search.count).toBe(5);
+		expect(search.minNs).toBeLessThanOrEqual(search.p50Ns);
+		expect(search.p50Ns).toBeLessThanOrEqual(search.p90Ns);
+		expect(search.p90Ns).toBeLessThanOrEqual(search.p99Ns);
+		expect(search.p99Ns).toBeLessThanOrEqual(search.p999Ns);
+		expect(search.p999Ns).toBeLessThanOrEqual(search.maxNs);
+		expect(search.totalNs).toBeGreaterThanOrEqual(search.maxNs);
+		expect(methods.insert).toBeUndefined();
+	});
+
+	test("should time an async query until it settles", async () => {
+		const trie = Seshat.fromWords(["hello", "help", "world"]);
+		Seshat.setPerfCounters(true);
+		const pending = trie.getWordsWithPrefixAsync("he");
+		expect(Seshat.getPerfCounters().methods.wordsWithPrefixAsync).toBeUndefined();
+		await pending;
+		expect(Seshat.getPerfCounters().methods.wordsWithPrefixAsync.count).toBe(1);
+	});
+
+	test("should count result bytes handed to JS", () => {
+		const trie = Seshat.fromWords(Array.from({ length: 1000 }, (_, i) => `word${i}`));
+		Seshat.setPerfCounters(true);
+		const buffer = trie.toBuffer();
+		expect(Seshat.getPerfCounters().bytesMarshalled).toBe(buffer.length);
+	});
+
+	test("should count trie work only in builds that compile it in", () => {
+		const trie = new Seshat();
+		["hello", "help", "helm", "world"].forEach(w => trie.insert(w));
+		trie.remove("world");
+		trie.search("help");
+		const counters = Seshat.getPerfCounters();
+		if (counters.countersCompiled) {
+			expect(counters.nodesVisited).toBeGreaterThan(0);
+			expect(counters.childProbes).toBeGreaterThan(0);
+			expect(counters.splits).toBeGreaterThan(0);
+			expect(counters.orphanCleanups).toBeGreaterThan(0);
+			expect(counters.arenaAllocations).toBeGreaterThan(0);
+		} else {
+			expect(counters.nodesVisited).toBe(0);
+			expect(counters.splits).toBe(0);
+		}
+	});
+
+	test("should start over on reset and validate its switch", () => {
+		const trie = Seshat.fromWords(["hello"]);
+		Seshat.setPerfCounters(true);
+		trie.search("hello");
+		Seshat.resetPerfCounters();
+		expect(Seshat.getPerfCounters().methods).toEqual({});
+		expect(() => Seshat.setPerfCounters("yes" as any)).toThrow(TypeError);
+	});
+});